@@ -0,0 +1,371 @@
+// Formation channel selection benchmark
+// 1. Replays recorded channel surveys (host/bench/data/survey_*.csv, or files given with -f)
+//    through main/channel_select.c, prints the ranking and fails when the chosen channels
+//    differ from the "# expect" line of the recording.
+// 2. Forms a network with main/main.c in randomly generated apartment environments (Wi-Fi
+//    access points, neighbouring PANs) and joins devices, once with the pre-formation survey
+//    and once with the scans failing so the stack picks from the whole mask as before. Reports
+//    the formed channel's Wi-Fi share, MAC retries and join latency. Each run is a child
+//    process, since the app keeps its state in statics.
+//   bench_channel_select [-f survey.csv]... [-n trials] [-d devices] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "channel_survey.h"
+#include "channel_select.h"
+#include "nwk/esp_zigbee_nwk.h"
+
+void app_main(void);
+
+#define ALL_CHANNELS        (0x07FFF800UL)
+#define MAX_FILES           (16)
+#define MAX_APS             (6)
+#define MAX_PANS            (6)
+
+static const char *s_default_files[] = {
+	SURVEY_DATA_DIR "/survey_apartment.csv",
+	SURVEY_DATA_DIR "/survey_office_wifi13.csv",
+	SURVEY_DATA_DIR "/survey_house_quiet.csv",
+};
+
+// ---- Recorded surveys -----------------------------------------------------------
+
+static bool replay(const char *path, bool verbose)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	channel_survey_entry_t table[CHANNEL_SURVEY_COUNT];
+	memset(table, 0, sizeof(table));
+	char title[160] = "";
+	uint32_t expect = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') {
+			if (!strncmp(line, "# expect", 8)) {
+				char *p = line + 8;
+				for (long ch; (ch = strtol(p, &p, 10)) > 0;) expect |= 1UL << ch;
+			} else if (!title[0]) {
+				snprintf(title, sizeof(title), "%.*s", (int)(sizeof(title) - 1), line + 2);
+				title[strcspn(title, "\n")] = 0;
+			}
+			continue;
+		}
+		int ch, noise, avg, max, nets, open;
+		if (sscanf(line, "%d,%d,%d,%d,%d,%d", &ch, &noise, &avg, &max, &nets, &open) != 6) continue;
+		if (ch < CHANNEL_SURVEY_FIRST || ch > CHANNEL_SURVEY_LAST) continue;
+		channel_survey_entry_t *e = &table[ch - CHANNEL_SURVEY_FIRST];
+		e->channel = (uint8_t)ch;
+		e->have = CHANNEL_SURVEY_HAVE_ED | CHANNEL_SURVEY_HAVE_SCAN;
+		e->noise_dbm = (int8_t)noise;
+		e->noise_avg_dbm = (int8_t)avg;
+		e->noise_max_dbm = (int8_t)max;
+		e->networks = (uint8_t)nets;
+		e->open_networks = (uint8_t)open;
+	}
+	fclose(f);
+
+	channel_select_rank_t ranks[CHANNEL_SURVEY_COUNT];
+	size_t n = channel_select_rank(table, ALL_CHANNELS, ranks);
+	uint32_t mask = channel_select_mask(table, ALL_CHANNELS, CHANNEL_SELECT_CANDIDATES);
+	const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+	bool ok = !expect || mask == expect;
+	printf("%-26s chosen:", name);
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+		if (mask & (1UL << ch)) printf(" %u", ch);
+	}
+	printf("  ranking:");
+	for (size_t i = 0; i < n && i < 6; i++) printf(" %u(%d)", ranks[i].channel, ranks[i].score);
+	printf(" ... %s\n", !expect ? "(no expectation)" : ok ? "ok" : "MISMATCH");
+	if (verbose || !ok) {
+		printf("  %s\n", title);
+		for (size_t i = 0; i < n; i++) {
+			printf("  ch%-3u score %3d  noise %3d  wifi %3d  PANs %3d\n", ranks[i].channel, ranks[i].score,
+				   ranks[i].noise, ranks[i].wifi, ranks[i].pans);
+		}
+	}
+	return ok;
+}
+
+// ---- Generated environments ----------------------------------------------------
+
+typedef struct {
+	int8_t noise[27];
+	uint8_t ap_count;
+	uint8_t ap_wifi[MAX_APS];       // Wi-Fi channel 1..13
+	int8_t ap_dbm[MAX_APS];
+	uint8_t ap_busy[MAX_APS];
+	uint8_t pan_count;
+	uint8_t pan_ch[MAX_PANS];
+	bool pan_open[MAX_PANS];
+} env_t;
+
+static uint32_t s_rng;
+
+static uint32_t rng(void)
+{
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng;
+}
+
+static int rng_range(int lo, int hi)
+{
+	return lo + (int)(rng() % (uint32_t)(hi - lo + 1));
+}
+
+// Access points mostly on 1/6/11; some on the channels in between or on 13 (EU)
+static void make_env(env_t *env, uint32_t seed)
+{
+	static const uint8_t common[] = { 1, 6, 11 };
+	s_rng = seed * 2654435761u + 1;
+	memset(env, 0, sizeof(*env));
+	for (int ch = 11; ch <= 26; ch++) env->noise[ch] = (int8_t)rng_range(-95, -90);
+	env->ap_count = (uint8_t)rng_range(3, MAX_APS);
+	for (uint8_t i = 0; i < env->ap_count; i++) {
+		env->ap_wifi[i] = rng() % 5 ? common[rng() % 3] : (uint8_t)rng_range(1, 13);
+		env->ap_dbm[i] = (int8_t)rng_range(-75, -55);
+		env->ap_busy[i] = (uint8_t)rng_range(20, 60);
+	}
+	env->pan_count = (uint8_t)rng_range(1, MAX_PANS);
+	for (uint8_t i = 0; i < env->pan_count; i++) {
+		env->pan_ch[i] = (uint8_t)rng_range(11, 26);
+		env->pan_open[i] = rng() % 10 < 3;
+	}
+}
+
+static void apply_env(const env_t *env)
+{
+	int8_t dbm[27];
+	uint32_t busy[27];
+	memset(dbm, -128, sizeof(dbm));
+	memset(busy, 0, sizeof(busy));
+	for (uint8_t i = 0; i < env->ap_count; i++) {
+		int fw = 2412 + 5 * (env->ap_wifi[i] - 1);
+		for (int ch = 11; ch <= 26; ch++) {
+			int fz = 2405 + 5 * (ch - 11);
+			// 22 MHz Wi-Fi channel against a 2 MHz Zigbee channel
+			if (abs(fz - fw) >= 12) continue;
+			if (env->ap_dbm[i] > dbm[ch]) dbm[ch] = env->ap_dbm[i];
+			busy[ch] += env->ap_busy[i];
+		}
+	}
+	for (uint8_t ch = 11; ch <= 26; ch++) {
+		sim_set_channel_noise(ch, env->noise[ch]);
+		if (busy[ch]) sim_set_channel_wifi(ch, dbm[ch], (uint8_t)(busy[ch] > 90 ? 90 : busy[ch]));
+	}
+	for (uint8_t i = 0; i < env->pan_count; i++) sim_add_pan(env->pan_ch[i], (uint16_t)(0x2000 + i), env->pan_open[i]);
+}
+
+// ---- One formation + join run (child process) -----------------------------------
+
+typedef struct {
+	uint8_t channel;
+	uint8_t busy_pct;               // collision share of the formed channel
+	bool wifi;                      // the formed channel overlaps an access point
+	uint32_t frames;
+	uint32_t retries;
+	uint32_t failures;
+	uint32_t joined;
+	double formed_s;
+	double latency_avg_ms;
+	double latency_max_ms;
+} trial_t;
+
+static size_t s_first;
+static size_t s_joining;
+
+static bool joins_done(void)
+{
+	for (size_t i = s_first; i < s_first + s_joining; i++) {
+		if (!sim_device_at(i)->interviewed_us) return false;
+	}
+	return true;
+}
+
+static void run_trial(const env_t *env, uint32_t seed, bool survey, size_t devices, bool verbose, trial_t *out)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	cfg.seed = seed;
+	cfg.verbose = verbose;
+	sim_init(&cfg);
+	apply_env(env);
+	// Failed scans leave the app without survey data: the stack picks from the whole mask
+	sim_fail_scans(!survey);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + 60ULL * 1000 * 1000);
+	sim_fail_scans(false);
+	memset(out, 0, sizeof(*out));
+	out->formed_s = (double)sim_now_us() / 1e6;
+	out->channel = esp_zb_get_current_channel();
+	out->busy_pct = sim_channel_busy_pct(out->channel);
+	for (uint8_t i = 0; i < env->ap_count; i++) {
+		int fw = 2412 + 5 * (env->ap_wifi[i] - 1), fz = 2405 + 5 * (out->channel - 11);
+		if (abs(fz - fw) < 12) out->wifi = true;
+	}
+	sim_run_until(sim_now_us() + 1000 * 1000);
+
+	uint32_t frames0 = sim_stats()->mac_frames, retries0 = sim_stats()->mac_retries;
+	uint32_t failures0 = sim_stats()->mac_failures;
+	s_first = sim_device_count();
+	s_joining = 0;
+	for (size_t i = 0; i < devices; i++) {
+		sim_device_t d;
+		memset(&d, 0, sizeof(d));
+		d.short_addr = (uint16_t)(0x3000 + i);
+		d.ieee[0] = (uint8_t)i;
+		d.ieee[1] = (uint8_t)(i >> 8);
+		d.ieee[7] = 0x5A;
+		d.ep_count = 1;
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0100, .in_count = 1,
+									 .clusters = { 0x0000 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "LUMI");
+		snprintf(d.model, sizeof(d.model), "lumi.sensor_motion");
+		sim_device_t *dev = sim_add_device(&d);
+		if (!dev) break;
+		sim_announce(dev, (uint64_t)(sim_rand() % 2000) * 1000);
+		s_joining++;
+	}
+	sim_run_while(joins_done, sim_now_us() + 300ULL * 1000 * 1000);
+	double sum = 0;
+	for (size_t i = s_first; i < s_first + s_joining; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (!d->interviewed_us) continue;
+		double lat = (double)(d->interviewed_us - d->announce_us) / 1000.0;
+		sum += lat;
+		if (lat > out->latency_max_ms) out->latency_max_ms = lat;
+		out->joined++;
+	}
+	out->latency_avg_ms = out->joined ? sum / out->joined : 0.0;
+	out->frames = sim_stats()->mac_frames - frames0;
+	out->retries = sim_stats()->mac_retries - retries0;
+	out->failures = sim_stats()->mac_failures - failures0;
+}
+
+static bool fork_trial(const env_t *env, uint32_t seed, bool survey, size_t devices, bool verbose, trial_t *out)
+{
+	int fd[2];
+	if (pipe(fd) != 0) return false;
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) return false;
+	if (pid == 0) {
+		close(fd[0]);
+		trial_t t;
+		run_trial(env, seed, survey, devices, verbose, &t);
+		ssize_t w = write(fd[1], &t, sizeof(t));
+		_exit(w == (ssize_t)sizeof(t) ? 0 : 1);
+	}
+	close(fd[1]);
+	ssize_t r = read(fd[0], out, sizeof(*out));
+	close(fd[0]);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return r == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+typedef struct {
+	uint32_t trials;
+	uint32_t on_wifi;
+	uint64_t busy_sum;
+	uint64_t frames;
+	uint64_t retries;
+	uint64_t failures;
+	uint32_t joined;
+	uint32_t expected;
+	double latency_sum_ms;          // of per-trial averages
+	double latency_max_ms;
+	double formed_sum_s;
+} summary_t;
+
+static void add(summary_t *s, const trial_t *t, size_t devices)
+{
+	s->trials++;
+	s->on_wifi += t->wifi;
+	s->busy_sum += t->busy_pct;
+	s->frames += t->frames;
+	s->retries += t->retries;
+	s->failures += t->failures;
+	s->joined += t->joined;
+	s->expected += (uint32_t)devices;
+	s->latency_sum_ms += t->latency_avg_ms;
+	if (t->latency_max_ms > s->latency_max_ms) s->latency_max_ms = t->latency_max_ms;
+	s->formed_sum_s += t->formed_s;
+}
+
+static void print_summary(const char *label, const summary_t *s)
+{
+	if (!s->trials) return;
+	printf("%-22s formed after %.1f s, on Wi-Fi %u/%u, busy %.1f%%, MAC retries %.3f/frame, lost %lu,"
+		   " joined %u/%u, join latency avg %.1f max %.1f ms\n",
+		   label, s->formed_sum_s / s->trials, s->on_wifi, s->trials, (double)s->busy_sum / s->trials,
+		   s->frames ? (double)s->retries / (double)s->frames : 0.0, (unsigned long)s->failures, s->joined,
+		   s->expected, s->latency_sum_ms / s->trials, s->latency_max_ms);
+}
+
+int main(int argc, char **argv)
+{
+	const char *files[MAX_FILES];
+	size_t file_count = 0;
+	uint32_t trials = 50, seed = 1;
+	size_t devices = 20;
+	bool verbose = false;
+	int c;
+	while ((c = getopt(argc, argv, "f:n:d:r:vh")) != -1) {
+		switch (c) {
+		case 'f':
+			if (file_count < MAX_FILES) files[file_count++] = optarg;
+			break;
+		case 'n': trials = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'd': devices = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'r': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-f survey.csv]... [-n trials] [-d devices] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (!file_count) {
+		for (size_t i = 0; i < sizeof(s_default_files) / sizeof(s_default_files[0]); i++) files[file_count++] = s_default_files[i];
+	}
+
+	printf("recorded surveys (candidates=%u margin=%u):\n", CHANNEL_SELECT_CANDIDATES, CHANNEL_SELECT_MARGIN);
+	bool ok = true;
+	for (size_t i = 0; i < file_count; i++) ok &= replay(files[i], verbose);
+
+	if (trials) {
+		printf("formation in generated environments: %u trials, %zu joining devices each\n", trials, devices);
+		summary_t sel = { 0 }, stack = { 0 };
+		for (uint32_t t = 0; t < trials; t++) {
+			env_t env;
+			make_env(&env, seed + t);
+			trial_t a, b;
+			if (!fork_trial(&env, seed + t, true, devices, false, &a) ||
+				!fork_trial(&env, seed + t, false, devices, false, &b)) {
+				fprintf(stderr, "trial %u failed\n", t);
+				return 1;
+			}
+			add(&sel, &a, devices);
+			add(&stack, &b, devices);
+			if (verbose) {
+				printf("  trial %-3u survey ch%u busy %u%% retries %u/%u | stack ch%u busy %u%% retries %u/%u\n", t,
+					   a.channel, a.busy_pct, a.retries, a.frames, b.channel, b.busy_pct, b.retries, b.frames);
+			}
+		}
+		print_summary("survey + selection:", &sel);
+		print_summary("stack choice:", &stack);
+		// The selection must not do worse than the stack on the same environments
+		ok &= sel.retries * stack.frames <= stack.retries * sel.frames;
+	}
+	return ok ? 0 : 1;
+}
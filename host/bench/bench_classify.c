@@ -0,0 +1,224 @@
+// Detection pipeline benchmark
+// Joins the same mixed network twice, each run in its own process: once with only the Basic
+// classifier (the interview as before: ActiveEP, SimpleDesc, Basic read for every device) and
+// once with the whole pipeline (OUI at the announce, descriptor rules, then Basic). Checks the
+// verdicts and alerts are the same device by device and reports per device class the requests
+// issued and the time from announce to verdict, with the airtime of each run. Fails on a
+// verdict or alert difference, or when the pipeline issues more requests.
+//   bench_classify [-n devices] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "device_table.h"
+#include "interview.h"
+#include "classifier.h"
+
+void app_main(void);
+
+#define SEC                 (1000ULL * 1000)
+#define MAX_DEVICES         (256)
+
+typedef struct {
+	uint32_t devices;
+	uint32_t active_ep, simple_desc, reads;
+	uint32_t decided;
+	uint64_t verdict_sum_us, verdict_max_us;
+} class_result_t;
+
+typedef struct {
+	bool done;
+	uint32_t devices;
+	uint8_t kind[MAX_DEVICES];
+	uint8_t verdict[MAX_DEVICES];
+	uint16_t alerts[MAX_DEVICES];
+	class_result_t classes[SIM_KIND_COUNT];
+	uint64_t airtime_us;
+	uint32_t frames;
+	classifier_stats_t cs;
+} run_t;
+
+static uint32_t s_devices = 120;
+static uint32_t s_seed = 1;
+static bool s_verbose;
+static uint8_t s_kind[SIM_MAX_DEVICES];
+static uint64_t s_verdict_us[SIM_MAX_DEVICES];
+
+static void add_device(uint32_t i)
+{
+	uint32_t r = sim_net_rand() % 100;
+	// Roughly a home bought over the years: IKEA lights and remotes, Hue, Aqara sensors, Tuya
+	uint8_t k = r < 25 ? SIM_KIND_IKEA_BULB : r < 35 ? SIM_KIND_IKEA_REMOTE_SL : r < 50 ? SIM_KIND_HUE
+			  : r < 65 ? SIM_KIND_AQARA : r < 80 ? SIM_KIND_TUYA : r < 90 ? SIM_KIND_SONOFF_PLUG : SIM_KIND_INNR;
+	sim_device_t d;
+	sim_device_of_kind(&d, &sim_device_kinds[k], (uint16_t)(0x3000 + i), sim_net_rand(), (uint16_t)i);
+	snprintf(d.sw_build, sizeof(d.sw_build), "1.0.%03u", sim_net_rand() % 100);
+	sim_device_t *dev = sim_add_device(&d);
+	if (!dev) return;
+	s_kind[sim_device_count() - 1] = k;
+	sim_announce(dev, (uint64_t)(sim_net_rand() % 20000) * 1000);
+}
+
+// Checked after every simulator event: the first time each device's entry is classified
+static bool all_classified(void)
+{
+	bool all = true;
+	for (size_t i = 0; i < sim_device_count(); i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (!s_verdict_us[i]) {
+			const device_entry_t *e = device_table_find(d->ieee);
+			if (e && e->state == DEVICE_STATE_DONE) s_verdict_us[i] = sim_now_us();
+		}
+		if (!s_verdict_us[i] || (d->expect_alert && !d->alerted_us)) all = false;
+	}
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return all && is.queue_depth == 0 && is.in_flight == 0;
+}
+
+static void run(bool pipeline, run_t *out)
+{
+	memset(out, 0, sizeof(*out));
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	cfg.seed = s_seed;
+	cfg.verbose = s_verbose;
+	sim_init(&cfg);
+	if (!pipeline) {
+		classifier_set_enabled("oui", false);
+		classifier_set_enabled("descriptor", false);
+	}
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + 60 * SEC);
+	sim_run_until(sim_now_us() + SEC);
+	sim_stats_t before = *sim_stats();
+
+	sim_net_seed(s_seed);
+	for (uint32_t i = 0; i < s_devices; i++) add_device(i);
+	out->done = sim_run_while(all_classified, sim_now_us() + 300 * SEC);
+	const sim_stats_t *st = sim_stats();
+	out->airtime_us = st->airtime_us - before.airtime_us;
+	out->frames = st->mac_frames - before.mac_frames;
+	classifier_get_stats(&out->cs);
+
+	out->devices = (uint32_t)sim_device_count();
+	for (size_t i = 0; i < out->devices; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		const device_entry_t *e = device_table_find(d->ieee);
+		class_result_t *c = &out->classes[s_kind[i]];
+		out->kind[i] = s_kind[i];
+		out->verdict[i] = e ? e->verdict : INTERVIEW_VERDICT_NONE;
+		out->alerts[i] = d->alerts;
+		c->devices++;
+		c->active_ep += d->active_ep_reqs;
+		c->simple_desc += d->simple_desc_reqs;
+		c->reads += d->basic_reads;
+		if (!s_verdict_us[i]) continue;
+		uint64_t t = s_verdict_us[i] - d->announce_us;
+		c->decided++;
+		c->verdict_sum_us += t;
+		if (t > c->verdict_max_us) c->verdict_max_us = t;
+	}
+}
+
+static bool fork_run(bool pipeline, run_t *out)
+{
+	int fd[2];
+	if (pipe(fd) != 0) return false;
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) return false;
+	if (pid == 0) {
+		close(fd[0]);
+		static run_t r;
+		run(pipeline, &r);
+		ssize_t w = write(fd[1], &r, sizeof(r));
+		_exit(w == (ssize_t)sizeof(r) ? 0 : 1);
+	}
+	close(fd[1]);
+	size_t got = 0;
+	for (ssize_t r; got < sizeof(*out) && (r = read(fd[0], (char *)out + got, sizeof(*out) - got)) > 0;) got += (size_t)r;
+	close(fd[0]);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return got == sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static uint32_t requests(const class_result_t *c)
+{
+	return c->active_ep + c->simple_desc + c->reads;
+}
+
+static void print_run(const char *label, const run_t *r)
+{
+	printf("%s: classified=%s airtime=%.1f ms frames=%u votes=%u early_exits=%u decided annce/descriptor/basic=%u/%u/%u\n",
+		   label, r->done ? "all" : "NOT ALL", (double)r->airtime_us / 1000.0, r->frames, r->cs.votes,
+		   r->cs.early_exits, r->cs.decided[CLASSIFY_ANNCE], r->cs.decided[CLASSIFY_DESCRIPTOR],
+		   r->cs.decided[CLASSIFY_BASIC]);
+	printf("  %-9s %4s %10s %11s %6s %9s %9s\n", "class", "n", "active_ep", "simple_desc", "reads",
+		   "avg ms", "max ms");
+	for (size_t k = 0; k < SIM_KIND_COUNT; k++) {
+		const class_result_t *c = &r->classes[k];
+		if (!c->devices) continue;
+		printf("  %-9s %4u %10u %11u %6u %9.1f %9.1f\n", sim_device_kinds[k].name, c->devices, c->active_ep,
+			   c->simple_desc, c->reads, c->decided ? (double)c->verdict_sum_us / c->decided / 1000.0 : 0.0,
+			   (double)c->verdict_max_us / 1000.0);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:r:vh")) != -1) {
+		switch (c) {
+		case 'n': s_devices = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'r': s_seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': s_verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-n devices] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (s_devices > MAX_DEVICES) s_devices = MAX_DEVICES;
+	if (s_devices > DEVICE_TABLE_MAX_DEVICES) s_devices = DEVICE_TABLE_MAX_DEVICES;
+
+	static run_t basic, pipeline;
+	if (!fork_run(false, &basic) || !fork_run(true, &pipeline)) {
+		fprintf(stderr, "run failed\n");
+		return 1;
+	}
+	printf("devices=%u seed=%u confidence=%u%%\n", s_devices, s_seed, (unsigned)CLASSIFIER_CONFIDENCE);
+	print_run("basic only", &basic);
+	print_run("pipeline", &pipeline);
+
+	uint32_t mismatches = 0, alert_diffs = 0, matches = 0;
+	for (uint32_t i = 0; i < basic.devices && i < pipeline.devices; i++) {
+		matches += basic.verdict[i] == INTERVIEW_VERDICT_MATCH;
+		if (basic.verdict[i] != pipeline.verdict[i]) {
+			mismatches++;
+			printf("verdict mismatch: device %u (%s) basic=%u pipeline=%u\n", i, sim_device_kinds[basic.kind[i]].name,
+				   basic.verdict[i], pipeline.verdict[i]);
+		}
+		alert_diffs += basic.alerts[i] != pipeline.alerts[i];
+	}
+	uint32_t req_basic = 0, req_pipeline = 0;
+	for (size_t k = 0; k < SIM_KIND_COUNT; k++) {
+		req_basic += requests(&basic.classes[k]);
+		req_pipeline += requests(&pipeline.classes[k]);
+	}
+	printf("verdicts: %u devices, %u matches, %u mismatches, %u alert differences\n", basic.devices, matches,
+		   mismatches, alert_diffs);
+	printf("requests: basic only %u, pipeline %u (%.0f%% fewer), airtime %.0f%% less\n", req_basic, req_pipeline,
+		   req_basic ? 100.0 * (1.0 - (double)req_pipeline / req_basic) : 0.0,
+		   basic.airtime_us ? 100.0 * (1.0 - (double)pipeline.airtime_us / basic.airtime_us) : 0.0);
+
+	bool ok = basic.done && pipeline.done && basic.devices == pipeline.devices && !mismatches && !alert_diffs &&
+			  req_pipeline <= req_basic;
+	if (!ok) printf("FAIL\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+// Device table microbenchmark
+// Compares main/device_table.c against the structures it replaced:
+//   ring:  the old s_alerted[] list of short addresses (linear scan, circular overwrite)
+//   array: the old interview records (linear scan on IEEE or short address)
+// at 16, 128 and 1024 devices, and cross-checks the table against a reference model
+// under random insert/rebind/remove traffic.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "device_table.h"
+
+#define MAX_N       (1024)
+
+typedef struct {
+	bool used;
+	uint16_t addr;
+	uint8_t ieee[8];
+	uint32_t last_used;
+} linear_dev_t;
+
+static uint16_t s_ring[MAX_N];
+static uint16_t s_ring_count;
+static uint16_t s_ring_wr;
+static linear_dev_t s_lin[MAX_N];
+
+static uint8_t s_ieee[2 * MAX_N][8];
+static uint16_t s_short[2 * MAX_N];
+static uint32_t s_order[1 << 16];
+static volatile uintptr_t s_sink;
+
+static uint32_t s_rng = 0x12345678u;
+
+static uint32_t rnd(void)
+{
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Devices 0..n-1 are present, n..2n-1 are used for misses. IEEE addresses share
+// the IKEA OUI and differ in the low bytes, like a real installation.
+static void make_devices(size_t n)
+{
+	for (size_t i = 0; i < 2 * n; i++) {
+		uint64_t v = 0x000B57FFFE000000ull | (rnd() & 0xFFFFFF);
+		for (int b = 0; b < 8; b++) s_ieee[i][b] = (uint8_t)(v >> (8 * b));
+		s_short[i] = (uint16_t)(rnd() % 0xFFF0);
+		for (size_t j = 0; j < i; j++) {
+			// Keep both keys unique
+			if (memcmp(s_ieee[j], s_ieee[i], 8) == 0 || s_short[j] == s_short[i]) {
+				i--;
+				break;
+			}
+		}
+	}
+}
+
+// The table only needs a clock and a log sink: the simulator is not linked
+int64_t esp_timer_get_time(void)
+{
+	return (int64_t)(now_ns() / 1000);
+}
+
+void sim_log_write(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+	(void)level;
+	(void)tag;
+	(void)fmt;
+}
+
+// ---- Old structures ------------------------------------------------------------
+
+static bool ring_has(uint16_t addr)
+{
+	for (uint16_t i = 0; i < s_ring_count; i++) {
+		if (s_ring[i] == addr) return true;
+	}
+	return false;
+}
+
+static void ring_mark(uint16_t addr, uint16_t cap)
+{
+	if (ring_has(addr)) return;
+	if (s_ring_count < cap) {
+		s_ring[s_ring_count++] = addr;
+	} else {
+		s_ring[s_ring_wr++ % cap] = addr;
+	}
+}
+
+static linear_dev_t *lin_by_ieee(const uint8_t ieee[8], size_t cap)
+{
+	for (size_t i = 0; i < cap; i++) {
+		if (s_lin[i].used && memcmp(s_lin[i].ieee, ieee, 8) == 0) return &s_lin[i];
+	}
+	return NULL;
+}
+
+static linear_dev_t *lin_by_addr(uint16_t addr, size_t cap)
+{
+	for (size_t i = 0; i < cap; i++) {
+		if (s_lin[i].used && s_lin[i].addr == addr) return &s_lin[i];
+	}
+	return NULL;
+}
+
+static linear_dev_t *lin_upsert(const uint8_t ieee[8], uint16_t addr, size_t cap)
+{
+	linear_dev_t *d = lin_by_ieee(ieee, cap);
+	if (!d) {
+		for (size_t i = 0; i < cap && !d; i++) {
+			if (!s_lin[i].used) d = &s_lin[i];
+		}
+		if (!d) return NULL;
+		d->used = true;
+		memcpy(d->ieee, ieee, 8);
+	}
+	d->addr = addr;
+	return d;
+}
+
+// ---- Benchmark -----------------------------------------------------------------
+
+typedef struct {
+	double insert;
+	double find_ieee;
+	double find_short;
+	double miss;
+} op_cost_t;
+
+static size_t s_ops;
+
+static double per_op(uint64_t t0, size_t ops)
+{
+	return (double)(now_ns() - t0) / (double)ops;
+}
+
+static void bench_ring(size_t n, op_cost_t *c)
+{
+	uint64_t t0 = now_ns();
+	s_ring_count = s_ring_wr = 0;
+	for (size_t i = 0; i < n; i++) ring_mark(s_short[i], (uint16_t)n);
+	c->insert = per_op(t0, n);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += ring_has(s_short[s_order[k] % n]);
+	c->find_short = per_op(t0, s_ops);
+	c->find_ieee = 0;
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += ring_has(s_short[n + s_order[k] % n]);
+	c->miss = per_op(t0, s_ops);
+}
+
+static void bench_linear(size_t n, op_cost_t *c)
+{
+	memset(s_lin, 0, sizeof(s_lin));
+	uint64_t t0 = now_ns();
+	for (size_t i = 0; i < n; i++) s_sink += (uintptr_t)lin_upsert(s_ieee[i], s_short[i], n);
+	c->insert = per_op(t0, n);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += (uintptr_t)lin_by_ieee(s_ieee[s_order[k] % n], n);
+	c->find_ieee = per_op(t0, s_ops);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += (uintptr_t)lin_by_addr(s_short[s_order[k] % n], n);
+	c->find_short = per_op(t0, s_ops);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += (uintptr_t)lin_by_ieee(s_ieee[n + s_order[k] % n], n);
+	c->miss = per_op(t0, s_ops);
+}
+
+static void bench_table(size_t n, op_cost_t *c)
+{
+	device_table_clear();
+	uint64_t t0 = now_ns();
+	for (size_t i = 0; i < n; i++) s_sink += (uintptr_t)device_table_upsert(s_ieee[i], s_short[i]);
+	c->insert = per_op(t0, n);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += (uintptr_t)device_table_find(s_ieee[s_order[k] % n]);
+	c->find_ieee = per_op(t0, s_ops);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += (uintptr_t)device_table_find_short(s_short[s_order[k] % n]);
+	c->find_short = per_op(t0, s_ops);
+	t0 = now_ns();
+	for (size_t k = 0; k < s_ops; k++) s_sink += (uintptr_t)device_table_find(s_ieee[n + s_order[k] % n]);
+	c->miss = per_op(t0, s_ops);
+}
+
+// ---- Cross-check ---------------------------------------------------------------
+
+// Random upserts, short address reassignments and removals against a plain model
+static bool check_table(size_t n, size_t steps)
+{
+	static int16_t model_short_owner[0x10000];
+	static bool present[2 * MAX_N];
+	static uint16_t addr_of[2 * MAX_N];
+	memset(present, 0, sizeof(present));
+	for (size_t i = 0; i < 0x10000; i++) model_short_owner[i] = -1;
+	device_table_clear();
+	for (size_t s = 0; s < steps; s++) {
+		size_t i = rnd() % (2 * n);
+		uint32_t op = rnd() % 8;
+		if (op < 5) {
+			// Join or rejoin, half of the time with an address from the small pool so they collide
+			uint16_t addr = (op & 1) ? (uint16_t)(rnd() % 64) : s_short[i];
+			size_t live = 0;
+			for (size_t j = 0; j < 2 * n; j++) live += present[j];
+			if (!present[i] && live >= DEVICE_TABLE_MAX_DEVICES) continue;
+			if (!device_table_upsert(s_ieee[i], addr)) return false;
+			if (present[i] && addr_of[i] != DEVICE_TABLE_NO_ADDR) model_short_owner[addr_of[i]] = -1;
+			if (model_short_owner[addr] >= 0) addr_of[model_short_owner[addr]] = DEVICE_TABLE_NO_ADDR;
+			model_short_owner[addr] = (int16_t)i;
+			present[i] = true;
+			addr_of[i] = addr;
+		} else if (present[i]) {
+			device_table_remove(device_table_find(s_ieee[i]));
+			if (addr_of[i] != DEVICE_TABLE_NO_ADDR) model_short_owner[addr_of[i]] = -1;
+			present[i] = false;
+		}
+		if (s % 64 == 0 || s == steps - 1) {
+			for (size_t j = 0; j < 2 * n; j++) {
+				device_entry_t *e = device_table_find(s_ieee[j]);
+				if (present[j] != (e != NULL)) return false;
+				if (e && e->short_addr != addr_of[j]) return false;
+				if (e && addr_of[j] != DEVICE_TABLE_NO_ADDR && device_table_find_short(addr_of[j]) != e) return false;
+			}
+			for (uint32_t a = 0; a < 64; a++) {
+				device_entry_t *e = device_table_find_short((uint16_t)a);
+				int16_t owner = model_short_owner[a];
+				if ((owner >= 0) != (e != NULL)) return false;
+				if (e && memcmp(e->ieee, s_ieee[owner], 8) != 0) return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	s_ops = argc > 1 ? (size_t)strtoul(argv[1], NULL, 0) : 200000;
+	for (size_t k = 0; k < sizeof(s_order) / sizeof(s_order[0]); k++) s_order[k] = rnd();
+	if (s_ops > sizeof(s_order) / sizeof(s_order[0])) s_ops = sizeof(s_order) / sizeof(s_order[0]);
+
+	printf("device table: %u entries, %zu bytes static; %zu lookups per measurement\n",
+		   DEVICE_TABLE_MAX_DEVICES, sizeof(device_entry_t) * DEVICE_TABLE_MAX_DEVICES, s_ops);
+	printf("%6s %-6s %10s %10s %10s %10s   (ns/op)\n", "n", "impl", "insert", "find_ieee", "find_short", "miss");
+	static const size_t sizes[] = {16, 128, 1024};
+	bool ok = true;
+	for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+		size_t n = sizes[si];
+		make_devices(n);
+		op_cost_t ring, lin, tab;
+		bench_ring(n, &ring);
+		bench_linear(n, &lin);
+		bench_table(n, &tab);
+		printf("%6zu %-6s %10.1f %10s %10.1f %10.1f\n", n, "ring", ring.insert, "-", ring.find_short, ring.miss);
+		printf("%6zu %-6s %10.1f %10.1f %10.1f %10.1f\n", n, "array", lin.insert, lin.find_ieee, lin.find_short, lin.miss);
+		printf("%6zu %-6s %10.1f %10.1f %10.1f %10.1f\n", n, "table", tab.insert, tab.find_ieee, tab.find_short, tab.miss);
+		bool good = check_table(n, 20000);
+		printf("%6zu cross-check: %s\n", n, good ? "ok" : "MISMATCH");
+		ok &= good;
+	}
+	return ok ? 0 : 1;
+}
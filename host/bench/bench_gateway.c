@@ -0,0 +1,407 @@
+// Gateway link benchmark
+// Several coordinators (-c), each in its own process, stream to one reference receiver
+// (host/tools/gateway_recv) over pseudo-terminals. Each forms its network and takes two waves of
+// joins (-n devices in all): the first with the gateway keeping up, the second while the
+// gateway holds the first coordinator's CTS for -H seconds, as a busy host would. Between the
+// waves, bytes that are not a frame (one with a valid-looking header among them) are written on
+// the last coordinator's line.
+// Checks, per coordinator: the receiver decodes as many network, join, verdict and alert records
+// as the coordinator sent, and DROPPED records add up to what it dropped; no alert dropped; no
+// frame lost; only the junk skipped. The held coordinator must have stalled on the UART.
+// Reports records per frame, bytes per record on the wire against the receiver's text lines,
+// the longest any record and any alert waited before its frame left.
+//   bench_gateway [-c coordinators] [-n devices] [-H hold_s] [-r seed] [-v]
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "device_table.h"
+#include "interview.h"
+#include "gateway_link.h"
+
+void app_main(void);
+
+#define SEC                 (1000ULL * 1000)
+#define MAX_COORDINATORS    (8)
+#define WAVE_SPREAD_S       (5)
+
+static const sim_kind_t s_kinds[] = { SIM_KIND_IKEA_BULB, SIM_KIND_HUE, SIM_KIND_AQARA, SIM_KIND_TUYA };
+#define KIND_COUNT          (sizeof(s_kinds) / sizeof(s_kinds[0]))
+
+// What a coordinator's process reports back
+typedef struct {
+	bool formed;
+	bool done;
+	uint8_t node[8];
+	uint32_t devices;
+	uint32_t junk;                  // bytes written between frames
+	gateway_link_stats_t gw;
+	sim_uart_stats_t uart;
+} coord_t;
+
+// What the receiver printed for one coordinator
+typedef struct {
+	unsigned long by_type[GWLINK_TYPE_COUNT];
+	unsigned long dropped;
+	unsigned long text_bytes;       // record lines
+	unsigned long frames, records, bytes, rejected, skipped, lost;
+	bool summary;
+} heard_t;
+
+static uint32_t s_coordinators = 2;
+static uint32_t s_devices = 120;
+static uint32_t s_hold_s = 20;
+static uint32_t s_seed = 1;
+static bool s_verbose;
+
+static void add_device(uint32_t coord, uint32_t i, uint64_t delay_us)
+{
+	const sim_device_kind_t *kind = &sim_device_kinds[s_kinds[sim_net_rand() % KIND_COUNT]];
+	// Byte 2 tells the coordinators' devices apart
+	uint32_t lo = (sim_net_rand() & 0xFFFF) | coord << 16;
+	sim_device_t d;
+	sim_device_of_kind(&d, kind, (uint16_t)(0x3000 + i), lo, (uint16_t)i);
+	sim_device_t *dev = sim_add_device(&d);
+	if (dev) sim_announce(dev, delay_us);
+}
+
+static bool all_classified(void)
+{
+	for (size_t i = 0; i < sim_device_count(); i++) {
+		const sim_device_t *d = sim_device_at(i);
+		const device_entry_t *e = device_table_find(d->ieee);
+		if (!e || e->state != DEVICE_STATE_DONE || (d->expect_alert && !d->alerted_us)) return false;
+	}
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.queue_depth == 0 && is.in_flight == 0;
+}
+
+static void cts_ev(void *ctx, uintptr_t asserted)
+{
+	(void)ctx;
+	sim_uart_set_cts(GATEWAY_LINK_UART, asserted != 0);
+}
+
+// A line that is not all frames: noise, then a header whose length and CRC do not check out
+static uint32_t write_junk(int fd)
+{
+	uint8_t junk[64];
+	for (size_t i = 0; i < sizeof(junk); i++) junk[i] = (uint8_t)sim_net_rand();
+	gwlink_frame_hdr_t h = { .sync = { GWLINK_SYNC0, GWLINK_SYNC1 }, .version = GWLINK_VERSION, .count = 1,
+							 .len = 8 };
+	memcpy(&junk[16], &h, sizeof(h));
+	junk[48] = GWLINK_SYNC0;
+	junk[49] = GWLINK_SYNC1;
+	junk[50] = 0xEE;
+	// Whatever the random bytes drew, the stream must not resync on a frame that is not there
+	junk[sizeof(junk) - 1] = 0;
+	ssize_t n = write(fd, junk, sizeof(junk));
+	return n > 0 ? (uint32_t)n : 0;
+}
+
+static void run_coordinator(uint32_t index, int fd, coord_t *out)
+{
+	memset(out, 0, sizeof(*out));
+	sim_coordinator_ieee[0] = (uint8_t)(0x10 + index);
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	cfg.seed = s_seed + index;
+	cfg.verbose = s_verbose;
+	sim_init(&cfg);
+	sim_uart_attach(GATEWAY_LINK_UART, fd);
+	app_main();
+	sim_rtos_start_tasks();
+	out->formed = sim_run_while(sim_network_formed, sim_now_us() + 60 * SEC);
+	sim_run_until(sim_now_us() + SEC);
+	memcpy(out->node, sim_coordinator_ieee, sizeof(out->node));
+	if (!out->formed) return;
+
+	sim_net_seed(s_seed + index);
+	uint32_t first = s_devices / 2;
+	for (uint32_t i = 0; i < first; i++) add_device(index, i, (uint64_t)(sim_net_rand() % (WAVE_SPREAD_S * 1000)) * 1000);
+	bool done = sim_run_while(all_classified, sim_now_us() + 120 * SEC);
+	sim_run_until(sim_now_us() + SEC);
+
+	// Quiet line: whatever the link sends next starts after the junk
+	if (index == s_coordinators - 1) out->junk = write_junk(fd);
+	if (index == 0) {
+		sim_uart_set_cts(GATEWAY_LINK_UART, false);
+		sim_schedule(s_hold_s * SEC, cts_ev, NULL, 1);
+	}
+	for (uint32_t i = first; i < s_devices; i++) {
+		add_device(index, i, (uint64_t)(sim_net_rand() % (WAVE_SPREAD_S * 1000)) * 1000);
+	}
+	done = sim_run_while(all_classified, sim_now_us() + (120 + s_hold_s) * SEC) && done;
+	if (index == 0) sim_run_until(sim_now_us() + s_hold_s * SEC);
+	// Let the last frames out
+	sim_run_until(sim_now_us() + 2 * SEC);
+	out->done = done;
+	out->devices = (uint32_t)sim_device_count();
+	gateway_link_get_stats(&out->gw);
+	out->uart = *sim_uart_stats(GATEWAY_LINK_UART);
+}
+
+static bool open_pty(int *master, char *slave, size_t slave_len)
+{
+	*master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0) return false;
+	const char *name = ptsname(*master);
+	if (!name) return false;
+	snprintf(slave, slave_len, "%s", name);
+	// Raw on the master side too, or the line discipline would rewrite the frames
+	struct termios t;
+	if (tcgetattr(*master, &t) == 0) {
+		cfmakeraw(&t);
+		tcsetattr(*master, TCSANOW, &t);
+	}
+	return true;
+}
+
+static void sleep_ms(long ms)
+{
+	struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+	nanosleep(&ts, NULL);
+}
+
+static long file_size(const char *path)
+{
+	struct stat st;
+	return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// Wait for the receiver's first line: it has opened and configured every port
+static bool wait_listening(const char *path)
+{
+	for (int i = 0; i < 500; i++) {
+		FILE *f = fopen(path, "r");
+		char line[128] = "";
+		if (f) {
+			bool got = fgets(line, sizeof(line), f) && strncmp(line, "# listening", 11) == 0;
+			fclose(f);
+			if (got) return true;
+		}
+		sleep_ms(10);
+	}
+	return false;
+}
+
+static void format_node(const uint8_t node[8], char *out)
+{
+	for (int i = 7; i >= 0; i--) out += sprintf(out, "%02X%s", node[i], i ? ":" : "");
+}
+
+static int type_of(const char *name)
+{
+	static const char *const names[GWLINK_TYPE_COUNT] = {
+		[GWLINK_NETWORK] = "network", [GWLINK_JOIN] = "join", [GWLINK_VERDICT] = "verdict",
+		[GWLINK_ALERT] = "alert", [GWLINK_DROPPED] = "dropped",
+	};
+	for (int t = GWLINK_NETWORK; t < GWLINK_TYPE_COUNT; t++) {
+		if (strcmp(name, names[t]) == 0) return t;
+	}
+	return -1;
+}
+
+static bool parse_receiver(const char *path, char slaves[][64], const coord_t *coords, heard_t *heard)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) return false;
+	char nodes[MAX_COORDINATORS][24];
+	for (uint32_t i = 0; i < s_coordinators; i++) format_node(coords[i].node, nodes[i]);
+	char line[512];
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') {
+			char port[64];
+			heard_t h;
+			if (sscanf(line, "# %63[^:]: frames %lu records %lu bytes %lu rejected %lu skipped %lu lost %lu", port,
+					   &h.frames, &h.records, &h.bytes, &h.rejected, &h.skipped, &h.lost) != 7) {
+				continue;
+			}
+			for (uint32_t i = 0; i < s_coordinators; i++) {
+				if (strcmp(port, slaves[i]) != 0) continue;
+				heard[i].frames = h.frames;
+				heard[i].records = h.records;
+				heard[i].bytes = h.bytes;
+				heard[i].rejected = h.rejected;
+				heard[i].skipped = h.skipped;
+				heard[i].lost = h.lost;
+				heard[i].summary = true;
+			}
+			continue;
+		}
+		char node[24], type[16];
+		unsigned boot, seq;
+		unsigned long ms, count = 0;
+		int n = sscanf(line, "%23s %u %u %lu %15s %lu", node, &boot, &seq, &ms, type, &count);
+		if (n < 5) continue;
+		int t = type_of(type);
+		for (uint32_t i = 0; i < s_coordinators; i++) {
+			if (strcmp(node, nodes[i]) != 0) continue;
+			if (t > 0) heard[i].by_type[t]++;
+			if (t == GWLINK_DROPPED) heard[i].dropped += count;
+			heard[i].text_bytes += strlen(line);
+		}
+	}
+	fclose(f);
+	return true;
+}
+
+static bool check(const char *what, bool cond)
+{
+	if (!cond) printf("FAIL: %s\n", what);
+	return cond;
+}
+
+int main(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "c:n:H:r:vh")) != -1) {
+		switch (c) {
+		case 'c': s_coordinators = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'n': s_devices = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'H': s_hold_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'r': s_seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': s_verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-c coordinators] [-n devices] [-H hold_s] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (s_coordinators == 0 || s_coordinators > MAX_COORDINATORS) s_coordinators = 2;
+	if (s_devices < 2 || s_devices > SIM_MAX_DEVICES) s_devices = 120;
+	signal(SIGPIPE, SIG_IGN);
+
+	int masters[MAX_COORDINATORS];
+	char slaves[MAX_COORDINATORS][64];
+	for (uint32_t i = 0; i < s_coordinators; i++) {
+		if (!open_pty(&masters[i], slaves[i], sizeof(slaves[i]))) {
+			perror("pty");
+			return 1;
+		}
+	}
+	// The receiver's output goes to a file: nobody has to keep reading it while the
+	// coordinators run
+	char out_path[] = "/tmp/bench_gateway_XXXXXX";
+	int out_fd = mkstemp(out_path);
+	if (out_fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	fflush(stdout);
+	pid_t recv_pid = fork();
+	if (recv_pid == 0) {
+		for (uint32_t i = 0; i < s_coordinators; i++) close(masters[i]);
+		dup2(out_fd, STDOUT_FILENO);
+		char *args[MAX_COORDINATORS + 4];
+		int a = 0;
+		args[a++] = (char *)GATEWAY_RECV;
+		args[a++] = (char *)"-b";
+		args[a++] = (char *)"460800";
+		for (uint32_t i = 0; i < s_coordinators; i++) args[a++] = slaves[i];
+		args[a] = NULL;
+		execv(GATEWAY_RECV, args);
+		_exit(127);
+	}
+	close(out_fd);
+	bool ok = recv_pid > 0 && check("receiver started", wait_listening(out_path));
+
+	static coord_t coords[MAX_COORDINATORS];
+	pid_t pids[MAX_COORDINATORS];
+	int pipes[MAX_COORDINATORS];
+	for (uint32_t i = 0; ok && i < s_coordinators; i++) {
+		int fd[2];
+		if (pipe(fd) != 0) return 1;
+		fflush(stdout);
+		pids[i] = fork();
+		if (pids[i] == 0) {
+			close(fd[0]);
+			for (uint32_t j = 0; j < s_coordinators; j++) {
+				if (j != i) close(masters[j]);
+			}
+			static coord_t r;
+			run_coordinator(i, masters[i], &r);
+			ssize_t w = write(fd[1], &r, sizeof(r));
+			_exit(w == (ssize_t)sizeof(r) ? 0 : 1);
+		}
+		close(fd[1]);
+		pipes[i] = fd[0];
+	}
+	for (uint32_t i = 0; ok && i < s_coordinators; i++) {
+		size_t got = 0;
+		for (ssize_t r; got < sizeof(coords[i]) && (r = read(pipes[i], (char *)&coords[i] + got, sizeof(coords[i]) - got)) > 0;) {
+			got += (size_t)r;
+		}
+		close(pipes[i]);
+		int status = 0;
+		waitpid(pids[i], &status, 0);
+		ok = check("coordinator ran", got == sizeof(coords[i]) && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+	// Hanging up may discard what the receiver has not read yet: wait until it stops printing
+	long size = -1;
+	for (int quiet = 0; quiet < 30; sleep_ms(10)) {
+		long s = file_size(out_path);
+		quiet = s == size ? quiet + 1 : 0;
+		size = s;
+	}
+	for (uint32_t i = 0; i < s_coordinators; i++) close(masters[i]);
+	int status = 0;
+	if (recv_pid > 0) waitpid(recv_pid, &status, 0);
+	ok = check("receiver exited", recv_pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) && ok;
+
+	static heard_t heard[MAX_COORDINATORS];
+	ok = check("receiver output", parse_receiver(out_path, slaves, coords, heard)) && ok;
+	unlink(out_path);
+	if (!ok) return 1;
+
+	printf("gateway link: %u coordinator%s, %u devices each, coordinator 0 held %u s, %d baud, flush %d ms\n",
+		   s_coordinators, s_coordinators == 1 ? "" : "s", s_devices, s_hold_s, GATEWAY_LINK_BAUD, GATEWAY_LINK_FLUSH_MS);
+	printf("  %-5s %7s %7s %6s %7s %6s %7s %6s %7s %8s %8s %7s %8s %8s\n", "coord", "records", "dropped", "frames",
+		   "rec/frm", "max", "B/rec", "text", "stalls", "stall ms", "held ms", "junk", "age ms", "alert ms");
+	for (uint32_t i = 0; i < s_coordinators; i++) {
+		const coord_t *co = &coords[i];
+		const heard_t *h = &heard[i];
+		char label[64];
+		uint32_t sent = co->gw.records;
+		printf("  %-5u %7u %7u %6u %7.1f %6u %7.1f %6.1f %7u %8u %8.0f %7lu %8u %8u\n", i, sent, co->gw.dropped,
+			   co->gw.frames, co->gw.frames ? (double)h->records / co->gw.frames : 0.0, co->gw.frame_records_max,
+			   h->records ? (double)h->bytes / h->records : 0.0, h->records ? (double)h->text_bytes / h->records : 0.0,
+			   co->gw.stalls, co->gw.stall_ms, (double)co->uart.held_us / 1000.0, h->skipped, co->gw.age_max_ms,
+			   co->gw.alert_age_max_ms);
+
+		snprintf(label, sizeof(label), "coordinator %u formed and classified every device", i);
+		ok &= check(label, co->formed && co->done && co->devices == s_devices);
+		snprintf(label, sizeof(label), "coordinator %u: receiver summary", i);
+		ok &= check(label, h->summary);
+		for (int t = GWLINK_NETWORK; t < GWLINK_DROPPED; t++) {
+			snprintf(label, sizeof(label), "coordinator %u: type %d records sent %u, decoded %lu", i, t, co->gw.by_type[t],
+					 h->by_type[t]);
+			ok &= check(label, h->by_type[t] == co->gw.by_type[t]);
+		}
+		snprintf(label, sizeof(label), "coordinator %u: DROPPED records add up (%lu of %u)", i, h->dropped, co->gw.dropped);
+		ok &= check(label, h->dropped == co->gw.dropped);
+		snprintf(label, sizeof(label), "coordinator %u: no alert dropped", i);
+		ok &= check(label, co->gw.alerts_dropped == 0);
+		snprintf(label, sizeof(label), "coordinator %u: frames decoded %lu of %u, lost %lu", i, h->frames, co->gw.frames,
+				 h->lost);
+		ok &= check(label, h->frames == co->gw.frames && h->lost == 0 && h->bytes == co->gw.bytes);
+		snprintf(label, sizeof(label), "coordinator %u: skipped %lu of %u junk bytes", i, h->skipped, co->junk);
+		ok &= check(label, h->skipped == co->junk && (co->junk ? h->rejected > 0 : h->rejected == 0));
+		if (i == 0 && s_hold_s) {
+			ok &= check("held coordinator stalled on the UART", co->gw.stalls > 0 && co->uart.blocked_writes > 0);
+		}
+	}
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+// Join/interview pipeline benchmark
+// Replays a synthetic DEVICE_ANNCE storm against main/main.c linked with the simulator
+// and reports throughput, detection latency percentiles and peak heap.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+#include "device_table.h"
+#include "interview.h"
+#include "device_cache.h"
+#include "actuator.h"
+#include "latency.h"
+
+void app_main(void);
+
+typedef struct {
+	const char *manufacturer;
+	const char *model;
+	uint32_t oui;
+	bool ikea;
+	uint8_t ep_count;
+	sim_endpoint_t eps[SIM_MAX_ENDPOINTS];
+} device_kind_t;
+
+#define HA_EP(ep, dev) { .endpoint = (ep), .profile_id = 0x0104, .device_id = (dev), .in_count = 3, .out_count = 1, .clusters = {0x0000, 0x0003, 0x0006, 0x0019} }
+#define GP_EP          { .endpoint = 242, .profile_id = 0xA1E0, .device_id = 0x0061, .in_count = 0, .out_count = 1, .clusters = {0x0021} }
+
+static const device_kind_t s_ikea_kinds[] = {
+	{ "IKEA of Sweden", "TRADFRI bulb E27 WS opal 980lm", 0x000B57, true, 2, { HA_EP(1, 0x010C), GP_EP } },
+	{ "IKEA of Sweden", "TRADFRI bulb GU10 W 400lm", 0x000B57, true, 2, { HA_EP(1, 0x0101), GP_EP } },
+	{ "IKEA of Sweden", "TRADFRI Driver 30W", 0x000B57, true, 3, { HA_EP(1, 0x0101), HA_EP(2, 0x0101), GP_EP } },
+	{ "IKEA of Sweden", "TRÅDFRI bulb E14 WS 470lm", 0x000B57, true, 2, { HA_EP(1, 0x010C), GP_EP } },
+	{ "IKEA of Sweden", "TRADFRI remote control", 0x000B57, true, 1, { HA_EP(1, 0x0820) } },
+};
+
+static const device_kind_t s_other_kinds[] = {
+	{ "Philips", "LCT015", 0x001788, false, 2, { HA_EP(11, 0x010D), GP_EP } },
+	{ "LUMI", "lumi.sensor_motion.aq2", 0x00158D, false, 1, { HA_EP(1, 0x0107) } },
+	{ "SONOFF", "BASICZBR3", 0x00124B, false, 1, { HA_EP(1, 0x0100) } },
+	{ "_TZ3000_abcd1234", "TS0505B", 0xA4C138, false, 2, { HA_EP(1, 0x010D), GP_EP } },
+};
+
+typedef struct {
+	uint32_t devices;
+	uint32_t ikea_pct;
+	uint32_t spread_ms;
+	uint32_t announces;             // announces per device (rejoins after the first)
+	uint32_t rejoin_gap_ms;
+	uint32_t deadline_s;
+} bench_opts_t;
+
+static size_t s_expect_alerts;
+static uint32_t s_announces = 1;
+
+// Every announce delivered, every expected alert seen and the interview scheduler idle
+static bool all_done(void)
+{
+	size_t n = sim_device_count();
+	for (size_t i = 0; i < n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (d->announces < s_announces) return false;
+		if (d->expect_alert && !d->alerted_us) return false;
+	}
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.queue_depth == 0 && is.in_flight == 0;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+static void print_percentiles(const char *label, uint64_t *v, size_t n)
+{
+	if (n == 0) {
+		printf("%-22s n=0\n", label);
+		return;
+	}
+	qsort(v, n, sizeof(v[0]), cmp_u64);
+	#define PCT(p) ((double)v[((n - 1) * (p)) / 100] / 1000.0)
+	printf("%-22s n=%zu p50=%.1f p90=%.1f p99=%.1f max=%.1f ms\n",
+		   label, n, PCT(50), PCT(90), PCT(99), (double)v[n - 1] / 1000.0);
+	#undef PCT
+}
+
+// Firmware latency histograms, all device classes together: the same figures a field device
+// prints with the `latency` console command
+static void print_stage_latency(void)
+{
+	for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+		latency_hist_t all = { 0 }, h;
+		for (int c = 0; c < LATENCY_CLASS_COUNT; c++) {
+			latency_get((latency_stage_t)s, (latency_class_t)c, &h);
+			all.count += h.count;
+			all.sum += h.sum;
+			if (h.max > all.max) all.max = h.max;
+			for (int b = 0; b < LATENCY_BUCKETS; b++) all.buckets[b] += h.buckets[b];
+		}
+		if (!all.count) continue;
+		double scale = latency_stage_is_cycles((latency_stage_t)s) ? (double)LATENCY_CPU_MHZ : 1.0;
+		printf("stage %-18s n=%-5lu mean=%9.1f p50<%9.1f p90<%9.1f max=%9.1f us\n",
+			   latency_stage_name((latency_stage_t)s), (unsigned long)all.count,
+			   (double)all.sum / all.count / scale, latency_percentile(&all, 50) / scale,
+			   latency_percentile(&all, 90) / scale, all.max / scale);
+	}
+}
+
+static void make_devices(const bench_opts_t *o)
+{
+	for (uint32_t i = 0; i < o->devices; i++) {
+		bool ikea = (sim_rand() % 100) < o->ikea_pct;
+		const device_kind_t *k = ikea
+			? &s_ikea_kinds[sim_rand() % (sizeof(s_ikea_kinds) / sizeof(s_ikea_kinds[0]))]
+			: &s_other_kinds[sim_rand() % (sizeof(s_other_kinds) / sizeof(s_other_kinds[0]))];
+		sim_device_t d;
+		memset(&d, 0, sizeof(d));
+		do {
+			d.short_addr = (uint16_t)(1 + sim_rand() % 0xFFF6);
+		} while (sim_find_device(d.short_addr));
+		uint32_t lo = sim_rand(), mid = sim_rand();
+		sim_make_ieee(d.ieee, k->oui, lo, (uint16_t)(lo >> 24 << 8 | (mid & 0xFF)));
+		d.ep_count = k->ep_count;
+		memcpy(d.eps, k->eps, sizeof(d.eps));
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "%s", k->manufacturer);
+		snprintf(d.model, sizeof(d.model), "%s", k->model);
+		snprintf(d.sw_build, sizeof(d.sw_build), "%u.%u.%03u", 1 + sim_rand() % 2, sim_rand() % 4, sim_rand() % 100);
+		d.expect_alert = k->ikea;
+		s_expect_alerts += k->ikea;
+		sim_device_t *dev = sim_add_device(&d);
+		if (!dev) continue;
+		for (uint32_t a = 0; a < o->announces; a++) {
+			uint64_t at_ms = (uint64_t)a * o->rejoin_gap_ms + (o->spread_ms ? sim_rand() % o->spread_ms : 0);
+			sim_announce(dev, at_ms * 1000);
+		}
+	}
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+			"usage: %s [-n devices] [-i ikea_pct] [-s spread_ms] [-q aps_queue] [-l latency_ms]\n"
+			"          [-j jitter_ms] [-a announces] [-g rejoin_gap_ms] [-d deadline_s] [-r seed]\n"
+			"          [-N nvs_file] [-H] [-v]\n"
+			"  -N loads NVS from nvs_file before the run and saves it afterwards (run twice for a cold restart)\n"
+			"  -H prints the full latency histograms (as the `latency` console command does)\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	bench_opts_t o = { .devices = 50, .ikea_pct = 30, .spread_ms = 200, .announces = 1,
+					   .rejoin_gap_ms = 30000, .deadline_s = 600 };
+	const char *nvs_path = NULL;
+	bool histograms = false;
+	int c;
+	while ((c = getopt(argc, argv, "n:i:s:q:l:j:a:g:d:r:N:Hvh")) != -1) {
+		switch (c) {
+		case 'n': o.devices = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'i': o.ikea_pct = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 's': o.spread_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'q': cfg.aps_queue_len = (uint16_t)strtoul(optarg, NULL, 0); break;
+		case 'l': cfg.device_latency_us = (uint32_t)strtoul(optarg, NULL, 0) * 1000; break;
+		case 'j': cfg.device_jitter_us = (uint32_t)strtoul(optarg, NULL, 0) * 1000; break;
+		case 'a': o.announces = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'g': o.rejoin_gap_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'd': o.deadline_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'N': nvs_path = optarg; break;
+		case 'H': histograms = true; break;
+		case 'v': cfg.verbose = true; break;
+		default: usage(argv[0]); return 2;
+		}
+	}
+	if (o.devices > SIM_MAX_DEVICES) o.devices = SIM_MAX_DEVICES;
+	if (o.announces == 0) o.announces = 1;
+	s_announces = o.announces;
+
+	sim_init(&cfg);
+	bool nvs_loaded = nvs_path && sim_nvs_load(nvs_path);
+	app_main();
+	sim_rtos_start_tasks();
+	// Let the network form and steering open before the storm
+	sim_run_while(sim_network_formed, sim_now_us() + 60ULL * 1000 * 1000);
+	sim_run_until(sim_now_us() + 1000 * 1000);
+	size_t heap_after_init = sim_heap_current();
+	sim_heap_reset_peak();
+	sim_stats_t before = *sim_stats();
+	latency_reset();
+
+	uint64_t t_start = sim_now_us();
+	make_devices(&o);
+	uint64_t wall0 = sim_wall_ns();
+	bool ok = sim_run_while(all_done, t_start + (uint64_t)o.deadline_s * 1000 * 1000);
+	uint64_t wall = sim_wall_ns() - wall0;
+	const sim_stats_t *st = sim_stats();
+	size_t heap_peak = sim_heap_peak();
+
+	size_t n = sim_device_count(), interviewed = 0, alerted = 0, dup_alerts = 0, alerts = 0;
+	uint64_t makespan = 0;
+	uint64_t *det = calloc(n ? n : 1, sizeof(uint64_t));
+	uint64_t *itv = calloc(n ? n : 1, sizeof(uint64_t));
+	size_t n_det = 0, n_itv = 0;
+	for (size_t i = 0; i < n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (d->interviewed_us) {
+			interviewed++;
+			itv[n_itv++] = d->interviewed_us - d->announce_us;
+			if (d->interviewed_us - t_start > makespan) makespan = d->interviewed_us - t_start;
+		}
+		if (d->alerted_us) {
+			alerted++;
+			det[n_det++] = d->alerted_us - d->announce_us;
+			if (d->alerted_us - t_start > makespan) makespan = d->alerted_us - t_start;
+		}
+		if (d->alerts > 1) dup_alerts += d->alerts - 1;
+		alerts += d->alerts;
+	}
+
+	printf("storm: devices=%zu ikea=%zu announces=%u spread=%ums aps_queue=%u latency=%u+%ums seed=%u\n",
+		   n, s_expect_alerts, o.announces, o.spread_ms, cfg.aps_queue_len,
+		   cfg.device_latency_us / 1000, cfg.device_jitter_us / 1000, cfg.seed);
+	printf("interviewed=%zu/%zu alerted=%zu/%zu duplicate_alerts=%zu %s\n",
+		   interviewed, n, alerted, s_expect_alerts, dup_alerts, ok ? "" : "(DEADLINE HIT)");
+	printf("makespan=%.1f ms throughput=%.1f devices/s (simulated)\n",
+		   (double)makespan / 1000.0, makespan ? (double)interviewed * 1e6 / (double)makespan : 0.0);
+	print_percentiles("detection latency", det, n_det);
+	print_percentiles("interview latency", itv, n_itv);
+	printf("requests: active_ep=%u simple_desc=%u zcl_read=%u dropped=%u max_inflight=%u airtime=%.1f ms\n",
+		   st->active_ep_reqs - before.active_ep_reqs, st->simple_desc_reqs - before.simple_desc_reqs,
+		   st->zcl_read_reqs - before.zcl_read_reqs, st->dropped - before.dropped, st->max_inflight,
+		   (double)(st->airtime_us - before.airtime_us) / 1000.0);
+	interview_stats_t is;
+	interview_get_stats(&is);
+	printf("scheduler: issued=%lu completed=%lu retries=%lu timeouts=%lu failures=%lu dropped=%lu+%lu queue=%u peak=%u in_flight_peak=%u\n",
+		   (unsigned long)is.issued, (unsigned long)is.completed, (unsigned long)is.retries,
+		   (unsigned long)is.timeouts, (unsigned long)is.failures, (unsigned long)is.dropped_queue_full,
+		   (unsigned long)is.dropped_retries, is.queue_depth, is.queue_peak, is.in_flight_peak);
+	printf("interview: classified=%lu known=%lu duplicate_announces=%lu\n",
+		   (unsigned long)is.classified, (unsigned long)is.known, (unsigned long)is.duplicates);
+	device_table_stats_t ts;
+	device_table_get_stats(&ts);
+	printf("device table: entries=%u peak=%u/%u inserts=%lu evictions=%lu full=%lu addr_changes=%lu addr_conflicts=%lu\n",
+		   ts.entries, ts.peak, DEVICE_TABLE_MAX_DEVICES, (unsigned long)ts.inserts, (unsigned long)ts.evictions,
+		   (unsigned long)ts.full, (unsigned long)ts.addr_changes, (unsigned long)ts.addr_conflicts);
+	printf("host cpu: events=%llu app=%.2f ms (%.1f us/device, worst event %.1f us) wall=%.2f ms\n",
+		   (unsigned long long)(st->events - before.events),
+		   (double)(st->dispatch_ns - before.dispatch_ns) / 1e6,
+		   n ? (double)(st->dispatch_ns - before.dispatch_ns) / 1e3 / (double)n : 0.0,
+		   (double)st->max_dispatch_ns / 1e3, (double)wall / 1e6);
+	printf("heap: after_init=%zu peak=%zu bytes\n", heap_after_init, heap_peak);
+	print_stage_latency();
+	if (histograms) latency_dump();
+	// Modelled driver time (RMT refresh, LEDC update, RTOS calls) spent in the Zigbee context
+	uint64_t zb_busy = st->busy_us[SIM_CTX_ZIGBEE] - before.busy_us[SIM_CTX_ZIGBEE];
+	printf("alert output: alerts=%zu zigbee_blocked=%llu us (%.1f us/alert) led_refreshes zigbee=%lu timer=%lu task=%lu\n",
+		   alerts, (unsigned long long)zb_busy, alerts ? (double)zb_busy / (double)alerts : 0.0,
+		   (unsigned long)(st->led_refreshes[SIM_CTX_ZIGBEE] - before.led_refreshes[SIM_CTX_ZIGBEE]),
+		   (unsigned long)(st->led_refreshes[SIM_CTX_TIMER] - before.led_refreshes[SIM_CTX_TIMER]),
+		   (unsigned long)(st->led_refreshes[SIM_CTX_TASK] - before.led_refreshes[SIM_CTX_TASK]));
+	actuator_stats_t as;
+	actuator_get_stats(&as);
+	printf("actuator: posted=%lu dropped=%lu processed=%lu batches=%lu ring_peak=%u/%u max_latency=%lu us\n",
+		   (unsigned long)as.posted, (unsigned long)as.dropped, (unsigned long)as.processed,
+		   (unsigned long)as.batches, as.ring_peak, ACTUATOR_RING_LEN, (unsigned long)as.max_latency_us);
+
+	// Let the batched cache flush happen, then report flash traffic
+	sim_run_until(sim_now_us() + (DEVICE_CACHE_FLUSH_DELAY_MS + 1000) * 1000ULL);
+	device_cache_stats_t cs;
+	device_cache_get_stats(&cs);
+	const sim_nvs_stats_t *ns = sim_nvs_stats();
+	printf("device cache: %s entries=%u hits=%lu misses=%lu updates=%lu flushes=%lu chunk_writes=%lu nvs_bytes_written=%llu\n",
+		   nvs_loaded ? "warm" : "cold", cs.entries, (unsigned long)cs.hits, (unsigned long)cs.misses,
+		   (unsigned long)cs.updates, (unsigned long)cs.flushes, (unsigned long)cs.chunk_writes,
+		   (unsigned long long)ns->bytes_written);
+	if (nvs_path && !sim_nvs_save(nvs_path)) fprintf(stderr, "failed to save %s\n", nvs_path);
+	free(det);
+	free(itv);
+	return ok ? 0 : 1;
+}
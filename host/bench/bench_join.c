@@ -0,0 +1,265 @@
+// Join window benchmark
+// Runs main/main.c for hours of simulated time with bulbs joining now and then, and reports
+// permit-join broadcasts per hour, the share of time the network is open, and time to join
+// (first association attempt to device announcement) for:
+//   - pairing sessions: the join button or the console's `join`, then 1-4 bulbs powered on
+//     within 20 s
+//   - a neighbour pairing devices in their own PAN for 3 minutes, heard by the channel survey,
+//     with a bulb of ours powered on in the first two
+//   - spontaneous bulbs: powered on without a button press, found by an idle window
+//   - a join storm: 40 devices within a minute of one console `join`
+// Each kind of join has a fixed bound on its slowest join, whatever the join window is
+// configured to. The request asks for a new bulb in within a few seconds: requested joins
+// (button, console, storm) must all take under REQUESTED_MAX_S. Two kinds miss it by design and
+// are held to their own bounds instead:
+//   - a neighbour's bulb is only let in once the survey hears the neighbour's open PAN; within a
+//     2% airtime budget an active scan comes round each channel every 2 minutes, so NEIGHBOUR_MAX_S
+//   - a spontaneous bulb waits for the next idle window, at most 4 minutes away with the default
+//     back-off, so SPONTANEOUS_MAX_S; the button is the documented way to pair within seconds
+// Each bound includes one association retry (3 s). The network must also stay closed most of
+// the time (MAX_OPEN_PCT).
+// The previous firmware re-ran BDB steering 60 s after each completion: one permit-join
+// broadcast a minute and the network always open.
+// Four smart plugs join the coordinator in the formation window; bulbs join through them.
+//   bench_join [-t hours] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+#include "join_window.h"
+
+void app_main(void);
+
+#define SEC                 (1000ULL * 1000)
+#define LEGACY_PERIOD_S     (60)
+#define NEIGHBOUR_PAN       (0x5E6F)
+#define STORM_DEVICES       (40)
+#define ROUTERS             (4)
+#define NEIGHBOUR_WINDOW_S  (180)
+#define REQUESTED_MAX_S     (5)
+#define NEIGHBOUR_MAX_S     (2 * 60 + 3)
+#define SPONTANEOUS_MAX_S   (4 * 60 + 3)
+#define MAX_OPEN_PCT        (25.0)
+
+typedef enum {
+	KIND_BUTTON = 0,
+	KIND_CONSOLE,
+	KIND_NEIGHBOUR,
+	KIND_SPONTANEOUS,
+	KIND_STORM,
+	KIND_COUNT,
+} join_kind_t;
+
+static const char *const s_kind_names[KIND_COUNT] = { "button", "console", "neighbour", "spontaneous", "storm" };
+// Slowest join allowed per kind, seconds
+static const uint32_t s_kind_max_s[KIND_COUNT] = { REQUESTED_MAX_S, REQUESTED_MAX_S, NEIGHBOUR_MAX_S,
+												   SPONTANEOUS_MAX_S, REQUESTED_MAX_S };
+
+static join_kind_t s_kind[SIM_MAX_DEVICES];
+static uint32_t s_sessions[KIND_COUNT];
+static uint16_t s_next_short = 0x2000;
+static uint32_t s_storm_broadcasts_before;
+static uint32_t s_storm_broadcasts;
+static uint16_t s_routers[ROUTERS];
+
+static sim_device_t *new_bulb(join_kind_t kind)
+{
+	sim_device_t d;
+	memset(&d, 0, sizeof(d));
+	d.short_addr = s_next_short++;
+	uint32_t lo = sim_rand();
+	d.ieee[0] = (uint8_t)lo; d.ieee[1] = (uint8_t)(lo >> 8); d.ieee[2] = (uint8_t)(lo >> 16);
+	d.ieee[3] = (uint8_t)(lo >> 24); d.ieee[4] = (uint8_t)d.short_addr;
+	d.ieee[5] = 0x57; d.ieee[6] = 0x0B; d.ieee[7] = 0x00;
+	d.ep_count = 1;
+	d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0101, .in_count = 3,
+								 .clusters = { 0x0000, 0x0003, 0x0006 } };
+	snprintf(d.manufacturer, sizeof(d.manufacturer), "IKEA of Sweden");
+	snprintf(d.model, sizeof(d.model), "TRADFRI bulb E27 WW 806lm");
+	d.parent_short = s_routers[sim_rand() % ROUTERS];
+	d.lqi = (uint8_t)(120 + sim_rand() % 136);
+	sim_device_t *dev = sim_add_device(&d);
+	if (dev) s_kind[sim_device_count() - 1] = kind;
+	return dev;
+}
+
+static void add_routers(void)
+{
+	for (int i = 0; i < ROUTERS; i++) {
+		sim_device_t d;
+		memset(&d, 0, sizeof(d));
+		d.short_addr = s_routers[i] = (uint16_t)(0x1000 + i);
+		d.ieee[0] = (uint8_t)i; d.ieee[5] = 0x4B; d.ieee[6] = 0x12; d.ieee[7] = 0x00;
+		d.ep_count = 1;
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0051, .in_count = 2,
+									 .clusters = { 0x0000, 0x0006 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "SONOFF");
+		snprintf(d.model, sizeof(d.model), "S26R2ZB");
+		sim_join(sim_add_device(&d), (uint64_t)(1 + i) * SEC);
+		s_kind[sim_device_count() - 1] = KIND_COUNT;     // not reported
+	}
+}
+
+static void power_on(join_kind_t kind, size_t n, uint64_t min_us, uint64_t spread_us)
+{
+	for (size_t i = 0; i < n; i++) {
+		sim_device_t *dev = new_bulb(kind);
+		if (dev) sim_join(dev, min_us + (spread_us ? (uint64_t)sim_rand() % spread_us : 0));
+	}
+}
+
+// A user opens the network, then powers on a few bulbs
+static void session(void *ctx, uintptr_t kind)
+{
+	(void)ctx;
+	if (kind == KIND_BUTTON) {
+		sim_gpio_pulse(JOIN_WINDOW_BUTTON_GPIO, 0, 150 * 1000);
+	} else {
+		sim_console_exec("join");
+	}
+	s_sessions[kind]++;
+	power_on((join_kind_t)kind, 1 + sim_rand() % 4, 2 * SEC, 18 * SEC);
+}
+
+// A neighbour opens their network for three minutes; one of our bulbs is powered on meanwhile
+static void neighbour_close(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	sim_set_pan_open(NEIGHBOUR_PAN, false);
+}
+
+static void neighbour(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	sim_set_pan_open(NEIGHBOUR_PAN, true);
+	sim_schedule(NEIGHBOUR_WINDOW_S * SEC, neighbour_close, NULL, 0);
+	s_sessions[KIND_NEIGHBOUR]++;
+	power_on(KIND_NEIGHBOUR, 1, 0, 120 * SEC);
+}
+
+static void spontaneous(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	s_sessions[KIND_SPONTANEOUS]++;
+	power_on(KIND_SPONTANEOUS, 1, 0, 0);
+}
+
+static void storm_end(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	join_window_stats_t js;
+	join_window_get_stats(&js);
+	s_storm_broadcasts = js.broadcasts - s_storm_broadcasts_before;
+}
+
+static void storm(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	join_window_stats_t js;
+	join_window_get_stats(&js);
+	s_storm_broadcasts_before = js.broadcasts;
+	sim_console_exec("join");
+	s_sessions[KIND_STORM]++;
+	power_on(KIND_STORM, STORM_DEVICES, SEC, 60 * SEC);
+	sim_schedule(5 * 60 * SEC, storm_end, NULL, 0);
+}
+
+// Uniformly within [from, to)
+static uint64_t at(uint64_t from, uint64_t to)
+{
+	return from + (((uint64_t)sim_rand() << 32) | sim_rand()) % (to - from);
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	uint32_t hours = 24;
+	int c;
+	while ((c = getopt(argc, argv, "t:r:vh")) != -1) {
+		switch (c) {
+		case 't': hours = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-t hours] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (hours < 2) hours = 2;
+
+	sim_init(&cfg);
+	sim_add_pan(20, NEIGHBOUR_PAN, false);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + 60 * SEC);
+	add_routers();
+	uint64_t t0 = sim_now_us();
+	uint64_t end = t0 + hours * 3600 * SEC;
+
+	// Leave the first 10 minutes to the formation window, and an hour at the end for the last
+	// spontaneous bulb to be found
+	uint64_t from = t0 + 600 * SEC, to = end - 3600 * SEC;
+	for (uint32_t i = 0; i < hours / 3; i++) sim_schedule(at(from, to) - t0, session, NULL, KIND_BUTTON + i % 2);
+	for (uint32_t i = 0; i < hours / 2; i++) sim_schedule(at(from, to) - t0, neighbour, NULL, 0);
+	for (uint32_t i = 0; i < hours; i++) sim_schedule(at(from, to) - t0, spontaneous, NULL, 0);
+	sim_schedule((from + to) / 2 - t0, storm, NULL, 0);
+	sim_run_until(end);
+
+	join_window_stats_t js;
+	join_window_get_stats(&js);
+	double elapsed_s = (double)(sim_now_us() - t0) / 1e6;
+	double per_hour = js.broadcasts * 3600.0 / elapsed_s;
+	double open_pct = (double)js.open_us / 1e6 * 100.0 / elapsed_s;
+	printf("%u h simulated after formation\n", hours);
+	printf("join window: %lu windows, open %.1f%% of the time, idle interval now %lu s\n",
+		   (unsigned long)js.windows, open_pct, (unsigned long)js.idle_interval_s);
+	printf("permit-join broadcasts: %lu (%.1f/h):", (unsigned long)js.broadcasts, per_hour);
+	for (int i = 0; i < JOIN_WINDOW_SRC_COUNT; i++) {
+		printf(" %s %lu", join_window_src_name((join_window_src_t)i), (unsigned long)js.by_source[i]);
+	}
+	printf("\nstorm of %d devices: %lu broadcast(s)\n", STORM_DEVICES, (unsigned long)s_storm_broadcasts);
+	printf("time to join (first association attempt to announce):\n");
+
+	bool ok = true;
+	for (int k = 0; k < KIND_COUNT; k++) {
+		uint64_t sum = 0, max = 0;
+		size_t n = 0, joined = 0, attempts = 0;
+		for (size_t i = 0; i < sim_device_count(); i++) {
+			const sim_device_t *d = sim_device_at(i);
+			if (s_kind[i] != (join_kind_t)k || !d->join_start_us) continue;
+			n++;
+			attempts += d->join_attempts;
+			if (!d->announce_us) continue;
+			uint64_t lat = d->announce_us - d->join_start_us;
+			sum += lat;
+			if (lat > max) max = lat;
+			joined++;
+		}
+		double avg_s = joined ? (double)sum / (double)joined / 1e6 : 0.0;
+		printf("  %-12s sessions %3lu  devices %3zu  joined %3zu  attempts/device %5.1f  avg %7.1f s  max %7.1f s"
+			   "  (bound %lu s)\n", s_kind_names[k], (unsigned long)s_sessions[k], n, joined,
+			   n ? (double)attempts / (double)n : 0.0, avg_s, (double)max / 1e6, (unsigned long)s_kind_max_s[k]);
+		if (joined != n || max > (uint64_t)s_kind_max_s[k] * SEC) {
+			printf("FAIL: %s joins too slow (avg %.1f s, max %.1f s, bound %lu s), %zu of %zu joined\n",
+				   s_kind_names[k], avg_s, (double)max / 1e6, (unsigned long)s_kind_max_s[k], joined, n);
+			ok = false;
+		}
+	}
+	// Unless built with the opt-in that keeps it open on purpose
+	if (!JOIN_WINDOW_MOSTLY_OPEN && open_pct > MAX_OPEN_PCT) {
+		printf("FAIL: network open %.1f%% of the time (at most %.0f%%)\n", open_pct, MAX_OPEN_PCT);
+		ok = false;
+	}
+	printf("previous steering loop: %.1f broadcasts/h, open 100%% of the time, every bulb in within ~3 s\n",
+		   3600.0 / LEGACY_PERIOD_S);
+	ok = ok && per_hour < 3600.0 / LEGACY_PERIOD_S;
+	return ok ? 0 : 1;
+}
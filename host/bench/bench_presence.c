@@ -0,0 +1,252 @@
+// Presence benchmark
+// Runs main/main.c with the simulator: bulbs join and are classified, then presence.c binds
+// them and configures On/Off reporting. Reports the setup traffic, the steady-state air cost of
+// the reports against polling every device with a Basic read each heartbeat, and checks:
+// - a device whose power is cut without leaving is marked offline within the missed-report
+//   limit, and back on its first report after power returns
+// - a firmware update (new SW build ID) is re-read and changes the device's fingerprint, both
+//   after a power cycle and while the device stays online (Basic report)
+// - a device refusing Basic reporting still reports On/Off; one refusing Bind is not reporting
+//   bench_presence [-n devices] [-t minutes] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+#include "device_table.h"
+#include "interview.h"
+#include "presence.h"
+#include "metrics.h"
+
+void app_main(void);
+
+#define FIRST_SHORT         (0x2000)
+#define MIN_US              (60ULL * 1000 * 1000)
+#define OFFLINE_LIMIT_US    ((uint64_t)PRESENCE_HEARTBEAT_S * PRESENCE_MISSED_REPORTS * 1000 * 1000)
+
+static size_t s_n;
+static size_t s_candidates;
+
+static sim_device_t *add_bulb(size_t i, bool on_off)
+{
+	sim_device_t d;
+	memset(&d, 0, sizeof(d));
+	d.short_addr = (uint16_t)(FIRST_SHORT + i);
+	d.ieee[0] = (uint8_t)i;
+	d.ieee[1] = (uint8_t)(i >> 8);
+	d.ieee[7] = 0x33;
+	d.ep_count = 1;
+	if (on_off) {
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0100, .in_count = 3,
+									 .out_count = 1, .clusters = { 0x0000, 0x0003, 0x0006, 0x0019 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "SONOFF");
+		snprintf(d.model, sizeof(d.model), "BASICZBR3");
+	} else {
+		// A sensor: nothing to report On/Off from
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0107, .in_count = 2,
+									 .clusters = { 0x0000, 0x0406 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "LUMI");
+		snprintf(d.model, sizeof(d.model), "lumi.sensor_motion.aq2");
+	}
+	snprintf(d.sw_build, sizeof(d.sw_build), "1.0.%zu", i % 7);
+	return sim_add_device(&d);
+}
+
+static bool setup_done(void)
+{
+	presence_stats_t ps;
+	presence_get_stats(&ps);
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.classified == s_n && ps.subscribed + ps.refused == s_candidates;
+}
+
+static const device_entry_t *entry(const sim_device_t *d)
+{
+	return device_table_find_short(d->short_addr);
+}
+
+static sim_device_t *s_watch;
+static uint8_t s_watch_flag;
+static bool s_watch_set;
+
+static bool watch_done(void)
+{
+	const device_entry_t *e = entry(s_watch);
+	return e && ((e->flags & s_watch_flag) != 0) == s_watch_set;
+}
+
+// Run until the device's flag is set (or cleared); returns the time it took, or 0 on the deadline
+static uint64_t wait_flag(sim_device_t *d, uint8_t flag, bool set, uint64_t limit_us)
+{
+	s_watch = d;
+	s_watch_flag = flag;
+	s_watch_set = set;
+	uint64_t t0 = sim_now_us();
+	return sim_run_while(watch_done, t0 + limit_us) ? sim_now_us() - t0 : 0;
+}
+
+static sim_device_t *s_fw_dev;
+static uint32_t s_fw_before;
+
+static bool fw_changed(void)
+{
+	const device_entry_t *e = entry(s_fw_dev);
+	return e && e->fw_fingerprint && e->fw_fingerprint != s_fw_before;
+}
+
+// New SW build on dev, while it stays online or across a power cycle; true when the fingerprint changed
+static bool firmware_update(sim_device_t *dev, const char *build, bool power_cycle, uint64_t *took_us)
+{
+	s_fw_dev = dev;
+	s_fw_before = entry(dev)->fw_fingerprint;
+	uint64_t t0 = sim_now_us();
+	if (power_cycle) {
+		sim_power(dev, false, false);
+		sim_set_sw_build(dev, build);
+		sim_run_until(sim_now_us() + 30ULL * 1000 * 1000);
+		t0 = sim_now_us();
+		sim_power(dev, true, false);
+	} else {
+		sim_set_sw_build(dev, build);
+	}
+	bool ok = sim_run_while(fw_changed, t0 + MIN_US);
+	*took_us = sim_now_us() - t0;
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	uint32_t minutes = 60;
+	s_n = 40;
+	int c;
+	while ((c = getopt(argc, argv, "n:t:r:vh")) != -1) {
+		switch (c) {
+		case 'n': s_n = (size_t)strtoul(optarg, NULL, 0); break;
+		case 't': minutes = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-n devices] [-t minutes] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (s_n < 8) s_n = 8;
+
+	sim_init(&cfg);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + MIN_US);
+
+	// Every eighth device a sensor; one bulb refuses Basic reporting, one refuses Bind
+	sim_device_t *basic_refuser = NULL, *bind_refuser = NULL, *cut = NULL, *fw_online = NULL;
+	for (size_t i = 0; i < s_n; i++) {
+		bool bulb = i % 8 != 7;
+		sim_device_t *d = add_bulb(i, bulb);
+		if (!d) return 1;
+		s_candidates += bulb;
+		if (i == 1) basic_refuser = d;
+		if (i == 2) bind_refuser = d;
+		if (i == 3) cut = d;
+		if (i == 4) fw_online = d;
+		sim_announce(d, (uint64_t)(sim_rand() % 5000) * 1000);
+	}
+	basic_refuser->basic_unreportable = true;
+	bind_refuser->bind_unsupported = true;
+
+	const sim_stats_t *st = sim_stats();
+	uint64_t t0 = sim_now_us();
+	bool setup_ok = sim_run_while(setup_done, t0 + 10 * MIN_US);
+	presence_stats_t ps;
+	presence_get_stats(&ps);
+	printf("setup: %zu devices (%zu with On/Off) in %.1f s: %lu subscribed, %lu refused, %lu without Basic reporting, "
+		   "%lu bind + %lu configure reporting requests\n", s_n, s_candidates, (double)(sim_now_us() - t0) / 1e6,
+		   (unsigned long)ps.subscribed, (unsigned long)ps.refused, (unsigned long)ps.basic_refused,
+		   (unsigned long)st->bind_reqs, (unsigned long)st->config_report_reqs);
+	bool ok = setup_ok && ps.subscribed == s_candidates - 1 && ps.refused == 1 && ps.basic_refused == 1;
+	size_t bad_config = 0;
+	for (size_t i = 0; i < s_n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		bool want = d != bind_refuser && d->eps[0].in_count == 3;
+		bool reporting = d->onoff_bound && d->onoff_max_s == PRESENCE_HEARTBEAT_S;
+		bool basic = d->basic_bound && d->basic_reporting;
+		if (reporting != want || basic != (want && d != basic_refuser)) bad_config++;
+	}
+	const device_entry_t *refused = entry(bind_refuser);
+	if (bad_config || !refused || !(refused->flags & DEVICE_FLAG_NO_REPORTING)) {
+		printf("FAIL: %zu devices configured wrong, Bind refuser %s\n", bad_config,
+			   refused && (refused->flags & DEVICE_FLAG_NO_REPORTING) ? "ok" : "not marked");
+		ok = false;
+	}
+
+	// Steady state: the reports are all the traffic presence needs
+	metrics_snapshot_t m0, m1;
+	metrics_snapshot(&m0);
+	uint32_t frames0 = st->mac_frames, reports0 = st->reports;
+	uint64_t air0 = st->airtime_us;
+	sim_run_until(sim_now_us() + (uint64_t)minutes * MIN_US);
+	metrics_snapshot(&m1);
+	presence_get_stats(&ps);
+	uint32_t reports = st->reports - reports0, frames = st->mac_frames - frames0;
+	uint64_t air = st->airtime_us - air0;
+	uint32_t polls = 0;
+	for (int r = METRICS_REQ_ACTIVE_EP; r <= METRICS_REQ_READ_ATTR; r++) {
+		polls += m1.requests[r][METRICS_ISSUED] - m0.requests[r][METRICS_ISSUED];
+	}
+	polls += m1.requests[METRICS_REQ_BIND][METRICS_ISSUED] - m0.requests[METRICS_REQ_BIND][METRICS_ISSUED];
+	polls += m1.requests[METRICS_REQ_CONFIG_REPORT][METRICS_ISSUED] -
+			 m0.requests[METRICS_REQ_CONFIG_REPORT][METRICS_ISSUED];
+	// Polling: a Basic read request and its response per device and heartbeat
+	double per_frame_us = frames ? (double)air / frames : 0.0;
+	uint64_t poll_frames = 2ULL * (s_candidates - 1) * ((uint64_t)minutes * 60 / PRESENCE_HEARTBEAT_S);
+	printf("steady state, %u min: %lu reports, %lu frames, %.2f s airtime (%.3f%%), %lu app requests, %lu went "
+		   "offline\n", minutes, (unsigned long)reports, (unsigned long)frames, (double)air / 1e6,
+		   100.0 * (double)air / ((double)minutes * 60e6), (unsigned long)polls, (unsigned long)ps.went_offline);
+	printf("polling every %u s instead: %llu frames (%.2f s airtime), %llu requests through the APS queue\n",
+		   (unsigned)PRESENCE_HEARTBEAT_S, (unsigned long long)poll_frames, poll_frames * per_frame_us / 1e6,
+		   (unsigned long long)(poll_frames / 2));
+	if (polls || ps.went_offline || ps.reporting != s_candidates - 1 || reports < poll_frames / 2) {
+		printf("FAIL: steady state not quiet or reports missing\n");
+		ok = false;
+	}
+
+	// Power cut without leaving the network
+	sim_power(cut, false, false);
+	uint64_t offline_us = wait_flag(cut, DEVICE_FLAG_OFFLINE, true, OFFLINE_LIMIT_US + 2 * MIN_US +
+									(uint64_t)PRESENCE_HEARTBEAT_S * 1000 * 1000);
+	sim_run_until(sim_now_us() + 2 * MIN_US);
+	uint16_t reads_before = cut->basic_reads;
+	sim_power(cut, true, false);
+	uint64_t back_us = wait_flag(cut, DEVICE_FLAG_OFFLINE, false, MIN_US);
+	sim_run_until(sim_now_us() + 10ULL * 1000 * 1000);
+	presence_get_stats(&ps);
+	printf("power cut: offline after %.0f s (limit %u x %u s), back %.1f s after power-on, %u Basic re-read\n",
+		   (double)offline_us / 1e6, (unsigned)PRESENCE_MISSED_REPORTS, (unsigned)PRESENCE_HEARTBEAT_S,
+		   (double)back_us / 1e6, cut->basic_reads - reads_before);
+	if (!offline_us || !back_us || ps.went_offline != 1 || ps.came_back != 1 || cut->basic_reads != reads_before + 1) {
+		printf("FAIL: power cut not followed\n");
+		ok = false;
+	}
+
+	// Firmware updates
+	uint64_t fw_cycle_us = 0, fw_online_us = 0;
+	bool fw1 = firmware_update(cut, "2.0.0", true, &fw_cycle_us);
+	bool fw2 = firmware_update(fw_online, "2.0.1", false, &fw_online_us);
+	printf("firmware update: re-read %.1f s after power-on, %.2f s after a Basic report while online\n",
+		   (double)fw_cycle_us / 1e6, (double)fw_online_us / 1e6);
+	if (!fw1 || !fw2) {
+		printf("FAIL: firmware update %s not seen\n", fw1 ? "while online" : "across a power cycle");
+		ok = false;
+	}
+	interview_stats_t is;
+	interview_get_stats(&is);
+	presence_get_stats(&ps);
+	printf("presence: %lu reports, %lu re-reads (%lu refreshes), %u reporting, %u offline\n",
+		   (unsigned long)ps.reports, (unsigned long)ps.fw_rereads, (unsigned long)is.refreshes, ps.reporting,
+		   ps.offline);
+	if (ps.reports_unknown || is.refreshes != ps.fw_rereads || ps.offline) ok = false;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+// Rejoin benchmark
+// Runs main/main.c with the simulator: bulbs and plugs join (a quarter of them through a router)
+// and are interviewed once. Then checks, with the announce to LED-red latency of every alert:
+// - a known bulb leaving and rejoining, at its short address or a new one, is identified from
+//   its IEEE address without an interview request, within REJOIN_TARGET_US
+// - a device announcing at the short address of a bulb whose interview is in flight takes the
+//   address over: it gets its own verdict, and the bulb starts over when it announces again
+// - a bulb leaving for good keeps its verdict for when it joins again
+// - a bulb the device table lost is found again from its next report, through the stack's
+//   address map, and one that moved without announcing through an IEEE_addr_req
+//   bench_rejoin [-n devices] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+#include "device_table.h"
+#include "interview.h"
+#include "presence.h"
+#include "address.h"
+#include "actuator.h"
+
+void app_main(void);
+
+#define FIRST_SHORT         (0x3000)
+#define MOVED_SHORT         (0x5000)    // short addresses given out on rejoin
+#define SEC                 (1000ULL * 1000)
+#define REJOIN_TARGET_US    (50 * 1000)
+#define REJOIN_TRIALS       (6)
+
+static size_t s_n;
+static size_t s_added;
+static bool s_ok = true;
+
+static sim_device_t *add_device(bool bulb, uint16_t parent_short)
+{
+	sim_device_t d;
+	memset(&d, 0, sizeof(d));
+	d.short_addr = (uint16_t)(FIRST_SHORT + s_added);
+	d.ieee[0] = (uint8_t)s_added;
+	d.ieee[1] = (uint8_t)(s_added >> 8);
+	d.ieee[7] = 0x44;
+	d.parent_short = parent_short;
+	d.ep_count = 1;
+	d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0100, .in_count = 4,
+								 .out_count = 1, .clusters = { 0x0000, 0x0003, 0x0006, 0x0008, 0x0019 } };
+	if (bulb) {
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "IKEA of Sweden");
+		snprintf(d.model, sizeof(d.model), "TRADFRI bulb E27 WW 806lm");
+	} else {
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "SONOFF");
+		snprintf(d.model, sizeof(d.model), "BASICZBR3");
+	}
+	snprintf(d.sw_build, sizeof(d.sw_build), "2.3.%zu", s_added % 5);
+	d.expect_alert = bulb;
+	s_added++;
+	return sim_add_device(&d);
+}
+
+static const device_entry_t *entry(const sim_device_t *d)
+{
+	const device_entry_t *e = device_table_find_short(d->short_addr);
+	return e && memcmp(e->ieee, d->ieee, sizeof(e->ieee)) == 0 ? e : NULL;
+}
+
+static void check(bool cond, const char *what)
+{
+	if (cond) return;
+	printf("FAIL: %s\n", what);
+	s_ok = false;
+}
+
+static bool all_classified(void)
+{
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.classified == s_n;
+}
+
+static bool presence_idle(void)
+{
+	presence_stats_t ps;
+	presence_get_stats(&ps);
+	return ps.subscribed + ps.refused >= s_n;
+}
+
+static bool led_red(void)
+{
+	return sim_led_color() == 0xFF0000;
+}
+
+static bool led_green(void)
+{
+	return !led_red();
+}
+
+static const sim_device_t *s_watch;
+static uint16_t s_watch_count;
+
+static bool announced(void)
+{
+	return s_watch->announces > s_watch_count;
+}
+
+static uint32_t interview_reqs(void)
+{
+	const sim_stats_t *st = sim_stats();
+	return st->active_ep_reqs + st->simple_desc_reqs + st->zcl_read_reqs;
+}
+
+// Wait for dev's next announce, then for the LED to turn red; returns announce to red, 0 if it did not
+static uint64_t announce_to_alert(const sim_device_t *dev)
+{
+	s_watch = dev;
+	s_watch_count = dev->announces;
+	if (!sim_run_while(announced, sim_now_us() + 10 * SEC)) return 0;
+	uint64_t t0 = sim_now_us();
+	if (!sim_run_while(led_red, t0 + SEC)) return 0;
+	return sim_now_us() - t0;
+}
+
+// Let the previous alert run out so the next one shows on the LED
+static void wait_idle(void)
+{
+	sim_run_while(led_green, sim_now_us() + (uint64_t)ALERT_DURATION_MS * 1000 + SEC);
+	sim_run_until(sim_now_us() + SEC);
+}
+
+static uint64_t s_lat_max, s_lat_sum;
+static uint32_t s_lat_n;
+
+static void note_latency(uint64_t us)
+{
+	if (us > s_lat_max) s_lat_max = us;
+	s_lat_sum += us;
+	s_lat_n++;
+}
+
+// Known bulb leaves and rejoins; new_short 0 keeps its address
+static void rejoin(sim_device_t *d, uint16_t new_short)
+{
+	wait_idle();
+	uint32_t reqs0 = interview_reqs();
+	uint16_t old_short = d->short_addr;
+	sim_leave(d, true, 0);
+	sim_run_until(sim_now_us() + 1000);
+	if (new_short) sim_set_short(d, new_short);
+	uint64_t us = announce_to_alert(d);
+	note_latency(us);
+	const device_entry_t *e = entry(d);
+	bool moved_ok = !new_short || !device_table_find_short(old_short);
+	check(us && us < REJOIN_TARGET_US, "known bulb not alerted within the target after rejoin");
+	check(interview_reqs() == reqs0, "known bulb interviewed again after rejoin");
+	check(e && e->verdict == INTERVIEW_VERDICT_MATCH && moved_ok, "rejoined bulb not at its new address");
+}
+
+static const sim_device_t *s_pending_dev;
+
+static bool request_out(void)
+{
+	return s_pending_dev->active_ep_reqs > 0;
+}
+
+static const device_entry_t *s_entry;
+
+static bool entry_classified(void)
+{
+	return s_entry && s_entry->state == DEVICE_STATE_DONE;
+}
+
+static bool found_again(void)
+{
+	const device_entry_t *e = entry(s_watch);
+	return e && e->state == DEVICE_STATE_DONE;
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	s_n = 24;
+	int c;
+	while ((c = getopt(argc, argv, "n:r:vh")) != -1) {
+		switch (c) {
+		case 'n': s_n = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-n devices] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (s_n < 12) s_n = 12;
+
+	sim_init(&cfg);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + 60 * SEC);
+
+	// A plug as router first; two bulbs out of three; every fourth device behind the router
+	sim_device_t *router = add_device(false, 0);
+	sim_announce(router, 0);
+	for (size_t i = 1; i < s_n; i++) {
+		sim_device_t *d = add_device(i % 3 != 0, i % 4 == 3 ? router->short_addr : 0);
+		sim_announce(d, SEC + (uint64_t)(sim_rand() % 4000) * 1000);
+	}
+	bool joined = sim_run_while(all_classified, sim_now_us() + 120 * SEC);
+	sim_run_while(presence_idle, sim_now_us() + 120 * SEC);
+	uint64_t first_sum = 0, first_max = 0;
+	uint32_t bulbs = 0;
+	for (size_t i = 0; i < s_n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (!d->expect_alert || !d->alerted_us) continue;
+		uint64_t us = d->alerted_us - d->announce_us;
+		first_sum += us;
+		if (us > first_max) first_max = us;
+		bulbs++;
+	}
+	printf("first join: %zu devices, %u bulbs alerted after their interview: %.1f ms mean, %.1f ms max\n", s_n,
+		   bulbs, bulbs ? (double)first_sum / bulbs / 1e3 : 0.0, (double)first_max / 1e3);
+	check(joined && bulbs == (s_n - 1) - (s_n - 1) / 3, "first joins not all classified");
+
+	// Known bulbs rejoin: at their address, at a new one, directly and behind the router
+	sim_device_t *bulb_list[REJOIN_TRIALS + 4];
+	size_t nb = 0;
+	for (size_t i = 0; i < s_n && nb < REJOIN_TRIALS + 4; i++) {
+		sim_device_t *d = sim_device_at(i);
+		if (d->expect_alert) bulb_list[nb++] = d;
+	}
+	check(nb == REJOIN_TRIALS + 4, "not enough bulbs");
+	if (!s_ok) return 1;
+	for (size_t t = 0; t < REJOIN_TRIALS; t++) rejoin(bulb_list[t], t % 2 ? (uint16_t)(MOVED_SHORT + t) : 0);
+	printf("rejoin of a known bulb: %u trials, announce to LED red %.0f us mean, %llu us max (target %u ms), "
+		   "no interview request\n", s_lat_n, s_lat_n ? (double)s_lat_sum / s_lat_n : 0.0,
+		   (unsigned long long)s_lat_max, REJOIN_TARGET_US / 1000);
+
+	// Takeover while an interview is in flight: a new bulb moves away unannounced and a plug
+	// announces at its old address before the bulb's ActiveEP is answered
+	wait_idle();
+	device_table_stats_t ds0, ds1;
+	device_table_get_stats(&ds0);
+	sim_device_t *moving = add_device(true, 0);
+	uint16_t taken = moving->short_addr;
+	sim_announce(moving, 0);
+	s_pending_dev = moving;
+	sim_run_while(request_out, sim_now_us() + 5 * SEC);
+	const device_entry_t *moving_e = entry(moving);
+	sim_set_short(moving, (uint16_t)(MOVED_SHORT + 0x100));
+	sim_device_t *taker = add_device(false, 0);
+	sim_set_short(taker, taken);
+	sim_announce(taker, 0);
+	s_watch = taker;
+	bool taker_done = sim_run_while(found_again, sim_now_us() + 60 * SEC);
+	sim_run_until(sim_now_us() + 10 * SEC);
+	const device_entry_t *taker_e = entry(taker);
+	device_table_get_stats(&ds1);
+	bool moving_reset = moving_e && moving_e->short_addr == DEVICE_TABLE_NO_ADDR &&
+						moving_e->state == DEVICE_STATE_NEW && moving_e->verdict == INTERVIEW_VERDICT_NONE;
+	printf("takeover: plug took 0x%04X from a bulb being interviewed: plug %s, %u alert(s) raised for it, "
+		   "bulb %s\n", taken, taker_e && taker_e->verdict == INTERVIEW_VERDICT_OTHER ? "classified as other" : "wrong",
+		   taker->alerts, moving_reset ? "forgotten until it announces" : "still interviewed");
+	check(taker_done && taker_e && taker_e->verdict == INTERVIEW_VERDICT_OTHER && !taker->alerts,
+		  "device taking over an address got a wrong verdict");
+	check(moving_reset && ds1.addr_conflicts == ds0.addr_conflicts + 1, "previous owner not released");
+	s_entry = moving_e;
+	sim_announce(moving, 0);
+	bool moving_done = sim_run_while(entry_classified, sim_now_us() + 60 * SEC);
+	check(moving_done && entry(moving) && entry(moving)->verdict == INTERVIEW_VERDICT_MATCH && moving->alerts,
+		  "bulb not identified after announcing at its new address");
+
+	// Leave for good, join again later
+	wait_idle();
+	sim_device_t *leaver = bulb_list[REJOIN_TRIALS];
+	const device_entry_t *leaver_e = entry(leaver);
+	sim_leave(leaver, false, 0);
+	sim_run_until(sim_now_us() + 30 * SEC);
+	bool released = leaver_e && leaver_e->short_addr == DEVICE_TABLE_NO_ADDR &&
+					!(leaver_e->flags & DEVICE_FLAG_REPORTING) && leaver_e->verdict == INTERVIEW_VERDICT_MATCH;
+	uint32_t reqs0 = interview_reqs();
+	sim_announce(leaver, 0);
+	uint64_t back_us = announce_to_alert(leaver);
+	sim_run_until(sim_now_us() + 10 * SEC);
+	printf("leave: address released, verdict kept; joined again: LED red %llu us after the announce, %u interview "
+		   "requests, reporting set up again: %s\n", (unsigned long long)back_us, interview_reqs() - reqs0,
+		   leaver->onoff_bound ? "yes" : "no");
+	check(released, "leaving device not released");
+	check(back_us && back_us < REJOIN_TARGET_US && interview_reqs() == reqs0 && leaver->onoff_bound,
+		  "device joining again after a leave not identified from its IEEE address");
+
+	// A bulb the table lost reports: resolved from the stack's address map
+	wait_idle();
+	sim_device_t *lost = bulb_list[REJOIN_TRIALS + 1];
+	uint16_t alerts0 = lost->alerts;
+	device_table_remove((device_entry_t *)entry(lost));
+	s_watch = lost;
+	uint64_t t0 = sim_now_us();
+	bool lost_found = sim_run_while(found_again, t0 + 2ULL * PRESENCE_HEARTBEAT_S * SEC);
+	uint64_t lost_us = sim_now_us() - t0;
+	sim_run_until(sim_now_us() + SEC);
+	address_stats_t as;
+	address_get_stats(&as);
+	printf("lost from the table: found from its report after %.0f s through the address map, alerted again: %s\n",
+		   (double)lost_us / 1e6, lost->alerts > alerts0 ? "yes" : "no");
+	check(lost_found && as.resolved_local == 1 && !lost->ieee_addr_reqs && lost->alerts > alerts0,
+		  "lost device not resolved from the address map");
+
+	// A bulb moved without announcing: resolved over the air, same entry
+	sim_device_t *mover = bulb_list[REJOIN_TRIALS + 2];
+	const device_entry_t *mover_e = entry(mover);
+	sim_set_short(mover, (uint16_t)(MOVED_SHORT + 0x200));
+	s_watch = mover;
+	t0 = sim_now_us();
+	bool mover_found = sim_run_while(found_again, t0 + 2ULL * PRESENCE_HEARTBEAT_S * SEC);
+	address_get_stats(&as);
+	printf("moved unannounced: found at 0x%04X from its report after %.0f s, %u IEEE_addr_req\n", mover->short_addr,
+		   (double)(sim_now_us() - t0) / 1e6, mover->ieee_addr_reqs);
+	check(mover_found && entry(mover) == mover_e && as.resolved_air == 1 && mover->ieee_addr_reqs == 1,
+		  "moved device not resolved over the air");
+
+	presence_stats_t ps;
+	presence_get_stats(&ps);
+	printf("address: %lu leaves (%lu rejoin), %lu resolved locally, %lu over the air, %lu failed; %lu reports from "
+		   "unknown senders\n", (unsigned long)as.leaves, (unsigned long)as.rejoins, (unsigned long)as.resolved_local,
+		   (unsigned long)as.resolved_air, (unsigned long)as.resolve_failed, (unsigned long)ps.reports_unknown);
+	check(!as.resolve_failed, "address resolution failed");
+	return s_ok ? 0 : 1;
+}
@@ -0,0 +1,553 @@
+// Replay benchmark
+// Replays a site session against main/main.c. The trace is exported from the site's `evlog`
+// partition with `evlog_decode -t` (format in host/tools/evlog_decode.c):
+// - every device is rebuilt in the simulator from its recorded answers (endpoints, simple
+//   descriptors, Basic strings), with the shortest request round trip seen in the trace as its
+//   turnaround; devices that joined without answering anything were classified before the
+//   capture and go into the device cache with the verdict their alerts imply
+// - joins (at the recorded short address and parent), leaves, power cuts and firmware updates
+//   happen at their recorded times on the virtual clock, relative to network formation
+// - the replay's own event log goes through evlog_decode -t again, and the alerts of every
+//   device (by IEEE address and source) must be those of the trace
+// Reports the wall-clock speedup over the recorded span and the processing cost per event.
+//   bench_replay [-r seed] [-v] [trace]
+// Without a trace, replays bench/data/trace_site.txt. Exits 1 when the alerts differ.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "sim.h"
+#include "device_cache.h"
+#include "event_log.h"
+
+void app_main(void);
+
+#define SEC                 (1000ULL * 1000)
+#define SETTLE_US           (60 * SEC)      // run on after the last event: alerts, flushes
+#define ALERT_SOURCES       (2)             // interview, cache
+#define ADDR_COUNT          (0x10000)
+
+typedef enum {
+	EV_FORMED,
+	EV_JOIN,
+	EV_EP,
+	EV_DESC,
+	EV_ATTR,
+	EV_ALERT,
+	EV_LEAVE,
+	EV_OFF,
+	EV_ON,
+} ev_kind_t;
+
+typedef struct {
+	uint64_t ms;
+	uint32_t line;                  // line number: keeps the file order of events at the same time
+	ev_kind_t kind;
+	int32_t dev;                    // device index once resolved, -1 when unknown
+	uint16_t short_addr;
+	uint16_t parent_short;          // join: 0 for the coordinator's children
+	uint8_t ieee[8];
+	uint8_t capability;
+	uint8_t endpoint;
+	uint8_t count;                  // endpoints or input clusters
+	uint8_t eps[SIM_MAX_ENDPOINTS];
+	uint16_t profile_id, device_id;
+	uint16_t clusters[8];
+	uint16_t cluster, attr_id;
+	char str[SIM_STR_MAX];          // attr: string value
+	bool is_string;
+	bool new_build;                 // attr: SW build ID changed since the interview (firmware update)
+	uint8_t source;                 // alert: 0 interview, 1 cache
+} trace_ev_t;
+
+typedef struct {
+	uint8_t ieee[8];
+	sim_device_t model;
+	sim_device_t *sim;
+	bool answered;                  // ActiveEP, SimpleDesc or Basic answers in the trace
+	uint64_t last_ms;               // last join or answer
+	uint64_t min_gap_ms;            // shortest gap between a join or answer and the next answer
+	uint16_t alerts[ALERT_SOURCES];
+	uint64_t first_alert_ms;
+} trace_dev_t;
+
+typedef struct {
+	trace_ev_t *evs;
+	size_t n_evs, cap_evs;
+	trace_dev_t *devs;
+	size_t n_devs, cap_devs;
+	bool formed;
+	uint64_t formed_ms;
+	uint32_t unresolved;            // events from a short address no join had given out
+} trace_t;
+
+static sim_config_t s_cfg;
+static trace_t s_trace;
+static int32_t s_by_short[ADDR_COUNT];
+static size_t s_next;               // next event to replay
+static int64_t s_offset_us;         // replay time - recorded time
+
+// ---- Trace parsing ------------------------------------------------------------------
+
+static bool parse_ieee(const char *s, uint8_t ieee[8])
+{
+	unsigned b[8];
+	if (sscanf(s, "%2x:%2x:%2x:%2x:%2x:%2x:%2x:%2x", &b[7], &b[6], &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]) != 8) {
+		return false;
+	}
+	for (int i = 0; i < 8; i++) ieee[i] = (uint8_t)b[i];
+	return true;
+}
+
+// 'string' with \xNN escapes
+static bool parse_string(const char *s, char *out, size_t size)
+{
+	if (*s++ != '\'') return false;
+	size_t n = 0;
+	while (*s && *s != '\'') {
+		unsigned c = (uint8_t)*s++;
+		if (c == '\\' && s[0] == 'x' && sscanf(s + 1, "%2x", &c) == 1) s += 3;
+		if (n + 1 < size) out[n++] = (char)c;
+	}
+	out[n] = '\0';
+	return *s == '\'';
+}
+
+static bool parse_line(const char *line, trace_ev_t *ev)
+{
+	unsigned long long ms;
+	char kind[16], a[32], b[32];
+	unsigned v[12];
+	int used = 0, n;
+	if (sscanf(line, "%llu %15s %n", &ms, kind, &used) != 2) return false;
+	const char *rest = line + used;
+	memset(ev, 0, sizeof(*ev));
+	ev->ms = ms;
+	ev->dev = -1;
+	if (strcmp(kind, "formed") == 0) {
+		ev->kind = EV_FORMED;
+		return true;
+	}
+	if (strcmp(kind, "join") == 0) {
+		ev->kind = EV_JOIN;
+		n = sscanf(rest, "%x %31s %x %x", &v[0], a, &v[1], &v[2]);
+		if (n < 3 || !parse_ieee(a, ev->ieee)) return false;
+		ev->short_addr = (uint16_t)v[0];
+		ev->capability = (uint8_t)v[1];
+		ev->parent_short = n == 4 ? (uint16_t)v[2] : 0;
+		return true;
+	}
+	if (strcmp(kind, "ep") == 0) {
+		ev->kind = EV_EP;
+		if (sscanf(rest, "%x%n", &v[0], &used) != 1) return false;
+		ev->short_addr = (uint16_t)v[0];
+		for (rest += used; ev->count < SIM_MAX_ENDPOINTS && sscanf(rest, "%u%n", &v[1], &used) == 1; rest += used) {
+			ev->eps[ev->count++] = (uint8_t)v[1];
+		}
+		return true;
+	}
+	if (strcmp(kind, "desc") == 0) {
+		ev->kind = EV_DESC;
+		if (sscanf(rest, "%x %u %x %x%n", &v[0], &v[1], &v[2], &v[3], &used) != 4) return false;
+		ev->short_addr = (uint16_t)v[0];
+		ev->endpoint = (uint8_t)v[1];
+		ev->profile_id = (uint16_t)v[2];
+		ev->device_id = (uint16_t)v[3];
+		for (rest += used; ev->count < 8 && sscanf(rest, "%x%n", &v[4], &used) == 1; rest += used) {
+			ev->clusters[ev->count++] = (uint16_t)v[4];
+		}
+		return true;
+	}
+	if (strcmp(kind, "attr") == 0) {
+		ev->kind = EV_ATTR;
+		if (sscanf(rest, "%x %u %x %x %x %n", &v[0], &v[1], &v[2], &v[3], &v[4], &used) != 5) return false;
+		ev->short_addr = (uint16_t)v[0];
+		ev->endpoint = (uint8_t)v[1];
+		ev->cluster = (uint16_t)v[2];
+		ev->attr_id = (uint16_t)v[3];
+		ev->is_string = rest[used] == '\'';
+		return !ev->is_string || parse_string(rest + used, ev->str, sizeof(ev->str));
+	}
+	if (strcmp(kind, "alert") == 0) {
+		ev->kind = EV_ALERT;
+		if (sscanf(rest, "%x %31s", &v[0], b) != 2) return false;
+		ev->short_addr = (uint16_t)v[0];
+		ev->source = strcmp(b, "cache") == 0;
+		return true;
+	}
+	if (strcmp(kind, "leave") == 0) {
+		ev->kind = EV_LEAVE;
+		return sscanf(rest, "%31s", a) == 1 && parse_ieee(a, ev->ieee);
+	}
+	if (strcmp(kind, "off") == 0 || strcmp(kind, "on") == 0) {
+		ev->kind = kind[1] == 'f' ? EV_OFF : EV_ON;
+		if (sscanf(rest, "%x", &v[0]) != 1) return false;
+		ev->short_addr = (uint16_t)v[0];
+		return true;
+	}
+	return false;
+}
+
+static int cmp_ev(const void *a, const void *b)
+{
+	const trace_ev_t *x = a, *y = b;
+	if (x->ms != y->ms) return x->ms < y->ms ? -1 : 1;
+	return x->line < y->line ? -1 : x->line > y->line;
+}
+
+static int32_t find_dev(const trace_t *t, const uint8_t ieee[8])
+{
+	for (size_t i = 0; i < t->n_devs; i++) {
+		if (memcmp(t->devs[i].ieee, ieee, 8) == 0) return (int32_t)i;
+	}
+	return -1;
+}
+
+static int32_t add_dev(trace_t *t, const uint8_t ieee[8])
+{
+	int32_t found = find_dev(t, ieee);
+	if (found >= 0) return found;
+	if (t->n_devs == t->cap_devs) {
+		t->cap_devs = t->cap_devs ? t->cap_devs * 2 : 64;
+		t->devs = realloc(t->devs, t->cap_devs * sizeof(*t->devs));
+	}
+	trace_dev_t *d = &t->devs[t->n_devs];
+	memset(d, 0, sizeof(*d));
+	memcpy(d->ieee, ieee, 8);
+	memcpy(d->model.ieee, ieee, 8);
+	d->min_gap_ms = UINT64_MAX;
+	return (int32_t)t->n_devs++;
+}
+
+static void note_answer(trace_dev_t *d, uint64_t ms)
+{
+	// Answers of one frame share a timestamp; a long gap is a later read, not a round trip
+	if (ms > d->last_ms && ms - d->last_ms < d->min_gap_ms) d->min_gap_ms = ms - d->last_ms;
+	d->last_ms = ms;
+	d->answered = true;
+}
+
+static sim_endpoint_t *model_ep(sim_device_t *m, uint8_t endpoint)
+{
+	for (uint8_t i = 0; i < m->ep_count; i++) {
+		if (m->eps[i].endpoint == endpoint) return &m->eps[i];
+	}
+	return NULL;
+}
+
+// Events in time order, each tied to its device (joins and leaves by IEEE address, the rest by
+// the short address a join gave out last), and the device models built from the answers
+static void resolve(trace_t *t)
+{
+	qsort(t->evs, t->n_evs, sizeof(*t->evs), cmp_ev);
+	for (size_t i = 0; i < ADDR_COUNT; i++) s_by_short[i] = -1;
+	for (size_t i = 0; i < t->n_evs; i++) {
+		trace_ev_t *ev = &t->evs[i];
+		if (ev->kind == EV_FORMED) {
+			t->formed = true;
+			t->formed_ms = ev->ms;
+			continue;
+		}
+		if (ev->kind == EV_JOIN || ev->kind == EV_LEAVE) {
+			ev->dev = ev->kind == EV_JOIN ? add_dev(t, ev->ieee) : find_dev(t, ev->ieee);
+		} else {
+			ev->dev = s_by_short[ev->short_addr];
+		}
+		if (ev->dev < 0) {
+			t->unresolved++;
+			continue;
+		}
+		trace_dev_t *d = &t->devs[ev->dev];
+		sim_device_t *m = &d->model;
+		switch (ev->kind) {
+		case EV_JOIN:
+			if (!m->short_addr) {
+				m->short_addr = ev->short_addr;
+				m->end_device = !(ev->capability & 0x02);
+				m->parent_short = ev->parent_short;
+			}
+			s_by_short[ev->short_addr] = ev->dev;
+			d->last_ms = ev->ms;
+			break;
+		case EV_EP:
+			if (!m->ep_count) {
+				for (uint8_t e = 0; e < ev->count; e++) m->eps[m->ep_count++].endpoint = ev->eps[e];
+			}
+			note_answer(d, ev->ms);
+			break;
+		case EV_DESC: {
+			sim_endpoint_t *e = model_ep(m, ev->endpoint);
+			if (e) {
+				e->profile_id = ev->profile_id;
+				e->device_id = ev->device_id;
+				e->in_count = ev->count;
+				memcpy(e->clusters, ev->clusters, sizeof(e->clusters));
+			}
+			note_answer(d, ev->ms);
+			break;
+		}
+		case EV_ATTR:
+			if (ev->cluster == 0x0000 && ev->is_string) {
+				char *field = ev->attr_id == 0x0004 ? m->manufacturer : ev->attr_id == 0x0005 ? m->model :
+							  ev->attr_id == 0x4000 ? m->sw_build : NULL;
+				if (field && !field[0]) {
+					snprintf(field, SIM_STR_MAX, "%s", ev->str);
+				} else if (field == m->sw_build && strcmp(field, ev->str) != 0) {
+					ev->new_build = true;
+				}
+			}
+			note_answer(d, ev->ms);
+			break;
+		case EV_ALERT:
+			if (!d->alerts[0] && !d->alerts[1]) d->first_alert_ms = ev->ms;
+			d->alerts[ev->source]++;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static bool load_trace(FILE *f, trace_t *t)
+{
+	memset(t, 0, sizeof(*t));
+	char line[512];
+	uint32_t no = 0;
+	bool ok = true;
+	while (fgets(line, sizeof(line), f)) {
+		no++;
+		if (line[0] == '#' || line[0] == '\n') continue;
+		if (t->n_evs == t->cap_evs) {
+			t->cap_evs = t->cap_evs ? t->cap_evs * 2 : 1024;
+			t->evs = realloc(t->evs, t->cap_evs * sizeof(*t->evs));
+		}
+		if (!parse_line(line, &t->evs[t->n_evs])) {
+			fprintf(stderr, "trace line %u: cannot parse: %s", no, line);
+			ok = false;
+			continue;
+		}
+		t->evs[t->n_evs++].line = no;
+	}
+	resolve(t);
+	return ok && t->n_evs;
+}
+
+static void free_trace(trace_t *t)
+{
+	free(t->evs);
+	free(t->devs);
+	memset(t, 0, sizeof(*t));
+}
+
+// ---- Replay ------------------------------------------------------------------------
+
+static bool actionable(const trace_ev_t *ev)
+{
+	if (ev->dev < 0) return false;
+	return ev->kind == EV_JOIN || ev->kind == EV_LEAVE || ev->kind == EV_OFF || ev->kind == EV_ON ||
+		   (ev->kind == EV_ATTR && ev->new_build);
+}
+
+static void schedule_next(void);
+
+static void fire(void *ctx, uintptr_t arg)
+{
+	(void)arg;
+	const trace_ev_t *ev = (const trace_ev_t *)ctx;
+	sim_device_t *d = s_trace.devs[ev->dev].sim;
+	switch (ev->kind) {
+	case EV_JOIN:
+		// A device that announces has power, wherever the trace lost track of it
+		if (d->powered_off) sim_power(d, true, false);
+		sim_set_short(d, ev->short_addr);
+		d->parent_short = ev->parent_short;
+		sim_announce(d, 0);
+		break;
+	case EV_LEAVE:
+		sim_leave(d, false, 0);
+		break;
+	case EV_OFF:
+		sim_power(d, false, false);
+		break;
+	case EV_ON:
+		if (d->powered_off) sim_power(d, true, false);
+		break;
+	case EV_ATTR:
+		sim_set_sw_build(d, ev->str);
+		break;
+	default:
+		break;
+	}
+	schedule_next();
+}
+
+// One event queued at a time: hours of traffic never fill the simulator's queue
+static void schedule_next(void)
+{
+	while (s_next < s_trace.n_evs && !actionable(&s_trace.evs[s_next])) s_next++;
+	if (s_next >= s_trace.n_evs) return;
+	const trace_ev_t *ev = &s_trace.evs[s_next++];
+	int64_t at = (int64_t)ev->ms * 1000 + s_offset_us;
+	uint64_t now = sim_now_us();
+	sim_schedule(at > (int64_t)now ? (uint64_t)at - now : 0, fire, (void *)ev, 0);
+}
+
+static void build_devices(void)
+{
+	for (size_t i = 0; i < s_trace.n_devs; i++) {
+		trace_dev_t *t = &s_trace.devs[i];
+		if (!t->answered) {
+			interview_verdict_t v = t->alerts[0] || t->alerts[1] ? INTERVIEW_VERDICT_MATCH : INTERVIEW_VERDICT_OTHER;
+			device_cache_put(t->ieee, "", 0, "", 0, v);
+		}
+		// One request and one response on the air per hop around the device's turnaround
+		uint64_t air_us = 2ULL * s_cfg.frame_airtime_us * (t->model.parent_short ? 2 : 1);
+		if (t->min_gap_ms != UINT64_MAX && t->min_gap_ms * 1000 > air_us + 1000) {
+			t->model.latency_us = (uint32_t)(t->min_gap_ms * 1000 - air_us);
+		}
+		t->sim = sim_add_device(&t->model);
+		// Off the network until its first recorded join
+		t->sim->left = true;
+	}
+}
+
+// ---- Comparison --------------------------------------------------------------------
+
+static void print_ieee(const uint8_t ieee[8])
+{
+	for (int i = 7; i >= 0; i--) printf("%02X%s", ieee[i], i ? ":" : "");
+}
+
+static bool replayed_trace(const char *image, trace_t *out)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "'%s' -t '%s'", EVLOG_DECODE, image);
+	FILE *p = popen(cmd, "r");
+	if (!p) return false;
+	bool ok = load_trace(p, out);
+	return pclose(p) == 0 && ok;
+}
+
+static bool compare(const trace_t *site, const trace_t *replay)
+{
+	bool ok = true;
+	uint32_t alerts[2] = { 0 }, matched = 0;
+	int64_t delta_sum = 0, delta_max = 0;
+	for (size_t i = 0; i < site->n_devs; i++) {
+		const trace_dev_t *s = &site->devs[i];
+		int32_t j = find_dev(replay, s->ieee);
+		const trace_dev_t *r = j >= 0 ? &replay->devs[j] : NULL;
+		uint16_t got[ALERT_SOURCES] = { r ? r->alerts[0] : 0, r ? r->alerts[1] : 0 };
+		alerts[0] += s->alerts[0] + s->alerts[1];
+		alerts[1] += got[0] + got[1];
+		if (got[0] != s->alerts[0] || got[1] != s->alerts[1]) {
+			printf("MISMATCH ");
+			print_ieee(s->ieee);
+			printf(": %u interview + %u cache alert(s) on site, %u + %u replayed\n", s->alerts[0], s->alerts[1],
+				   got[0], got[1]);
+			ok = false;
+		} else if (s->alerts[0] + s->alerts[1]) {
+			// Alert time relative to formation, replay against site
+			int64_t d = ((int64_t)r->first_alert_ms - (int64_t)replay->formed_ms) -
+						((int64_t)s->first_alert_ms - (int64_t)site->formed_ms);
+			delta_sum += d;
+			if (llabs(d) > llabs(delta_max)) delta_max = d;
+			matched++;
+		}
+	}
+	for (size_t j = 0; j < replay->n_devs; j++) {
+		const trace_dev_t *r = &replay->devs[j];
+		if (find_dev(site, r->ieee) >= 0 || !(r->alerts[0] + r->alerts[1])) continue;
+		printf("MISMATCH ");
+		print_ieee(r->ieee);
+		printf(": alerted in the replay, not on site\n");
+		alerts[1] += r->alerts[0] + r->alerts[1];
+		ok = false;
+	}
+	printf("alerts: %u on site, %u replayed; %u device(s) alerted as on site, first alert %+.1f ms mean, %+lld ms "
+		   "worst against the trace\n", alerts[0], alerts[1], matched, matched ? (double)delta_sum / matched : 0.0,
+		   (long long)delta_max);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	sim_default_config(&s_cfg);
+	int c;
+	while ((c = getopt(argc, argv, "r:vh")) != -1) {
+		switch (c) {
+		case 'r': s_cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': s_cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-r seed] [-v] [trace]\n", argv[0]);
+			return 2;
+		}
+	}
+	const char *path = optind < argc ? argv[optind] : REPLAY_DATA_DIR "/trace_site.txt";
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	bool parsed = load_trace(f, &s_trace);
+	fclose(f);
+	if (!parsed) {
+		fprintf(stderr, "%s: no usable trace\n", path);
+		return 1;
+	}
+	uint64_t span_ms = s_trace.evs[s_trace.n_evs - 1].ms - (s_trace.formed ? s_trace.formed_ms : 0);
+	printf("trace %s: %zu events, %zu devices, %.1f h after formation", path, s_trace.n_evs, s_trace.n_devs,
+		   span_ms / 3600e3);
+	if (s_trace.unresolved) printf(", %u from unknown short addresses (ignored)", s_trace.unresolved);
+	putchar('\n');
+
+	sim_init(&s_cfg);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + 60 * SEC);
+	s_offset_us = (int64_t)sim_now_us() - (s_trace.formed ? (int64_t)s_trace.formed_ms * 1000 : 0);
+	build_devices();
+
+	sim_stats_t before = *sim_stats();
+	uint64_t t0 = sim_now_us(), w0 = sim_wall_ns();
+	schedule_next();
+	uint64_t end = (uint64_t)((int64_t)s_trace.evs[s_trace.n_evs - 1].ms * 1000 + s_offset_us) + SETTLE_US;
+	sim_run_until(end);
+	uint64_t wall_ns = sim_wall_ns() - w0;
+	const sim_stats_t *st = sim_stats();
+	uint64_t events = st->events - before.events;
+	double virt_s = (sim_now_us() - t0) / 1e6;
+	printf("replayed %.1f h of virtual time in %.3f s: %.0fx real time\n", virt_s / 3600, wall_ns / 1e9,
+		   wall_ns ? virt_s * 1e9 / wall_ns : 0.0);
+	printf("events: %llu simulator events, %.2f us mean, %.1f us max per event; %.2f us per trace event\n",
+		   (unsigned long long)events, events ? (st->dispatch_ns - before.dispatch_ns) / 1e3 / events : 0.0,
+		   st->max_dispatch_ns / 1e3, (st->dispatch_ns - before.dispatch_ns) / 1e3 / s_trace.n_evs);
+	printf("traffic: %u ActiveEP, %u SimpleDesc, %u ZCL reads, %u reports, %u dropped\n",
+		   st->active_ep_reqs - before.active_ep_reqs, st->simple_desc_reqs - before.simple_desc_reqs,
+		   st->zcl_read_reqs - before.zcl_read_reqs, st->reports - before.reports, st->dropped - before.dropped);
+
+	// The replay's own capture, decoded like the site's
+	event_log_flush();
+	sim_run_until(sim_now_us() + SEC);
+	char image[] = "/tmp/bench_replay_XXXXXX";
+	int fd = mkstemp(image);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	close(fd);
+	trace_t replay;
+	bool ok = sim_flash_save(EVLOG_PARTITION_LABEL, image) && replayed_trace(image, &replay);
+	unlink(image);
+	if (!ok) {
+		printf("FAIL: replay event log not decoded\n");
+		return 1;
+	}
+	ok = compare(&s_trace, &replay);
+	free_trace(&replay);
+	free_trace(&s_trace);
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+// Scale benchmark
+// 250 devices across 10 routers by default. The routers join the coordinator in the formation
+// window. The other devices join through them after a console `join 254`, each with its own
+// association, Update-Device, announce and interview. The bench then reports:
+//   - joins refused, interview latency and the Mgmt_Lqi traffic of the topology pass
+//   - the inventory (device table parent, depth, LQI) checked against the simulated mesh
+//   - app RAM: static tables per device slot and heap per device
+//   - heap allocations by the app's own code once the network is up (heap_guard.c), which must
+//     be none: its tasks, timers and tables are all static. The simulated NVS allocates like
+//     ESP-IDF's, so a device cache flush that opens a handle is caught
+//   - the stack sizing main.c asks for, with the ZBOSS tables it implies (estimated: the
+//     library's allocations cannot be measured on the host)
+//   - the resulting device ceiling for a RAM budget
+//   - the app's runtime metrics (`metrics`), whose request counters must match the requests
+//     the simulated stack received
+//   bench_scale [-n devices] [-R routers] [-k free_kb] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+#include "device_table.h"
+#include "device_cache.h"
+#include "interview.h"
+#include "topology.h"
+#include "metrics.h"
+#include "heap_guard.h"
+
+void app_main(void);
+
+#define SEC                 (1000ULL * 1000)
+#define MAX_ROUTERS         (64)
+
+// Estimated ZBOSS RAM per table entry (esp-zigbee-lib 1.x, ESP32-C6). The neighbour and
+// address tables scale with the overall network size, the child table with max_children.
+#define EST_NEIGHBOR_BYTES  (40)
+#define EST_ADDR_MAP_BYTES  (20)
+#define EST_CHILD_BYTES     (16)
+#define EST_IO_BUFFER_BYTES (160)
+// Heap left for the app and the Zigbee tables once the stack, Wi-Fi off, console and tasks are up
+// (heap_caps_get_free_size(MALLOC_CAP_DEFAULT) after esp_zb_start on target)
+#define FREE_HEAP_KB        (180)
+
+static uint16_t s_routers[MAX_ROUTERS];
+static uint32_t s_router_count = 10;
+
+static void add_device(uint16_t short_addr, uint32_t oui, bool router, uint16_t parent, bool ikea)
+{
+	sim_device_t d;
+	memset(&d, 0, sizeof(d));
+	d.short_addr = short_addr;
+	sim_make_ieee(d.ieee, oui, sim_rand(), short_addr);
+	d.ep_count = 1;
+	d.end_device = !router;
+	d.parent_short = parent;
+	d.lqi = (uint8_t)(90 + sim_rand() % 166);
+	if (router) {
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0051, .in_count = 2,
+									 .clusters = { 0x0000, 0x0006 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "SONOFF");
+		snprintf(d.model, sizeof(d.model), "S26R2ZB");
+	} else if (ikea) {
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0820, .in_count = 3,
+									 .clusters = { 0x0000, 0x0001, 0x0003 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "IKEA of Sweden");
+		snprintf(d.model, sizeof(d.model), "TRADFRI remote control");
+		d.expect_alert = true;
+	} else {
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0402, .in_count = 3,
+									 .clusters = { 0x0000, 0x0001, 0x0500 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "LUMI");
+		snprintf(d.model, sizeof(d.model), "lumi.sensor_magnet.aq2");
+	}
+	snprintf(d.sw_build, sizeof(d.sw_build), "1.0.%03u", sim_rand() % 100);
+	sim_device_t *dev = sim_add_device(&d);
+	if (dev) sim_join(dev, (router ? 1 : 5) * SEC + sim_rand() % (30 * SEC));
+}
+
+// Interviewed, or classified before its interview ended
+static bool classified(const sim_device_t *d)
+{
+	if (d->interviewed_us) return true;
+	const device_entry_t *e = device_table_find(d->ieee);
+	return e && e->state == DEVICE_STATE_DONE;
+}
+
+static bool all_interviewed(void)
+{
+	for (size_t i = 0; i < sim_device_count(); i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (!classified(d) || (d->expect_alert && !d->alerted_us)) return false;
+	}
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.queue_depth == 0 && is.in_flight == 0;
+}
+
+static uint32_t s_passes_before;
+
+static bool topology_passed(void)
+{
+	topology_stats_t ts;
+	topology_get_stats(&ts);
+	return ts.passes > s_passes_before;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	uint32_t devices = 250, free_kb = FREE_HEAP_KB;
+	int c;
+	while ((c = getopt(argc, argv, "n:R:k:r:vh")) != -1) {
+		switch (c) {
+		case 'n': devices = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'R': s_router_count = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'k': free_kb = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-n devices] [-R routers] [-k free_kb] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (s_router_count > MAX_ROUTERS) s_router_count = MAX_ROUTERS;
+	if (devices > SIM_MAX_DEVICES) devices = SIM_MAX_DEVICES;
+	if (devices < s_router_count) devices = s_router_count;
+
+	sim_init(&cfg);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_while(sim_network_formed, sim_now_us() + 60 * SEC);
+	sim_run_until(sim_now_us() + SEC);
+	size_t heap_after_init = sim_heap_current();
+	sim_heap_reset_peak();
+	sim_stats_t before = *sim_stats();
+	uint64_t t0 = sim_now_us();
+
+	// Routers power on in the formation window; everything else joins through them once the
+	// installer opens the network
+	for (uint32_t i = 0; i < s_router_count; i++) {
+		s_routers[i] = (uint16_t)(0x1000 + i);
+		add_device(s_routers[i], 0x00124B, true, 0x0000, false);
+	}
+	sim_console_exec("join 254");
+	for (uint32_t i = s_router_count; i < devices; i++) {
+		uint16_t parent = s_router_count ? s_routers[sim_rand() % s_router_count] : 0x0000;
+		bool ikea = sim_rand() % 3 == 0;
+		add_device((uint16_t)(0x2000 + i), ikea ? 0x000B57 : 0x00158D, false, parent, ikea);
+	}
+	bool ok = sim_run_while(all_interviewed, t0 + 600 * SEC);
+	uint64_t interviewed_at = sim_now_us();
+	topology_stats_t ts;
+	topology_get_stats(&ts);
+	s_passes_before = ts.passes;
+	ok = sim_run_while(topology_passed, sim_now_us() + (TOPOLOGY_SETTLE_MS + TOPOLOGY_REFRESH_MS) * 1000ULL) && ok;
+	topology_get_stats(&ts);
+	const sim_stats_t *st = sim_stats();
+	size_t heap_peak = sim_heap_peak();
+	// Before the bench allocates anything itself: it runs outside any task, like an app task would
+	uint32_t app_allocs = heap_guard_app_allocs();
+
+	// Join and interview
+	size_t n = sim_device_count(), joined = 0, interviewed = 0, by_oui = 0;
+	uint64_t *itv = calloc(n ? n : 1, sizeof(uint64_t));
+	size_t n_itv = 0;
+	for (size_t i = 0; i < n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		joined += d->announces > 0;
+		by_oui += !d->interviewed_us && classified(d);
+		if (!d->interviewed_us) continue;
+		interviewed++;
+		itv[n_itv++] = d->interviewed_us - d->announce_us;
+	}
+	qsort(itv, n_itv, sizeof(itv[0]), cmp_u64);
+	printf("devices=%zu routers=%u seed=%u\n", n, s_router_count, cfg.seed);
+	printf("joined=%zu/%zu refused_associations=%u interviewed=%zu classified_by_oui=%zu makespan=%.1f s\n",
+		   joined, n, st->joins_refused - before.joins_refused, interviewed, by_oui, (double)(interviewed_at - t0) / 1e6);
+	if (n_itv) {
+		printf("interview latency: p50=%.1f p90=%.1f max=%.1f ms\n", (double)itv[(n_itv - 1) / 2] / 1000.0,
+			   (double)itv[(n_itv - 1) * 9 / 10] / 1000.0, (double)itv[n_itv - 1] / 1000.0);
+	}
+	printf("air: frames=%u relayed=%u retries=%u failures=%u mgmt_lqi=%u\n",
+		   st->mac_frames - before.mac_frames, st->relayed_frames - before.relayed_frames,
+		   st->mac_retries - before.mac_retries, st->mac_failures - before.mac_failures,
+		   st->mgmt_lqi_reqs - before.mgmt_lqi_reqs);
+	free(itv);
+
+	// Inventory against the simulated mesh
+	size_t missing = 0, bad_parent = 0, bad_depth = 0, bad_lqi = 0;
+	for (size_t i = 0; i < n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (!d->announces) continue;
+		const device_entry_t *e = device_table_find(d->ieee);
+		if (!e) {
+			missing++;
+			continue;
+		}
+		bad_parent += e->parent_short != d->parent_short;
+		bad_depth += e->depth != sim_device_depth(d);
+		bad_lqi += e->lqi != (d->lqi ? d->lqi : 255);
+	}
+	printf("inventory: missing=%zu wrong_parent=%zu wrong_depth=%zu wrong_lqi=%zu\n", missing, bad_parent,
+		   bad_depth, bad_lqi);
+	printf("topology: routers=%u with_children=%u coordinator_children=%u max_depth=%u depth[1..]=%u/%u/%u+ "
+		   "updates=%lu passes=%lu lqi_reqs=%lu lqi_failures=%lu\n", ts.routers, ts.parents,
+		   ts.coordinator_children, ts.max_depth, ts.by_depth[1], ts.by_depth[2], ts.by_depth[3] + ts.by_depth[4],
+		   (unsigned long)ts.updates, (unsigned long)ts.passes, (unsigned long)ts.lqi_reqs,
+		   (unsigned long)ts.lqi_failures);
+
+	// Memory
+	size_t table = device_table_ram_bytes(), cache = device_cache_ram_bytes();
+	double table_slot = (double)table / DEVICE_TABLE_MAX_DEVICES, cache_slot = (double)cache / DEVICE_CACHE_MAX_ENTRIES;
+	double heap_dev = heap_peak > heap_after_init ? (double)(heap_peak - heap_after_init) / (double)n : 0.0;
+	printf("app RAM: device table %zu B (%u slots, entry %zu B, %.1f B/slot), device cache %zu B (%u slots, %.1f B/slot)\n",
+		   table, DEVICE_TABLE_MAX_DEVICES, sizeof(device_entry_t), table_slot, cache, DEVICE_CACHE_MAX_ENTRIES, cache_slot);
+	printf("app heap: after_init=%zu peak=%zu bytes (%.1f B/device during the joins), %lu allocations by app tasks "
+		   "after start-up\n", heap_after_init, heap_peak, heap_dev, (unsigned long)app_allocs);
+	sim_zb_sizing_t sz;
+	sim_zb_get_sizing(&sz);
+	size_t est_nbr = (size_t)sz.network_size * EST_NEIGHBOR_BYTES, est_addr = (size_t)sz.network_size * EST_ADDR_MAP_BYTES;
+	size_t est_child = (size_t)sz.max_children * EST_CHILD_BYTES, est_io = (size_t)sz.io_buffers * EST_IO_BUFFER_BYTES;
+	size_t est_stack = est_nbr + est_addr + est_child + est_io;
+	printf("stack sizing: max_children=%u network_size=%u io_buffers=%u (estimated ZBOSS tables: neighbour %zu B, "
+		   "address %zu B, child %zu B, io buffers %zu B = %zu B)\n", sz.max_children, sz.network_size,
+		   sz.io_buffers, est_nbr, est_addr, est_child, est_io, est_stack);
+	double per_device = table_slot + cache_slot + heap_dev + EST_NEIGHBOR_BYTES + EST_ADDR_MAP_BYTES;
+	double fixed = (double)est_io + (double)est_child;
+	uint32_t ceiling = (uint32_t)(((double)free_kb * 1024.0 - fixed) / per_device);
+	printf("per-device RAM: %.1f B (app %.1f B + estimated stack %u B); ceiling with %u KB free: ~%u devices "
+		   "(device table holds %u, network size %u)\n", per_device, table_slot + cache_slot + heap_dev,
+		   EST_NEIGHBOR_BYTES + EST_ADDR_MAP_BYTES, free_kb, ceiling, DEVICE_TABLE_MAX_DEVICES, sz.network_size);
+
+	// Runtime metrics as the console shows them; the app's counters against what reached the stack
+	printf("metrics:\n");
+	sim_console_exec("metrics");
+	metrics_snapshot_t m;
+	metrics_snapshot(&m);
+	const struct { metrics_req_t req; uint32_t stack; } checks[] = {
+		{ METRICS_REQ_ACTIVE_EP, st->active_ep_reqs },
+		{ METRICS_REQ_SIMPLE_DESC, st->simple_desc_reqs },
+		{ METRICS_REQ_READ_ATTR, st->zcl_read_reqs },
+		{ METRICS_REQ_MGMT_LQI, st->mgmt_lqi_reqs },
+		{ METRICS_REQ_ENERGY_DETECT, st->ed_requests },
+		{ METRICS_REQ_ACTIVE_SCAN, st->scan_requests },
+		{ METRICS_REQ_BIND, st->bind_reqs },
+		{ METRICS_REQ_CONFIG_REPORT, st->config_report_reqs },
+		{ METRICS_REQ_IEEE_ADDR, st->ieee_addr_reqs },
+	};
+	size_t bad_counts = 0;
+	for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+		uint32_t issued = m.requests[checks[i].req][METRICS_ISSUED];
+		if (issued == checks[i].stack) continue;
+		bad_counts++;
+		printf("metrics mismatch: %s issued=%lu, stack saw %lu\n", metrics_req_name(checks[i].req),
+			   (unsigned long)issued, (unsigned long)checks[i].stack);
+	}
+
+	ok = ok && !bad_counts && !app_allocs && joined == n && interviewed + by_oui == n && !missing && !bad_parent && !bad_depth && !bad_lqi;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// Channel survey benchmark
+// Runs main/main.c with the simulator in a crowded 2.4 GHz environment (Wi-Fi on channels
+// 1/6/11 raising the noise on Zigbee channels 11-14, 16-19 and 21-24, neighbouring PANs)
+// and reports the survey table, the channels filled by the formation sweep and the radio duty
+// cycle against the budget. Then joins devices twice: with the survey running, and with the
+// previous full 16-channel active scan (duration 4, re-armed 1 s after each completion),
+// to compare interview latency.
+//   bench_survey [-t minutes] [-n devices] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+#include "channel_survey.h"
+#include "esp_zigbee_core.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+
+void app_main(void);
+
+#define ALL_CHANNELS        (0x07FFF800UL)
+#define LEGACY_DURATION     (4)
+#define LEGACY_REARM_US     (1000 * 1000)
+
+static bool s_legacy;
+static uint16_t s_next_short = 0x1000;
+
+static void environment(void)
+{
+	// Wi-Fi channel 1, 6 and 11 cover Zigbee 11-14, 16-19 and 21-24
+	static const int8_t noise[16] = { -68, -64, -66, -72, -93, -61, -58, -60, -70, -94, -75, -71, -73, -79, -92, -90 };
+	for (uint8_t ch = 11; ch <= 26; ch++) sim_set_channel_noise(ch, noise[ch - 11]);
+	sim_add_pan(11, 0x1A2B, false);
+	sim_add_pan(15, 0x3C4D, false);
+	sim_add_pan(15, 0x5E6F, true);
+	sim_add_pan(20, 0x7081, false);
+	sim_add_pan(25, 0x92A3, false);
+}
+
+// ---- Previous firmware: full active scan, re-armed one second after each completion ----
+
+static void legacy_scan(void *ctx, uintptr_t arg);
+
+static void legacy_scan_done(esp_zb_zdp_status_t status, uint8_t count, esp_zb_network_descriptor_t *list)
+{
+	(void)status;
+	(void)count;
+	(void)list;
+	if (s_legacy) sim_schedule(LEGACY_REARM_US, legacy_scan, NULL, 0);
+}
+
+static void legacy_scan(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	if (s_legacy) esp_zb_zdo_active_scan_request(ALL_CHANNELS, LEGACY_DURATION, legacy_scan_done);
+}
+
+// ---- Join storm -------------------------------------------------------------------
+
+static size_t s_storm_first;
+static size_t s_storm_n;
+
+static bool storm_done(void)
+{
+	for (size_t i = s_storm_first; i < s_storm_first + s_storm_n; i++) {
+		if (!sim_device_at(i)->interviewed_us) return false;
+	}
+	return true;
+}
+
+static void storm(const char *label, size_t n)
+{
+	s_storm_first = sim_device_count();
+	s_storm_n = 0;
+	for (size_t i = 0; i < n; i++) {
+		sim_device_t d;
+		memset(&d, 0, sizeof(d));
+		d.short_addr = s_next_short++;
+		d.ieee[0] = (uint8_t)d.short_addr;
+		d.ieee[1] = (uint8_t)(d.short_addr >> 8);
+		d.ieee[7] = 0x17;
+		d.ep_count = 1;
+		d.eps[0] = (sim_endpoint_t){ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0100, .in_count = 1,
+									 .clusters = { 0x0000 } };
+		snprintf(d.manufacturer, sizeof(d.manufacturer), "SONOFF");
+		snprintf(d.model, sizeof(d.model), "BASICZBR3");
+		sim_device_t *dev = sim_add_device(&d);
+		if (!dev) break;
+		sim_announce(dev, (uint64_t)(sim_rand() % 10000) * 1000);
+		s_storm_n++;
+	}
+	uint64_t t0 = sim_now_us();
+	sim_run_while(storm_done, t0 + 600ULL * 1000 * 1000);
+	uint64_t sum = 0, max = 0;
+	size_t done = 0;
+	for (size_t i = s_storm_first; i < s_storm_first + s_storm_n; i++) {
+		const sim_device_t *d = sim_device_at(i);
+		if (!d->interviewed_us) continue;
+		uint64_t lat = d->interviewed_us - d->announce_us;
+		sum += lat;
+		if (lat > max) max = lat;
+		done++;
+	}
+	printf("%-28s interviewed=%zu/%zu latency avg=%.1f max=%.1f ms\n", label, done, s_storm_n,
+		   done ? (double)sum / (double)done / 1000.0 : 0.0, (double)max / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	uint32_t minutes = 60;
+	size_t devices = 30;
+	int c;
+	while ((c = getopt(argc, argv, "t:n:r:vh")) != -1) {
+		switch (c) {
+		case 't': minutes = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'n': devices = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-t minutes] [-n devices] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	sim_init(&cfg);
+	environment();
+	app_main();
+	sim_rtos_start_tasks();
+
+	// Formation sweeps every channel first; the sliced survey then keeps the table fresh
+	sim_run_while(sim_network_formed, sim_now_us() + 60ULL * 1000 * 1000);
+	sim_run_until(sim_now_us() + 1000 * 1000);
+	unsigned complete = 0;
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+		complete += channel_survey_get(ch)->have == (CHANNEL_SURVEY_HAVE_ED | CHANNEL_SURVEY_HAVE_SCAN);
+	}
+	uint64_t formed_ms = sim_now_us() / 1000;
+	sim_run_until(sim_now_us() + (uint64_t)minutes * 60 * 1000 * 1000);
+	channel_survey_stats_t st;
+	channel_survey_get_stats(&st);
+
+	printf("channel  noise(dBm) avg  max  PANs open  ED age  scan age\n");
+	uint32_t now_ms = (uint32_t)(sim_now_us() / 1000);
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+		const channel_survey_entry_t *e = channel_survey_get(ch);
+		printf("%7u  %10d %4d %4d %5u %4u %6lus %8lus\n", ch, e->noise_dbm, e->noise_avg_dbm, e->noise_max_dbm,
+			   e->networks, e->open_networks, (unsigned long)((now_ms - e->ed_ms) / 1000),
+			   (unsigned long)((now_ms - e->scan_ms) / 1000));
+	}
+	printf("formation sweep: %u/%u channels complete, network formed at %.1f s\n", complete, CHANNEL_SURVEY_COUNT,
+		   (double)formed_ms / 1000.0);
+	printf("survey: %u min, slices ed=%lu scan=%lu busy_waits=%lu passes=%lu\n", minutes, (unsigned long)st.ed_slices, (unsigned long)st.scan_slices,
+		   (unsigned long)st.busy_waits, (unsigned long)st.passes);
+	printf("survey radio duty: %.2f%% (%.1f s off-channel, budget %u%%)\n", st.duty_permyriad / 100.0,
+		   (double)st.radio_us / 1e6, CHANNEL_SURVEY_BUDGET_PCT);
+	double legacy_scan_ms = 16.0 * ((1u << LEGACY_DURATION) + 1) * 15.36;
+	printf("previous full scan: %.0f ms every %.0f ms, radio duty %.1f%%, every channel refreshed every %.1f s\n",
+		   legacy_scan_ms, legacy_scan_ms + LEGACY_REARM_US / 1000.0,
+		   100.0 * legacy_scan_ms / (legacy_scan_ms + LEGACY_REARM_US / 1000.0),
+		   (legacy_scan_ms + LEGACY_REARM_US / 1000.0) / 1000.0);
+
+	storm("joins with survey:", devices);
+	channel_survey_stop();
+	s_legacy = true;
+	sim_schedule(0, legacy_scan, NULL, 0);
+	storm("joins with full-scan loop:", devices);
+	s_legacy = false;
+	return st.duty_permyriad <= CHANNEL_SURVEY_BUDGET_PCT * 100 ? 0 : 1;
+}
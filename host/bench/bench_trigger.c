@@ -0,0 +1,132 @@
+// Simulation input benchmark
+// Drives SIMULATION_PIN of main/main.c linked with the simulator and reports, per scenario,
+// triggers seen, bounces rejected and trigger-to-alert latency (edge to LED update). The same
+// pulses are replayed against a model of the previous firmware, which sampled the pin from a
+// 1 s timer and ignored it until the 10 s alert had ended.
+//   bench_trigger [-n pulses] [-r seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "sim.h"
+#include "actuator.h"
+#include "trigger_input.h"
+
+void app_main(void);
+
+#define POLL_PERIOD_US      (1000 * 1000)
+#define POLL_PHASES         (1000)      // poll model averaged over random timer phases
+#define MAX_PULSES          (4096)
+
+typedef struct {
+	const char *name;
+	bool pulse_train;
+	uint32_t period_us;         // between the starts of consecutive triggers
+	uint32_t width_us;          // how long the pin stays high
+	uint32_t bounces;           // extra short pulses before the pin settles high
+} scenario_t;
+
+static const scenario_t s_scenarios[] = {
+	{ "button (bouncing)",   false, 500 * 1000, 200 * 1000, 5 },
+	{ "short pulse 100us",   false, 250 * 1000, 100, 0 },
+	{ "burst 5 kHz",         true, 200, 50, 0 },
+	{ "burst 1 kHz",         true, 1000, 100, 0 },
+};
+#define SCENARIO_COUNT  (sizeof(s_scenarios) / sizeof(s_scenarios[0]))
+
+static uint64_t s_pulse_start[MAX_PULSES];
+
+// Previous firmware: level sampled every second; a HIGH sample alerts unless an alert started
+// less than ALERT_DURATION_MS ago. Averaged over POLL_PHASES random timer phases.
+static void poll_model(const scenario_t *sc, size_t n, double *caught, double *avg_ms, double *max_ms)
+{
+	uint64_t end = s_pulse_start[n - 1] + sc->width_us;
+	double sum = 0, max = 0;
+	size_t total = 0;
+	for (size_t p = 0; p < POLL_PHASES; p++) {
+		uint64_t alert_until = 0;
+		size_t i = 0;
+		for (uint64_t t = s_pulse_start[0] + sim_rand() % POLL_PERIOD_US; t <= end; t += POLL_PERIOD_US) {
+			// Pulse covering the sample, if any (pulses do not overlap)
+			while (i < n && s_pulse_start[i] + sc->width_us <= t) i++;
+			if (i == n || s_pulse_start[i] > t || t < alert_until) continue;
+			double lat = (double)(t - s_pulse_start[i]) / 1000.0;
+			sum += lat;
+			if (lat > max) max = lat;
+			total++;
+			alert_until = t + ALERT_DURATION_MS * 1000ULL;
+		}
+	}
+	*caught = (double)total / POLL_PHASES;
+	*avg_ms = total ? sum / (double)total : 0.0;
+	*max_ms = max;
+}
+
+static bool run_scenario(const scenario_t *sc, size_t n)
+{
+	trigger_input_set_pulse_train(sc->pulse_train);
+	// Let the previous scenario's alert end and the debounce window expire
+	sim_run_until(sim_now_us() + (ALERT_DURATION_MS + 1000) * 1000ULL);
+	trigger_input_stats_t tb, ta;
+	actuator_stats_t as;
+	trigger_input_get_stats(&tb);
+	actuator_reset_stats();
+
+	uint64_t t0 = sim_now_us() + 1000;
+	for (size_t i = 0; i < n; i++) {
+		uint64_t start = t0 + (uint64_t)i * sc->period_us;
+		s_pulse_start[i] = start;
+		uint64_t delay = start - sim_now_us();
+		// Contact bounce: short pulses 150 us apart, then the pin settles high
+		for (uint32_t b = 0; b < sc->bounces; b++) sim_gpio_pulse(SIMULATION_PIN, delay + b * 150, 60);
+		sim_gpio_pulse(SIMULATION_PIN, delay + sc->bounces * 150, sc->width_us);
+	}
+	sim_run_until(s_pulse_start[n - 1] + sc->width_us + 100 * 1000);
+	trigger_input_get_stats(&ta);
+	actuator_get_stats(&as);
+
+	double avg_us = as.sim_latency_samples ? (double)as.sim_latency_sum_us / (double)as.sim_latency_samples : 0.0;
+	double poll_caught, poll_avg, poll_max;
+	poll_model(sc, n, &poll_caught, &poll_avg, &poll_max);
+	printf("%-20s pulses=%-5zu edges=%-6u bounces=%-5u detected=%-5u %s latency avg=%.1f max=%u us"
+		   " | 1s poll: detected=%.1f latency avg=%.0f max=%.0f ms\n",
+		   sc->name, n, ta.edges - tb.edges, ta.bounces - tb.bounces, as.sim_triggers,
+		   as.sim_triggers == n ? "(lossless)" : "(LOST)    ", avg_us, as.sim_latency_max_us, poll_caught, poll_avg,
+		   poll_max);
+	return as.sim_triggers == n;
+}
+
+int main(int argc, char **argv)
+{
+	sim_config_t cfg;
+	sim_default_config(&cfg);
+	size_t n = 100;
+	int c;
+	while ((c = getopt(argc, argv, "n:r:vh")) != -1) {
+		switch (c) {
+		case 'n': n = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'r': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'v': cfg.verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-n pulses] [-r seed] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (n == 0) n = 1;
+	if (n > MAX_PULSES) n = MAX_PULSES;
+
+	sim_init(&cfg);
+	app_main();
+	sim_rtos_start_tasks();
+	sim_run_until(sim_now_us() + 2 * 1000 * 1000);
+
+	printf("simulation input: GPIO %d, debounce=%u us, pulse-train min period=%u us\n",
+		   SIMULATION_PIN, TRIGGER_INPUT_DEBOUNCE_US, TRIGGER_INPUT_PULSE_MIN_US);
+	// Latency runs from the timestamp taken in the ISR to the LED update in the actuator task;
+	// the pin to ISR entry adds isr_latency_us and the LED refresh itself led_refresh_us
+	printf("modelled: isr_latency=%u us task_switch=%u us led_refresh=%u us\n",
+		   cfg.isr_latency_us, cfg.task_switch_us, cfg.led_refresh_us);
+	bool ok = true;
+	for (size_t i = 0; i < SCENARIO_COUNT; i++) ok &= run_scenario(&s_scenarios[i], n);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,352 @@
+// Host-side simulator for the coordinator app
+// - Virtual clock and event queue driving esp_zb_scheduler_alarm and FreeRTOS timers
+// - Scriptable stand-in for the ZDO/ZCL requests issued by main/main.c
+// - Air/APS model so request storms behave like they do on the radio
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef SIM_MAX_DEVICES
+#define SIM_MAX_DEVICES         (2048)
+#endif
+#ifndef SIM_MAX_EVENTS
+#define SIM_MAX_EVENTS          (16384)
+#endif
+#ifndef SIM_MAX_ENDPOINTS
+#define SIM_MAX_ENDPOINTS       (4)
+#endif
+#ifndef SIM_STR_MAX
+#define SIM_STR_MAX             (64)
+#endif
+// Clock of the modelled CPU (esp_cpu_get_cycle_count)
+#ifndef SIM_CPU_MHZ
+#define SIM_CPU_MHZ             (160)
+#endif
+// Heap left to the app once ESP-IDF and the Zigbee stack have started (esp_heap_caps.h)
+#ifndef SIM_HEAP_BYTES
+#define SIM_HEAP_BYTES          (200 * 1024)
+#endif
+
+typedef void (*sim_event_fn)(void *ctx, uintptr_t arg);
+
+typedef struct {
+	uint32_t device_latency_us;     // turnaround inside the remote device
+	uint32_t device_jitter_us;      // uniform extra turnaround [0, jitter)
+	uint32_t frame_airtime_us;      // air occupied by one request or response frame
+	uint32_t zdo_timeout_us;        // time before a lost ZDO request reports TIMEOUT
+	uint16_t aps_queue_len;         // outstanding requests the stack accepts before dropping
+	// Modelled cost of driver calls, charged to the calling context (see sim_stats_t.busy_us)
+	uint32_t led_refresh_us;        // led_strip_refresh: the caller waits for the RMT transfer
+	uint32_t ledc_update_us;        // ledc_update_duty
+	uint32_t rtos_call_us;          // timer command or task notification
+	uint32_t isr_latency_us;        // GPIO edge to ISR entry
+	uint32_t task_switch_us;        // notification to the woken task running
+	uint32_t log_byte_us;           // console UART time per log line byte, charged to the logging context
+									// (87 at 115200 baud; 0 by default: log lines cost nothing)
+	uint32_t flash_page_us;         // program one 256-byte flash page
+	uint32_t flash_erase_us;        // erase one 4 KB flash sector
+	uint32_t seed;
+	bool verbose;                   // print app log lines
+} sim_config_t;
+
+// Execution context of the code currently running in the simulator
+typedef enum {
+	SIM_CTX_MAIN,                   // app_main and the harness itself
+	SIM_CTX_ZIGBEE,                 // Zigbee task: signals, ZDO/ZCL callbacks, scheduler alarms
+	SIM_CTX_TIMER,                  // FreeRTOS timer service task
+	SIM_CTX_ISR,                    // interrupt handlers
+	SIM_CTX_TASK,                   // other tasks created with xTaskCreate
+	SIM_CTX_COUNT,
+} sim_ctx_t;
+
+typedef struct {
+	uint8_t endpoint;
+	uint16_t profile_id;
+	uint16_t device_id;
+	uint8_t in_count;
+	uint8_t out_count;
+	uint16_t clusters[8];           // in_count input clusters followed by out_count output clusters
+} sim_endpoint_t;
+
+typedef struct {
+	uint16_t short_addr;
+	uint8_t ieee[8];
+	uint8_t ep_count;
+	sim_endpoint_t eps[SIM_MAX_ENDPOINTS];
+	char manufacturer[SIM_STR_MAX];
+	char model[SIM_STR_MAX];
+	char sw_build[SIM_STR_MAX];
+	bool expect_alert;
+	bool end_device;                // announces capability 0x80 instead of 0x8e (router)
+	uint16_t parent_short;          // router it joined through; 0x0000 is the coordinator
+	uint8_t lqi;                    // link quality to its parent, 0 for 255
+	bool bind_unsupported;          // answers ZDO Bind with NOT_SUPPORTED
+	bool basic_unreportable;        // refuses reporting of the Basic SW build ID
+	bool powered_off;               // answers nothing and sends no reports (sim_power)
+	uint32_t latency_us;            // own turnaround instead of device_latency_us + jitter, 0 = config's
+	// Filled in by the simulator
+	uint64_t announce_us;           // first announce
+	uint16_t announces;
+	uint64_t join_start_us;         // first association attempt (sim_join)
+	uint16_t join_attempts;
+	uint64_t interviewed_us;        // first Basic read response delivered
+	uint64_t alerted_us;            // first ALERT observed
+	uint16_t active_ep_reqs;
+	uint16_t simple_desc_reqs;
+	uint16_t basic_reads;
+	uint16_t alerts;
+	uint16_t binds;                 // ZDO Bind requests answered
+	uint16_t config_reports;        // Configure Reporting commands answered
+	bool onoff_bound, basic_bound;  // bound to the coordinator
+	uint16_t onoff_max_s;           // On/Off maximum reporting interval, 0 = not configured
+	bool basic_reporting;           // SW build ID reported on change
+	bool build_report_pending;      // SW build changed while no report could be sent
+	uint32_t report_gen;            // invalidates scheduled reports on reconfiguration and power changes
+	uint32_t reports;               // attribute reports sent
+	bool left;                      // off the network after sim_leave without rejoin, until it announces
+	bool addr_mapped;               // in the stack's address map, at mapped_short (set by its announces)
+	uint16_t mapped_short;
+	uint16_t ieee_addr_reqs;        // IEEE_addr_req answered
+} sim_device_t;
+
+typedef struct {
+	uint32_t active_ep_reqs;
+	uint32_t simple_desc_reqs;
+	uint32_t zcl_read_reqs;
+	uint32_t dropped;               // requests refused because the APS queue was full
+	uint32_t inflight;
+	uint32_t max_inflight;
+	uint64_t airtime_us;            // total air occupied by requests and responses
+	uint32_t mac_frames;            // frames sent on the network channel
+	uint32_t mac_retries;           // extra attempts after a collision
+	uint32_t mac_failures;          // frames lost after all retries
+	uint64_t scan_us;               // radio time spent in energy detection and active scans
+	uint32_t ed_requests;
+	uint32_t scan_requests;
+	uint32_t permit_join_broadcasts;
+	uint32_t mgmt_lqi_reqs;
+	uint32_t bind_reqs;
+	uint32_t config_report_reqs;
+	uint32_t ieee_addr_reqs;
+	uint32_t reports;               // attribute reports sent by devices
+	uint32_t relayed_frames;        // extra hops for devices behind routers
+	uint32_t joins_refused;         // associations refused: coordinator child table or network size full
+	uint64_t events;
+	uint64_t dispatch_ns;           // wall-clock time spent inside app callbacks
+	uint64_t max_dispatch_ns;
+	uint32_t alerts;
+	uint32_t log_lines;             // lines at INFO and above (the firmware's log level)
+	uint64_t log_bytes[SIM_CTX_COUNT];
+	uint32_t debug_lines;           // ESP_LOGD lines: filtered out on the firmware, not charged
+	uint64_t debug_bytes;
+	uint64_t busy_us[SIM_CTX_COUNT];    // modelled driver time charged to each context
+	uint32_t led_refreshes[SIM_CTX_COUNT];
+	uint32_t ledc_updates[SIM_CTX_COUNT];
+	uint32_t gpio_isrs;             // GPIO interrupt handlers run
+} sim_stats_t;
+
+void sim_default_config(sim_config_t *cfg);
+void sim_init(const sim_config_t *cfg);
+
+// Virtual clock / event queue
+uint64_t sim_now_us(void);
+bool sim_schedule(uint64_t delay_us, sim_event_fn fn, void *ctx, uintptr_t arg);
+void sim_cancel(sim_event_fn fn, void *ctx, uintptr_t arg);
+// Run events until the clock reaches t_us or the queue is empty
+void sim_run_until(uint64_t t_us);
+// Run until done() returns true or the clock reaches deadline; returns done()
+bool sim_run_while(bool (*done)(void), uint64_t deadline_us);
+uint32_t sim_rand(void);
+
+// Devices
+sim_device_t *sim_add_device(const sim_device_t *tmpl);
+sim_device_t *sim_find_device(uint16_t short_addr);
+size_t sim_device_count(void);
+sim_device_t *sim_device_at(size_t i);
+void sim_announce(sim_device_t *dev, uint64_t delay_us);
+// Power on a factory-new device after delay_us: it tries to associate every 3 s until permit
+// join is open, then announces. Devices with parent_short 0 need room in the coordinator's child
+// table (max_children); every device needs room in the network size.
+void sim_join(sim_device_t *dev, uint64_t delay_us);
+// Cut or restore the power of a device. A device powered off answers nothing and stops reporting.
+// Powered on, it announces (rejoin) if announce is set, reports On/Off about a second later when
+// reporting is configured, and its SW build when that changed and is reported.
+void sim_power(sim_device_t *dev, bool on, bool announce);
+// New SW build ID, as after a firmware update; reported at once when the device is powered and
+// reports it, otherwise at the next power-on
+void sim_set_sw_build(sim_device_t *dev, const char *build);
+// Leave the network after delay_us: the coordinator's children send a leave indication, a router
+// reports the others with an Update-Device "left". With rejoin the device announces again
+// SIM_JOIN_ASSOC_US later, at whatever short address it has then; without it, it forgets its
+// bindings and reporting setup and stays away until it announces.
+void sim_leave(sim_device_t *dev, bool rejoin, uint64_t delay_us);
+// A device still on the network the coordinator restored from zb_storage after a restart: in the
+// stack's address map again, and bound to the coordinator as the previous run left it: On/Off
+// reports every onoff_max_s (0: not bound) and SW build reports when basic_reporting. Its
+// first report comes at a random point of the interval.
+void sim_resume_device(sim_device_t *dev, uint16_t onoff_max_s, bool basic_reporting);
+// Move a device to another short address without telling anyone: the stack's address map still
+// has the old one until the device announces
+void sim_set_short(sim_device_t *dev, uint16_t short_addr);
+// IEEE address of the coordinator (esp_zb_get_long_address, esp_read_mac); set it before app_main
+// to tell several simulated coordinators apart
+extern uint8_t sim_coordinator_ieee[8];
+// Hops between the coordinator and the device (1 for its children); frames to and from it are
+// sent once per hop. Devices behind a router also get an Update-Device (DEVICE_UPDATE signal)
+// before each announce.
+uint8_t sim_device_depth(const sim_device_t *dev);
+
+// Test networks shared by the benches
+// Products as they join, with their one endpoint; the bench decides how many of each
+typedef enum {
+	SIM_KIND_IKEA_BULB,
+	SIM_KIND_IKEA_REMOTE_SL,        // IKEA remote on a Silicon Labs OUI: only its strings tell
+	SIM_KIND_HUE,
+	SIM_KIND_AQARA,
+	SIM_KIND_TUYA,
+	SIM_KIND_SONOFF_PLUG,           // router, same Silicon Labs OUI as the remote
+	SIM_KIND_INNR,
+	SIM_KIND_COUNT,
+} sim_kind_t;
+
+typedef struct {
+	const char *name;
+	const char *manufacturer;
+	const char *model;
+	uint32_t oui;
+	bool ikea;                      // alert expected
+	bool end_device;
+	sim_endpoint_t ep;
+} sim_device_kind_t;
+
+extern const sim_device_kind_t sim_device_kinds[SIM_KIND_COUNT];
+// Generator of the network apart from sim_rand, so the same seed draws the same devices in every
+// run of a bench whatever the app takes from sim_rand. Survives sim_init()
+void sim_net_seed(uint32_t seed);
+uint32_t sim_net_rand(void);
+// IEEE address under an OUI: lo in the low three bytes, then i (a device index or address)
+void sim_make_ieee(uint8_t ieee[8], uint32_t oui, uint32_t lo, uint16_t i);
+// Template of a device of the kind for sim_add_device: addresses, endpoint, strings and expected
+// alert set, everything else zero
+void sim_device_of_kind(sim_device_t *d, const sim_device_kind_t *kind, uint16_t short_addr, uint32_t lo, uint16_t i);
+
+// Stack sizing as configured by the app (esp_zb_init and the esp_zb_*_size_set calls)
+typedef struct {
+	uint16_t max_children;
+	uint16_t network_size;
+	uint16_t io_buffers;
+	uint16_t scheduler_queue;
+} sim_zb_sizing_t;
+void sim_zb_get_sizing(sim_zb_sizing_t *out);
+void sim_signal(uint32_t sig, int status, const void *params, size_t len);
+// True once the network is up: formation signal delivered, or network restored from zb_storage
+// (DEVICE_REBOOT)
+bool sim_network_formed(void);
+// Formation requests received: 0 after a restore from zb_storage
+uint32_t sim_formations(void);
+// Permit join state set by esp_zb_bdb_open_network, and the total time it was open
+bool sim_permit_join_open(void);
+uint64_t sim_permit_open_us(void);
+
+// Tasks created by app_main. Each task runs on its own thread, one at a time: it runs until
+// it blocks (task notification, vTaskDelay) and is resumed by simulator events, so blocking
+// tasks behave as on FreeRTOS while the simulation stays deterministic.
+void sim_rtos_start_tasks(void);
+sim_ctx_t sim_ctx(void);
+const char *sim_ctx_name(sim_ctx_t ctx);
+
+// Radio environment seen by energy detection and active scans (channels 11..26).
+// Every channel starts at -95 dBm with no Wi-Fi and no neighbouring PAN.
+// Wi-Fi is bursty: each detection slot sees dbm with probability busy_pct, and the same share
+// of frame attempts on the network channel collide; each neighbouring PAN adds 3 %.
+// Formation without a narrowed channel set picks the quietest of one short detection per channel.
+void sim_set_channel_noise(uint8_t channel, int8_t dbm);
+void sim_set_channel_wifi(uint8_t channel, int8_t dbm, uint8_t busy_pct);
+bool sim_add_pan(uint8_t channel, uint16_t pan_id, bool permit_joining);
+// Neighbouring PAN opening or closing for joining (its beacons' permit-join bit)
+void sim_set_pan_open(uint16_t pan_id, bool permit_joining);
+// Share of frame attempts on the channel that collide (Wi-Fi plus neighbouring PANs)
+uint8_t sim_channel_busy_pct(uint8_t channel);
+// Complete energy detections and active scans at once with TIMEOUT while set
+void sim_fail_scans(bool fail);
+// The next `count` restores from zb_storage (DEVICE_REBOOT) or formations complete with ESP_FAIL
+void sim_fail_restores(uint32_t count);
+void sim_fail_formations(uint32_t count);
+
+// HAL observation
+// Pin level seen by gpio_get_level; an edge matching the pin's intr_type runs its ISR
+// handler isr_latency_us later, in SIM_CTX_ISR
+void sim_gpio_set_level(int gpio, int level);
+// Drive the pin away from its current level (its pull, for an input) after delay_us and back
+// width_us later: a high pulse on a pulled-down pin, a button press on a pulled-up one
+void sim_gpio_pulse(int gpio, uint64_t delay_us, uint32_t width_us);
+uint32_t sim_led_color(void);           // 0xRRGGBB of pixel 0 at last refresh
+uint32_t sim_ledc_duty(void);
+
+// UART transmit side (driver/uart.h): the driver's buffer drains at the baud rate, 10 bits a
+// byte, into the attached file descriptor (-1: discarded). With CTS flow control configured,
+// draining stops while the bench holds CTS deasserted. A write to the descriptor that blocks
+// (a pseudo-terminal nobody reads) blocks the simulation in real time, not on the virtual clock.
+typedef struct {
+	uint64_t bytes;                 // sent on the line
+	uint32_t writes;                // uart_write_bytes calls
+	uint32_t blocked_writes;        // calls that waited for room in the buffer
+	uint64_t held_us;               // time CTS held the line with bytes waiting
+	uint32_t level_peak;            // bytes in the driver's buffer
+} sim_uart_stats_t;
+
+void sim_uart_attach(int port, int fd);
+void sim_uart_set_cts(int port, bool asserted);
+const sim_uart_stats_t *sim_uart_stats(int port);
+
+// Run a serial console command line (as typed at the esp_console REPL) in SIM_CTX_TASK.
+// Returns the command's result, or -1 when the REPL is not started or the command is unknown.
+int sim_console_exec(const char *line);
+
+// NVS contents survive sim_init(); load/save them to emulate a reboot across runs
+typedef struct {
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t commits;
+	uint64_t bytes_written;         // entry headers included
+} sim_nvs_stats_t;
+
+bool sim_nvs_load(const char *path);
+bool sim_nvs_save(const char *path);
+void sim_nvs_reset(void);
+const sim_nvs_stats_t *sim_nvs_stats(void);
+
+// Flash partitions behind esp_partition_* (`evlog`, and `zb_storage` where the stack keeps its
+// network): erase sets 0xFF and a write can only clear bits. Contents survive sim_init();
+// save/load them to emulate a reboot across runs.
+typedef struct {
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t erases;                // 4 KB sectors
+	uint64_t bytes_written;
+	uint64_t busy_us;               // modelled program and erase time
+	uint32_t overwrites;            // written bytes that needed a 0 -> 1 bit change (missing erase)
+} sim_flash_stats_t;
+
+bool sim_flash_load(const char *label, const char *path);
+bool sim_flash_save(const char *label, const char *path);
+void sim_flash_reset(void);
+const sim_flash_stats_t *sim_flash_stats(void);
+// The next `count` esp_partition_write() calls fail with ESP_FAIL and program nothing
+void sim_flash_fail_writes(uint32_t count);
+// esp_reset_reason() of the next boot (esp_reset_reason_t; ESP_RST_POWERON by default)
+void sim_set_reset_reason(int reason);
+
+// Heap accounting of everything linked into the harness (app + simulator)
+size_t sim_heap_current(void);
+size_t sim_heap_peak(void);
+void sim_heap_reset_peak(void);
+
+const sim_stats_t *sim_stats(void);
+const sim_config_t *sim_config(void);
+uint64_t sim_wall_ns(void);
+
+// Called by the app stubs
+void sim_zb_on_alert_line(const char *line);
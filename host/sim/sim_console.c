@@ -0,0 +1,82 @@
+// esp_console stand-in: registered commands run from sim_console_exec() in the REPL task context
+
+#include <stdio.h>
+#include <string.h>
+#include "sim_internal.h"
+#include "esp_console.h"
+
+#define SIM_CONSOLE_MAX_CMDS    (16)
+#define SIM_CONSOLE_MAX_ARGS    (8)
+
+struct esp_console_repl_s {
+	int unused;
+};
+
+static esp_console_cmd_t s_cmds[SIM_CONSOLE_MAX_CMDS];
+static size_t s_cmd_count;
+static bool s_started;
+static esp_console_repl_t s_repl;
+
+void sim_console_reset(void)
+{
+	memset(s_cmds, 0, sizeof(s_cmds));
+	s_cmd_count = 0;
+	s_started = false;
+}
+
+esp_err_t esp_console_new_repl_uart(const esp_console_dev_uart_config_t *dev_config,
+									const esp_console_repl_config_t *repl_config, esp_console_repl_t **ret_repl)
+{
+	(void)dev_config;
+	(void)repl_config;
+	*ret_repl = &s_repl;
+	return ESP_OK;
+}
+
+esp_err_t esp_console_new_repl_usb_serial_jtag(const esp_console_dev_usb_serial_jtag_config_t *dev_config,
+											   const esp_console_repl_config_t *repl_config, esp_console_repl_t **ret_repl)
+{
+	(void)dev_config;
+	return esp_console_new_repl_uart(NULL, repl_config, ret_repl);
+}
+
+esp_err_t esp_console_start_repl(esp_console_repl_t *repl)
+{
+	(void)repl;
+	s_started = true;
+	return ESP_OK;
+}
+
+esp_err_t esp_console_cmd_register(const esp_console_cmd_t *cmd)
+{
+	if (!cmd || !cmd->command || !cmd->func) return ESP_ERR_INVALID_ARG;
+	if (s_cmd_count >= SIM_CONSOLE_MAX_CMDS) return ESP_ERR_NO_MEM;
+	s_cmds[s_cmd_count++] = *cmd;
+	return ESP_OK;
+}
+
+esp_err_t esp_console_register_help_command(void)
+{
+	return ESP_OK;
+}
+
+int sim_console_exec(const char *line)
+{
+	char buf[128];
+	char *argv[SIM_CONSOLE_MAX_ARGS];
+	int argc = 0;
+	if (!s_started) return -1;
+	snprintf(buf, sizeof(buf), "%s", line);
+	for (char *tok = strtok(buf, " \t\n"); tok && argc < SIM_CONSOLE_MAX_ARGS; tok = strtok(NULL, " \t\n")) {
+		argv[argc++] = tok;
+	}
+	if (!argc) return 0;
+	for (size_t i = 0; i < s_cmd_count; i++) {
+		if (strcmp(s_cmds[i].command, argv[0]) != 0) continue;
+		sim_ctx_t prev = sim_ctx_enter(SIM_CTX_TASK);
+		int rc = s_cmds[i].func(argc, argv);
+		sim_ctx_restore(prev);
+		return rc;
+	}
+	return -1;
+}
@@ -0,0 +1,343 @@
+// Virtual clock, event queue, logging and heap accounting for the host simulator
+
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include "sim_internal.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+
+typedef struct {
+	uint64_t at_us;
+	uint64_t seq;
+	sim_event_fn fn;
+	void *ctx;
+	uintptr_t arg;
+} sim_event_t;
+
+static sim_config_t s_cfg;
+static sim_stats_t s_stats;
+static uint64_t s_now_us;
+static uint64_t s_seq;
+static sim_event_t s_heap[SIM_MAX_EVENTS];
+static size_t s_heap_len;
+static uint32_t s_rng;
+
+static sim_ctx_t s_ctx = SIM_CTX_MAIN;
+
+static size_t s_heap_cur;
+static size_t s_heap_peak;
+static size_t s_heap_max;           // peak since start, for heap_caps_get_minimum_free_size
+
+void sim_default_config(sim_config_t *cfg)
+{
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->device_latency_us = 8000;
+	cfg->device_jitter_us = 12000;
+	cfg->frame_airtime_us = 2500;   // ~60 byte frame at 250 kbit/s + CSMA backoff
+	cfg->zdo_timeout_us = 5 * 1000 * 1000;
+	cfg->aps_queue_len = 16;
+	cfg->led_refresh_us = 110;      // 24 bits x 1.25 us + 80 us reset latch + driver overhead
+	cfg->ledc_update_us = 6;
+	cfg->rtos_call_us = 3;
+	cfg->isr_latency_us = 2;        // interrupt entry through the GPIO ISR service dispatcher
+	cfg->task_switch_us = 5;
+	cfg->flash_page_us = 600;       // page program, typical for the module's SPI NOR flash
+	cfg->flash_erase_us = 45000;    // sector erase, typical
+	cfg->seed = 1;
+}
+
+void sim_init(const sim_config_t *cfg)
+{
+	s_cfg = *cfg;
+	memset(&s_stats, 0, sizeof(s_stats));
+	s_now_us = 0;
+	s_seq = 0;
+	s_heap_len = 0;
+	s_rng = cfg->seed ? cfg->seed : 1;
+	s_ctx = SIM_CTX_MAIN;
+	sim_zb_reset();
+	sim_rtos_reset();
+	sim_hal_reset();
+	sim_uart_reset();
+	sim_console_reset();
+	sim_flash_reset_stats();
+}
+
+const sim_config_t *sim_config(void) { return &s_cfg; }
+const sim_stats_t *sim_stats(void) { return &s_stats; }
+sim_stats_t *sim_stats_mut(void) { return &s_stats; }
+uint64_t sim_now_us(void) { return s_now_us; }
+
+sim_ctx_t sim_ctx(void) { return s_ctx; }
+
+sim_ctx_t sim_ctx_enter(sim_ctx_t ctx)
+{
+	sim_ctx_t prev = s_ctx;
+	s_ctx = ctx;
+	return prev;
+}
+
+void sim_ctx_restore(sim_ctx_t prev)
+{
+	s_ctx = prev;
+}
+
+const char *sim_ctx_name(sim_ctx_t ctx)
+{
+	static const char *const names[SIM_CTX_COUNT] = { "main", "zigbee", "timer", "isr", "task" };
+	return ctx < SIM_CTX_COUNT ? names[ctx] : "?";
+}
+
+void sim_charge_us(uint32_t us)
+{
+	s_stats.busy_us[s_ctx] += us;
+}
+
+uint64_t sim_wall_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Host CPU time plus the driver time modelled so far, in cycles at SIM_CPU_MHZ
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+	uint64_t busy_us = 0;
+	for (int i = 0; i < SIM_CTX_COUNT; i++) busy_us += s_stats.busy_us[i];
+	return (esp_cpu_cycle_count_t)(sim_wall_ns() * SIM_CPU_MHZ / 1000 + busy_us * SIM_CPU_MHZ);
+}
+
+uint32_t sim_rand(void)
+{
+	// xorshift32: deterministic across platforms for a given seed
+	uint32_t x = s_rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	s_rng = x;
+	return x;
+}
+
+static bool ev_less(const sim_event_t *a, const sim_event_t *b)
+{
+	return a->at_us < b->at_us || (a->at_us == b->at_us && a->seq < b->seq);
+}
+
+bool sim_schedule(uint64_t delay_us, sim_event_fn fn, void *ctx, uintptr_t arg)
+{
+	if (s_heap_len >= SIM_MAX_EVENTS) {
+		fprintf(stderr, "sim: event queue full\n");
+		return false;
+	}
+	size_t i = s_heap_len++;
+	sim_event_t ev = { .at_us = s_now_us + delay_us, .seq = s_seq++, .fn = fn, .ctx = ctx, .arg = arg };
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (!ev_less(&ev, &s_heap[parent])) break;
+		s_heap[i] = s_heap[parent];
+		i = parent;
+	}
+	s_heap[i] = ev;
+	return true;
+}
+
+static sim_event_t heap_pop(void)
+{
+	sim_event_t top = s_heap[0];
+	sim_event_t last = s_heap[--s_heap_len];
+	size_t i = 0;
+	for (;;) {
+		size_t l = 2 * i + 1, r = l + 1, m = i;
+		const sim_event_t *best = &last;
+		if (l < s_heap_len && ev_less(&s_heap[l], best)) { m = l; best = &s_heap[l]; }
+		if (r < s_heap_len && ev_less(&s_heap[r], best)) { m = r; }
+		if (m == i) break;
+		s_heap[i] = s_heap[m];
+		i = m;
+	}
+	if (s_heap_len) s_heap[i] = last;
+	return top;
+}
+
+static void ev_noop(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	(void)arg;
+}
+
+void sim_cancel(sim_event_fn fn, void *ctx, uintptr_t arg)
+{
+	// Cancelled events stay in the heap and fire as no-ops
+	for (size_t i = 0; i < s_heap_len; i++) {
+		if (s_heap[i].fn == fn && s_heap[i].ctx == ctx && s_heap[i].arg == arg) {
+			s_heap[i].fn = ev_noop;
+		}
+	}
+}
+
+static void dispatch_one(void)
+{
+	sim_event_t ev = heap_pop();
+	if (ev.at_us > s_now_us) s_now_us = ev.at_us;
+	uint64_t t0 = sim_wall_ns();
+	ev.fn(ev.ctx, ev.arg);
+	uint64_t dt = sim_wall_ns() - t0;
+	s_stats.events++;
+	s_stats.dispatch_ns += dt;
+	if (dt > s_stats.max_dispatch_ns) s_stats.max_dispatch_ns = dt;
+}
+
+void sim_run_until(uint64_t t_us)
+{
+	while (s_heap_len && s_heap[0].at_us <= t_us) {
+		dispatch_one();
+	}
+	if (t_us > s_now_us) s_now_us = t_us;
+}
+
+bool sim_run_while(bool (*done)(void), uint64_t deadline_us)
+{
+	while (!done()) {
+		if (!s_heap_len || s_heap[0].at_us > deadline_us) {
+			if (deadline_us > s_now_us) s_now_us = deadline_us;
+			return done();
+		}
+		dispatch_one();
+	}
+	return true;
+}
+
+// ---- Logging -----------------------------------------------------------------
+
+void sim_log_write(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+	// Always format: the firmware pays this cost on every log line too (debug lines are only
+	// formatted here, to be counted)
+	char line[256];
+	va_list ap;
+	va_start(ap, fmt);
+	int len = vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	// "I (12345) ZB_SCAN: " prefix and line end
+	uint32_t bytes = (uint32_t)(len > 0 ? len : 0) + 22;
+	if (level > ESP_LOG_INFO) {
+		s_stats.debug_lines++;
+		s_stats.debug_bytes += bytes;
+	} else {
+		s_stats.log_lines++;
+		s_stats.log_bytes[s_ctx] += bytes;
+		sim_charge_us(bytes * s_cfg.log_byte_us);
+	}
+	if (level == ESP_LOG_WARN && strncmp(line, "ALERT", 5) == 0) {
+		sim_zb_on_alert_line(line);
+	}
+	if (s_cfg.verbose) {
+		static const char lvl[] = "NEWIDV";
+		printf("%c (%llu) %s: %s\n", lvl[level], (unsigned long long)(s_now_us / 1000), tag, line);
+	}
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+	switch (code) {
+	case ESP_OK: return "ESP_OK";
+	case ESP_FAIL: return "ESP_FAIL";
+	case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+	case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+	case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+	case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+	case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+	case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+	case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+	default: return "ERROR";
+	}
+}
+
+// ---- Heap accounting (linked with -Wl,--wrap=malloc,...) -----------------------
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+void __real_free(void *p);
+
+// The app may define these (CONFIG_HEAP_USE_HOOKS on the target)
+__attribute__((weak)) void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+	(void)ptr;
+	(void)size;
+	(void)caps;
+}
+
+__attribute__((weak)) void esp_heap_trace_free_hook(void *ptr)
+{
+	(void)ptr;
+}
+
+static void heap_add(void *p)
+{
+	if (!p) return;
+	esp_heap_trace_alloc_hook(p, malloc_usable_size(p), MALLOC_CAP_DEFAULT);
+	s_heap_cur += malloc_usable_size(p);
+	if (s_heap_cur > s_heap_peak) s_heap_peak = s_heap_cur;
+	if (s_heap_cur > s_heap_max) s_heap_max = s_heap_cur;
+}
+
+void *__wrap_malloc(size_t size)
+{
+	void *p = __real_malloc(size);
+	heap_add(p);
+	return p;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+	void *p = __real_calloc(n, size);
+	heap_add(p);
+	return p;
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+	if (p) {
+		esp_heap_trace_free_hook(p);
+		s_heap_cur -= malloc_usable_size(p);
+	}
+	void *q = __real_realloc(p, size);
+	if (q) {
+		heap_add(q);
+	} else if (p) {
+		esp_heap_trace_alloc_hook(p, malloc_usable_size(p), MALLOC_CAP_DEFAULT);
+		s_heap_cur += malloc_usable_size(p);
+	}
+	return q;
+}
+
+void __wrap_free(void *p)
+{
+	if (p) {
+		esp_heap_trace_free_hook(p);
+		s_heap_cur -= malloc_usable_size(p);
+	}
+	__real_free(p);
+}
+
+size_t sim_heap_current(void) { return s_heap_cur; }
+size_t sim_heap_peak(void) { return s_heap_peak; }
+void sim_heap_reset_peak(void) { s_heap_peak = s_heap_cur; }
+
+static size_t heap_left(size_t used)
+{
+	return used < SIM_HEAP_BYTES ? SIM_HEAP_BYTES - used : 0;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) { (void)caps; return heap_left(s_heap_cur); }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { (void)caps; return heap_left(s_heap_max); }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { (void)caps; return heap_left(s_heap_cur); }
+size_t heap_caps_get_allocated_size(void *ptr) { return ptr ? malloc_usable_size(ptr) : 0; }
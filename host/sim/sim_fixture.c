@@ -0,0 +1,69 @@
+// Test networks for the benches: device kinds, their own generator and IEEE addresses
+
+#include <stdio.h>
+#include <string.h>
+#include "sim_internal.h"
+
+// The OUIs these devices ship with: chip vendors' blocks (Silicon Labs, Telink) are shared by
+// many brands and only the vendors' own blocks are in classify_rules.h
+const sim_device_kind_t sim_device_kinds[SIM_KIND_COUNT] = {
+	[SIM_KIND_IKEA_BULB] = { "ikea", "IKEA of Sweden", "TRADFRI bulb E27 WS opal 980lm", 0x000B57, true, false,
+		{ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x010C, .in_count = 6, .out_count = 1,
+		  .clusters = { 0x0000, 0x0003, 0x0004, 0x0006, 0x0008, 0xFC7C, 0x0019 } } },
+	[SIM_KIND_IKEA_REMOTE_SL] = { "ikea-sl2", "IKEA of Sweden", "TRADFRI remote control", 0x842E14, true, true,
+		{ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0820, .in_count = 4, .out_count = 1,
+		  .clusters = { 0x0000, 0x0001, 0x0003, 0xFC7C, 0x0019 } } },
+	[SIM_KIND_HUE] = { "hue", "Signify Netherlands B.V.", "LCA001", 0x001788, false, false,
+		{ .endpoint = 11, .profile_id = 0x0104, .device_id = 0x010D, .in_count = 5, .out_count = 1,
+		  .clusters = { 0x0000, 0x0003, 0x0004, 0x0006, 0x0008, 0x0019 } } },
+	[SIM_KIND_AQARA] = { "aqara", "LUMI", "lumi.weather", 0x00158D, false, true,
+		{ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x5F01, .in_count = 3,
+		  .clusters = { 0x0000, 0x0003, 0xFFFF } } },
+	[SIM_KIND_TUYA] = { "tuya", "_TZE200_cwbvmsar", "TS0601", 0xA4C138, false, false,
+		{ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x0051, .in_count = 4, .out_count = 2,
+		  .clusters = { 0x0000, 0x0004, 0x0005, 0xEF00, 0x000A, 0x0019 } } },
+	[SIM_KIND_SONOFF_PLUG] = { "sonoff", "SONOFF", "S26R2ZB", 0x842E14, false, false,
+		{ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x010A, .in_count = 4,
+		  .clusters = { 0x0000, 0x0003, 0x0006, 0x0702 } } },
+	[SIM_KIND_INNR] = { "innr", "innr", "RB 285 C", 0x04CD15, false, false,
+		{ .endpoint = 1, .profile_id = 0x0104, .device_id = 0x010D, .in_count = 5, .out_count = 1,
+		  .clusters = { 0x0000, 0x0003, 0x0004, 0x0006, 0x0008, 0x0019 } } },
+};
+
+static uint32_t s_net_rng = 1;
+
+void sim_net_seed(uint32_t seed)
+{
+	s_net_rng = seed * 2654435761u | 1;
+}
+
+uint32_t sim_net_rand(void)
+{
+	// xorshift32, as sim_rand
+	uint32_t x = s_net_rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	s_net_rng = x;
+	return x;
+}
+
+void sim_make_ieee(uint8_t ieee[8], uint32_t oui, uint32_t lo, uint16_t i)
+{
+	ieee[0] = (uint8_t)lo; ieee[1] = (uint8_t)(lo >> 8); ieee[2] = (uint8_t)(lo >> 16);
+	ieee[3] = (uint8_t)(i >> 8); ieee[4] = (uint8_t)i;
+	ieee[5] = (uint8_t)oui; ieee[6] = (uint8_t)(oui >> 8); ieee[7] = (uint8_t)(oui >> 16);
+}
+
+void sim_device_of_kind(sim_device_t *d, const sim_device_kind_t *kind, uint16_t short_addr, uint32_t lo, uint16_t i)
+{
+	memset(d, 0, sizeof(*d));
+	d->short_addr = short_addr;
+	sim_make_ieee(d->ieee, kind->oui, lo, i);
+	d->ep_count = 1;
+	d->eps[0] = kind->ep;
+	d->end_device = kind->end_device;
+	d->expect_alert = kind->ikea;
+	snprintf(d->manufacturer, sizeof(d->manufacturer), "%s", kind->manufacturer);
+	snprintf(d->model, sizeof(d->model), "%s", kind->model);
+}
@@ -0,0 +1,180 @@
+// Flash model behind esp_partition_*: the app-owned partitions of partitions.csv as NOR flash
+// (erase sets 0xFF, a write can only clear bits) with erase/program time charged to the caller.
+// Contents survive sim_init(); save/load them to emulate a reboot across runs.
+
+#include <stdio.h>
+#include <string.h>
+#include "sim_internal.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+
+#define SIM_FLASH_SECTOR        (4096)
+#define SIM_FLASH_PAGE          (256)
+
+// Offsets as laid out from partitions.csv
+static esp_partition_t s_parts[] = {
+	{ .type = (esp_partition_type_t)0x40, .subtype = (esp_partition_subtype_t)0x00, .address = 0x155000,
+	  .size = 64 * 1024, .erase_size = SIM_FLASH_SECTOR, .label = "evlog" },
+	{ .type = ESP_PARTITION_TYPE_DATA, .subtype = ESP_PARTITION_SUBTYPE_DATA_FAT, .address = 0x150000,
+	  .size = 16 * 1024, .erase_size = SIM_FLASH_SECTOR, .label = "zb_storage" },
+};
+#define SIM_FLASH_PARTS         (sizeof(s_parts) / sizeof(s_parts[0]))
+
+static uint8_t s_evlog[64 * 1024];
+static uint8_t s_zb_storage[16 * 1024];
+static uint8_t *const s_data[SIM_FLASH_PARTS] = { s_evlog, s_zb_storage };
+static sim_flash_stats_t s_flash_stats;
+static uint32_t s_fail_writes;
+static esp_reset_reason_t s_reset_reason = ESP_RST_POWERON;
+
+static bool s_initialised;
+
+// Factory-fresh flash reads as erased
+static void ensure_blank(void)
+{
+	if (s_initialised) return;
+	s_initialised = true;
+	for (size_t i = 0; i < SIM_FLASH_PARTS; i++) memset(s_data[i], 0xFF, s_parts[i].size);
+}
+
+static int part_index(const esp_partition_t *p)
+{
+	for (size_t i = 0; i < SIM_FLASH_PARTS; i++) {
+		if (p == &s_parts[i]) return (int)i;
+	}
+	return -1;
+}
+
+static int find_label(const char *label)
+{
+	for (size_t i = 0; i < SIM_FLASH_PARTS; i++) {
+		if (strcmp(s_parts[i].label, label) == 0) return (int)i;
+	}
+	return -1;
+}
+
+void sim_flash_reset(void)
+{
+	s_initialised = true;
+	for (size_t i = 0; i < SIM_FLASH_PARTS; i++) memset(s_data[i], 0xFF, s_parts[i].size);
+	memset(&s_flash_stats, 0, sizeof(s_flash_stats));
+}
+
+void sim_flash_reset_stats(void)
+{
+	memset(&s_flash_stats, 0, sizeof(s_flash_stats));
+	s_fail_writes = 0;
+}
+
+void sim_flash_fail_writes(uint32_t count)
+{
+	s_fail_writes = count;
+}
+
+const sim_flash_stats_t *sim_flash_stats(void) { return &s_flash_stats; }
+
+bool sim_flash_load(const char *label, const char *path)
+{
+	ensure_blank();
+	int i = find_label(label);
+	FILE *f = i < 0 ? NULL : fopen(path, "rb");
+	if (!f) return false;
+	size_t n = fread(s_data[i], 1, s_parts[i].size, f);
+	fclose(f);
+	return n == s_parts[i].size;
+}
+
+bool sim_flash_save(const char *label, const char *path)
+{
+	ensure_blank();
+	int i = find_label(label);
+	FILE *f = i < 0 ? NULL : fopen(path, "wb");
+	if (!f) return false;
+	size_t n = fwrite(s_data[i], 1, s_parts[i].size, f);
+	fclose(f);
+	return n == s_parts[i].size;
+}
+
+uint8_t *sim_flash_part_data(const char *label, size_t *size)
+{
+	ensure_blank();
+	int i = find_label(label);
+	if (i < 0) return NULL;
+	if (size) *size = s_parts[i].size;
+	return s_data[i];
+}
+
+void sim_set_reset_reason(int reason)
+{
+	s_reset_reason = (esp_reset_reason_t)reason;
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+	return s_reset_reason;
+}
+
+// ---- esp_partition API ---------------------------------------------------------
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+												const char *label)
+{
+	ensure_blank();
+	for (size_t i = 0; i < SIM_FLASH_PARTS; i++) {
+		const esp_partition_t *p = &s_parts[i];
+		if (p->type != type) continue;
+		if (subtype != ESP_PARTITION_SUBTYPE_ANY && p->subtype != subtype) continue;
+		if (label && strcmp(p->label, label) != 0) continue;
+		return p;
+	}
+	return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+	int i = part_index(partition);
+	if (i < 0 || !dst) return ESP_ERR_INVALID_ARG;
+	if (src_offset > partition->size || size > partition->size - src_offset) return ESP_ERR_INVALID_SIZE;
+	memcpy(dst, s_data[i] + src_offset, size);
+	s_flash_stats.reads++;
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+	int i = part_index(partition);
+	if (i < 0 || !src) return ESP_ERR_INVALID_ARG;
+	if (dst_offset > partition->size || size > partition->size - dst_offset) return ESP_ERR_INVALID_SIZE;
+	if (s_fail_writes) {
+		s_fail_writes--;
+		return ESP_FAIL;
+	}
+	uint8_t *d = s_data[i] + dst_offset;
+	const uint8_t *s = (const uint8_t *)src;
+	for (size_t k = 0; k < size; k++) {
+		// NOR flash: programming only clears bits
+		if (s[k] & ~d[k]) s_flash_stats.overwrites++;
+		d[k] &= s[k];
+	}
+	size_t pages = size ? (dst_offset + size - 1) / SIM_FLASH_PAGE - dst_offset / SIM_FLASH_PAGE + 1 : 0;
+	uint32_t us = (uint32_t)pages * sim_config()->flash_page_us;
+	sim_charge_us(us);
+	s_flash_stats.writes++;
+	s_flash_stats.bytes_written += size;
+	s_flash_stats.busy_us += us;
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+	int i = part_index(partition);
+	if (i < 0) return ESP_ERR_INVALID_ARG;
+	if (offset % SIM_FLASH_SECTOR || size % SIM_FLASH_SECTOR) return ESP_ERR_INVALID_SIZE;
+	if (offset > partition->size || size > partition->size - offset) return ESP_ERR_INVALID_SIZE;
+	memset(s_data[i] + offset, 0xFF, size);
+	uint32_t us = (uint32_t)(size / SIM_FLASH_SECTOR) * sim_config()->flash_erase_us;
+	sim_charge_us(us);
+	s_flash_stats.erases += (uint32_t)(size / SIM_FLASH_SECTOR);
+	s_flash_stats.busy_us += us;
+	return ESP_OK;
+}
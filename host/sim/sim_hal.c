@@ -0,0 +1,192 @@
+// GPIO, LEDC, LED strip and NVS stand-ins
+
+#include <stdlib.h>
+#include <string.h>
+#include "sim_internal.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "led_strip.h"
+#include "nvs_flash.h"
+
+struct sim_led_strip {
+	uint32_t pixel;
+	uint32_t shown;
+};
+
+static int s_gpio_level[64];
+static struct {
+	gpio_int_type_t intr_type;
+	gpio_isr_t fn;
+	void *arg;
+} s_gpio_isr[64];
+static bool s_isr_service;
+static uint32_t s_ledc_duty_pending;
+static uint32_t s_ledc_duty;
+static uint32_t s_led_color;
+
+void sim_hal_reset(void)
+{
+	memset(s_gpio_level, 0, sizeof(s_gpio_level));
+	memset(s_gpio_isr, 0, sizeof(s_gpio_isr));
+	s_isr_service = false;
+	s_ledc_duty_pending = 0;
+	s_ledc_duty = 0;
+	s_led_color = 0;
+}
+
+static void gpio_isr_fire(void *ctx, uintptr_t gpio)
+{
+	(void)ctx;
+	if (!s_isr_service || !s_gpio_isr[gpio].fn) return;
+	sim_stats_mut()->gpio_isrs++;
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ISR);
+	s_gpio_isr[gpio].fn(s_gpio_isr[gpio].arg);
+	sim_ctx_restore(prev);
+}
+
+void sim_gpio_set_level(int gpio, int level)
+{
+	if (gpio < 0 || gpio >= 64) return;
+	int old = s_gpio_level[gpio];
+	s_gpio_level[gpio] = level = level ? 1 : 0;
+	bool fire;
+	switch (s_gpio_isr[gpio].intr_type) {
+	case GPIO_INTR_POSEDGE: fire = !old && level; break;
+	case GPIO_INTR_NEGEDGE: fire = old && !level; break;
+	case GPIO_INTR_ANYEDGE: fire = old != level; break;
+	case GPIO_INTR_HIGH_LEVEL: fire = level; break;
+	case GPIO_INTR_LOW_LEVEL: fire = !level; break;
+	default: fire = false; break;
+	}
+	if (fire) sim_schedule(sim_config()->isr_latency_us, gpio_isr_fire, NULL, (uintptr_t)gpio);
+}
+
+static void gpio_pulse_edge(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	sim_gpio_set_level((int)(arg >> 1), (int)(arg & 1));
+}
+
+void sim_gpio_pulse(int gpio, uint64_t delay_us, uint32_t width_us)
+{
+	uintptr_t rest = (gpio >= 0 && gpio < 64) ? (uintptr_t)s_gpio_level[gpio] : 0;
+	sim_schedule(delay_us, gpio_pulse_edge, NULL, ((uintptr_t)gpio << 1) | !rest);
+	sim_schedule(delay_us + width_us, gpio_pulse_edge, NULL, ((uintptr_t)gpio << 1) | rest);
+}
+
+uint32_t sim_led_color(void) { return s_led_color; }
+uint32_t sim_ledc_duty(void) { return s_ledc_duty; }
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+	for (int pin = 0; pin < 64; pin++) {
+		if (!(cfg->pin_bit_mask & (1ULL << pin))) continue;
+		s_gpio_isr[pin].intr_type = cfg->intr_type;
+		// An unconnected input rests at its pull
+		if (cfg->pull_up_en == GPIO_PULLUP_ENABLE) s_gpio_level[pin] = 1;
+		if (cfg->pull_down_en == GPIO_PULLDOWN_ENABLE) s_gpio_level[pin] = 0;
+	}
+	return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+	if (gpio_num < 0 || gpio_num >= 64) return ESP_ERR_INVALID_ARG;
+	s_gpio_isr[gpio_num].intr_type = intr_type;
+	return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+	(void)intr_alloc_flags;
+	if (s_isr_service) return ESP_ERR_INVALID_STATE;
+	s_isr_service = true;
+	return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void)
+{
+	s_isr_service = false;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+	if (gpio_num < 0 || gpio_num >= 64) return ESP_ERR_INVALID_ARG;
+	if (!s_isr_service) return ESP_ERR_INVALID_STATE;
+	s_gpio_isr[gpio_num].fn = isr_handler;
+	s_gpio_isr[gpio_num].arg = args;
+	return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+	if (gpio_num < 0 || gpio_num >= 64) return ESP_ERR_INVALID_ARG;
+	s_gpio_isr[gpio_num].fn = NULL;
+	return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+	return (gpio_num >= 0 && gpio_num < 64) ? s_gpio_level[gpio_num] : 0;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *cfg) { (void)cfg; return ESP_OK; }
+esp_err_t ledc_channel_config(const ledc_channel_config_t *cfg) { (void)cfg; return ESP_OK; }
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty)
+{
+	(void)mode;
+	(void)channel;
+	s_ledc_duty_pending = duty;
+	return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+	(void)mode;
+	(void)channel;
+	sim_charge_us(sim_config()->ledc_update_us);
+	sim_stats_mut()->ledc_updates[sim_ctx()]++;
+	s_ledc_duty = s_ledc_duty_pending;
+	return ESP_OK;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config,
+								   const led_strip_rmt_config_t *rmt_config,
+								   led_strip_handle_t *ret_strip)
+{
+	(void)led_config;
+	(void)rmt_config;
+	*ret_strip = (led_strip_handle_t)calloc(1, sizeof(struct sim_led_strip));
+	return *ret_strip ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index,
+							  uint32_t red, uint32_t green, uint32_t blue)
+{
+	if (index != 0) return ESP_OK;
+	// The app sends GRB order through the RGB arguments; store what reaches the LED
+	strip->pixel = ((green & 0xff) << 16) | ((red & 0xff) << 8) | (blue & 0xff);
+	return ESP_OK;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip)
+{
+	// The RMT driver blocks the caller until the frame has been sent
+	sim_charge_us(sim_config()->led_refresh_us);
+	sim_stats_mut()->led_refreshes[sim_ctx()]++;
+	strip->shown = strip->pixel;
+	s_led_color = strip->shown;
+	return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip)
+{
+	strip->pixel = 0;
+	return led_strip_refresh(strip);
+}
+
+esp_err_t nvs_flash_init(void)
+{
+	return ESP_OK;
+}
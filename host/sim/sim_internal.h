@@ -0,0 +1,21 @@
+// Shared between the simulator translation units only
+#pragma once
+
+#include "sim.h"
+
+sim_stats_t *sim_stats_mut(void);
+void sim_zb_reset(void);
+void sim_rtos_reset(void);
+void sim_hal_reset(void);
+void sim_uart_reset(void);
+void sim_console_reset(void);
+void sim_flash_reset_stats(void);
+// Contents of a partition for the stack model's own storage (zb_storage): not counted in the
+// flash statistics, which are the app's
+uint8_t *sim_flash_part_data(const char *label, size_t *size);
+
+// Run code in a context; returns the previous one for sim_ctx_restore()
+sim_ctx_t sim_ctx_enter(sim_ctx_t ctx);
+void sim_ctx_restore(sim_ctx_t prev);
+// Charge modelled driver time to the current context
+void sim_charge_us(uint32_t us);
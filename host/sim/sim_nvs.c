@@ -0,0 +1,201 @@
+// In-memory NVS with write accounting; can be loaded from / saved to a file to emulate reboots.
+// Allocates where ESP-IDF's NVS does (a handle entry per open handle, a page list per blob write),
+// so the heap guard sees them
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_internal.h"
+#include "nvs.h"
+
+#ifndef SIM_NVS_MAX_ITEMS
+#define SIM_NVS_MAX_ITEMS       (128)
+#endif
+#ifndef SIM_NVS_MAX_BLOB
+#define SIM_NVS_MAX_BLOB        (4000)
+#endif
+// Usable space of the 0x6000 `nvs` partition (one page is kept free for compaction)
+#ifndef SIM_NVS_CAPACITY
+#define SIM_NVS_CAPACITY        (5 * 4096 - 5 * 32 * 4)
+#endif
+#define SIM_NVS_MAX_HANDLES     (8)
+// nvs::HandleEntry and the UsedPageNode list of a multi-page blob write
+#define SIM_NVS_HANDLE_ALLOC    (48)
+#define SIM_NVS_BLOB_ALLOC      (24)
+
+typedef struct {
+	bool used;
+	char ns[16];
+	char key[16];
+	uint16_t len;
+	uint8_t data[SIM_NVS_MAX_BLOB];
+} sim_nvs_item_t;
+
+static sim_nvs_item_t s_items[SIM_NVS_MAX_ITEMS];
+static char s_handles[SIM_NVS_MAX_HANDLES][16];
+static void *s_handle_entries[SIM_NVS_MAX_HANDLES];
+static void *volatile s_blob_pages;
+static sim_nvs_stats_t s_nvs_stats;
+
+void sim_nvs_reset(void)
+{
+	memset(s_items, 0, sizeof(s_items));
+	memset(s_handles, 0, sizeof(s_handles));
+	for (size_t i = 0; i < SIM_NVS_MAX_HANDLES; i++) {
+		free(s_handle_entries[i]);
+		s_handle_entries[i] = NULL;
+	}
+	memset(&s_nvs_stats, 0, sizeof(s_nvs_stats));
+}
+
+const sim_nvs_stats_t *sim_nvs_stats(void) { return &s_nvs_stats; }
+
+static size_t used_bytes(void)
+{
+	size_t total = 0;
+	for (size_t i = 0; i < SIM_NVS_MAX_ITEMS; i++) {
+		// 32-byte entry header + data rounded up to 32-byte entries
+		if (s_items[i].used) total += 32 + ((s_items[i].len + 31u) / 32u) * 32u;
+	}
+	return total;
+}
+
+static sim_nvs_item_t *find(const char *ns, const char *key)
+{
+	for (size_t i = 0; i < SIM_NVS_MAX_ITEMS; i++) {
+		if (s_items[i].used && strcmp(s_items[i].ns, ns) == 0 && strcmp(s_items[i].key, key) == 0) {
+			return &s_items[i];
+		}
+	}
+	return NULL;
+}
+
+static const char *handle_ns(nvs_handle_t h)
+{
+	if (h == 0 || h > SIM_NVS_MAX_HANDLES || !s_handles[h - 1][0]) return NULL;
+	return s_handles[h - 1];
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+	(void)open_mode;
+	for (nvs_handle_t i = 0; i < SIM_NVS_MAX_HANDLES; i++) {
+		if (!s_handles[i][0]) {
+			s_handle_entries[i] = malloc(SIM_NVS_HANDLE_ALLOC);
+			if (!s_handle_entries[i]) return ESP_ERR_NO_MEM;
+			snprintf(s_handles[i], sizeof(s_handles[i]), "%s", namespace_name);
+			*out_handle = i + 1;
+			return ESP_OK;
+		}
+	}
+	return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+	if (!handle_ns(handle)) return;
+	s_handles[handle - 1][0] = '\0';
+	free(s_handle_entries[handle - 1]);
+	s_handle_entries[handle - 1] = NULL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+	const char *ns = handle_ns(handle);
+	if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+	s_nvs_stats.reads++;
+	sim_nvs_item_t *it = find(ns, key);
+	if (!it) return ESP_ERR_NVS_NOT_FOUND;
+	if (!out_value) {
+		*length = it->len;
+		return ESP_OK;
+	}
+	if (*length < it->len) return ESP_ERR_NVS_INVALID_LENGTH;
+	memcpy(out_value, it->data, it->len);
+	*length = it->len;
+	return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+	const char *ns = handle_ns(handle);
+	if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+	if (length > SIM_NVS_MAX_BLOB) return ESP_ERR_NVS_INVALID_LENGTH;
+	sim_nvs_item_t *it = find(ns, key);
+	if (!it) {
+		for (size_t i = 0; i < SIM_NVS_MAX_ITEMS && !it; i++) {
+			if (!s_items[i].used) it = &s_items[i];
+		}
+		if (!it) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+		memset(it, 0, sizeof(*it));
+		snprintf(it->ns, sizeof(it->ns), "%s", ns);
+		snprintf(it->key, sizeof(it->key), "%s", key);
+	}
+	uint16_t old_len = it->len;
+	bool was_used = it->used;
+	it->used = true;
+	it->len = (uint16_t)length;
+	if (used_bytes() > SIM_NVS_CAPACITY) {
+		it->len = old_len;
+		it->used = was_used;
+		return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+	}
+	// Through a volatile pointer, or the compiler drops the unused allocation
+	s_blob_pages = malloc(SIM_NVS_BLOB_ALLOC);
+	memcpy(it->data, value, length);
+	free(s_blob_pages);
+	s_blob_pages = NULL;
+	s_nvs_stats.writes++;
+	s_nvs_stats.bytes_written += 32 + length;
+	return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+	const char *ns = handle_ns(handle);
+	if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+	for (size_t i = 0; i < SIM_NVS_MAX_ITEMS; i++) {
+		if (s_items[i].used && strcmp(s_items[i].ns, ns) == 0) s_items[i].used = false;
+	}
+	return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+	if (!handle_ns(handle)) return ESP_ERR_NVS_INVALID_HANDLE;
+	s_nvs_stats.commits++;
+	return ESP_OK;
+}
+
+bool sim_nvs_load(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) return false;
+	sim_nvs_item_t it;
+	size_t n = 0;
+	while (n < SIM_NVS_MAX_ITEMS &&
+		   fread(it.ns, sizeof(it.ns), 1, f) == 1 && fread(it.key, sizeof(it.key), 1, f) == 1 &&
+		   fread(&it.len, sizeof(it.len), 1, f) == 1 && it.len <= SIM_NVS_MAX_BLOB &&
+		   fread(it.data, it.len, 1, f) == (it.len ? 1u : 0u)) {
+		it.used = true;
+		s_items[n++] = it;
+	}
+	fclose(f);
+	return true;
+}
+
+bool sim_nvs_save(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	if (!f) return false;
+	for (size_t i = 0; i < SIM_NVS_MAX_ITEMS; i++) {
+		const sim_nvs_item_t *it = &s_items[i];
+		if (!it->used) continue;
+		fwrite(it->ns, sizeof(it->ns), 1, f);
+		fwrite(it->key, sizeof(it->key), 1, f);
+		fwrite(&it->len, sizeof(it->len), 1, f);
+		fwrite(it->data, it->len, 1, f);
+	}
+	fclose(f);
+	return true;
+}
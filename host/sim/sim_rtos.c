@@ -0,0 +1,439 @@
+// FreeRTOS task/timer stand-ins running on the simulated clock
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sim_internal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#ifndef SIM_MAX_TASKS
+#define SIM_MAX_TASKS           (8)
+#endif
+
+struct sim_timer {
+	const char *name;
+	TickType_t period;
+	bool auto_reload;
+	bool active;
+	uint32_t generation;            // bumps on stop/restart so stale expiries are ignored
+	void *id;
+	TimerCallbackFunction_t cb;
+};
+
+struct sim_task {
+	TaskFunction_t fn;
+	void *arg;
+	const char *name;
+	uint32_t stack_depth;
+	UBaseType_t prio;
+	sim_ctx_t ctx;
+	bool started;
+	bool finished;
+	pthread_t thread;
+	pthread_cond_t cv;
+	bool go;                        // handed the CPU by the scheduler
+	bool waiting;                   // blocked in a notification wait or delay
+	bool notify_wait;               // a notification ends the wait (not a vTaskDelay)
+	uint32_t wait_gen;              // bumps per wait so stale wake-ups are ignored
+	uint32_t notify_value;
+	bool notify_pending;
+};
+
+static struct sim_task s_tasks[SIM_MAX_TASKS];
+static size_t s_task_count;
+
+// Only one thread runs at a time: the scheduler (event loop) or the task in s_running
+static pthread_mutex_t s_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_sched_cv = PTHREAD_COND_INITIALIZER;
+static struct sim_task *s_running;
+
+// Deferred calls queued for the timer service task
+#define SIM_PENDED_CALLS        (16)
+static struct {
+	PendedFunction_t fn;
+	void *p1;
+	uint32_t p2;
+} s_pended[SIM_PENDED_CALLS];
+
+void sim_rtos_reset(void)
+{
+	// Threads of a previous run stay blocked forever; only the bookkeeping is reset
+	memset(s_tasks, 0, sizeof(s_tasks));
+	s_task_count = 0;
+	memset(s_pended, 0, sizeof(s_pended));
+	s_running = NULL;
+}
+
+static uint64_t ticks_us(TickType_t ticks)
+{
+	return (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+static struct sim_task *current_task(void)
+{
+	return s_running && pthread_equal(s_running->thread, pthread_self()) ? s_running : NULL;
+}
+
+// Scheduler side: let t run until it blocks or returns
+static void task_resume(struct sim_task *t)
+{
+	if (t->finished) return;
+	sim_ctx_t prev = sim_ctx_enter(t->ctx);
+	pthread_mutex_lock(&s_mu);
+	s_running = t;
+	t->go = true;
+	pthread_cond_signal(&t->cv);
+	while (s_running == t) pthread_cond_wait(&s_sched_cv, &s_mu);
+	pthread_mutex_unlock(&s_mu);
+	sim_ctx_restore(prev);
+}
+
+// Task side: give the CPU back to the scheduler and wait to be resumed
+static void task_yield(struct sim_task *t)
+{
+	pthread_mutex_lock(&s_mu);
+	s_running = NULL;
+	pthread_cond_signal(&s_sched_cv);
+	while (!t->go) pthread_cond_wait(&t->cv, &s_mu);
+	t->go = false;
+	pthread_mutex_unlock(&s_mu);
+}
+
+static void task_wake(void *ctx, uintptr_t gen)
+{
+	struct sim_task *t = (struct sim_task *)ctx;
+	if (t->waiting && t->wait_gen == (uint32_t)gen) task_resume(t);
+}
+
+// Block the calling task until notified (if notify) or until the timeout expires
+static void task_block(struct sim_task *t, TickType_t wait, bool notify)
+{
+	t->waiting = true;
+	t->notify_wait = notify;
+	uint32_t gen = ++t->wait_gen;
+	if (wait != portMAX_DELAY) sim_schedule(ticks_us(wait), task_wake, t, gen);
+	task_yield(t);
+	t->waiting = false;
+}
+
+static void *task_thread(void *arg)
+{
+	struct sim_task *t = (struct sim_task *)arg;
+	pthread_mutex_lock(&s_mu);
+	while (!t->go) pthread_cond_wait(&t->cv, &s_mu);
+	t->go = false;
+	pthread_mutex_unlock(&s_mu);
+	t->fn(t->arg);
+	pthread_mutex_lock(&s_mu);
+	t->finished = true;
+	s_running = NULL;
+	pthread_cond_signal(&s_sched_cv);
+	pthread_mutex_unlock(&s_mu);
+	return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+					   void *arg, UBaseType_t prio, TaskHandle_t *out)
+{
+	if (s_task_count >= SIM_MAX_TASKS) return pdFAIL;
+	struct sim_task *t = &s_tasks[s_task_count++];
+	*t = (struct sim_task){ .fn = fn, .arg = arg, .name = name, .stack_depth = stack_depth, .prio = prio };
+	// The task running the Zigbee stack is accounted as the Zigbee context
+	t->ctx = strcmp(name, "zigbee_main") == 0 ? SIM_CTX_ZIGBEE : SIM_CTX_TASK;
+	pthread_cond_init(&t->cv, NULL);
+	if (out) *out = t;
+	return pdPASS;
+}
+
+void sim_rtos_start_tasks(void)
+{
+	for (size_t i = 0; i < s_task_count; i++) {
+		struct sim_task *t = &s_tasks[i];
+		if (t->started) continue;
+		t->started = true;
+		if (pthread_create(&t->thread, NULL, task_thread, t) != 0) {
+			fprintf(stderr, "sim: cannot start task %s\n", t->name);
+			abort();
+		}
+		pthread_detach(t->thread);
+		task_resume(t);
+	}
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	struct sim_task *t = current_task();
+	if (t) {
+		task_block(t, ticks, false);
+	} else {
+		// Called from app_main: let the rest of the simulated system run meanwhile
+		sim_run_until(sim_now_us() + ticks_us(ticks));
+	}
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+							   UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb)
+{
+	TaskHandle_t t = NULL;
+	if (!stack || !tcb) return NULL;
+	return xTaskCreate(fn, name, stack_depth, arg, prio, &t) == pdPASS ? t : NULL;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+	if (!task) task = current_task();
+	return task ? task->name : "none";
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return current_task();
+}
+
+TaskHandle_t xTaskGetHandle(const char *name)
+{
+	for (size_t i = 0; i < s_task_count; i++) {
+		if (strcmp(s_tasks[i].name, name) == 0) return &s_tasks[i];
+	}
+	return NULL;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+	// The calling task's when NULL; outside any task (app_main) there is no size to report
+	if (!task) task = current_task();
+	return task ? task->stack_depth : UINT32_MAX;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t value, eNotifyAction action)
+{
+	if (!t) return pdFAIL;
+	sim_charge_us(sim_config()->rtos_call_us);
+	switch (action) {
+	case eSetBits: t->notify_value |= value; break;
+	case eIncrement: t->notify_value++; break;
+	case eSetValueWithOverwrite: t->notify_value = value; break;
+	case eSetValueWithoutOverwrite:
+		if (t->notify_pending) return pdFAIL;
+		t->notify_value = value;
+		break;
+	default: break;
+	}
+	t->notify_pending = true;
+	// The woken task runs once the current context yields
+	if (t->waiting && t->notify_wait) sim_schedule(sim_config()->task_switch_us, task_wake, t, t->wait_gen);
+	return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t value, eNotifyAction action, BaseType_t *woken)
+{
+	if (woken && t && t->waiting && t->notify_wait) *woken = pdTRUE;
+	return xTaskNotify(t, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+	return xTaskNotify(t, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken)
+{
+	(void)xTaskNotifyFromISR(t, 0, eIncrement, woken);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t wait)
+{
+	struct sim_task *t = current_task();
+	if (!t) {
+		fprintf(stderr, "sim: xTaskNotifyWait outside a task\n");
+		abort();
+	}
+	if (!t->notify_pending) {
+		t->notify_value &= ~clear_on_entry;
+		if (wait == 0) return pdFALSE;
+		task_block(t, wait, true);
+	}
+	if (!t->notify_pending) return pdFALSE;
+	if (value) *value = t->notify_value;
+	t->notify_value &= ~clear_on_exit;
+	t->notify_pending = false;
+	return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t wait)
+{
+	struct sim_task *t = current_task();
+	if (!t) {
+		fprintf(stderr, "sim: ulTaskNotifyTake outside a task\n");
+		abort();
+	}
+	if (t->notify_value == 0 && wait != 0) task_block(t, wait, true);
+	uint32_t v = t->notify_value;
+	t->notify_value = clear_on_exit ? 0 : (v ? v - 1 : 0);
+	t->notify_pending = t->notify_value != 0;
+	return v;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)(sim_now_us() / (1000 * portTICK_PERIOD_MS));
+}
+
+static void timer_fire(void *ctx, uintptr_t generation)
+{
+	struct sim_timer *t = (struct sim_timer *)ctx;
+	if (!t->active || t->generation != (uint32_t)generation) return;
+	if (t->auto_reload) {
+		sim_schedule((uint64_t)t->period * portTICK_PERIOD_MS * 1000, timer_fire, t, t->generation);
+	} else {
+		t->active = false;
+	}
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_TIMER);
+	t->cb(t);
+	sim_ctx_restore(prev);
+}
+
+static void pended_fire(void *ctx, uintptr_t slot)
+{
+	(void)ctx;
+	PendedFunction_t fn = s_pended[slot].fn;
+	s_pended[slot].fn = NULL;
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_TIMER);
+	fn(s_pended[slot].p1, s_pended[slot].p2);
+	sim_ctx_restore(prev);
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t fn, void *p1, uint32_t p2, TickType_t wait)
+{
+	(void)wait;
+	sim_charge_us(sim_config()->rtos_call_us);
+	for (uintptr_t i = 0; i < SIM_PENDED_CALLS; i++) {
+		if (s_pended[i].fn) continue;
+		s_pended[i].fn = fn;
+		s_pended[i].p1 = p1;
+		s_pended[i].p2 = p2;
+		sim_schedule(sim_config()->task_switch_us, pended_fire, NULL, i);
+		return pdPASS;
+	}
+	return pdFAIL;              // timer command queue full
+}
+
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t fn, void *p1, uint32_t p2, BaseType_t *woken)
+{
+	BaseType_t ok = xTimerPendFunctionCall(fn, p1, p2, 0);
+	if (ok && woken) *woken = pdTRUE;
+	return ok;
+}
+
+_Static_assert(sizeof(struct sim_timer) <= sizeof(StaticTimer_t), "StaticTimer_t too small");
+
+static TimerHandle_t timer_init(struct sim_timer *t, const char *name, TickType_t period, UBaseType_t auto_reload,
+								void *id, TimerCallbackFunction_t cb)
+{
+	if (!t) return NULL;
+	memset(t, 0, sizeof(*t));
+	t->name = name;
+	t->period = period;
+	t->auto_reload = auto_reload != 0;
+	t->id = id;
+	t->cb = cb;
+	return t;
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+						   void *id, TimerCallbackFunction_t cb)
+{
+	return timer_init((struct sim_timer *)malloc(sizeof(struct sim_timer)), name, period, auto_reload, id, cb);
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t auto_reload,
+								 void *id, TimerCallbackFunction_t cb, StaticTimer_t *buf)
+{
+	return timer_init((struct sim_timer *)(void *)buf, name, period, auto_reload, id, cb);
+}
+
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t wait)
+{
+	(void)wait;
+	if (!t) return pdFAIL;
+	sim_charge_us(sim_config()->rtos_call_us);
+	t->generation++;
+	t->active = true;
+	sim_schedule((uint64_t)t->period * portTICK_PERIOD_MS * 1000, timer_fire, t, t->generation);
+	return pdPASS;
+}
+
+// Restarting a timer is the same as starting it: the previous expiry is invalidated
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t wait)
+{
+	return xTimerStart(t, wait);
+}
+
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t wait)
+{
+	(void)wait;
+	if (!t) return pdFAIL;
+	sim_charge_us(sim_config()->rtos_call_us);
+	t->generation++;
+	t->active = false;
+	return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t t)
+{
+	return t && t->active ? pdTRUE : pdFALSE;
+}
+
+TaskHandle_t xTimerGetTimerDaemonTaskHandle(void)
+{
+	return NULL;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t t)
+{
+	return t ? t->id : NULL;
+}
+
+int64_t esp_timer_get_time(void)
+{
+	return (int64_t)sim_now_us();
+}
+
+struct sim_sem {
+	int count;
+};
+_Static_assert(sizeof(struct sim_sem) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	struct sim_sem *s = (struct sim_sem *)calloc(1, sizeof(*s));
+	if (s) s->count = 1;
+	return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf)
+{
+	struct sim_sem *s = (struct sim_sem *)(void *)buf;
+	if (s) s->count = 1;
+	return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+	(void)wait;
+	if (!sem || sem->count == 0) return pdFAIL;
+	sem->count--;
+	return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+	if (!sem) return pdFAIL;
+	sem->count++;
+	return pdPASS;
+}
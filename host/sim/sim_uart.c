@@ -0,0 +1,204 @@
+// UART stand-in: the driver's transmit buffer, drained at the baud rate into a file descriptor
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "sim_internal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+
+// Bytes moved per drain event, about the hardware FIFO's empty threshold
+#define SIM_UART_CHUNK          (16)
+
+struct sim_uart {
+	bool installed;
+	uint8_t *buf;
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t baud;
+	bool flow_ctrl;                 // CTS configured
+	bool cts;
+	bool draining;                  // a drain event is scheduled
+	uint64_t held_since;            // CTS deasserted with bytes waiting, 0 when not held
+	int fd;
+	sim_uart_stats_t stats;
+};
+
+static struct sim_uart s_uart[UART_NUM_MAX];
+
+void sim_uart_reset(void)
+{
+	for (int i = 0; i < UART_NUM_MAX; i++) {
+		free(s_uart[i].buf);
+		memset(&s_uart[i], 0, sizeof(s_uart[i]));
+		s_uart[i].fd = -1;
+		s_uart[i].cts = true;
+	}
+}
+
+static bool valid(uart_port_t port)
+{
+	return port >= 0 && port < UART_NUM_MAX;
+}
+
+static uint64_t chunk_us(uart_port_t port, uint32_t bytes)
+{
+	uint32_t baud = s_uart[port].baud ? s_uart[port].baud : 115200;
+	uint64_t us = (uint64_t)bytes * 10 * 1000000 / baud;
+	return us ? us : 1;
+}
+
+static bool held(uart_port_t port)
+{
+	return s_uart[port].flow_ctrl && !s_uart[port].cts;
+}
+
+static void put_fd(int fd, const uint8_t *p, size_t len)
+{
+	while (fd >= 0 && len) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			return;
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+}
+
+static void drain_ev(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	uart_port_t port = (uart_port_t)arg;
+	struct sim_uart *u = &s_uart[port];
+	u->draining = false;
+	uint32_t level = u->head - u->tail;
+	if (!level) return;
+	if (held(port)) {
+		if (!u->held_since) u->held_since = sim_now_us();
+		return;
+	}
+	uint32_t n = level < SIM_UART_CHUNK ? level : SIM_UART_CHUNK;
+	uint32_t off = u->tail % u->size;
+	uint32_t first = n < u->size - off ? n : u->size - off;
+	put_fd(u->fd, &u->buf[off], first);
+	put_fd(u->fd, u->buf, n - first);
+	u->tail += n;
+	u->stats.bytes += n;
+	level -= n;
+	if (level) {
+		u->draining = true;
+		sim_schedule(chunk_us(port, level < SIM_UART_CHUNK ? level : SIM_UART_CHUNK), drain_ev, NULL, arg);
+	}
+}
+
+static void start_drain(uart_port_t port)
+{
+	struct sim_uart *u = &s_uart[port];
+	uint32_t level = u->head - u->tail;
+	if (u->draining || !level) return;
+	if (held(port)) {
+		if (!u->held_since) u->held_since = sim_now_us();
+		return;
+	}
+	u->draining = true;
+	sim_schedule(chunk_us(port, level < SIM_UART_CHUNK ? level : SIM_UART_CHUNK), drain_ev, NULL, (uintptr_t)port);
+}
+
+void sim_uart_attach(int port, int fd)
+{
+	if (valid(port)) s_uart[port].fd = fd;
+}
+
+void sim_uart_set_cts(int port, bool asserted)
+{
+	if (!valid(port)) return;
+	struct sim_uart *u = &s_uart[port];
+	u->cts = asserted;
+	if (asserted && u->held_since) {
+		u->stats.held_us += sim_now_us() - u->held_since;
+		u->held_since = 0;
+	}
+	if (asserted) start_drain(port);
+}
+
+const sim_uart_stats_t *sim_uart_stats(int port)
+{
+	return valid(port) ? &s_uart[port].stats : NULL;
+}
+
+// ---- driver/uart.h -------------------------------------------------------------
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+							  void *uart_queue, int intr_alloc_flags)
+{
+	(void)queue_size;
+	(void)uart_queue;
+	(void)intr_alloc_flags;
+	if (!valid(port) || rx_buffer_size <= UART_HW_FIFO_LEN(port)) return ESP_ERR_INVALID_ARG;
+	if (s_uart[port].installed) return ESP_FAIL;
+	// Without a software buffer the driver sends through the hardware FIFO alone
+	uint32_t size = (uint32_t)(tx_buffer_size > 0 ? tx_buffer_size : UART_HW_FIFO_LEN(port));
+	s_uart[port].buf = malloc(size);
+	if (!s_uart[port].buf) return ESP_ERR_NO_MEM;
+	s_uart[port].size = size;
+	s_uart[port].installed = true;
+	return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *cfg)
+{
+	if (!valid(port) || !cfg || cfg->baud_rate <= 0) return ESP_ERR_INVALID_ARG;
+	s_uart[port].baud = (uint32_t)cfg->baud_rate;
+	s_uart[port].flow_ctrl = cfg->flow_ctrl == UART_HW_FLOWCTRL_CTS || cfg->flow_ctrl == UART_HW_FLOWCTRL_CTS_RTS;
+	return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+	(void)tx_io_num;
+	(void)rx_io_num;
+	(void)rts_io_num;
+	if (!valid(port)) return ESP_ERR_INVALID_ARG;
+	// No CTS pin: the line never waits, whatever the flow control setting
+	if (cts_io_num < 0) s_uart[port].flow_ctrl = false;
+	return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size)
+{
+	if (!valid(port) || !s_uart[port].installed) return -1;
+	struct sim_uart *u = &s_uart[port];
+	const uint8_t *p = (const uint8_t *)src;
+	size_t left = size;
+	bool blocked = false;
+	u->stats.writes++;
+	while (left) {
+		uint32_t room = u->size - (u->head - u->tail);
+		if (!room) {
+			// Wait for the line as the driver does, a tick at a time
+			blocked = true;
+			vTaskDelay(1);
+			continue;
+		}
+		uint32_t n = left < room ? (uint32_t)left : room;
+		for (uint32_t i = 0; i < n; i++) u->buf[(u->head + i) % u->size] = p[i];
+		u->head += n;
+		p += n;
+		left -= n;
+		if (u->head - u->tail > u->stats.level_peak) u->stats.level_peak = u->head - u->tail;
+		start_drain(port);
+	}
+	if (blocked) u->stats.blocked_writes++;
+	return (int)size;
+}
+
+esp_err_t uart_get_tx_buffer_free_size(uart_port_t port, size_t *size)
+{
+	if (!valid(port) || !s_uart[port].installed || !size) return ESP_ERR_INVALID_ARG;
+	*size = s_uart[port].size - (s_uart[port].head - s_uart[port].tail);
+	return ESP_OK;
+}
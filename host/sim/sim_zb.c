@@ -0,0 +1,1334 @@
+// Scriptable stand-in for the esp-zigbee-lib calls made by the app
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_internal.h"
+#include "esp_zigbee_core.h"
+#include "nwk/esp_zigbee_nwk.h"
+#include "platform/esp_zigbee_platform.h"
+#include "esp_mac.h"
+#include "ha/esp_zigbee_ha_standard.h"
+
+#ifndef SIM_MAX_REQS
+#define SIM_MAX_REQS            (1024)
+#endif
+#ifndef SIM_MAX_ALARMS
+#define SIM_MAX_ALARMS          (256)
+#endif
+#define SIM_MAX_READ_ATTRS      (16)
+
+#define SIM_FORMATION_US        (1000 * 1000)
+#define SIM_INIT_US             (10 * 1000)         // BDB initialization on a factory-new stack
+#define SIM_RESUME_US           (150 * 1000)        // network restored from zb_storage until DEVICE_REBOOT
+#define SIM_PAN_ID              (0x1a62)
+#define SIM_NVRAM_MAGIC         (0x4E425A53u)       // "SZBN"
+#define SIM_STEERING_US         (20 * 1000)
+#define SIM_CHANNEL             (15)
+#define SIM_MAX_PANS            (64)
+#define SIM_NOISE_FLOOR_DBM     (-95)
+#define SIM_FORMATION_ED_DURATION   (1)     // energy detection the stack runs before forming
+#define SIM_PAN_BUSY_PCT        (3)         // share of the air each neighbouring PAN occupies
+#define SIM_BUSY_MAX_PCT        (90)
+#define SIM_MAC_MAX_RETRIES     (3)         // macMaxFrameRetries
+#define SIM_MAC_ACK_WAIT_US     (864)       // macAckWaitDuration
+#define SIM_MAC_BACKOFF_US      (320)       // unit backoff period
+#define SIM_JOIN_RETRY_US       (3 * 1000 * 1000)   // a factory-new device scans again every few seconds
+#define SIM_JOIN_ASSOC_US       (250 * 1000)        // association and key transport until the announce
+#define SIM_RELAY_US            (2 * 1000)          // router turnaround before forwarding a frame
+#define SIM_LQI_PER_RSP         (3)                 // Mgmt_Lqi_rsp neighbour records per frame
+#define SIM_NETWORK_SIZE        (64)                // stack default
+#define SIM_BOOT_REPORT_US      (1000 * 1000)       // power-on to the first attribute reports
+
+// What the stack keeps of its network in zb_storage; the real NVRAM also holds the keys, frame
+// counters and tables
+typedef struct {
+	uint32_t magic;
+	uint16_t pan_id;
+	uint8_t channel;
+} sim_nvram_t;
+
+typedef enum {
+	REQ_ACTIVE_EP,
+	REQ_SIMPLE_DESC,
+	REQ_READ_ATTR,
+	REQ_MGMT_LQI,
+	REQ_BIND,
+	REQ_CONFIG_REPORT,
+	REQ_IEEE_ADDR,
+} sim_req_kind_t;
+
+typedef struct {
+	bool used;
+	bool counted;                   // holds an APS queue slot
+	sim_req_kind_t kind;
+	void *cb;
+	void *user_ctx;
+	uint16_t dst;
+	uint8_t dst_ep;
+	uint8_t src_ep;
+	uint8_t tsn;
+	uint8_t start_index;            // Mgmt_Lqi
+	bool to_coordinator;            // Bind destination
+	uint16_t max_interval;          // Configure Reporting (attrs[0] is the attribute)
+	bool lost;                      // request or response frame lost after all MAC retries
+	uint8_t attr_n;
+	uint16_t cluster;
+	uint16_t attrs[SIM_MAX_READ_ATTRS];
+} sim_req_t;
+
+typedef struct {
+	bool used;
+	esp_zb_callback_t cb;
+	uint8_t param;
+} sim_alarm_t;
+
+static sim_device_t s_devices[SIM_MAX_DEVICES];
+static size_t s_device_count;
+static int16_t s_by_short[65536];
+static sim_req_t s_reqs[SIM_MAX_REQS];
+static sim_alarm_t s_alarms[SIM_MAX_ALARMS];
+static esp_zb_core_action_callback_t s_action_cb;
+static uint64_t s_air_busy_until;
+static uint8_t s_tsn;
+static uint8_t s_channel;
+static uint32_t s_channel_mask;
+static bool s_formed;
+static bool s_factory_new;
+static bool s_nvram_erase;
+static uint16_t s_pan_id;
+static uint32_t s_formations;
+static uint64_t s_permit_start;
+static uint64_t s_permit_until;
+static uint64_t s_permit_open_us;   // closed intervals, the current one excluded
+static uint32_t s_permit_gen;
+static int8_t s_noise_dbm[27];
+static int8_t s_wifi_dbm[27];
+static uint8_t s_wifi_busy_pct[27];
+static bool s_fail_scans;
+static uint32_t s_fail_restores;
+static uint32_t s_fail_formations;
+static esp_zb_network_descriptor_t s_pans[SIM_MAX_PANS];
+static size_t s_pan_count;
+static esp_zb_network_descriptor_t s_scan_result[SIM_MAX_PANS];
+static esp_zb_energy_detect_channel_info_t s_ed_result[16];
+static sim_zb_sizing_t s_sizing;
+
+uint8_t sim_coordinator_ieee[8] = { 0x01, 0x00, 0x5e, 0xfe, 0xff, 0x4b, 0xc6, 0x40 };
+
+void sim_zb_reset(void)
+{
+	memset(s_devices, 0, sizeof(s_devices));
+	s_device_count = 0;
+	memset(s_by_short, 0xff, sizeof(s_by_short));
+	memset(s_reqs, 0, sizeof(s_reqs));
+	memset(s_alarms, 0, sizeof(s_alarms));
+	s_action_cb = NULL;
+	s_air_busy_until = 0;
+	s_tsn = 0;
+	s_channel = 0;
+	s_channel_mask = 0;
+	s_formed = false;
+	s_factory_new = true;
+	s_nvram_erase = false;
+	s_pan_id = 0xFFFF;
+	s_formations = 0;
+	s_permit_start = s_permit_until = s_permit_open_us = 0;
+	s_permit_gen = 0;
+	memset(s_noise_dbm, SIM_NOISE_FLOOR_DBM, sizeof(s_noise_dbm));
+	memset(s_wifi_dbm, SIM_NOISE_FLOOR_DBM, sizeof(s_wifi_dbm));
+	memset(s_wifi_busy_pct, 0, sizeof(s_wifi_busy_pct));
+	s_fail_scans = false;
+	s_fail_restores = s_fail_formations = 0;
+	s_pan_count = 0;
+	memset(&s_sizing, 0, sizeof(s_sizing));
+	s_sizing.network_size = SIM_NETWORK_SIZE;
+}
+
+void sim_set_channel_noise(uint8_t channel, int8_t dbm)
+{
+	if (channel >= 11 && channel <= 26) s_noise_dbm[channel] = dbm;
+}
+
+void sim_set_channel_wifi(uint8_t channel, int8_t dbm, uint8_t busy_pct)
+{
+	if (channel < 11 || channel > 26) return;
+	s_wifi_dbm[channel] = dbm;
+	s_wifi_busy_pct[channel] = busy_pct > 100 ? 100 : busy_pct;
+}
+
+void sim_fail_scans(bool fail)
+{
+	s_fail_scans = fail;
+}
+
+void sim_fail_restores(uint32_t count)
+{
+	s_fail_restores = count;
+}
+
+void sim_fail_formations(uint32_t count)
+{
+	s_fail_formations = count;
+}
+
+// Share of frame attempts on a channel that collide with Wi-Fi bursts or neighbouring PANs
+static uint32_t channel_busy_pct(uint8_t channel)
+{
+	if (channel < 11 || channel > 26) return 0;
+	uint32_t busy = s_wifi_busy_pct[channel];
+	for (size_t i = 0; i < s_pan_count; i++) {
+		if (s_pans[i].logic_channel == channel) busy += SIM_PAN_BUSY_PCT;
+	}
+	return busy > SIM_BUSY_MAX_PCT ? SIM_BUSY_MAX_PCT : busy;
+}
+
+uint8_t sim_channel_busy_pct(uint8_t channel)
+{
+	return (uint8_t)channel_busy_pct(channel);
+}
+
+// Peak energy over the ((1<<duration)+1) slots of a detection: a Wi-Fi burst in any slot
+// shows, so short detections often miss a busy access point
+static int8_t ed_sample(uint8_t channel, uint8_t duration)
+{
+	int level = s_noise_dbm[channel];
+	uint8_t busy = s_wifi_busy_pct[channel];
+	for (uint32_t slot = 0; busy && slot < (1u << duration) + 1u; slot++) {
+		if (sim_rand() % 100 < busy && s_wifi_dbm[channel] > level) level = s_wifi_dbm[channel];
+	}
+	// Measurement spread of a few dB
+	return (int8_t)(level + (int)(sim_rand() % 5) - 2);
+}
+
+bool sim_add_pan(uint8_t channel, uint16_t pan_id, bool permit_joining)
+{
+	if (channel < 11 || channel > 26 || s_pan_count >= SIM_MAX_PANS) return false;
+	esp_zb_network_descriptor_t *d = &s_pans[s_pan_count++];
+	memset(d, 0, sizeof(*d));
+	d->short_pan_id = pan_id;
+	d->logic_channel = channel;
+	d->permit_joining = permit_joining;
+	d->router_capacity = true;
+	d->end_device_capacity = true;
+	for (int i = 0; i < 8; i++) d->extended_pan_id[i] = (uint8_t)(pan_id >> (8 * (i & 1))) ^ (uint8_t)i;
+	return true;
+}
+
+void sim_set_pan_open(uint16_t pan_id, bool permit_joining)
+{
+	for (size_t i = 0; i < s_pan_count; i++) {
+		if (s_pans[i].short_pan_id == pan_id) s_pans[i].permit_joining = permit_joining;
+	}
+}
+
+// ---- Devices -----------------------------------------------------------------
+
+sim_device_t *sim_add_device(const sim_device_t *tmpl)
+{
+	if (s_device_count >= SIM_MAX_DEVICES) return NULL;
+	sim_device_t *d = &s_devices[s_device_count];
+	*d = *tmpl;
+	d->announce_us = d->interviewed_us = d->alerted_us = d->join_start_us = 0;
+	d->join_attempts = 0;
+	d->active_ep_reqs = d->simple_desc_reqs = d->basic_reads = d->alerts = d->announces = 0;
+	d->binds = d->config_reports = 0;
+	d->onoff_bound = d->basic_bound = d->basic_reporting = d->build_report_pending = false;
+	d->onoff_max_s = 0;
+	d->report_gen = d->reports = 0;
+	d->left = d->addr_mapped = false;
+	d->mapped_short = 0;
+	d->ieee_addr_reqs = 0;
+	s_by_short[d->short_addr] = (int16_t)s_device_count;
+	s_device_count++;
+	return d;
+}
+
+sim_device_t *sim_find_device(uint16_t short_addr)
+{
+	int16_t i = s_by_short[short_addr];
+	return i < 0 ? NULL : &s_devices[i];
+}
+
+size_t sim_device_count(void) { return s_device_count; }
+sim_device_t *sim_device_at(size_t i) { return i < s_device_count ? &s_devices[i] : NULL; }
+
+void sim_signal(uint32_t sig, int status, const void *params, size_t len)
+{
+	struct {
+		uint32_t sig;
+		uint8_t params[64];
+	} buf;
+	memset(&buf, 0, sizeof(buf));
+	buf.sig = sig;
+	if (params && len) memcpy(buf.params, params, len < sizeof(buf.params) ? len : sizeof(buf.params));
+	esp_zb_app_signal_t s = { .p_app_signal = &buf.sig, .esp_err_status = status };
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+	esp_zb_app_signal_handler(&s);
+	sim_ctx_restore(prev);
+}
+
+static uint64_t air_reserve(uint64_t start_us, bool *lost);
+static uint64_t air_reserve_path(uint64_t start_us, uint16_t dst, bool *lost);
+
+uint8_t sim_device_depth(const sim_device_t *dev)
+{
+	uint8_t depth = 1;
+	for (const sim_device_t *p = dev; p && p->parent_short && depth < 16; depth++) {
+		p = sim_find_device(p->parent_short);
+	}
+	return depth;
+}
+
+// The stack learns the device's address from its announce (or the Update-Device before it); an
+// address taken over by another device is dropped from the map
+static void map_address(sim_device_t *dev)
+{
+	for (size_t i = 0; i < s_device_count; i++) {
+		if (s_devices[i].addr_mapped && s_devices[i].mapped_short == dev->short_addr) s_devices[i].addr_mapped = false;
+	}
+	dev->addr_mapped = true;
+	dev->mapped_short = dev->short_addr;
+}
+
+static void announce_fire(void *ctx, uintptr_t arg)
+{
+	(void)arg;
+	sim_device_t *d = (sim_device_t *)ctx;
+	bool first = !d->announces++;
+	if (first) d->announce_us = sim_now_us();
+	d->left = false;
+	map_address(d);
+	if (d->parent_short) {
+		// The parent router tells the trust center who joined through it
+		esp_zb_zdo_signal_device_update_params_t u = { .short_addr = d->short_addr, .status = first ? 1 : 0,
+														 .parent_short = d->parent_short };
+		memcpy(u.long_addr, d->ieee, sizeof(u.long_addr));
+		air_reserve(sim_now_us(), NULL);
+		sim_signal(ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE, ESP_OK, &u, sizeof(u));
+	}
+	esp_zb_zdo_signal_device_annce_params_t p = { .device_short_addr = d->short_addr,
+												  .capability = d->end_device ? 0x80 : 0x8e };
+	memcpy(p.ieee_addr, d->ieee, sizeof(p.ieee_addr));
+	sim_signal(ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE, ESP_OK, &p, sizeof(p));
+}
+
+static void leave_fire(void *ctx, uintptr_t rejoin)
+{
+	sim_device_t *d = (sim_device_t *)ctx;
+	bool lost = false;
+	air_reserve_path(sim_now_us(), d->short_addr, &lost);
+	if (d->parent_short) {
+		esp_zb_zdo_signal_device_update_params_t u = { .short_addr = d->short_addr, .status = 2,
+														 .parent_short = d->parent_short };
+		memcpy(u.long_addr, d->ieee, sizeof(u.long_addr));
+		sim_signal(ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE, ESP_OK, &u, sizeof(u));
+	} else {
+		esp_zb_zdo_signal_leave_indication_params_t l = { .short_addr = d->short_addr, .rejoin = (uint8_t)rejoin };
+		memcpy(l.device_addr, d->ieee, sizeof(l.device_addr));
+		sim_signal(ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION, ESP_OK, &l, sizeof(l));
+	}
+	if (rejoin) {
+		sim_schedule(SIM_JOIN_ASSOC_US, announce_fire, d, 0);
+		return;
+	}
+	// Leaving without rejoin resets the device's network state
+	d->left = true;
+	d->addr_mapped = false;
+	d->onoff_bound = d->basic_bound = d->basic_reporting = d->build_report_pending = false;
+	d->onoff_max_s = 0;
+	d->report_gen++;
+}
+
+void sim_leave(sim_device_t *dev, bool rejoin, uint64_t delay_us)
+{
+	sim_schedule(delay_us, leave_fire, dev, rejoin);
+}
+
+void sim_set_short(sim_device_t *dev, uint16_t short_addr)
+{
+	if (s_by_short[dev->short_addr] == (int16_t)(dev - s_devices)) s_by_short[dev->short_addr] = -1;
+	dev->short_addr = short_addr;
+	s_by_short[short_addr] = (int16_t)(dev - s_devices);
+}
+
+// Room for one more device: the stack refuses associations beyond its network size, and the
+// coordinator beyond max_children of its own
+static bool join_allowed(const sim_device_t *dev)
+{
+	size_t members = 0, children = 0;
+	for (size_t i = 0; i < s_device_count; i++) {
+		const sim_device_t *d = &s_devices[i];
+		if (!d->announces || d == dev) continue;
+		members++;
+		children += d->parent_short == 0;
+	}
+	if (members >= s_sizing.network_size) return false;
+	return dev->parent_short || !s_sizing.max_children || children < s_sizing.max_children;
+}
+
+void sim_announce(sim_device_t *dev, uint64_t delay_us)
+{
+	sim_schedule(delay_us, announce_fire, dev, 0);
+}
+
+// A factory-new device looks for an open network; it associates and announces when permit
+// join is on, and tries again a few seconds later otherwise
+static void join_attempt(void *ctx, uintptr_t arg)
+{
+	(void)arg;
+	sim_device_t *d = (sim_device_t *)ctx;
+	if (!d->join_start_us) d->join_start_us = sim_now_us();
+	d->join_attempts++;
+	if (sim_now_us() < s_permit_until && join_allowed(d)) {
+		sim_schedule(SIM_JOIN_ASSOC_US, announce_fire, d, 0);
+	} else {
+		if (sim_now_us() < s_permit_until) sim_stats_mut()->joins_refused++;
+		sim_schedule(SIM_JOIN_RETRY_US, join_attempt, d, 0);
+	}
+}
+
+void sim_join(sim_device_t *dev, uint64_t delay_us)
+{
+	sim_schedule(delay_us, join_attempt, dev, 0);
+}
+
+void sim_zb_on_alert_line(const char *line)
+{
+	sim_stats_mut()->alerts++;
+	const char *p = strstr(line, "(0x");
+	if (!p) return;
+	sim_device_t *d = sim_find_device((uint16_t)strtoul(p + 1, NULL, 16));
+	if (!d) return;
+	d->alerts++;
+	if (!d->alerted_us) d->alerted_us = sim_now_us();
+}
+
+// ---- Air / APS model ---------------------------------------------------------
+
+// One frame on the network channel. Attempts that collide with Wi-Fi or a neighbouring PAN
+// cost an ACK wait and a random backoff before the MAC retries. Returns when the last attempt
+// ends; *lost is set when every attempt collided.
+static uint64_t air_reserve(uint64_t start_us, bool *lost)
+{
+	const sim_config_t *cfg = sim_config();
+	sim_stats_t *st = sim_stats_mut();
+	if (start_us < s_air_busy_until) start_us = s_air_busy_until;
+	uint32_t busy = channel_busy_pct(s_channel);
+	bool ok = false;
+	st->mac_frames++;
+	for (uint32_t attempt = 0;; attempt++) {
+		start_us += cfg->frame_airtime_us;
+		st->airtime_us += cfg->frame_airtime_us;
+		if (!busy || sim_rand() % 100 >= busy) {
+			ok = true;
+			break;
+		}
+		if (attempt == SIM_MAC_MAX_RETRIES) break;
+		st->mac_retries++;
+		start_us += SIM_MAC_ACK_WAIT_US + (uint64_t)(sim_rand() % 8) * SIM_MAC_BACKOFF_US;
+	}
+	if (!ok) st->mac_failures++;
+	if (lost) *lost = !ok;
+	s_air_busy_until = start_us;
+	return start_us;
+}
+
+// A frame to or from a device behind routers: each router on the path forwards it after its
+// turnaround, on the same channel
+static uint64_t air_reserve_path(uint64_t start_us, uint16_t dst, bool *lost)
+{
+	const sim_device_t *d = sim_find_device(dst);
+	uint8_t hops = d ? sim_device_depth(d) : 1;
+	uint64_t t = air_reserve(start_us, lost);
+	for (uint8_t h = 1; h < hops && !*lost; h++) {
+		sim_stats_mut()->relayed_frames++;
+		t = air_reserve(t + SIM_RELAY_US, lost);
+	}
+	return t;
+}
+
+static void req_deliver(void *ctx, uintptr_t arg);
+static void req_device_ready(void *ctx, uintptr_t arg);
+
+static sim_req_t *req_alloc(sim_req_kind_t kind, void *cb, void *user_ctx, uint16_t dst)
+{
+	for (size_t i = 0; i < SIM_MAX_REQS; i++) {
+		if (!s_reqs[i].used) {
+			sim_req_t *r = &s_reqs[i];
+			memset(r, 0, sizeof(*r));
+			r->used = true;
+			r->kind = kind;
+			r->cb = cb;
+			r->user_ctx = user_ctx;
+			r->dst = dst;
+			return r;
+		}
+	}
+	fprintf(stderr, "sim: request pool exhausted\n");
+	abort();
+}
+
+static void req_submit(sim_req_t *r)
+{
+	const sim_config_t *cfg = sim_config();
+	sim_stats_t *st = sim_stats_mut();
+	uintptr_t idx = (uintptr_t)(r - s_reqs);
+	if (st->inflight >= cfg->aps_queue_len) {
+		// APS queue full: ZDO requests report TIMEOUT later, ZCL reads vanish
+		st->dropped++;
+		if (r->kind == REQ_READ_ATTR || r->kind == REQ_CONFIG_REPORT) {
+			r->used = false;
+		} else {
+			sim_schedule(cfg->zdo_timeout_us, req_deliver, NULL, idx);
+		}
+		return;
+	}
+	r->counted = true;
+	st->inflight++;
+	if (st->inflight > st->max_inflight) st->max_inflight = st->inflight;
+	uint64_t tx_done = air_reserve_path(sim_now_us(), r->dst, &r->lost);
+	if (r->lost) {
+		// No MAC ACK: ZDO requests report TIMEOUT, ZCL reads vanish
+		sim_schedule(cfg->zdo_timeout_us, req_deliver, NULL, idx);
+		return;
+	}
+	const sim_device_t *d = sim_find_device(r->dst);
+	uint64_t ready = tx_done;
+	if (d && d->latency_us) {
+		ready += d->latency_us;
+	} else {
+		ready += cfg->device_latency_us;
+		if (cfg->device_jitter_us) ready += sim_rand() % cfg->device_jitter_us;
+	}
+	sim_schedule(ready - sim_now_us(), req_device_ready, NULL, idx);
+}
+
+static void req_device_ready(void *ctx, uintptr_t idx)
+{
+	(void)ctx;
+	sim_req_t *r = &s_reqs[idx];
+	const sim_device_t *d = sim_find_device(r->dst);
+	if (!d || d->powered_off || d->left) {
+		// Nobody answers: ZDO times out, ZCL reads are lost
+		r->lost = true;
+		sim_schedule(sim_config()->zdo_timeout_us, req_deliver, NULL, idx);
+		return;
+	}
+	uint64_t rx_done = air_reserve_path(sim_now_us(), r->dst, &r->lost);
+	if (r->lost) {
+		sim_schedule(sim_config()->zdo_timeout_us, req_deliver, NULL, idx);
+		return;
+	}
+	sim_schedule(rx_done - sim_now_us(), req_deliver, NULL, idx);
+}
+
+static const sim_endpoint_t *find_ep(const sim_device_t *d, uint8_t ep)
+{
+	for (uint8_t i = 0; i < d->ep_count; i++) {
+		if (d->eps[i].endpoint == ep) return &d->eps[i];
+	}
+	return NULL;
+}
+
+static void deliver_read_attr(sim_req_t *r, sim_device_t *d)
+{
+	esp_zb_zcl_read_attr_resp_variable_t vars[SIM_MAX_READ_ATTRS];
+	uint8_t strs[SIM_MAX_READ_ATTRS][SIM_STR_MAX + 1];
+	uint8_t nums[SIM_MAX_READ_ATTRS][4];
+	bool any_ok = false;
+	for (uint8_t i = 0; i < r->attr_n; i++) {
+		esp_zb_zcl_read_attr_resp_variable_t *v = &vars[i];
+		memset(v, 0, sizeof(*v));
+		v->attribute.id = r->attrs[i];
+		v->status = ESP_ZB_ZCL_STATUS_SUCCESS;
+		const char *str = NULL;
+		switch (r->attrs[i]) {
+		case 0x0000: nums[i][0] = 3; break;                 // ZCL version
+		case 0x0001: nums[i][0] = 1; break;                 // Application version
+		case 0x0002: nums[i][0] = 2; break;                 // Stack version
+		case 0x0003: nums[i][0] = 1; break;                 // HW version
+		case 0x0004: str = d->manufacturer; break;
+		case 0x0005: str = d->model; break;
+		case 0x0006: str = "20240101"; break;               // Date code
+		case 0x0007: nums[i][0] = 1; break;                 // Power source: mains
+		case 0x4000: str = d->sw_build; break;
+		default: v->status = ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB; break;
+		}
+		if (r->cluster != 0x0000) v->status = ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB;
+		if (v->status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+			// leave value NULL
+		} else if (str) {
+			size_t len = strnlen(str, SIM_STR_MAX);
+			strs[i][0] = (uint8_t)len;
+			memcpy(&strs[i][1], str, len);
+			v->attribute.data.type = ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING;
+			v->attribute.data.size = (uint16_t)(len + 1);
+			v->attribute.data.value = strs[i];
+		} else {
+			v->attribute.data.type = r->attrs[i] == 0x0007 ? ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM : ESP_ZB_ZCL_ATTR_TYPE_U8;
+			v->attribute.data.size = 1;
+			v->attribute.data.value = nums[i];
+		}
+		any_ok |= v->status == ESP_ZB_ZCL_STATUS_SUCCESS;
+		v->next = (i + 1 < r->attr_n) ? &vars[i + 1] : NULL;
+	}
+	esp_zb_zcl_cmd_read_attr_resp_message_t msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.info.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+	msg.info.header.tsn = r->tsn;
+	msg.info.src_address.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT;
+	msg.info.src_address.u.short_addr = d->short_addr;
+	msg.info.src_endpoint = r->dst_ep;
+	msg.info.dst_endpoint = r->src_ep;
+	msg.info.cluster = r->cluster;
+	msg.info.profile = 0x0104;
+	msg.variables = r->attr_n ? vars : NULL;
+	if (any_ok && r->cluster == 0x0000 && !d->interviewed_us) d->interviewed_us = sim_now_us();
+	if (s_action_cb) s_action_cb(ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID, &msg);
+}
+
+static void fill_neighbor(esp_zb_zdo_neighbor_table_list_t *n, const sim_device_t *d, uint8_t relationship)
+{
+	memset(n, 0, sizeof(*n));
+	memcpy(n->ieee_addr, d->ieee, sizeof(n->ieee_addr));
+	n->network_addr = d->short_addr;
+	n->device_type = d->end_device ? ESP_ZB_DEVICE_TYPE_ED : ESP_ZB_DEVICE_TYPE_ROUTER;
+	n->rx_when_idle = !d->end_device;
+	n->relationship = relationship;
+	n->depth = sim_device_depth(d);
+	n->lqi = d->lqi ? d->lqi : 255;
+}
+
+// Neighbour table of a router: its parent first, then the devices that joined through it
+static void deliver_mgmt_lqi(sim_req_t *r, sim_device_t *router)
+{
+	struct {
+		esp_zb_zdo_mgmt_lqi_rsp_t rsp;
+		esp_zb_zdo_neighbor_table_list_t list[SIM_LQI_PER_RSP];
+	} buf;
+	memset(&buf, 0, sizeof(buf));
+	esp_zb_zdo_mgmt_lqi_rsp_callback_t cb = (esp_zb_zdo_mgmt_lqi_rsp_callback_t)r->cb;
+	if (!router) {
+		buf.rsp.status = ESP_ZB_ZDP_STATUS_TIMEOUT;
+		cb(&buf.rsp, r->user_ctx);
+		return;
+	}
+	buf.rsp.start_index = r->start_index;
+	uint8_t total = 0;
+	const sim_device_t *parent = router->parent_short ? sim_find_device(router->parent_short) : NULL;
+	if (parent) {
+		if (total >= r->start_index && buf.rsp.neighbor_table_list_count < SIM_LQI_PER_RSP) {
+			// ZDO relationship 0: parent
+			fill_neighbor(&buf.list[buf.rsp.neighbor_table_list_count++], parent, 0);
+		}
+		total++;
+	}
+	for (size_t i = 0; i < s_device_count; i++) {
+		const sim_device_t *c = &s_devices[i];
+		if (c->parent_short != router->short_addr || !c->announces) continue;
+		if (total >= r->start_index && buf.rsp.neighbor_table_list_count < SIM_LQI_PER_RSP) {
+			fill_neighbor(&buf.list[buf.rsp.neighbor_table_list_count++], c, 1);    // child
+		}
+		total++;
+	}
+	buf.rsp.neighbor_table_entries = total;
+	buf.rsp.status = ESP_ZB_ZDP_STATUS_SUCCESS;
+	cb(&buf.rsp, r->user_ctx);
+}
+
+// ---- Attribute reporting -----------------------------------------------------
+
+static bool has_in_cluster(const sim_device_t *d, uint8_t ep, uint16_t cluster)
+{
+	const sim_endpoint_t *e = find_ep(d, ep);
+	for (uint8_t i = 0; e && i < e->in_count; i++) {
+		if (e->clusters[i] == cluster) return true;
+	}
+	return false;
+}
+
+// Endpoint serving a cluster: where its reports come from
+static uint8_t cluster_ep(const sim_device_t *d, uint16_t cluster)
+{
+	for (uint8_t i = 0; i < d->ep_count; i++) {
+		if (has_in_cluster(d, d->eps[i].endpoint, cluster)) return d->eps[i].endpoint;
+	}
+	return d->ep_count ? d->eps[0].endpoint : 1;
+}
+
+// arg: cluster << 16 | attribute
+static void report_deliver(void *ctx, uintptr_t arg)
+{
+	sim_device_t *d = (sim_device_t *)ctx;
+	uint16_t cluster = (uint16_t)(arg >> 16), attr = (uint16_t)arg;
+	uint8_t value[SIM_STR_MAX + 1] = { 0 };
+	esp_zb_zcl_report_attr_message_t msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+	msg.src_address.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT;
+	msg.src_address.u.short_addr = d->short_addr;
+	msg.src_endpoint = cluster_ep(d, cluster);
+	msg.dst_endpoint = 1;
+	msg.cluster = cluster;
+	msg.attribute.id = attr;
+	if (cluster == 0x0000) {
+		size_t len = strnlen(d->sw_build, SIM_STR_MAX);
+		value[0] = (uint8_t)len;
+		memcpy(&value[1], d->sw_build, len);
+		msg.attribute.data.type = ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING;
+		msg.attribute.data.size = (uint16_t)(len + 1);
+	} else {
+		value[0] = 1;               // on
+		msg.attribute.data.type = ESP_ZB_ZCL_ATTR_TYPE_BOOL;
+		msg.attribute.data.size = 1;
+	}
+	msg.attribute.data.value = value;
+	if (!s_action_cb) return;
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+	s_action_cb(ESP_ZB_CORE_REPORT_ATTR_CB_ID, &msg);
+	sim_ctx_restore(prev);
+}
+
+// One report frame from the device to the coordinator
+static void report_send(sim_device_t *d, uint16_t cluster, uint16_t attr)
+{
+	bool lost = false;
+	d->reports++;
+	sim_stats_mut()->reports++;
+	uint64_t rx_done = air_reserve_path(sim_now_us(), d->short_addr, &lost);
+	if (!lost) sim_schedule(rx_done - sim_now_us(), report_deliver, d, (uintptr_t)cluster << 16 | attr);
+}
+
+// Periodic On/Off report every maximum interval; arg: report_gen it was scheduled under
+static void onoff_report_fire(void *ctx, uintptr_t gen)
+{
+	sim_device_t *d = (sim_device_t *)ctx;
+	if ((uint32_t)gen != d->report_gen || d->powered_off || !d->onoff_bound || !d->onoff_max_s) return;
+	report_send(d, 0x0006, 0x0000);
+	sim_schedule((uint64_t)d->onoff_max_s * 1000 * 1000, onoff_report_fire, d, gen);
+}
+
+static void build_report_fire(void *ctx, uintptr_t gen)
+{
+	sim_device_t *d = (sim_device_t *)ctx;
+	if ((uint32_t)gen != d->report_gen || d->powered_off) return;
+	if (!d->basic_bound || !d->basic_reporting) return;
+	d->build_report_pending = false;
+	report_send(d, 0x0000, 0x4000);
+}
+
+// Restart the reports after a configuration or power change; the first report after delay_us
+static void reports_restart(sim_device_t *d, uint64_t delay_us)
+{
+	d->report_gen++;
+	if (d->powered_off) return;
+	if (d->onoff_bound && d->onoff_max_s) sim_schedule(delay_us, onoff_report_fire, d, d->report_gen);
+	if (d->build_report_pending) sim_schedule(delay_us, build_report_fire, d, d->report_gen);
+}
+
+void sim_power(sim_device_t *dev, bool on, bool announce)
+{
+	dev->powered_off = !on;
+	if (!on) {
+		dev->report_gen++;
+		return;
+	}
+	if (announce) sim_announce(dev, SIM_JOIN_ASSOC_US);
+	reports_restart(dev, SIM_BOOT_REPORT_US);
+}
+
+void sim_set_sw_build(sim_device_t *dev, const char *build)
+{
+	snprintf(dev->sw_build, sizeof(dev->sw_build), "%s", build);
+	dev->build_report_pending = true;
+	if (!dev->powered_off) sim_schedule(0, build_report_fire, dev, dev->report_gen);
+}
+
+void sim_resume_device(sim_device_t *dev, uint16_t onoff_max_s, bool basic_reporting)
+{
+	dev->addr_mapped = true;
+	dev->mapped_short = dev->short_addr;
+	dev->onoff_bound = onoff_max_s != 0;
+	dev->onoff_max_s = onoff_max_s;
+	dev->basic_bound = dev->basic_reporting = basic_reporting;
+	reports_restart(dev, onoff_max_s ? (uint64_t)(sim_rand() % onoff_max_s) * 1000 * 1000 : 0);
+}
+
+static void deliver_bind(sim_req_t *r, sim_device_t *d)
+{
+	esp_zb_zdo_bind_callback_t cb = (esp_zb_zdo_bind_callback_t)r->cb;
+	if (!d) {
+		cb(ESP_ZB_ZDP_STATUS_TIMEOUT, r->user_ctx);
+		return;
+	}
+	d->binds++;
+	if (d->bind_unsupported) {
+		cb(ESP_ZB_ZDP_STATUS_NOT_SUPPORTED, r->user_ctx);
+		return;
+	}
+	if (!has_in_cluster(d, r->dst_ep, r->cluster)) {
+		cb(ESP_ZB_ZDP_STATUS_INVALID_EP, r->user_ctx);
+		return;
+	}
+	if (r->cluster == 0x0006) d->onoff_bound = r->to_coordinator;
+	if (r->cluster == 0x0000) d->basic_bound = r->to_coordinator;
+	cb(ESP_ZB_ZDP_STATUS_SUCCESS, r->user_ctx);
+	reports_restart(d, (uint64_t)d->onoff_max_s * 1000 * 1000);
+}
+
+static void deliver_config_report(sim_req_t *r, sim_device_t *d)
+{
+	d->config_reports++;
+	uint16_t attr = r->attrs[0];
+	esp_zb_zcl_status_t status = ESP_ZB_ZCL_STATUS_SUCCESS;
+	if (!has_in_cluster(d, r->dst_ep, r->cluster)) {
+		status = ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB;
+	} else if (r->cluster == 0x0006 && attr == 0x0000) {
+		d->onoff_max_s = r->max_interval;
+	} else if (r->cluster == 0x0000 && attr == 0x4000 && !d->basic_unreportable) {
+		d->basic_reporting = true;
+	} else {
+		status = ESP_ZB_ZCL_STATUS_UNREPORTABLE_ATTRIB;
+	}
+	// A single SUCCESS record, or the attribute that failed
+	esp_zb_zcl_config_report_resp_variable_t var = { .status = status, .attribute_id = attr };
+	esp_zb_zcl_cmd_config_report_resp_message_t msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.info.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+	msg.info.header.tsn = r->tsn;
+	msg.info.src_address.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT;
+	msg.info.src_address.u.short_addr = d->short_addr;
+	msg.info.src_endpoint = r->dst_ep;
+	msg.info.dst_endpoint = r->src_ep;
+	msg.info.cluster = r->cluster;
+	msg.info.profile = 0x0104;
+	msg.variables = &var;
+	if (s_action_cb) s_action_cb(ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID, &msg);
+	if (status == ESP_ZB_ZCL_STATUS_SUCCESS) reports_restart(d, (uint64_t)d->onoff_max_s * 1000 * 1000);
+}
+
+static void req_deliver_cb(sim_req_t *rp);
+
+static void req_deliver(void *ctx, uintptr_t idx)
+{
+	(void)ctx;
+	sim_req_t r = s_reqs[idx];
+	s_reqs[idx].used = false;
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+	req_deliver_cb(&r);
+	sim_ctx_restore(prev);
+}
+
+static void req_deliver_cb(sim_req_t *rp)
+{
+	sim_req_t r = *rp;
+	if (r.counted) sim_stats_mut()->inflight--;
+	sim_device_t *d = r.counted && !r.lost ? sim_find_device(r.dst) : NULL;
+	// Requests dropped by the APS queue or lost on the air are delivered with d == NULL (timeout)
+	switch (r.kind) {
+	case REQ_ACTIVE_EP: {
+		esp_zb_zdo_active_ep_callback_t cb = (esp_zb_zdo_active_ep_callback_t)r.cb;
+		if (!d) {
+			cb(ESP_ZB_ZDP_STATUS_TIMEOUT, 0, NULL, r.user_ctx);
+			break;
+		}
+		uint8_t eps[SIM_MAX_ENDPOINTS];
+		for (uint8_t i = 0; i < d->ep_count; i++) eps[i] = d->eps[i].endpoint;
+		cb(ESP_ZB_ZDP_STATUS_SUCCESS, d->ep_count, eps, r.user_ctx);
+		break;
+	}
+	case REQ_SIMPLE_DESC: {
+		esp_zb_zdo_simple_desc_callback_t cb = (esp_zb_zdo_simple_desc_callback_t)r.cb;
+		const sim_endpoint_t *ep = d ? find_ep(d, r.dst_ep) : NULL;
+		if (!ep) {
+			cb(d ? ESP_ZB_ZDP_STATUS_INVALID_EP : ESP_ZB_ZDP_STATUS_TIMEOUT, NULL, r.user_ctx);
+			break;
+		}
+		// The cluster list follows the descriptor in memory, as on the real stack
+		struct {
+			esp_zb_af_simple_desc_1_1_t desc;
+			uint16_t more[8];
+		} sd;
+		memset(&sd, 0, sizeof(sd));
+		sd.desc.endpoint = ep->endpoint;
+		sd.desc.app_profile_id = ep->profile_id;
+		sd.desc.app_device_id = ep->device_id;
+		sd.desc.app_input_cluster_count = ep->in_count;
+		sd.desc.app_output_cluster_count = ep->out_count;
+		memcpy(sd.desc.app_cluster_list, ep->clusters, sizeof(uint16_t) * (size_t)(ep->in_count + ep->out_count));
+		cb(ESP_ZB_ZDP_STATUS_SUCCESS, &sd.desc, r.user_ctx);
+		break;
+	}
+	case REQ_READ_ATTR:
+		if (d) {
+			d->basic_reads++;
+			deliver_read_attr(&r, d);
+		}
+		break;
+	case REQ_MGMT_LQI:
+		deliver_mgmt_lqi(&r, d);
+		break;
+	case REQ_BIND:
+		deliver_bind(&r, d);
+		break;
+	case REQ_CONFIG_REPORT:
+		if (d) deliver_config_report(&r, d);
+		break;
+	case REQ_IEEE_ADDR: {
+		esp_zb_zdo_ieee_addr_callback_t cb = (esp_zb_zdo_ieee_addr_callback_t)r.cb;
+		if (!d) {
+			cb(ESP_ZB_ZDP_STATUS_TIMEOUT, NULL, r.user_ctx);
+			break;
+		}
+		d->ieee_addr_reqs++;
+		esp_zb_zdo_ieee_addr_rsp_t rsp = { .nwk_addr = d->short_addr };
+		memcpy(rsp.ieee_addr, d->ieee, sizeof(rsp.ieee_addr));
+		cb(ESP_ZB_ZDP_STATUS_SUCCESS, &rsp, r.user_ctx);
+		break;
+	}
+	}
+}
+
+// ---- esp-zigbee-lib API ------------------------------------------------------
+
+void esp_zb_zdo_active_ep_req(esp_zb_zdo_active_ep_req_param_t *cmd_req,
+							  esp_zb_zdo_active_ep_callback_t user_cb, void *user_ctx)
+{
+	sim_stats_mut()->active_ep_reqs++;
+	sim_device_t *d = sim_find_device(cmd_req->addr_of_interest);
+	if (d) d->active_ep_reqs++;
+	sim_req_t *r = req_alloc(REQ_ACTIVE_EP, (void *)user_cb, user_ctx, cmd_req->addr_of_interest);
+	req_submit(r);
+}
+
+void esp_zb_zdo_simple_desc_req(esp_zb_zdo_simple_desc_req_param_t *cmd_req,
+								esp_zb_zdo_simple_desc_callback_t user_cb, void *user_ctx)
+{
+	sim_stats_mut()->simple_desc_reqs++;
+	sim_device_t *d = sim_find_device(cmd_req->addr_of_interest);
+	if (d) d->simple_desc_reqs++;
+	sim_req_t *r = req_alloc(REQ_SIMPLE_DESC, (void *)user_cb, user_ctx, cmd_req->addr_of_interest);
+	r->dst_ep = cmd_req->endpoint;
+	req_submit(r);
+}
+
+void esp_zb_zdo_mgmt_lqi_req(esp_zb_zdo_mgmt_lqi_req_param_t *cmd_req, esp_zb_zdo_mgmt_lqi_rsp_callback_t user_cb,
+							 void *user_ctx)
+{
+	sim_stats_mut()->mgmt_lqi_reqs++;
+	sim_req_t *r = req_alloc(REQ_MGMT_LQI, (void *)user_cb, user_ctx, cmd_req->dst_addr);
+	r->start_index = cmd_req->start_index;
+	req_submit(r);
+}
+
+esp_err_t esp_zb_nwk_get_next_neighbor(esp_zb_nwk_info_iterator_t *iterator, esp_zb_nwk_neighbor_info_t *nbr_info)
+{
+	// The coordinator's neighbours are the devices that joined it directly
+	for (size_t i = *iterator; i < s_device_count; i++) {
+		const sim_device_t *d = &s_devices[i];
+		if (d->parent_short || !d->announces) continue;
+		memset(nbr_info, 0, sizeof(*nbr_info));
+		memcpy(nbr_info->ieee_addr, d->ieee, sizeof(nbr_info->ieee_addr));
+		nbr_info->short_addr = d->short_addr;
+		nbr_info->device_type = d->end_device ? ESP_ZB_DEVICE_TYPE_ED : ESP_ZB_DEVICE_TYPE_ROUTER;
+		nbr_info->depth = 1;
+		nbr_info->rx_on_when_idle = !d->end_device;
+		nbr_info->relationship = 1;
+		nbr_info->lqi = d->lqi ? d->lqi : 255;
+		nbr_info->rssi = (int8_t)(-100 + nbr_info->lqi / 4);
+		*iterator = (esp_zb_nwk_info_iterator_t)(i + 1);
+		return ESP_OK;
+	}
+	return ESP_ERR_NOT_FOUND;
+}
+
+uint8_t esp_zb_zcl_read_attr_cmd_req(esp_zb_zcl_read_attr_cmd_t *cmd_req)
+{
+	sim_stats_mut()->zcl_read_reqs++;
+	sim_req_t *r = req_alloc(REQ_READ_ATTR, NULL, NULL, cmd_req->zcl_basic_cmd.dst_addr_u.addr_short);
+	r->dst_ep = cmd_req->zcl_basic_cmd.dst_endpoint;
+	r->src_ep = cmd_req->zcl_basic_cmd.src_endpoint;
+	r->cluster = cmd_req->clusterID;
+	r->attr_n = cmd_req->attr_number > SIM_MAX_READ_ATTRS ? SIM_MAX_READ_ATTRS : cmd_req->attr_number;
+	memcpy(r->attrs, cmd_req->attr_field, sizeof(uint16_t) * r->attr_n);
+	r->tsn = s_tsn++;
+	uint8_t tsn = r->tsn;
+	req_submit(r);
+	return tsn;
+}
+
+void esp_zb_zdo_device_bind_req(esp_zb_zdo_bind_req_param_t *cmd_req, esp_zb_zdo_bind_callback_t user_cb,
+								void *user_ctx)
+{
+	sim_stats_mut()->bind_reqs++;
+	sim_req_t *r = req_alloc(REQ_BIND, (void *)user_cb, user_ctx, cmd_req->req_dst_addr);
+	r->dst_ep = cmd_req->src_endp;
+	r->cluster = cmd_req->cluster_id;
+	r->to_coordinator = cmd_req->dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED &&
+						!memcmp(cmd_req->dst_address_u.addr_long, sim_coordinator_ieee, 8) && cmd_req->dst_endp == 1;
+	req_submit(r);
+}
+
+uint8_t esp_zb_zcl_config_report_cmd_req(esp_zb_zcl_config_report_cmd_t *cmd_req)
+{
+	sim_stats_mut()->config_report_reqs++;
+	sim_req_t *r = req_alloc(REQ_CONFIG_REPORT, NULL, NULL, cmd_req->zcl_basic_cmd.dst_addr_u.addr_short);
+	r->dst_ep = cmd_req->zcl_basic_cmd.dst_endpoint;
+	r->src_ep = cmd_req->zcl_basic_cmd.src_endpoint;
+	r->cluster = cmd_req->clusterID;
+	// One record is all the app sends
+	if (cmd_req->record_number && cmd_req->record_field) {
+		r->attr_n = 1;
+		r->attrs[0] = cmd_req->record_field[0].attributeID;
+		r->max_interval = cmd_req->record_field[0].max_interval;
+	}
+	r->tsn = s_tsn++;
+	uint8_t tsn = r->tsn;
+	req_submit(r);
+	return tsn;
+}
+
+void esp_zb_zdo_ieee_addr_req(esp_zb_zdo_ieee_addr_req_param_t *cmd_req, esp_zb_zdo_ieee_addr_callback_t user_cb,
+							  void *user_ctx)
+{
+	sim_stats_mut()->ieee_addr_reqs++;
+	sim_req_t *r = req_alloc(REQ_IEEE_ADDR, (void *)user_cb, user_ctx, cmd_req->dst_nwk_addr);
+	req_submit(r);
+}
+
+esp_err_t esp_zb_ieee_address_by_short(uint16_t short_addr, uint8_t *ieee_addr)
+{
+	for (size_t i = 0; i < s_device_count; i++) {
+		if (s_devices[i].addr_mapped && s_devices[i].mapped_short == short_addr) {
+			memcpy(ieee_addr, s_devices[i].ieee, 8);
+			return ESP_OK;
+		}
+	}
+	return ESP_ERR_NOT_FOUND;
+}
+
+static void alarm_fire(void *ctx, uintptr_t idx)
+{
+	(void)ctx;
+	sim_alarm_t a = s_alarms[idx];
+	s_alarms[idx].used = false;
+	if (!a.used || !a.cb) return;
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+	a.cb(a.param);
+	sim_ctx_restore(prev);
+}
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time)
+{
+	if (!cb) return;
+	for (size_t i = 0; i < SIM_MAX_ALARMS; i++) {
+		if (!s_alarms[i].used) {
+			s_alarms[i] = (sim_alarm_t){ .used = true, .cb = cb, .param = param };
+			sim_schedule((uint64_t)time * 1000, alarm_fire, NULL, i);
+			return;
+		}
+	}
+	fprintf(stderr, "sim: scheduler alarm pool exhausted\n");
+	abort();
+}
+
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param)
+{
+	for (size_t i = 0; i < SIM_MAX_ALARMS; i++) {
+		if (s_alarms[i].used && s_alarms[i].cb == cb && s_alarms[i].param == param) {
+			s_alarms[i].used = false;
+			sim_cancel(alarm_fire, NULL, i);
+		}
+	}
+}
+
+// The network as the stack keeps it across resets
+static bool nvram_load(sim_nvram_t *out)
+{
+	const uint8_t *data = sim_flash_part_data("zb_storage", NULL);
+	memcpy(out, data, sizeof(*out));
+	return out->magic == SIM_NVRAM_MAGIC;
+}
+
+static void nvram_save(void)
+{
+	size_t size = 0;
+	uint8_t *data = sim_flash_part_data("zb_storage", &size);
+	sim_nvram_t n = { .magic = SIM_NVRAM_MAGIC, .pan_id = s_pan_id, .channel = s_channel };
+	memset(data, 0xFF, size);
+	memcpy(data, &n, sizeof(n));
+}
+
+static void signal_fire(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	if (arg == ESP_ZB_BDB_SIGNAL_FORMATION) {
+		s_formed = true;
+		s_factory_new = false;
+		nvram_save();
+	} else if (arg == ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT) {
+		s_formed = true;
+	}
+	sim_signal((uint32_t)arg, ESP_OK, NULL, 0);
+}
+
+// Restore or formation that failed: nothing is kept, zb_storage is left as it was
+static void signal_fail(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	sim_signal((uint32_t)arg, ESP_FAIL, NULL, 0);
+}
+
+bool sim_network_formed(void) { return s_formed; }
+uint32_t sim_formations(void) { return s_formations; }
+
+bool sim_permit_join_open(void) { return sim_now_us() < s_permit_until; }
+
+uint64_t sim_permit_open_us(void)
+{
+	uint64_t now = sim_now_us();
+	return s_permit_open_us + ((now < s_permit_until ? now : s_permit_until) - s_permit_start);
+}
+
+static void permit_status_fire(void *ctx, uintptr_t arg)
+{
+	(void)ctx;
+	uint8_t duration = (uint8_t)arg;
+	sim_signal(ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS, ESP_OK, &duration, sizeof(duration));
+}
+
+static void permit_expire(void *ctx, uintptr_t gen)
+{
+	if ((uint32_t)gen == s_permit_gen) permit_status_fire(ctx, 0);
+}
+
+esp_err_t esp_zb_bdb_open_network(uint8_t permit_duration)
+{
+	uint64_t now = sim_now_us();
+	s_permit_open_us += (now < s_permit_until ? now : s_permit_until) - s_permit_start;
+	s_permit_start = now;
+	s_permit_until = now + (uint64_t)permit_duration * 1000 * 1000;
+	s_permit_gen++;
+	sim_stats_mut()->permit_join_broadcasts++;
+	uint64_t sent = air_reserve(now, NULL);
+	sim_schedule(sent - now, permit_status_fire, NULL, permit_duration);
+	if (permit_duration) sim_schedule(s_permit_until - now, permit_expire, NULL, s_permit_gen);
+	return ESP_OK;
+}
+
+bool esp_zb_lock_acquire(TickType_t block_ticks)
+{
+	// One simulated thread runs at a time
+	(void)block_ticks;
+	return true;
+}
+
+void esp_zb_lock_release(void) { }
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg)
+{
+	if (nwk_cfg->esp_zb_role != ESP_ZB_DEVICE_TYPE_ED) s_sizing.max_children = nwk_cfg->nwk_cfg.zczr_cfg.max_children;
+}
+
+esp_err_t esp_zb_overall_network_size_set(uint16_t size)
+{
+	s_sizing.network_size = size;
+	return ESP_OK;
+}
+
+esp_err_t esp_zb_io_buffer_size_set(uint16_t size)
+{
+	s_sizing.io_buffers = size;
+	return ESP_OK;
+}
+
+esp_err_t esp_zb_scheduler_queue_size_set(uint16_t size)
+{
+	s_sizing.scheduler_queue = size;
+	return ESP_OK;
+}
+
+void sim_zb_get_sizing(sim_zb_sizing_t *out) { *out = s_sizing; }
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config) { (void)config; return ESP_OK; }
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list) { (void)ep_list; return ESP_OK; }
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb) { s_action_cb = cb; }
+void esp_zb_stack_main_loop(void) { }
+void esp_zb_set_bdb_commissioning_mode(esp_zb_bdb_commissioning_mode_mask_t mode) { (void)mode; }
+uint8_t esp_zb_get_current_channel(void) { return s_channel; }
+uint16_t esp_zb_get_pan_id(void) { return s_pan_id; }
+bool esp_zb_bdb_is_factory_new(void) { return s_factory_new; }
+void esp_zb_nvram_erase_at_start(bool erase) { s_nvram_erase = erase; }
+uint16_t esp_zb_get_short_address(void) { return 0x0000; }
+void esp_zb_get_long_address(esp_zb_ieee_addr_t addr) { memcpy(addr, sim_coordinator_ieee, 8); }
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type)
+{
+	if (type != ESP_MAC_IEEE802154) return ESP_ERR_NOT_SUPPORTED;
+	for (int i = 0; i < 8; i++) mac[i] = sim_coordinator_ieee[7 - i];
+	return ESP_OK;
+}
+
+esp_zb_ep_list_t *esp_zb_configuration_tool_ep_create(uint8_t endpoint_id, esp_zb_configuration_tool_cfg_t *cfg)
+{
+	(void)endpoint_id;
+	(void)cfg;
+	// The SDK builds its cluster lists on the heap; keep a comparable footprint
+	return (esp_zb_ep_list_t *)malloc(256);
+}
+
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask)
+{
+	s_channel_mask = channel_mask;
+	return ESP_OK;
+}
+
+static void nvram_erase(void)
+{
+	size_t size = 0;
+	uint8_t *data = sim_flash_part_data("zb_storage", &size);
+	memset(data, 0xFF, size);
+}
+
+// The restart ends the process, as a reset ends a boot in the benches that run several
+void esp_zb_factory_reset(void)
+{
+	nvram_erase();
+	fprintf(stderr, "sim: esp_zb_factory_reset: zb_storage erased, restarting\n");
+	exit(0);
+}
+
+esp_err_t esp_zb_start(bool autostart)
+{
+	(void)autostart;
+	if (s_nvram_erase) nvram_erase();
+	sim_schedule(0, signal_fire, NULL, ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP);
+	return ESP_OK;
+}
+
+// Formation as the stack does it: one short energy detection over the channel set, quietest
+// reading wins (lowest channel on ties)
+static uint8_t stack_pick_channel(void)
+{
+	uint8_t best = 0;
+	int best_dbm = 127;
+	for (uint8_t ch = 11; ch <= 26; ch++) {
+		if (!(s_channel_mask & (1u << ch))) continue;
+		int dbm = ed_sample(ch, SIM_FORMATION_ED_DURATION);
+		if (dbm < best_dbm) {
+			best_dbm = dbm;
+			best = ch;
+		}
+	}
+	return best ? best : SIM_CHANNEL;
+}
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask)
+{
+	if (mode_mask == ESP_ZB_BDB_MODE_INITIALIZATION) {
+		// Restore the network from zb_storage if there is one; the devices never notice
+		sim_nvram_t n;
+		s_factory_new = !nvram_load(&n);
+		if (!s_factory_new) {
+			s_pan_id = n.pan_id;
+			s_channel = n.channel;
+		}
+		bool fail = !s_factory_new && s_fail_restores && s_fail_restores--;
+		sim_schedule(s_factory_new ? SIM_INIT_US : SIM_RESUME_US, fail ? signal_fail : signal_fire, NULL,
+					 s_factory_new ? ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START : ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT);
+	} else if (mode_mask & ESP_ZB_BDB_MODE_NETWORK_FORMATION) {
+		s_formations++;
+		s_pan_id = SIM_PAN_ID;
+		s_channel = stack_pick_channel();
+		bool fail = s_fail_formations && s_fail_formations--;
+		sim_schedule(SIM_FORMATION_US, fail ? signal_fail : signal_fire, NULL, ESP_ZB_BDB_SIGNAL_FORMATION);
+	} else if (mode_mask & ESP_ZB_BDB_MODE_NETWORK_STEERING) {
+		esp_zb_bdb_open_network(180);       // BDB steering on a coordinator: permit join for 180 s
+		sim_schedule(SIM_STEERING_US, signal_fire, NULL, ESP_ZB_BDB_SIGNAL_STEERING);
+	}
+	return ESP_OK;
+}
+
+// The radio leaves the network channel for the whole scan: queued frames wait behind it
+static uint64_t scan_reserve(uint32_t channel_mask, uint8_t duration)
+{
+	uint32_t channels = (uint32_t)__builtin_popcount(channel_mask & 0x07FFF800u);
+	uint64_t scan_us = (uint64_t)channels * ((1u << duration) + 1u) * 15360u;
+	uint64_t start = sim_now_us() > s_air_busy_until ? sim_now_us() : s_air_busy_until;
+	s_air_busy_until = start + scan_us;
+	sim_stats_mut()->scan_us += scan_us;
+	return s_air_busy_until - sim_now_us();
+}
+
+static void scan_fire(void *ctx, uintptr_t mask)
+{
+	esp_zb_zdo_scan_complete_callback_t cb = (esp_zb_zdo_scan_complete_callback_t)ctx;
+	if (s_fail_scans) {
+		sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+		cb(ESP_ZB_ZDP_STATUS_TIMEOUT, 0, NULL);
+		sim_ctx_restore(prev);
+		return;
+	}
+	uint8_t n = 0;
+	for (size_t i = 0; i < s_pan_count; i++) {
+		if (mask & (1u << s_pans[i].logic_channel)) s_scan_result[n++] = s_pans[i];
+	}
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+	cb(ESP_ZB_ZDP_STATUS_SUCCESS, n, n ? s_scan_result : NULL);
+	sim_ctx_restore(prev);
+}
+
+void esp_zb_zdo_active_scan_request(uint32_t channel_mask, uint8_t scan_duration,
+									esp_zb_zdo_scan_complete_callback_t user_cb)
+{
+	sim_stats_mut()->scan_requests++;
+	sim_schedule(s_fail_scans ? 0 : scan_reserve(channel_mask, scan_duration), scan_fire, (void *)user_cb, channel_mask);
+}
+
+// arg: channel mask (bits 11..26) with the duration in bits 28..31
+static void ed_fire(void *ctx, uintptr_t arg)
+{
+	esp_zb_zdo_energy_detect_callback_t cb = (esp_zb_zdo_energy_detect_callback_t)ctx;
+	uint8_t duration = (uint8_t)(arg >> 28);
+	uint16_t n = 0;
+	for (uint8_t ch = 11; !s_fail_scans && ch <= 26; ch++) {
+		if (!(arg & (1u << ch))) continue;
+		s_ed_result[n++] = (esp_zb_energy_detect_channel_info_t){ .channel_nbr = ch, .energy_detected = ed_sample(ch, duration) };
+	}
+	sim_ctx_t prev = sim_ctx_enter(SIM_CTX_ZIGBEE);
+	cb(s_fail_scans ? ESP_ZB_ZDP_STATUS_TIMEOUT : ESP_ZB_ZDP_STATUS_SUCCESS, n, n ? s_ed_result : NULL);
+	sim_ctx_restore(prev);
+}
+
+void esp_zb_zdo_energy_detect_request(uint32_t channel_mask, uint8_t duration,
+									  esp_zb_zdo_energy_detect_callback_t cb)
+{
+	sim_stats_mut()->ed_requests++;
+	sim_schedule(s_fail_scans ? 0 : scan_reserve(channel_mask, duration), ed_fire, (void *)cb,
+				 (channel_mask & 0x07FFF800u) | ((uintptr_t)(duration & 0x0f) << 28));
+}
+
+void *esp_zb_app_signal_get_params(uint32_t *signal_p)
+{
+	return signal_p + 1;
+}
+
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal)
+{
+	switch (signal) {
+	case ESP_ZB_ZDO_SIGNAL_DEFAULT_START: return "ESP_ZB_ZDO_SIGNAL_DEFAULT_START";
+	case ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP: return "ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP";
+	case ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE: return "ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE";
+	case ESP_ZB_ZDO_SIGNAL_LEAVE: return "ESP_ZB_ZDO_SIGNAL_LEAVE";
+	case ESP_ZB_ZDO_SIGNAL_ERROR: return "ESP_ZB_ZDO_SIGNAL_ERROR";
+	case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START: return "ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START";
+	case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT: return "ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT";
+	case ESP_ZB_BDB_SIGNAL_STEERING: return "ESP_ZB_BDB_SIGNAL_STEERING";
+	case ESP_ZB_BDB_SIGNAL_FORMATION: return "ESP_ZB_BDB_SIGNAL_FORMATION";
+	case ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION: return "ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION";
+	case ESP_ZB_ZDO_SIGNAL_DEVICE_AUTHORIZED: return "ESP_ZB_ZDO_SIGNAL_DEVICE_AUTHORIZED";
+	case ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE: return "ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE";
+	case ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS: return "ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS";
+	default: return "UNKNOWN";
+	}
+}
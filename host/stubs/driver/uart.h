@@ -0,0 +1,45 @@
+// Host stub of driver/uart.h: transmit side only. The simulator drains the driver's buffer at
+// the baud rate, holds it while CTS is deasserted, and hands the bytes to a file descriptor
+// (sim_uart_attach)
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef int uart_port_t;
+
+#define UART_NUM_0              (0)
+#define UART_NUM_1              (1)
+#define UART_NUM_MAX            (2)
+#define UART_PIN_NO_CHANGE      (-1)
+#define UART_HW_FIFO_LEN(port)  (128)
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE, UART_PARITY_EVEN = 2, UART_PARITY_ODD = 3 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5 = 2, UART_STOP_BITS_2 = 3 } uart_stop_bits_t;
+typedef enum {
+	UART_HW_FLOWCTRL_DISABLE,
+	UART_HW_FLOWCTRL_RTS,
+	UART_HW_FLOWCTRL_CTS,
+	UART_HW_FLOWCTRL_CTS_RTS,
+} uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_DEFAULT } uart_sclk_t;
+
+typedef struct {
+	int baud_rate;
+	uart_word_length_t data_bits;
+	uart_parity_t parity;
+	uart_stop_bits_t stop_bits;
+	uart_hw_flowcontrol_t flow_ctrl;
+	uint8_t rx_flow_ctrl_thresh;
+	uart_sclk_t source_clk;
+} uart_config_t;
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+							  void *uart_queue, int intr_alloc_flags);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *cfg);
+esp_err_t uart_set_pin(uart_port_t port, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num);
+// Blocks the calling task while the transmit buffer is full
+int uart_write_bytes(uart_port_t port, const void *src, size_t size);
+esp_err_t uart_get_tx_buffer_free_size(uart_port_t port, size_t *size);
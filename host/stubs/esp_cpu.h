@@ -0,0 +1,9 @@
+// Host stub of esp_cpu.h: the cycle counter counts host CPU time plus the driver time
+// modelled by the simulator, at SIM_CPU_MHZ
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
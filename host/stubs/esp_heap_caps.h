@@ -0,0 +1,21 @@
+// Host stub of esp_heap_caps.h: one heap of SIM_HEAP_BYTES, of which the simulator's heap
+// accounting (sim_heap_current) is in use. Fragmentation is not modelled: the largest free
+// block is all of the free heap
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_allocated_size(void *ptr);
+
+// Heap hooks (CONFIG_HEAP_USE_HOOKS): called after every successful allocation and before every
+// free, by the simulator's malloc/calloc/realloc/free wrappers on the host
+void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps);
+void esp_heap_trace_free_hook(void *ptr);
@@ -0,0 +1,10 @@
+// Host stub of esp_mac.h: the IEEE 802.15.4 address is the simulated coordinator's
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum { ESP_MAC_WIFI_STA, ESP_MAC_BT = 2, ESP_MAC_IEEE802154 = 6 } esp_mac_type_t;
+
+// Most significant byte first, as on the target (8 bytes for ESP_MAC_IEEE802154)
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
@@ -0,0 +1,6 @@
+// Host stub of esp_timer.h: microseconds of simulated time
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,57 @@
+// Host stub of esp_zigbee_core.h
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "esp_zigbee_type.h"
+#include "zdo/esp_zigbee_zdo_common.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "zcl/esp_zigbee_zcl_common.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+
+typedef enum {
+	ESP_ZB_BDB_MODE_INITIALIZATION = 0,
+	ESP_ZB_BDB_MODE_TOUCHLINK_COMMISSIONING = 1,
+	ESP_ZB_BDB_MODE_NETWORK_STEERING = 2,
+	ESP_ZB_BDB_MODE_NETWORK_FORMATION = 4,
+} esp_zb_bdb_commissioning_mode_mask_t;
+
+typedef enum {
+	ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID = 0x0000,
+	ESP_ZB_CORE_REPORT_ATTR_CB_ID = 0x2000,
+	ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID = 0x1000,
+	ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID = 0x1001,
+	ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID = 0x1002,
+	ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID = 0x1005,
+} esp_zb_core_action_callback_id_t;
+
+typedef esp_err_t (*esp_zb_core_action_callback_t)(esp_zb_core_action_callback_id_t callback_id, const void *message);
+
+void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_s);
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg);
+// Stack table sizing, before esp_zb_init
+esp_err_t esp_zb_overall_network_size_set(uint16_t size);
+esp_err_t esp_zb_io_buffer_size_set(uint16_t size);
+esp_err_t esp_zb_scheduler_queue_size_set(uint16_t size);
+esp_err_t esp_zb_start(bool autostart);
+// Erase zb_storage at esp_zb_start: the network is formed again instead of restored
+void esp_zb_nvram_erase_at_start(bool erase);
+// Erase zb_storage and restart: the next boot is factory new
+void esp_zb_factory_reset(void);
+// No network in zb_storage (valid after the BDB initialization signal)
+bool esp_zb_bdb_is_factory_new(void);
+void esp_zb_stack_main_loop(void);
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list);
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb);
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask);
+void esp_zb_set_bdb_commissioning_mode(esp_zb_bdb_commissioning_mode_mask_t commissioning_mode);
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask);
+// Broadcast Mgmt_Permit_Joining for permit_duration seconds (0 closes the network)
+esp_err_t esp_zb_bdb_open_network(uint8_t permit_duration);
+// Serialise calls into the stack from tasks other than the Zigbee task
+bool esp_zb_lock_acquire(TickType_t block_ticks);
+void esp_zb_lock_release(void);
+// The stack's address map: devices it has heard announce or been told about
+esp_err_t esp_zb_ieee_address_by_short(uint16_t short_addr, uint8_t *ieee_addr);
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time);
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param);
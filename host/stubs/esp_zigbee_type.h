@@ -0,0 +1,77 @@
+// Host stub of esp_zigbee_type.h: the subset of esp-zigbee-lib types the app uses
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef uint8_t esp_zb_ieee_addr_t[8];
+typedef uint8_t esp_zb_ext_pan_id_t[8];
+
+typedef union {
+	uint16_t addr_short;
+	esp_zb_ieee_addr_t addr_long;
+} esp_zb_addr_u;
+
+typedef enum {
+	ESP_ZB_DEVICE_TYPE_COORDINATOR = 0x0,
+	ESP_ZB_DEVICE_TYPE_ROUTER = 0x1,
+	ESP_ZB_DEVICE_TYPE_ED = 0x2,
+	ESP_ZB_DEVICE_TYPE_NONE = 0x3,
+} esp_zb_nwk_device_type_t;
+
+typedef enum {
+	ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT = 0x0,
+	ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT = 0x1,
+	ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT = 0x2,
+	ESP_ZB_APS_ADDR_MODE_64_ENDP_PRESENT = 0x3,
+} esp_zb_aps_address_mode_t;
+typedef esp_zb_aps_address_mode_t esp_zb_zcl_address_mode_t;
+
+typedef struct {
+	uint16_t max_children;
+} esp_zb_zczr_cfg_t;
+
+typedef struct {
+	uint8_t ed_timeout;
+	uint32_t keep_alive;
+} esp_zb_zed_cfg_t;
+
+typedef struct {
+	esp_zb_nwk_device_type_t esp_zb_role;
+	bool install_code_policy;
+	union {
+		esp_zb_zczr_cfg_t zczr_cfg;
+		esp_zb_zed_cfg_t zed_cfg;
+	} nwk_cfg;
+} esp_zb_cfg_t;
+
+typedef struct {
+	esp_zb_ext_pan_id_t extended_pan_id;
+	uint16_t short_pan_id;
+	uint8_t logic_channel;
+	bool permit_joining;
+	bool router_capacity;
+	bool end_device_capacity;
+} esp_zb_network_descriptor_t;
+
+typedef struct esp_zb_energy_detect_channel_info_s {
+	uint8_t channel_nbr;
+	int8_t energy_detected;         // dBm
+} esp_zb_energy_detect_channel_info_t;
+
+typedef struct {
+	uint8_t endpoint;
+	uint16_t app_profile_id;
+	uint16_t app_device_id;
+	uint32_t app_device_version: 4;
+	uint32_t reserved: 4;
+	uint8_t app_input_cluster_count;
+	uint8_t app_output_cluster_count;
+	uint16_t app_cluster_list[2];
+} esp_zb_af_simple_desc_1_1_t;
+
+typedef struct sim_ep_list esp_zb_ep_list_t;
+
+typedef void (*esp_zb_callback_t)(uint8_t param);
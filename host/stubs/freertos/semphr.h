@@ -0,0 +1,15 @@
+// Host stub of FreeRTOS semaphores (the simulation is single-threaded)
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_sem *SemaphoreHandle_t;
+
+typedef struct {
+	void *opaque[10];
+} StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
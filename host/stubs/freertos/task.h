@@ -0,0 +1,44 @@
+// Host stub of FreeRTOS task API
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef struct sim_task *TaskHandle_t;
+// ESP-IDF counts stacks in bytes
+typedef uint8_t StackType_t;
+// Static buffers about the size of the target's, so .bss of the host build is comparable
+typedef struct {
+	void *opaque[44];
+} StaticTask_t;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+					   void *arg, UBaseType_t prio, TaskHandle_t *out);
+// The stack and TCB buffers are the caller's; host threads keep their own stacks
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+							   UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb);
+typedef enum {
+	eNoAction = 0,
+	eSetBits,
+	eIncrement,
+	eSetValueWithOverwrite,
+	eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TaskHandle_t xTaskGetHandle(const char *name);
+// The calling task's when NULL
+const char *pcTaskGetName(TaskHandle_t task);
+// Host threads' stacks say nothing about the target's: reports the whole stack as never used
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t wait);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t wait);
+
+#define portYIELD_FROM_ISR(woken)   ((void)(woken))
@@ -0,0 +1,28 @@
+// Host stub of FreeRTOS software timers, driven by the simulated clock
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef struct sim_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+typedef void (*PendedFunction_t)(void *, uint32_t);
+
+typedef struct {
+	void *opaque[6];
+} StaticTimer_t;
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+						   void *id, TimerCallbackFunction_t cb);
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t auto_reload,
+								 void *id, TimerCallbackFunction_t cb, StaticTimer_t *buf);
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t t);
+void *pvTimerGetTimerID(TimerHandle_t t);
+// Timer callbacks run on the simulator's event loop, not in a task: NULL
+TaskHandle_t xTimerGetTimerDaemonTaskHandle(void);
+// Run fn(p1, p2) in the timer service task
+BaseType_t xTimerPendFunctionCall(PendedFunction_t fn, void *p1, uint32_t p2, TickType_t wait);
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t fn, void *p1, uint32_t p2, BaseType_t *woken);
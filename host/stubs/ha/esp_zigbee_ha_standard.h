@@ -0,0 +1,14 @@
+// Host stub of ha/esp_zigbee_ha_standard.h
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+typedef struct {
+	uint8_t zcl_version;
+	uint8_t power_source;
+	uint16_t identify_time;
+} esp_zb_configuration_tool_cfg_t;
+
+#define ESP_ZB_DEFAULT_CONFIGURATION_TOOL_CONFIG() { .zcl_version = 3, .power_source = 0, .identify_time = 0 }
+
+esp_zb_ep_list_t *esp_zb_configuration_tool_ep_create(uint8_t endpoint_id, esp_zb_configuration_tool_cfg_t *cfg);
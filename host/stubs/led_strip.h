@@ -0,0 +1,34 @@
+// Host stub of the espressif/led_strip component
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct sim_led_strip *led_strip_handle_t;
+
+typedef enum { LED_MODEL_WS2812, LED_MODEL_SK6812 } led_model_t;
+
+typedef struct {
+	int strip_gpio_num;
+	uint32_t max_leds;
+	led_model_t led_model;
+	struct {
+		uint32_t invert_out: 1;
+	} flags;
+} led_strip_config_t;
+
+typedef struct {
+	uint32_t resolution_hz;
+	struct {
+		uint32_t with_dma: 1;
+	} flags;
+} led_strip_rmt_config_t;
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config,
+								   const led_strip_rmt_config_t *rmt_config,
+								   led_strip_handle_t *ret_strip);
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index,
+							  uint32_t red, uint32_t green, uint32_t blue);
+esp_err_t led_strip_refresh(led_strip_handle_t strip);
+esp_err_t led_strip_clear(led_strip_handle_t strip);
@@ -0,0 +1,6 @@
+// Host stub of nvs_flash.h
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init(void);
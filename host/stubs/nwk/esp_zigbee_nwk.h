@@ -0,0 +1,30 @@
+// Host stub of nwk/esp_zigbee_nwk.h
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+uint8_t esp_zb_get_current_channel(void);
+uint16_t esp_zb_get_pan_id(void);
+uint16_t esp_zb_get_short_address(void);
+void esp_zb_get_long_address(esp_zb_ieee_addr_t addr);
+
+typedef uint16_t esp_zb_nwk_info_iterator_t;
+#define ESP_ZB_NWK_INFO_ITERATOR_INIT   (0)
+
+typedef struct {
+	esp_zb_ieee_addr_t ieee_addr;
+	uint16_t short_addr;
+	uint8_t device_type;
+	uint8_t depth;
+	uint8_t rx_on_when_idle;
+	uint8_t relationship;
+	uint8_t lqi;
+	int8_t rssi;
+	uint8_t outgoing_cost;
+	uint8_t age;
+	uint32_t device_timeout;
+	uint32_t timeout_counter;
+} esp_zb_nwk_neighbor_info_t;
+
+// Local neighbour table, one entry per call; ESP_ERR_NOT_FOUND after the last one
+esp_err_t esp_zb_nwk_get_next_neighbor(esp_zb_nwk_info_iterator_t *iterator, esp_zb_nwk_neighbor_info_t *nbr_info);
@@ -0,0 +1,22 @@
+// Host stub of platform/esp_zigbee_platform.h
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+typedef enum { ZB_RADIO_MODE_NATIVE = 0, ZB_RADIO_MODE_UART_RCP = 1 } esp_zb_radio_mode_t;
+typedef enum { ZB_HOST_CONNECTION_MODE_NONE = 0, ZB_HOST_CONNECTION_MODE_CLI_UART = 1, ZB_HOST_CONNECTION_MODE_RCP_UART = 2 } esp_zb_host_connection_mode_t;
+
+typedef struct {
+	esp_zb_radio_mode_t radio_mode;
+} esp_zb_radio_config_t;
+
+typedef struct {
+	esp_zb_host_connection_mode_t host_connection_mode;
+} esp_zb_host_config_t;
+
+typedef struct {
+	esp_zb_radio_config_t radio_config;
+	esp_zb_host_config_t host_config;
+} esp_zb_platform_config_t;
+
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config);
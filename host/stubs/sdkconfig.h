@@ -0,0 +1,5 @@
+// Host stub of the generated sdkconfig.h: Kconfig's defaults. Like the generated file, it only
+// defines the bool options that are set; every other option is left to the module's default
+#pragma once
+
+#define CONFIG_ZB_SCAN_JOIN_ON_OPEN_PAN 1
@@ -0,0 +1,79 @@
+// Host stub of zcl/esp_zigbee_zcl_command.h
+#pragma once
+
+#include "zcl/esp_zigbee_zcl_common.h"
+
+typedef struct {
+	esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+	esp_zb_zcl_address_mode_t address_mode;
+	uint16_t clusterID;
+	uint8_t manuf_specific: 2;
+	uint8_t direction: 1;
+	uint8_t dis_default_resp: 1;
+	uint16_t manuf_code;
+	uint8_t attr_number;
+	uint16_t *attr_field;
+} esp_zb_zcl_read_attr_cmd_t;
+
+typedef struct esp_zb_zcl_read_attr_resp_variable_s {
+	esp_zb_zcl_status_t status;
+	esp_zb_zcl_attribute_t attribute;
+	struct esp_zb_zcl_read_attr_resp_variable_s *next;
+} esp_zb_zcl_read_attr_resp_variable_t;
+
+typedef struct {
+	esp_zb_zcl_cmd_info_t info;
+	esp_zb_zcl_read_attr_resp_variable_t *variables;
+} esp_zb_zcl_cmd_read_attr_resp_message_t;
+
+uint8_t esp_zb_zcl_read_attr_cmd_req(esp_zb_zcl_read_attr_cmd_t *cmd_req);
+
+typedef enum {
+	ESP_ZB_ZCL_REPORT_DIRECTION_SEND = 0x00,
+	ESP_ZB_ZCL_REPORT_DIRECTION_RECV = 0x01,
+} esp_zb_zcl_report_direction_t;
+
+typedef struct {
+	esp_zb_zcl_report_direction_t direction;
+	uint16_t attributeID;
+	uint8_t attrType;
+	uint16_t min_interval;
+	uint16_t max_interval;
+	void *reportable_change;
+} esp_zb_zcl_config_report_record_t;
+
+typedef struct {
+	esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+	esp_zb_zcl_address_mode_t address_mode;
+	uint16_t clusterID;
+	uint8_t manuf_specific: 2;
+	uint8_t direction: 1;
+	uint8_t dis_default_resp: 1;
+	uint16_t manuf_code;
+	uint16_t record_number;
+	esp_zb_zcl_config_report_record_t *record_field;
+} esp_zb_zcl_config_report_cmd_t;
+
+typedef struct esp_zb_zcl_config_report_resp_variable_s {
+	esp_zb_zcl_status_t status;
+	esp_zb_zcl_report_direction_t direction;
+	uint16_t attribute_id;
+	struct esp_zb_zcl_config_report_resp_variable_s *next;
+} esp_zb_zcl_config_report_resp_variable_t;
+
+// A single SUCCESS record when every attribute was configured
+typedef struct {
+	esp_zb_zcl_cmd_info_t info;
+	esp_zb_zcl_config_report_resp_variable_t *variables;
+} esp_zb_zcl_cmd_config_report_resp_message_t;
+
+typedef struct {
+	esp_zb_zcl_status_t status;
+	esp_zb_zcl_addr_t src_address;
+	uint8_t src_endpoint;
+	uint8_t dst_endpoint;
+	uint16_t cluster;
+	esp_zb_zcl_attribute_t attribute;
+} esp_zb_zcl_report_attr_message_t;
+
+uint8_t esp_zb_zcl_config_report_cmd_req(esp_zb_zcl_config_report_cmd_t *cmd_req);
@@ -0,0 +1,80 @@
+// Host stub of zcl/esp_zigbee_zcl_common.h
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+typedef enum {
+	ESP_ZB_ZCL_STATUS_SUCCESS = 0x00,
+	ESP_ZB_ZCL_STATUS_FAIL = 0x01,
+	ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB = 0x86,
+	ESP_ZB_ZCL_STATUS_UNREPORTABLE_ATTRIB = 0x8c,
+	ESP_ZB_ZCL_STATUS_TIMEOUT = 0x94,
+} esp_zb_zcl_status_t;
+
+typedef enum {
+	ESP_ZB_ZCL_ATTR_TYPE_NULL = 0x00,
+	ESP_ZB_ZCL_ATTR_TYPE_8BIT = 0x08,
+	ESP_ZB_ZCL_ATTR_TYPE_BOOL = 0x10,
+	ESP_ZB_ZCL_ATTR_TYPE_8BITMAP = 0x18,
+	ESP_ZB_ZCL_ATTR_TYPE_U8 = 0x20,
+	ESP_ZB_ZCL_ATTR_TYPE_U16 = 0x21,
+	ESP_ZB_ZCL_ATTR_TYPE_U32 = 0x23,
+	ESP_ZB_ZCL_ATTR_TYPE_S8 = 0x28,
+	ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM = 0x30,
+	ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING = 0x41,
+	ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING = 0x42,
+	ESP_ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING = 0x43,
+	ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING = 0x44,
+} esp_zb_zcl_attr_type_t;
+
+typedef enum {
+	ESP_ZB_ZCL_ADDR_TYPE_SHORT = 0,
+	ESP_ZB_ZCL_ADDR_TYPE_IEEE_GPD = 1,
+	ESP_ZB_ZCL_ADDR_TYPE_SRC_ID_GPD = 2,
+	ESP_ZB_ZCL_ADDR_TYPE_IEEE = 3,
+} esp_zb_zcl_address_type_t;
+
+typedef struct {
+	esp_zb_zcl_address_type_t addr_type;
+	union {
+		uint16_t short_addr;
+		uint32_t src_id;
+		esp_zb_ieee_addr_t ieee_addr;
+	} u;
+} esp_zb_zcl_addr_t;
+
+typedef struct {
+	esp_zb_zcl_attr_type_t type;
+	uint16_t size;
+	void *value;
+} esp_zb_zcl_attribute_data_t;
+
+typedef struct {
+	uint16_t id;
+	esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_attribute_t;
+
+typedef struct {
+	uint8_t fc;
+	uint16_t manuf_code;
+	uint8_t tsn;
+	int8_t rssi;
+} esp_zb_zcl_frame_header_t;
+
+typedef struct {
+	esp_zb_zcl_status_t status;
+	esp_zb_zcl_frame_header_t header;
+	esp_zb_zcl_addr_t src_address;
+	esp_zb_zcl_addr_t dst_address;
+	uint8_t src_endpoint;
+	uint8_t dst_endpoint;
+	uint16_t cluster;
+	uint16_t profile;
+	uint8_t command;
+} esp_zb_zcl_cmd_info_t;
+
+typedef struct {
+	esp_zb_addr_u dst_addr_u;
+	uint8_t dst_endpoint;
+	uint8_t src_endpoint;
+} esp_zb_zcl_basic_cmd_t;
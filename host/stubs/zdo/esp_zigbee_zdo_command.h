@@ -0,0 +1,99 @@
+// Host stub of zdo/esp_zigbee_zdo_command.h
+#pragma once
+
+#include "zdo/esp_zigbee_zdo_common.h"
+
+typedef struct {
+	uint16_t addr_of_interest;
+} esp_zb_zdo_active_ep_req_param_t;
+
+typedef struct {
+	uint16_t addr_of_interest;
+	uint8_t endpoint;
+} esp_zb_zdo_simple_desc_req_param_t;
+
+typedef struct {
+	uint16_t dst_addr;
+	uint8_t start_index;
+} esp_zb_zdo_mgmt_lqi_req_param_t;
+
+typedef struct {
+	uint16_t dst_nwk_addr;
+	uint16_t addr_of_interest;
+	uint8_t request_type;           // 0: single device, 1: extended (with associated devices)
+	uint8_t start_index;
+} esp_zb_zdo_ieee_addr_req_param_t;
+
+typedef struct {
+	esp_zb_ieee_addr_t ieee_addr;
+	uint16_t nwk_addr;
+} esp_zb_zdo_ieee_addr_rsp_t;
+
+typedef enum {
+	ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP = 0x01,
+	ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED = 0x03,
+} esp_zb_zdo_bind_dst_addr_mode_t;
+
+typedef struct {
+	esp_zb_ieee_addr_t src_address;
+	uint8_t src_endp;
+	uint16_t cluster_id;
+	uint8_t dst_addr_mode;          // esp_zb_zdo_bind_dst_addr_mode_t
+	esp_zb_addr_u dst_address_u;
+	uint8_t dst_endp;
+	uint16_t req_dst_addr;          // device holding the binding table
+} esp_zb_zdo_bind_req_param_t;
+
+typedef struct {
+	esp_zb_ext_pan_id_t extended_pan_id;
+	esp_zb_ieee_addr_t ieee_addr;
+	uint16_t network_addr;
+	uint8_t device_type: 2;
+	uint8_t rx_when_idle: 2;
+	uint8_t relationship: 3;
+	uint8_t reserved1: 1;
+	uint8_t permit_joining: 2;
+	uint8_t reserved2: 6;
+	uint8_t depth;
+	uint8_t lqi;
+} esp_zb_zdo_neighbor_table_list_t;
+
+typedef struct {
+	uint8_t status;
+	uint8_t neighbor_table_entries;
+	uint8_t start_index;
+	uint8_t neighbor_table_list_count;
+	esp_zb_zdo_neighbor_table_list_t neighbor_table_list[];
+} esp_zb_zdo_mgmt_lqi_rsp_t;
+
+typedef void (*esp_zb_zdo_mgmt_lqi_rsp_callback_t)(const esp_zb_zdo_mgmt_lqi_rsp_t *rsp, void *user_ctx);
+
+typedef void (*esp_zb_zdo_active_ep_callback_t)(esp_zb_zdp_status_t zdo_status, uint8_t ep_count,
+												uint8_t *ep_id_list, void *user_ctx);
+typedef void (*esp_zb_zdo_simple_desc_callback_t)(esp_zb_zdp_status_t zdo_status,
+												  esp_zb_af_simple_desc_1_1_t *simple_desc, void *user_ctx);
+typedef void (*esp_zb_zdo_scan_complete_callback_t)(esp_zb_zdp_status_t zdo_status, uint8_t count,
+													esp_zb_network_descriptor_t *nwk_descriptor);
+
+void esp_zb_zdo_active_ep_req(esp_zb_zdo_active_ep_req_param_t *cmd_req,
+							  esp_zb_zdo_active_ep_callback_t user_cb, void *user_ctx);
+void esp_zb_zdo_simple_desc_req(esp_zb_zdo_simple_desc_req_param_t *cmd_req,
+								esp_zb_zdo_simple_desc_callback_t user_cb, void *user_ctx);
+void esp_zb_zdo_mgmt_lqi_req(esp_zb_zdo_mgmt_lqi_req_param_t *cmd_req, esp_zb_zdo_mgmt_lqi_rsp_callback_t user_cb,
+							 void *user_ctx);
+typedef void (*esp_zb_zdo_ieee_addr_callback_t)(esp_zb_zdp_status_t zdo_status, esp_zb_zdo_ieee_addr_rsp_t *resp,
+												void *user_ctx);
+
+void esp_zb_zdo_ieee_addr_req(esp_zb_zdo_ieee_addr_req_param_t *cmd_req, esp_zb_zdo_ieee_addr_callback_t user_cb,
+							  void *user_ctx);
+typedef void (*esp_zb_zdo_bind_callback_t)(esp_zb_zdp_status_t zdo_status, void *user_ctx);
+
+void esp_zb_zdo_device_bind_req(esp_zb_zdo_bind_req_param_t *cmd_req, esp_zb_zdo_bind_callback_t user_cb,
+								void *user_ctx);
+typedef void (*esp_zb_zdo_energy_detect_callback_t)(esp_zb_zdp_status_t status, uint16_t count,
+												   esp_zb_energy_detect_channel_info_t *channel_info);
+
+void esp_zb_zdo_active_scan_request(uint32_t channel_mask, uint8_t scan_duration,
+									esp_zb_zdo_scan_complete_callback_t user_cb);
+void esp_zb_zdo_energy_detect_request(uint32_t channel_mask, uint8_t duration,
+									  esp_zb_zdo_energy_detect_callback_t cb);
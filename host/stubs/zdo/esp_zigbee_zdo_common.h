@@ -0,0 +1,65 @@
+// Host stub of zdo/esp_zigbee_zdo_common.h
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+typedef enum {
+	ESP_ZB_ZDO_SIGNAL_DEFAULT_START = 0x00,
+	ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP = 0x01,
+	ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE = 0x02,
+	ESP_ZB_ZDO_SIGNAL_LEAVE = 0x03,
+	ESP_ZB_ZDO_SIGNAL_ERROR = 0x04,
+	ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START = 0x05,
+	ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT = 0x06,
+	ESP_ZB_BDB_SIGNAL_STEERING = 0x0a,
+	ESP_ZB_BDB_SIGNAL_FORMATION = 0x0b,
+	ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION = 0x10,
+	ESP_ZB_ZDO_SIGNAL_DEVICE_AUTHORIZED = 0x2f,
+	ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE = 0x30,
+	ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS = 0x36,
+} esp_zb_app_signal_type_t;
+
+typedef enum {
+	ESP_ZB_ZDP_STATUS_SUCCESS = 0x00,
+	ESP_ZB_ZDP_STATUS_INV_REQUESTTYPE = 0x80,
+	ESP_ZB_ZDP_STATUS_DEVICE_NOT_FOUND = 0x81,
+	ESP_ZB_ZDP_STATUS_INVALID_EP = 0x82,
+	ESP_ZB_ZDP_STATUS_NOT_ACTIVE = 0x83,
+	ESP_ZB_ZDP_STATUS_NOT_SUPPORTED = 0x84,
+	ESP_ZB_ZDP_STATUS_TIMEOUT = 0x85,
+	ESP_ZB_ZDP_STATUS_NO_MATCH = 0x86,
+	ESP_ZB_ZDP_STATUS_NO_ENTRY = 0x88,
+	ESP_ZB_ZDP_STATUS_NO_DESCRIPTOR = 0x89,
+	ESP_ZB_ZDP_STATUS_INSUFFICIENT_SPACE = 0x8a,
+	ESP_ZB_ZDP_STATUS_NOT_PERMITTED = 0x8b,
+	ESP_ZB_ZDP_STATUS_TABLE_FULL = 0x8c,
+	ESP_ZB_ZDP_STATUS_NOT_AUTHORIZED = 0x8d,
+} esp_zb_zdp_status_t;
+
+typedef struct {
+	uint32_t *p_app_signal;
+	esp_err_t esp_err_status;
+} esp_zb_app_signal_t;
+
+typedef struct {
+	uint16_t device_short_addr;
+	esp_zb_ieee_addr_t ieee_addr;
+	uint8_t capability;
+} esp_zb_zdo_signal_device_annce_params_t;
+
+typedef struct {
+	uint16_t short_addr;
+	esp_zb_ieee_addr_t device_addr;
+	uint8_t rejoin;
+} esp_zb_zdo_signal_leave_indication_params_t;
+
+typedef struct {
+	esp_zb_ieee_addr_t long_addr;
+	uint16_t short_addr;
+	uint8_t status;
+	uint8_t tc_action;
+	uint16_t parent_short;
+} esp_zb_zdo_signal_device_update_params_t;
+
+void *esp_zb_app_signal_get_params(uint32_t *signal_p);
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal);
@@ -0,0 +1,429 @@
+// Event log decoder: prints the records of an `evlog` partition image, oldest first
+//   parttool.py read_partition --partition-name evlog --output evlog.bin
+//   evlog_decode [-s | -t [-b boot]] evlog.bin
+// -s prints record counts per type instead of the records. Torn records (a reset during the
+// write) are reported and skipped. Exits 1 when the image holds no event log.
+// -t prints the records of one boot (-b, the last one by default) as a replay trace for
+// bench_replay, one event per line, milliseconds since boot first:
+//   <ms> formed <pan> <channel>
+//   <ms> join <short> <ieee> <capability> [<parent>]
+//   <ms> ep <short> <ep>...
+//   <ms> desc <short> <ep> <profile> <device> <input cluster>...
+//   <ms> attr <short> <ep> <cluster> <attr> <type> <value>     ('string' with \xNN escapes, or 0xNN)
+//   <ms> alert <short> interview|cache
+//   <ms> leave <ieee>
+//   <ms> off <short>      (last heard before going offline) / <ms> on <short>
+// Lines are not in time order: an `off` is known only once the device has been silent a while.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "event_log_format.h"
+
+typedef struct {
+	uint32_t seq;
+	uint32_t index;
+	uint16_t boot;
+} sector_ref_t;
+
+static const char *const s_type_names[EVLOG_TYPE_COUNT] = {
+	"?", "BOOT", "FORMED", "JOIN", "ACTIVE_EP", "SIMPLE_DESC", "STEP_FAILED", "ATTR", "ALERT", "SCAN", "DROPPED",
+	"PRESENCE", "ADDRESS",
+};
+
+static const char *const s_reset_names[] = {
+	"unknown", "power-on", "external", "software", "panic", "interrupt watchdog", "task watchdog", "watchdog",
+	"deep sleep", "brownout", "SDIO",
+};
+
+static const char *const s_step_names[] = { "ActiveEP", "SimpleDesc", "Basic read" };
+
+static const char *const s_alert_sources[] = { "interview", "device cache", "simulation input" };
+
+static const char *const s_presence_states[] = { "reporting", "reporting refused", "offline", "back" };
+
+static const char *const s_address_events[] = { "changed", "taken over", "left", "resolved" };
+
+static int cmp_seq(const void *a, const void *b)
+{
+	const sector_ref_t *x = a, *y = b;
+	int32_t d = (int32_t)(x->seq - y->seq);
+	return d < 0 ? -1 : d > 0;
+}
+
+static void print_ieee(const uint8_t ieee[8])
+{
+	for (int i = 7; i >= 0; i--) printf("%02X%s", ieee[i], i ? ":" : "");
+}
+
+static void print_attr_value(const evlog_attr_t *a, size_t value_len, bool numeric_hex)
+{
+	// Character and octet strings, long or short
+	if (a->type == 0x41 || a->type == 0x42 || a->type == 0x43 || a->type == 0x44) {
+		putchar('\'');
+		for (size_t i = 0; i < value_len; i++) {
+			uint8_t c = a->value[i];
+			if (c >= 0x20 && c < 0x7F && c != '\'' && c != '\\') {
+				putchar(c);
+			} else {
+				printf("\\x%02X", c);
+			}
+		}
+		putchar('\'');
+		return;
+	}
+	uint32_t v = 0;
+	for (size_t i = 0; i < value_len && i < 4; i++) v |= (uint32_t)a->value[i] << (8 * i);
+	if (numeric_hex) {
+		printf("0x%lX", (unsigned long)v);
+	} else {
+		printf("%lu (0x%lX)", (unsigned long)v, (unsigned long)v);
+	}
+}
+
+static void print_record(const evlog_rec_hdr_t *h, const uint8_t *p, uint16_t boot)
+{
+	printf("[boot %u %8lu.%03lu] %-11s ", boot, (unsigned long)(h->time_ms / 1000), (unsigned long)(h->time_ms % 1000),
+		   h->type < EVLOG_TYPE_COUNT ? s_type_names[h->type] : "?");
+	switch (h->type) {
+	case EVLOG_BOOT: {
+		evlog_boot_t b;
+		memcpy(&b, p, sizeof(b));
+		printf("boot %u, reset: %s", b.boot,
+			   b.reset_reason < sizeof(s_reset_names) / sizeof(s_reset_names[0]) ? s_reset_names[b.reset_reason] : "?");
+		break;
+	}
+	case EVLOG_FORMED: {
+		evlog_formed_t f = { 0 };
+		memcpy(&f, p, h->len < sizeof(f) ? h->len : sizeof(f));
+		printf("PAN 0x%04X on channel %u%s", f.pan_id, f.channel, f.resumed ? ", resumed" : "");
+		break;
+	}
+	case EVLOG_JOIN: {
+		evlog_join_t j;
+		memcpy(&j, p, sizeof(j));
+		printf("0x%04X ", j.short_addr);
+		print_ieee(j.ieee);
+		printf(" cap 0x%02X", j.capability);
+		if (j.parent_short != 0xFFFF) printf(" parent 0x%04X", j.parent_short);
+		break;
+	}
+	case EVLOG_ACTIVE_EP: {
+		evlog_active_ep_t a;
+		memcpy(&a, p, sizeof(a));
+		printf("0x%04X %u endpoint(s):", a.short_addr, a.count);
+		for (size_t i = sizeof(a); i < h->len; i++) printf(" %u", p[i]);
+		break;
+	}
+	case EVLOG_SIMPLE_DESC: {
+		evlog_simple_desc_t s;
+		memcpy(&s, p, sizeof(s));
+		printf("0x%04X ep %u profile 0x%04X device 0x%04X", s.short_addr, s.endpoint, s.profile_id, s.device_id);
+		// Input clusters follow in newer records
+		if (h->len > sizeof(s)) printf(" clusters");
+		for (size_t i = sizeof(s); i + 1 < h->len; i += 2) printf(" 0x%04X", p[i] | p[i + 1] << 8);
+		break;
+	}
+	case EVLOG_STEP_FAILED: {
+		evlog_step_failed_t f;
+		memcpy(&f, p, sizeof(f));
+		printf("0x%04X %s", f.short_addr, f.step < 3 ? s_step_names[f.step] : "?");
+		if (f.step) printf(" ep %u", f.endpoint);
+		if (f.status == EVLOG_STATUS_TIMEOUT) {
+			printf(" timed out");
+		} else if (f.status == EVLOG_STATUS_GAVE_UP) {
+			printf(" given up");
+		} else {
+			printf(" status 0x%02X", f.status);
+		}
+		printf(" (attempt %u)", f.attempt);
+		break;
+	}
+	case EVLOG_ATTR: {
+		uint8_t buf[EVLOG_PAYLOAD_MAX];
+		memcpy(buf, p, h->len);
+		const evlog_attr_t *a = (const evlog_attr_t *)buf;
+		printf("0x%04X ep %u cluster 0x%04X attr 0x%04X type 0x%02X = ", a->short_addr, a->endpoint, a->cluster,
+			   a->attr_id, a->type);
+		print_attr_value(a, h->len - sizeof(*a), false);
+		break;
+	}
+	case EVLOG_ALERT: {
+		evlog_alert_t a;
+		memcpy(&a, p, sizeof(a));
+		if (a.source == EVLOG_ALERT_SIMULATION) {
+			printf("simulation input");
+		} else {
+			printf("0x%04X ep %u from %s", a.short_addr, a.endpoint, a.source < 3 ? s_alert_sources[a.source] : "?");
+		}
+		break;
+	}
+	case EVLOG_SCAN: {
+		evlog_scan_t s;
+		memcpy(&s, p, sizeof(s));
+		printf("channel %u PAN 0x%04X ext ", s.channel, s.pan_id);
+		print_ieee(s.ext_pan_id);
+		if (s.permit_joining) printf(" (open)");
+		break;
+	}
+	case EVLOG_DROPPED: {
+		evlog_dropped_t d;
+		memcpy(&d, p, sizeof(d));
+		printf("%lu record(s) lost", (unsigned long)d.count);
+		break;
+	}
+	case EVLOG_PRESENCE: {
+		evlog_presence_t r;
+		memcpy(&r, p, sizeof(r));
+		printf("0x%04X ep %u %s", r.short_addr, r.endpoint, r.state < 4 ? s_presence_states[r.state] : "?");
+		if (r.state == EVLOG_PRESENCE_OFFLINE || (r.state == EVLOG_PRESENCE_BACK && r.silent_s)) {
+			printf(" (silent %lu s)", (unsigned long)r.silent_s);
+		} else if (r.state == EVLOG_PRESENCE_BACK) {
+			printf(" (announced)");
+		}
+		break;
+	}
+	case EVLOG_ADDRESS: {
+		evlog_address_t a;
+		memcpy(&a, p, sizeof(a));
+		print_ieee(a.ieee);
+		printf(" 0x%04X %s", a.short_addr, a.event < 4 ? s_address_events[a.event] : "?");
+		if (a.event == EVLOG_ADDRESS_CHANGED) printf(" (was 0x%04X)", a.old_short);
+		break;
+	}
+	default:
+		printf("%u byte(s)", h->len);
+		break;
+	}
+	putchar('\n');
+}
+
+// One record as a replay trace line; records a replay does not need print nothing
+static void print_trace(const evlog_rec_hdr_t *h, const uint8_t *p)
+{
+	unsigned long ms = (unsigned long)h->time_ms;
+	switch (h->type) {
+	case EVLOG_FORMED: {
+		evlog_formed_t f;
+		memcpy(&f, p, offsetof(evlog_formed_t, resumed));
+		printf("%lu formed 0x%04X %u\n", ms, f.pan_id, f.channel);
+		break;
+	}
+	case EVLOG_JOIN: {
+		evlog_join_t j;
+		memcpy(&j, p, sizeof(j));
+		printf("%lu join 0x%04X ", ms, j.short_addr);
+		print_ieee(j.ieee);
+		printf(" 0x%02X", j.capability);
+		if (j.parent_short != 0xFFFF) printf(" 0x%04X", j.parent_short);
+		putchar('\n');
+		break;
+	}
+	case EVLOG_ACTIVE_EP: {
+		evlog_active_ep_t a;
+		memcpy(&a, p, sizeof(a));
+		printf("%lu ep 0x%04X", ms, a.short_addr);
+		for (size_t i = sizeof(a); i < h->len; i++) printf(" %u", p[i]);
+		putchar('\n');
+		break;
+	}
+	case EVLOG_SIMPLE_DESC: {
+		evlog_simple_desc_t s;
+		memcpy(&s, p, sizeof(s));
+		printf("%lu desc 0x%04X %u 0x%04X 0x%04X", ms, s.short_addr, s.endpoint, s.profile_id, s.device_id);
+		for (size_t i = sizeof(s); i + 1 < h->len; i += 2) printf(" 0x%04X", p[i] | p[i + 1] << 8);
+		putchar('\n');
+		break;
+	}
+	case EVLOG_ATTR: {
+		uint8_t buf[EVLOG_PAYLOAD_MAX];
+		memcpy(buf, p, h->len);
+		const evlog_attr_t *a = (const evlog_attr_t *)buf;
+		printf("%lu attr 0x%04X %u 0x%04X 0x%04X 0x%02X ", ms, a->short_addr, a->endpoint, a->cluster, a->attr_id,
+			   a->type);
+		print_attr_value(a, h->len - sizeof(*a), true);
+		putchar('\n');
+		break;
+	}
+	case EVLOG_ALERT: {
+		evlog_alert_t a;
+		memcpy(&a, p, sizeof(a));
+		if (a.source == EVLOG_ALERT_INTERVIEW || a.source == EVLOG_ALERT_CACHE) {
+			printf("%lu alert 0x%04X %s\n", ms, a.short_addr, a.source == EVLOG_ALERT_CACHE ? "cache" : "interview");
+		}
+		break;
+	}
+	case EVLOG_PRESENCE: {
+		evlog_presence_t r;
+		memcpy(&r, p, sizeof(r));
+		if (r.state == EVLOG_PRESENCE_OFFLINE) {
+			unsigned long silent = (unsigned long)r.silent_s * 1000;
+			printf("%lu off 0x%04X\n", ms > silent ? ms - silent : 0, r.short_addr);
+		} else if (r.state == EVLOG_PRESENCE_BACK) {
+			printf("%lu on 0x%04X\n", ms, r.short_addr);
+		}
+		break;
+	}
+	case EVLOG_ADDRESS: {
+		evlog_address_t a;
+		memcpy(&a, p, sizeof(a));
+		if (a.event == EVLOG_ADDRESS_LEFT) {
+			printf("%lu leave ", ms);
+			print_ieee(a.ieee);
+			putchar('\n');
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// Minimum payload of each type, so the printers never read past a record
+static size_t min_len(uint8_t type)
+{
+	switch (type) {
+	case EVLOG_BOOT: return sizeof(evlog_boot_t);
+	case EVLOG_FORMED: return offsetof(evlog_formed_t, resumed);
+	case EVLOG_JOIN: return sizeof(evlog_join_t);
+	case EVLOG_ACTIVE_EP: return sizeof(evlog_active_ep_t);
+	case EVLOG_SIMPLE_DESC: return sizeof(evlog_simple_desc_t);
+	case EVLOG_STEP_FAILED: return sizeof(evlog_step_failed_t);
+	case EVLOG_ATTR: return sizeof(evlog_attr_t);
+	case EVLOG_ALERT: return sizeof(evlog_alert_t);
+	case EVLOG_SCAN: return sizeof(evlog_scan_t);
+	case EVLOG_DROPPED: return sizeof(evlog_dropped_t);
+	case EVLOG_PRESENCE: return sizeof(evlog_presence_t);
+	case EVLOG_ADDRESS: return sizeof(evlog_address_t);
+	default: return 0;
+	}
+}
+
+typedef enum { MODE_RECORDS, MODE_SUMMARY, MODE_TRACE, MODE_LAST_BOOT } decode_mode_t;
+
+typedef struct {
+	uint32_t counts[EVLOG_TYPE_COUNT + 1];
+	uint32_t records, torn, boots, gaps;
+	uint16_t last_boot;
+} walk_stats_t;
+
+// Every intact record, oldest first; MODE_TRACE prints those of boot trace_boot
+static void walk(const uint8_t *img, const sector_ref_t *refs, uint32_t used, decode_mode_t mode, uint16_t trace_boot,
+				 walk_stats_t *st)
+{
+	memset(st, 0, sizeof(*st));
+	bool verbose = mode == MODE_RECORDS;
+	for (uint32_t s = 0; s < used; s++) {
+		if (s && refs[s].seq != refs[s - 1].seq + 1) {
+			st->gaps++;
+			if (verbose) printf("-- %lu sector(s) missing --\n", (unsigned long)(refs[s].seq - refs[s - 1].seq - 1));
+		}
+		const uint8_t *sec = img + (size_t)refs[s].index * EVLOG_SECTOR_SIZE;
+		uint16_t boot = refs[s].boot;
+		size_t off = sizeof(evlog_sector_hdr_t);
+		while (off + sizeof(evlog_rec_hdr_t) <= EVLOG_SECTOR_SIZE) {
+			evlog_rec_hdr_t h;
+			memcpy(&h, sec + off, sizeof(h));
+			if (h.type == EVLOG_ERASED) break;
+			const uint8_t *p = sec + off + sizeof(h);
+			if (h.len > EVLOG_PAYLOAD_MAX || off + sizeof(h) + h.len > EVLOG_SECTOR_SIZE || h.len < min_len(h.type) ||
+				evlog_crc16(evlog_crc16(0xFFFF, &h.time_ms, sizeof(h.time_ms)), p, h.len) != h.crc) {
+				st->torn++;
+				if (verbose) printf("-- torn record in sector %lu at %zu: rest of the sector skipped --\n",
+									(unsigned long)refs[s].index, off);
+				break;
+			}
+			if (h.type == EVLOG_BOOT) {
+				evlog_boot_t b;
+				memcpy(&b, p, sizeof(b));
+				boot = b.boot;
+				st->boots++;
+			}
+			st->records++;
+			st->counts[h.type < EVLOG_TYPE_COUNT ? h.type : EVLOG_TYPE_COUNT]++;
+			st->last_boot = boot;
+			if (verbose) print_record(&h, p, boot);
+			if (mode == MODE_TRACE && boot == trace_boot) print_trace(&h, p);
+			off += sizeof(h) + h.len;
+		}
+	}
+}
+
+static int usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-s | -t [-b boot]] evlog.bin\n", argv0);
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	decode_mode_t mode = MODE_RECORDS;
+	long trace_boot = -1;
+	int c;
+	while ((c = getopt(argc, argv, "stb:h")) != -1) {
+		switch (c) {
+		case 's': mode = MODE_SUMMARY; break;
+		case 't': mode = MODE_TRACE; break;
+		case 'b': trace_boot = strtol(optarg, NULL, 0); break;
+		default: return usage(argv[0]);
+		}
+	}
+	if (optind >= argc || (trace_boot >= 0 && mode != MODE_TRACE)) return usage(argv[0]);
+	FILE *f = fopen(argv[optind], "rb");
+	if (!f) {
+		perror(argv[optind]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (size <= 0 || size % EVLOG_SECTOR_SIZE) {
+		fprintf(stderr, "%s: not a whole number of %u-byte sectors\n", argv[optind], EVLOG_SECTOR_SIZE);
+		fclose(f);
+		return 1;
+	}
+	uint8_t *img = malloc((size_t)size);
+	if (!img || fread(img, 1, (size_t)size, f) != (size_t)size) {
+		fprintf(stderr, "%s: read failed\n", argv[optind]);
+		fclose(f);
+		free(img);
+		return 1;
+	}
+	fclose(f);
+
+	uint32_t sectors = (uint32_t)(size / EVLOG_SECTOR_SIZE), used = 0;
+	sector_ref_t *refs = calloc(sectors, sizeof(*refs));
+	for (uint32_t i = 0; i < sectors; i++) {
+		evlog_sector_hdr_t h;
+		memcpy(&h, img + (size_t)i * EVLOG_SECTOR_SIZE, sizeof(h));
+		if (h.magic != EVLOG_MAGIC || h.version != EVLOG_VERSION) continue;
+		refs[used++] = (sector_ref_t){ .seq = h.seq, .index = i, .boot = h.boot };
+	}
+	if (!used) {
+		fprintf(stderr, "%s: no event log sectors\n", argv[optind]);
+		free(refs);
+		free(img);
+		return 1;
+	}
+	qsort(refs, used, sizeof(*refs), cmp_seq);
+
+	walk_stats_t st;
+	if (mode == MODE_TRACE && trace_boot < 0) {
+		walk(img, refs, used, MODE_LAST_BOOT, 0, &st);
+		trace_boot = st.last_boot;
+	}
+	walk(img, refs, used, mode, (uint16_t)trace_boot, &st);
+	if (mode == MODE_SUMMARY) {
+		printf("sectors %lu of %lu, seq %lu..%lu, gaps %lu\n", (unsigned long)used, (unsigned long)sectors,
+			   (unsigned long)refs[0].seq, (unsigned long)refs[used - 1].seq, (unsigned long)st.gaps);
+		printf("records %lu, boots %lu, torn %lu\n", (unsigned long)st.records, (unsigned long)st.boots,
+			   (unsigned long)st.torn);
+		for (int t = 1; t < EVLOG_TYPE_COUNT; t++) printf("%s %lu\n", s_type_names[t], (unsigned long)st.counts[t]);
+		if (st.counts[EVLOG_TYPE_COUNT]) printf("unknown %lu\n", (unsigned long)st.counts[EVLOG_TYPE_COUNT]);
+	}
+	free(refs);
+	free(img);
+	return 0;
+}
@@ -0,0 +1,323 @@
+// Gateway link receiver: reference decoder of the coordinators' binary streams
+//   gateway_recv [-b baud] [-s] tty...
+// Reads any number of serial ports at once (one coordinator each, or several behind a
+// multiplexer) and prints one line per record, coordinator first:
+//   <node> <boot> <seq> <ms> network <pan> <channel> formed|resumed
+//   <node> <boot> <seq> <ms> join <short> <ieee> <capability> <parent>
+//   <node> <boot> <seq> <ms> verdict <short> <ieee> match|other interview|cache ['<model>']
+//   <node> <boot> <seq> <ms> alert <short> <ieee> <endpoint> interview|cache|simulation
+//   <node> <boot> <seq> <ms> dropped <count>
+// <ms> is the record's time since the coordinator's boot. Ports are set to raw 8N1 at -b baud
+// (460800 by default) with RTS/CTS flow control, so a slow reader holds the coordinators back
+// instead of losing bytes. Frames that fail their checks are skipped and the stream is searched
+// for the next one. -s prints only the summary, which ends the output once every port is closed
+// or on SIGINT/SIGTERM (lines starting with '#'):
+//   # <port>: frames <n> records <n> bytes <n> rejected <n> skipped <n> lost <n> dropped <n>
+// rejected: candidate frames with a bad length or CRC; skipped: bytes outside any frame;
+// lost: frames missing from a coordinator's sequence; dropped: records the coordinator reported
+// dropping under back-pressure.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include "gateway_link_format.h"
+
+#define MAX_PORTS           (32)
+#define MAX_NODES           (64)
+#define PORT_BUF            (4 * GWLINK_FRAME_MAX)
+
+typedef struct {
+	const char *path;
+	int fd;
+	uint8_t buf[PORT_BUF];
+	size_t len;
+	unsigned long frames, records, bytes, rejected, skipped, lost, dropped;
+} port_t;
+
+typedef struct {
+	uint8_t node[8];
+	uint16_t boot;
+	uint16_t seq;                   // last frame seen
+} node_t;
+
+static port_t s_ports[MAX_PORTS];
+static int s_port_count;
+static node_t s_nodes[MAX_NODES];
+static int s_node_count;
+static bool s_summary_only;
+static volatile sig_atomic_t s_stop;
+
+static const char *const s_alert_sources[] = { "interview", "cache", "simulation" };
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	s_stop = 1;
+}
+
+static speed_t baud_of(long baud)
+{
+	switch (baud) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+	case 460800: return B460800;
+	case 921600: return B921600;
+	case 1000000: return B1000000;
+	case 1500000: return B1500000;
+	case 2000000: return B2000000;
+	default: return 0;
+	}
+}
+
+static int open_port(const char *path, speed_t speed)
+{
+	int fd = open(path, O_RDONLY | O_NOCTTY);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	struct termios t;
+	if (tcgetattr(fd, &t) == 0) {
+		cfmakeraw(&t);
+		t.c_cflag |= CLOCAL | CREAD | CRTSCTS;
+		cfsetspeed(&t, speed);
+		if (tcsetattr(fd, TCSANOW, &t) != 0) perror(path);
+	}
+	return fd;
+}
+
+static void print_ieee(const uint8_t ieee[8])
+{
+	for (int i = 7; i >= 0; i--) printf("%02X%s", ieee[i], i ? ":" : "");
+}
+
+// Frames a coordinator's sequence skipped since its previous frame
+static unsigned long track(const gwlink_frame_hdr_t *h)
+{
+	for (int i = 0; i < s_node_count; i++) {
+		node_t *n = &s_nodes[i];
+		if (memcmp(n->node, h->node, sizeof(n->node)) != 0) continue;
+		unsigned long lost = 0;
+		// A new boot starts again from 0; within a boot, count the gap
+		if (h->boot == n->boot) lost = (uint16_t)(h->seq - n->seq - 1);
+		n->boot = h->boot;
+		n->seq = h->seq;
+		return lost;
+	}
+	if (s_node_count < MAX_NODES) {
+		node_t *n = &s_nodes[s_node_count++];
+		memcpy(n->node, h->node, sizeof(n->node));
+		n->boot = h->boot;
+		n->seq = h->seq;
+	}
+	// First frame heard from this coordinator: frames before it were sent before we listened
+	return 0;
+}
+
+static void print_record(const gwlink_frame_hdr_t *h, const gwlink_rec_hdr_t *r, const uint8_t *p)
+{
+	print_ieee(h->node);
+	printf(" %u %u %lu ", h->boot, h->seq, (unsigned long)(h->time_ms - r->age_ms));
+	switch (r->type) {
+	case GWLINK_NETWORK: {
+		gwlink_network_t n;
+		if (r->len < sizeof(n)) goto short_rec;
+		memcpy(&n, p, sizeof(n));
+		printf("network 0x%04X %u %s\n", n.pan_id, n.channel, n.resumed ? "resumed" : "formed");
+		return;
+	}
+	case GWLINK_JOIN: {
+		gwlink_join_t j;
+		if (r->len < sizeof(j)) goto short_rec;
+		memcpy(&j, p, sizeof(j));
+		printf("join 0x%04X ", j.short_addr);
+		print_ieee(j.ieee);
+		printf(" 0x%02X 0x%04X\n", j.capability, j.parent_short);
+		return;
+	}
+	case GWLINK_VERDICT: {
+		gwlink_verdict_t v;
+		if (r->len < sizeof(v)) goto short_rec;
+		memcpy(&v, p, sizeof(v));
+		printf("verdict 0x%04X ", v.short_addr);
+		print_ieee(v.ieee);
+		printf(" %s %s", v.verdict == 2 ? "match" : "other", v.source == GWLINK_VERDICT_CACHE ? "cache" : "interview");
+		if (r->len > sizeof(v)) {
+			printf(" '");
+			for (size_t i = sizeof(v); i < r->len; i++) {
+				uint8_t c = p[i];
+				if (c >= 0x20 && c < 0x7F && c != '\'' && c != '\\') {
+					putchar(c);
+				} else {
+					printf("\\x%02X", c);
+				}
+			}
+			putchar('\'');
+		}
+		putchar('\n');
+		return;
+	}
+	case GWLINK_ALERT: {
+		gwlink_alert_t a;
+		if (r->len < sizeof(a)) goto short_rec;
+		memcpy(&a, p, sizeof(a));
+		printf("alert 0x%04X ", a.short_addr);
+		print_ieee(a.ieee);
+		printf(" %u %s\n", a.endpoint, a.source < 3 ? s_alert_sources[a.source] : "?");
+		return;
+	}
+	case GWLINK_DROPPED: {
+		gwlink_dropped_t d;
+		if (r->len < sizeof(d)) goto short_rec;
+		memcpy(&d, p, sizeof(d));
+		printf("dropped %lu\n", (unsigned long)d.count);
+		return;
+	}
+	default:
+		printf("type %u, %u bytes\n", r->type, r->len);
+		return;
+	}
+short_rec:
+	printf("type %u, short record (%u bytes)\n", r->type, r->len);
+}
+
+static void take_frame(port_t *pt, const gwlink_frame_hdr_t *h, const uint8_t *records)
+{
+	pt->frames++;
+	pt->bytes += sizeof(*h) + h->len + sizeof(uint16_t);
+	pt->lost += track(h);
+	size_t off = 0;
+	while (off + sizeof(gwlink_rec_hdr_t) <= h->len) {
+		gwlink_rec_hdr_t r;
+		memcpy(&r, &records[off], sizeof(r));
+		off += sizeof(r);
+		if (off + r.len > h->len) break;
+		pt->records++;
+		if (r.type == GWLINK_DROPPED && r.len >= sizeof(gwlink_dropped_t)) {
+			gwlink_dropped_t d;
+			memcpy(&d, &records[off], sizeof(d));
+			pt->dropped += d.count;
+		}
+		if (!s_summary_only) print_record(h, &r, &records[off]);
+		off += r.len;
+	}
+	if (!s_summary_only) fflush(stdout);
+}
+
+// Take every complete frame in the port's buffer, skipping whatever is not one
+static void parse(port_t *pt)
+{
+	size_t at = 0;
+	while (at < pt->len) {
+		if (pt->buf[at] != GWLINK_SYNC0 || (at + 1 < pt->len && pt->buf[at + 1] != GWLINK_SYNC1)) {
+			at++;
+			pt->skipped++;
+			continue;
+		}
+		if (pt->len - at < sizeof(gwlink_frame_hdr_t)) break;
+		gwlink_frame_hdr_t h;
+		memcpy(&h, &pt->buf[at], sizeof(h));
+		if (h.version != GWLINK_VERSION || h.len > GWLINK_RECORDS_MAX) {
+			pt->rejected++;
+			pt->skipped++;
+			at++;
+			continue;
+		}
+		size_t size = sizeof(h) + h.len + sizeof(uint16_t);
+		if (pt->len - at < size) break;
+		const uint8_t *records = &pt->buf[at + sizeof(h)];
+		uint16_t crc;
+		memcpy(&crc, &records[h.len], sizeof(crc));
+		if (crc != gwlink_frame_crc(&h, records)) {
+			pt->rejected++;
+			pt->skipped++;
+			at++;
+			continue;
+		}
+		take_frame(pt, &h, records);
+		at += size;
+	}
+	memmove(pt->buf, &pt->buf[at], pt->len - at);
+	pt->len -= at;
+}
+
+static int usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-b baud] [-s] tty...\n", argv0);
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	long baud = 460800;
+	int c;
+	while ((c = getopt(argc, argv, "b:sh")) != -1) {
+		switch (c) {
+		case 'b': baud = strtol(optarg, NULL, 0); break;
+		case 's': s_summary_only = true; break;
+		default: return usage(argv[0]);
+		}
+	}
+	speed_t speed = baud_of(baud);
+	if (optind >= argc || argc - optind > MAX_PORTS || !speed) return usage(argv[0]);
+	for (int i = optind; i < argc; i++) {
+		port_t *pt = &s_ports[s_port_count++];
+		pt->path = argv[i];
+		pt->fd = open_port(argv[i], speed);
+		if (pt->fd < 0) return 1;
+	}
+	struct sigaction sa = { .sa_handler = on_signal };
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	printf("# listening on %d port%s\n", s_port_count, s_port_count == 1 ? "" : "s");
+	fflush(stdout);
+
+	int open_ports = s_port_count;
+	while (open_ports && !s_stop) {
+		struct pollfd fds[MAX_PORTS];
+		for (int i = 0; i < s_port_count; i++) fds[i] = (struct pollfd){ .fd = s_ports[i].fd, .events = POLLIN };
+		if (poll(fds, (nfds_t)s_port_count, -1) < 0) {
+			if (errno == EINTR) continue;
+			perror("poll");
+			break;
+		}
+		for (int i = 0; i < s_port_count; i++) {
+			port_t *pt = &s_ports[i];
+			if (pt->fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+			ssize_t n = read(pt->fd, &pt->buf[pt->len], sizeof(pt->buf) - pt->len);
+			if (n > 0) {
+				pt->len += (size_t)n;
+				parse(pt);
+				// A buffer full of no frame at all: let it go
+				if (pt->len == sizeof(pt->buf)) {
+					pt->skipped += pt->len;
+					pt->len = 0;
+				}
+			} else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+				// Hung up: the other end of a pseudo-terminal closed, or the adapter went away
+				close(pt->fd);
+				pt->fd = -1;
+				fds[i].fd = -1;
+				open_ports--;
+			}
+		}
+	}
+	for (int i = 0; i < s_port_count; i++) {
+		const port_t *pt = &s_ports[i];
+		printf("# %s: frames %lu records %lu bytes %lu rejected %lu skipped %lu lost %lu dropped %lu\n", pt->path,
+			   pt->frames, pt->records, pt->bytes, pt->rejected, pt->skipped, pt->lost, pt->dropped);
+	}
+	return 0;
+}
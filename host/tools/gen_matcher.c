@@ -0,0 +1,133 @@
+// Generates main/matcher_tables.h from main/match_rules.h
+// Builds the Aho-Corasick automaton of all rule patterns and flattens it into a DFA
+// (state x symbol class -> state) with the set of matching rules per state.
+//   gen_matcher [output.h]     (stdout when no file is given)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "match_rules.h"
+
+#define MAX_STATES      (2048)
+#define MAX_CLASSES     (96)
+
+typedef struct {
+	const char *name;
+	const char *pattern;
+} rule_t;
+
+#define X(id, fields, flags, vendor, pattern) { #id, pattern },
+static const rule_t s_rules[] = { MATCH_RULES(X) };
+#undef X
+#define RULE_COUNT      (sizeof(s_rules) / sizeof(s_rules[0]))
+
+static int s_class_of[128];         // folded ASCII symbol -> class, 0 = not in any pattern
+static int s_classes = 1;
+static int s_goto[MAX_STATES][MAX_CLASSES];
+static int s_delta[MAX_STATES][MAX_CLASSES];
+static int s_fail[MAX_STATES];
+static uint64_t s_out[MAX_STATES];
+static int s_states = 1;
+
+static int fail(const char *msg, const char *detail)
+{
+	fprintf(stderr, "gen_matcher: %s: %s\n", msg, detail);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	if (RULE_COUNT > 64) return fail("too many rules", "at most 64");
+	// Symbol classes, in ASCII order so the output does not depend on rule order
+	for (size_t r = 0; r < RULE_COUNT; r++) {
+		const char *p = s_rules[r].pattern;
+		if (!*p) return fail("empty pattern", s_rules[r].name);
+		for (; *p; p++) {
+			unsigned char c = (unsigned char)*p;
+			if (c < 0x20 || c > 0x7E || (c >= 'A' && c <= 'Z')) {
+				return fail("pattern must be lowercase printable ASCII", s_rules[r].name);
+			}
+			s_class_of[c] = -1;
+		}
+	}
+	for (int c = 0; c < 128; c++) {
+		if (s_class_of[c] == -1) s_class_of[c] = s_classes++;
+	}
+	if (s_classes > MAX_CLASSES) return fail("too many symbols", "raise MAX_CLASSES");
+
+	// Trie
+	memset(s_goto, -1, sizeof(s_goto));
+	for (size_t r = 0; r < RULE_COUNT; r++) {
+		int s = 0;
+		for (const char *p = s_rules[r].pattern; *p; p++) {
+			int cls = s_class_of[(unsigned char)*p];
+			if (s_goto[s][cls] < 0) {
+				if (s_states >= MAX_STATES) return fail("too many states", "raise MAX_STATES");
+				s_goto[s][cls] = s_states++;
+			}
+			s = s_goto[s][cls];
+		}
+		s_out[s] |= (uint64_t)1 << r;
+	}
+
+	// Failure links in BFS order, folded into a complete transition table
+	static int queue[MAX_STATES];
+	int head = 0, tail = 0;
+	for (int cls = 0; cls < s_classes; cls++) {
+		int v = s_goto[0][cls];
+		if (v < 0) {
+			s_delta[0][cls] = 0;
+		} else {
+			s_fail[v] = 0;
+			s_delta[0][cls] = v;
+			queue[tail++] = v;
+		}
+	}
+	while (head < tail) {
+		int u = queue[head++];
+		s_out[u] |= s_out[s_fail[u]];
+		for (int cls = 0; cls < s_classes; cls++) {
+			int v = s_goto[u][cls];
+			if (v < 0) {
+				s_delta[u][cls] = s_delta[s_fail[u]][cls];
+			} else {
+				s_fail[v] = s_delta[s_fail[u]][cls];
+				s_delta[u][cls] = v;
+				queue[tail++] = v;
+			}
+		}
+	}
+
+	FILE *f = stdout;
+	if (argc > 1 && !(f = fopen(argv[1], "w"))) return fail("cannot write", argv[1]);
+	const char *state_type = s_states <= 256 ? "uint8_t" : "uint16_t";
+	fprintf(f, "// Generated by host/tools/gen_matcher.c from match_rules.h: do not edit.\n");
+	fprintf(f, "// Aho-Corasick DFA over %zu patterns: %d states x %d symbol classes\n", RULE_COUNT, s_states, s_classes);
+	fprintf(f, "#pragma once\n\n#include <stdint.h>\n\n");
+	fprintf(f, "#define MATCH_TABLES_RULE_COUNT     (%zu)\n", RULE_COUNT);
+	fprintf(f, "#define MATCH_STATES                (%d)\n", s_states);
+	fprintf(f, "#define MATCH_CLASSES               (%d)\n\n", s_classes);
+	fprintf(f, "// ASCII byte -> symbol class (upper and lower case share a class)\n");
+	fprintf(f, "static const uint8_t s_match_class[128] = {");
+	for (int c = 0; c < 128; c++) {
+		int folded = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+		fprintf(f, "%s%d,", c % 16 ? " " : "\n\t", s_class_of[folded]);
+	}
+	fprintf(f, "\n};\n\n");
+	fprintf(f, "static const %s s_match_delta[MATCH_STATES][MATCH_CLASSES] = {\n", state_type);
+	for (int s = 0; s < s_states; s++) {
+		fprintf(f, "\t{");
+		for (int cls = 0; cls < s_classes; cls++) fprintf(f, "%s%d", cls ? "," : "", s_delta[s][cls]);
+		fprintf(f, "},\n");
+	}
+	fprintf(f, "};\n\n");
+	fprintf(f, "// Rules matched when the automaton enters each state\n");
+	fprintf(f, "static const uint64_t s_match_out[MATCH_STATES] = {");
+	for (int s = 0; s < s_states; s++) {
+		fprintf(f, "%s0x%llxull,", s % 6 ? " " : "\n\t", (unsigned long long)s_out[s]);
+	}
+	fprintf(f, "\n};\n");
+	if (f != stdout) fclose(f);
+	return 0;
+}
@@ -0,0 +1,311 @@
+// Alert output task: RGB LED and active buzzer
+
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/ledc.h"
+// On-board RGB LED (WS2812) driven via RMT
+#include "led_strip.h"
+#include "event_log.h"
+#include "gateway_link.h"
+#include "latency.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "actuator.h"
+
+static const char *TAG = "ZB_SCAN";
+
+_Static_assert((ACTUATOR_RING_LEN & (ACTUATOR_RING_LEN - 1)) == 0, "ACTUATOR_RING_LEN must be a power of two");
+
+// Notification bits of the actuator task
+#define NOTIFY_EVENTS           (1u << 0)   // alert events in the ring
+#define NOTIFY_SIMULATION       (1u << 1)   // edges in the simulation log
+#define NOTIFY_LED_TIMEOUT      (1u << 2)   // alert duration elapsed
+#define NOTIFY_BUZZER_TOGGLE    (1u << 3)
+
+typedef struct {
+	uint16_t short_addr;
+	uint8_t endpoint;
+	int64_t posted_us;
+} alert_event_t;
+
+// Single producer (Zigbee task) / single consumer (actuator task). Each index is written by
+// one side only; release/acquire publishes the slot contents together with the index.
+static alert_event_t s_ring[ACTUATOR_RING_LEN];
+static atomic_uint s_head;
+static atomic_uint s_tail;
+
+// Simulated detections: the ISR appends edge times and never waits. The count is what
+// makes the hand-over lossless; an edge time overwritten before the task reads it only
+// costs a latency sample.
+static int64_t s_sim_edge_us[ACTUATOR_RING_LEN];
+static atomic_uint s_sim_head;
+static unsigned s_sim_tail;
+
+static TaskHandle_t s_task = NULL;
+static StackType_t s_task_stack[ACTUATOR_TASK_STACK];
+static StaticTask_t s_task_tcb;
+static actuator_stats_t s_stats;
+
+// Owned by the actuator task after actuator_init()
+static led_strip_handle_t s_led_strip = NULL;
+static TimerHandle_t s_led_timer = NULL;    // timer to return to green after the configured duration
+static TimerHandle_t s_buzzer_timer = NULL; // buzzer blink timer during alert
+static StaticTimer_t s_led_timer_buf;
+static StaticTimer_t s_buzzer_timer_buf;
+static bool s_buzzer_state = false;
+static bool s_alerting = false;
+static uint32_t s_buzzer_on_duty = 0;       // duty for the configured volume
+
+static void led_set_rgb(uint8_t r, uint8_t g, uint8_t b)
+{
+	if (!s_led_strip) return;
+	// Set color of the first pixel and refresh
+	// Some WS2812 boards use GRB order; swap R<->G to correct colors
+	(void)led_strip_set_pixel(s_led_strip, 0, g, r, b);
+	(void)led_strip_refresh(s_led_strip);
+}
+
+static void buzzer_set(bool on)
+{
+	s_buzzer_state = on;
+	(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, on ? s_buzzer_on_duty : 0);
+	(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
+}
+
+// Timer callbacks run in the timer service task: hand the work to the actuator task
+static void led_timer_cb(TimerHandle_t xTimer)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)xTimer;
+	xTaskNotify(s_task, NOTIFY_LED_TIMEOUT, eSetBits);
+}
+
+static void buzzer_timer_cb(TimerHandle_t xTimer)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)xTimer;
+	xTaskNotify(s_task, NOTIFY_BUZZER_TOGGLE, eSetBits);
+}
+
+// LED red + buzzer blinking for ALERT_DURATION_MS (restarts the period if already alerting)
+static void alert_output_start(void)
+{
+	if (!s_alerting) {
+		led_set_rgb(255, 0, 0);
+		s_alerting = true;
+	}
+	if (s_led_timer) xTimerReset(s_led_timer, 0);
+	// Active buzzer: 2 Hz blinking, starting in the ON state
+	buzzer_set(true);
+	if (s_buzzer_timer) xTimerReset(s_buzzer_timer, 0);
+}
+
+static void alert_output_stop(void)
+{
+	// Return to green (idle), buzzer off
+	if (s_buzzer_timer) xTimerStop(s_buzzer_timer, 0);
+	buzzer_set(false);
+	led_set_rgb(0, 255, 0);
+	s_alerting = false;
+}
+
+// Drain the ring up to head, after the output was updated at now
+static void drain_events(unsigned head, int64_t now)
+{
+	unsigned tail = atomic_load_explicit(&s_tail, memory_order_relaxed);
+	s_stats.processed += head - tail;
+	for (; tail != head; tail++) {
+		const alert_event_t *ev = &s_ring[tail & (ACTUATOR_RING_LEN - 1)];
+		uint32_t latency = (uint32_t)(now - ev->posted_us);
+		if (latency > s_stats.max_latency_us) s_stats.max_latency_us = latency;
+		latency_record(LATENCY_ALERT_OUTPUT, LATENCY_CLASS_OTHER, latency);
+		ESP_LOGD(TAG, "Alert output for 0x%04X ep%u (queued %lu us)", ev->short_addr, ev->endpoint,
+				 (unsigned long)latency);
+	}
+	atomic_store_explicit(&s_tail, tail, memory_order_release);
+}
+
+static void drain_simulation(unsigned head, int64_t now)
+{
+	uint32_t n = head - s_sim_tail;
+	uint32_t first_latency = 0;
+	for (unsigned seq = s_sim_tail; seq != head; seq++) {
+		int64_t edge_us = s_sim_edge_us[seq & (ACTUATOR_RING_LEN - 1)];
+		// Valid only if the ISR has not reused the slot meanwhile
+		if (atomic_load_explicit(&s_sim_head, memory_order_acquire) - seq > ACTUATOR_RING_LEN) continue;
+		uint32_t latency = (uint32_t)(now - edge_us);
+		if (seq == s_sim_tail) first_latency = latency;
+		if (latency > s_stats.sim_latency_max_us) s_stats.sim_latency_max_us = latency;
+		s_stats.sim_latency_sum_us += latency;
+		s_stats.sim_latency_samples++;
+	}
+	s_sim_tail = head;
+	s_stats.sim_triggers += n;
+	evlog_alert_t rec = { .short_addr = 0xFFFF, .endpoint = 0, .source = EVLOG_ALERT_SIMULATION };
+	event_log_write(EVLOG_ALERT, &rec, sizeof(rec));
+	gateway_link_alert(NULL, rec.short_addr, rec.endpoint, EVLOG_ALERT_SIMULATION);
+	ESP_LOGW(TAG, "SIMULATION ALERT: %lu trigger(s), alert output %lu us after the edge", (unsigned long)n,
+			 (unsigned long)first_latency);
+}
+
+static void led_init(void);
+static void buzzer_init(void);
+
+static void actuator_task(void *arg)
+{
+	(void)arg;
+	// Peripherals and the startup beep here rather than in actuator_init(): app_main and the
+	// Zigbee stack start-up do not wait for them
+	led_init();
+	buzzer_init();
+	// Startup beep: 200ms to verify buzzer works
+	buzzer_set(true);
+	vTaskDelay(pdMS_TO_TICKS(200));
+	buzzer_set(false);
+	// Alerts posted before this task existed were not notified (s_task was still NULL): look at
+	// the rings once before the first wait, so they are served now rather than with the next one
+	xTaskNotify(xTaskGetCurrentTaskHandle(), NOTIFY_EVENTS | NOTIFY_SIMULATION, eSetBits);
+	for (;;) {
+		uint32_t bits = 0;
+		xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+		// A timeout that raced with a new alert is handled first, so the new alert wins
+		if (bits & NOTIFY_LED_TIMEOUT) alert_output_stop();
+		if ((bits & NOTIFY_BUZZER_TOGGLE) && s_alerting) buzzer_set(!s_buzzer_state);
+		// Everything queued so far is served by one output update
+		unsigned head = atomic_load_explicit(&s_head, memory_order_acquire);
+		unsigned sim_head = atomic_load_explicit(&s_sim_head, memory_order_acquire);
+		bool events = head != atomic_load_explicit(&s_tail, memory_order_relaxed);
+		bool sims = sim_head != s_sim_tail;
+		if (!events && !sims) continue;
+		alert_output_start();
+		int64_t now = esp_timer_get_time();
+		if (events) {
+			s_stats.batches++;
+			drain_events(head, now);
+		}
+		if (sims) drain_simulation(sim_head, now);
+	}
+}
+
+bool actuator_post_alert(uint16_t short_addr, uint8_t endpoint)
+{
+	unsigned head = atomic_load_explicit(&s_head, memory_order_relaxed);
+	unsigned tail = atomic_load_explicit(&s_tail, memory_order_acquire);
+	unsigned used = head - tail;
+	if (used >= ACTUATOR_RING_LEN) {
+		s_stats.dropped++;
+		return false;
+	}
+	s_ring[head & (ACTUATOR_RING_LEN - 1)] = (alert_event_t){
+		.short_addr = short_addr,
+		.endpoint = endpoint,
+		.posted_us = esp_timer_get_time(),
+	};
+	atomic_store_explicit(&s_head, head + 1, memory_order_release);
+	s_stats.posted++;
+	if (used + 1 > s_stats.ring_peak) s_stats.ring_peak = (uint16_t)(used + 1);
+	if (s_task) xTaskNotify(s_task, NOTIFY_EVENTS, eSetBits);
+	return true;
+}
+
+void actuator_post_simulation_from_isr(int64_t edge_us, BaseType_t *woken)
+{
+	unsigned head = atomic_load_explicit(&s_sim_head, memory_order_relaxed);
+	s_sim_edge_us[head & (ACTUATOR_RING_LEN - 1)] = edge_us;
+	atomic_store_explicit(&s_sim_head, head + 1, memory_order_release);
+	if (s_task) xTaskNotifyFromISR(s_task, NOTIFY_SIMULATION, eSetBits, woken);
+}
+
+void actuator_get_stats(actuator_stats_t *out)
+{
+	*out = s_stats;
+}
+
+void actuator_reset_stats(void)
+{
+	s_stats = (actuator_stats_t){ 0 };
+}
+
+static void led_init(void)
+{
+	// Configure LED strip device with RMT
+	led_strip_config_t strip_config = {
+		.strip_gpio_num = BOARD_RGB_LED_GPIO,
+		.max_leds = 1,
+		.led_model = LED_MODEL_WS2812,
+		.flags.invert_out = false,
+	};
+	led_strip_rmt_config_t rmt_config = {
+		.resolution_hz = 10 * 1000 * 1000, // 10MHz
+		.flags.with_dma = false,
+	};
+	esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &s_led_strip);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Failed to initialize RGB LED (gpio=%d): %s", BOARD_RGB_LED_GPIO, esp_err_to_name(err));
+		s_led_strip = NULL;
+		return;
+	}
+	(void)led_strip_clear(s_led_strip);
+	// Idle state: green
+	led_set_rgb(0, 255, 0);
+}
+
+static void buzzer_init(void)
+{
+	// Configure LEDC for PWM on the buzzer GPIO
+	ledc_timer_config_t tcfg = {
+		.speed_mode = BUZZER_LEDC_MODE,
+		.duty_resolution = BUZZER_LEDC_DUTY_RES,
+		.timer_num = BUZZER_LEDC_TIMER,
+		.freq_hz = BUZZER_PWM_FREQ_HZ,
+		.clk_cfg = LEDC_AUTO_CLK,
+	};
+	esp_err_t err = ledc_timer_config(&tcfg);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "LEDC timer config failed: %s", esp_err_to_name(err));
+	}
+	ledc_channel_config_t ccfg = {
+		.gpio_num = BUZZER_GPIO,
+		.speed_mode = BUZZER_LEDC_MODE,
+		.channel = BUZZER_LEDC_CHANNEL,
+		.intr_type = LEDC_INTR_DISABLE,
+		.timer_sel = BUZZER_LEDC_TIMER,
+		.duty = 0,
+		.hpoint = 0,
+		.flags = { .output_invert = 0 },
+	};
+	err = ledc_channel_config(&ccfg);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "LEDC channel config failed: %s", esp_err_to_name(err));
+	}
+	// Compute duty for the configured volume
+	uint32_t max_duty = (1U << (int)BUZZER_LEDC_DUTY_RES) - 1U;
+	uint32_t pct = (BUZZER_VOLUME_PCT > 100) ? 100 : BUZZER_VOLUME_PCT;
+	s_buzzer_on_duty = (max_duty * pct) / 100U;
+	// Ensure initial OFF
+	buzzer_set(false);
+}
+
+esp_err_t actuator_init(void)
+{
+	// One-shot timer with the configured alert duration, periodic timer for 2 Hz blink
+	s_led_timer = xTimerCreateStatic("led_to_green", pdMS_TO_TICKS(ALERT_DURATION_MS), pdFALSE, NULL, led_timer_cb,
+									 &s_led_timer_buf);
+	s_buzzer_timer = xTimerCreateStatic("buzz_tgl", pdMS_TO_TICKS(250), pdTRUE, NULL, buzzer_timer_cb,
+										&s_buzzer_timer_buf);
+	if (!s_led_timer || !s_buzzer_timer) {
+		ESP_LOGW(TAG, "Failed to create alert timers");
+	}
+	s_task = xTaskCreateStatic(actuator_task, "actuator", ACTUATOR_TASK_STACK, NULL, ACTUATOR_TASK_PRIO, s_task_stack,
+							   &s_task_tcb);
+	if (!s_task) {
+		ESP_LOGE(TAG, "Failed to create actuator task");
+		return ESP_ERR_NO_MEM;
+	}
+	metrics_register_task(s_task, "actuator", ACTUATOR_TASK_STACK);
+	return ESP_OK;
+}
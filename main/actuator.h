@@ -0,0 +1,91 @@
+// Alert output: RGB LED and active buzzer, owned by a dedicated low-priority task
+// - The Zigbee task posts alert events to a lock-free single-producer/single-consumer ring
+//   and notifies the actuator task; it never calls the RMT/LEDC drivers or timer APIs itself
+// - The LED and buzzer timers only notify the actuator task, which makes every driver call
+// - Events queued while the task is busy are handled in one batch (one LED refresh)
+// - A full ring drops the event and counts it; the caller still logs the alert
+// - Simulated detections come from the simulation input ISR through a separate edge log,
+//   so the Zigbee ring keeps a single producer and no trigger is ever lost
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// Assumption: the board has a WS2812 RGB LED on GPIO 8 (ESP32-C6 DevKitC)
+#ifndef BOARD_RGB_LED_GPIO
+#define BOARD_RGB_LED_GPIO     (8)
+#endif
+// Active buzzer on GPIO 10 (logic high = ON)
+#ifndef BUZZER_GPIO
+#define BUZZER_GPIO            (10)
+#endif
+
+// Alert duration (LED red + active buzzer) in milliseconds
+#ifndef ALERT_DURATION_MS
+#define ALERT_DURATION_MS       (10 * 1000) // 10 seconds
+#endif
+
+// Active buzzer volume percentage (0..100). Implemented with LEDC PWM
+#ifndef BUZZER_VOLUME_PCT
+#define BUZZER_VOLUME_PCT       (100)
+#endif
+
+// PWM configuration for the buzzer
+#ifndef BUZZER_PWM_FREQ_HZ
+#define BUZZER_PWM_FREQ_HZ      (2000) // 2 kHz (more audible for some buzzers)
+#endif
+#ifndef BUZZER_LEDC_MODE
+#define BUZZER_LEDC_MODE        LEDC_LOW_SPEED_MODE
+#endif
+#ifndef BUZZER_LEDC_TIMER
+#define BUZZER_LEDC_TIMER       LEDC_TIMER_0
+#endif
+#ifndef BUZZER_LEDC_CHANNEL
+#define BUZZER_LEDC_CHANNEL     LEDC_CHANNEL_0
+#endif
+#ifndef BUZZER_LEDC_DUTY_RES
+#define BUZZER_LEDC_DUTY_RES    LEDC_TIMER_10_BIT // 10 bits -> 1023 max
+#endif
+
+// Alert events buffered between the Zigbee task and the actuator task (power of two)
+#ifndef ACTUATOR_RING_LEN
+#define ACTUATOR_RING_LEN       (16)
+#endif
+// Below the Zigbee task (5): alert output must never delay the stack
+#ifndef ACTUATOR_TASK_PRIO
+#define ACTUATOR_TASK_PRIO      (2)
+#endif
+#ifndef ACTUATOR_TASK_STACK
+#define ACTUATOR_TASK_STACK     (3072)
+#endif
+
+typedef struct {
+	uint32_t posted;            // alert events queued by the Zigbee task
+	uint32_t dropped;           // events lost to a full ring
+	uint32_t processed;         // events handled by the actuator task
+	uint32_t batches;           // wake-ups that handled at least one event
+	uint32_t max_latency_us;    // post to LED update, worst case
+	uint16_t ring_peak;
+	uint32_t sim_triggers;      // simulated detections handled, one per accepted edge
+	uint32_t sim_latency_max_us;    // edge to LED update
+	uint64_t sim_latency_sum_us;
+	uint32_t sim_latency_samples;   // triggers whose edge time was still in the log
+} actuator_stats_t;
+
+// Start the actuator task, which configures the LED and buzzer (LED green, short startup beep)
+// without holding up the caller
+esp_err_t actuator_init(void);
+
+// Queue an alert for a device. Zigbee task only (single producer); never blocks.
+// Returns false when the ring is full and the event was dropped.
+bool actuator_post_alert(uint16_t short_addr, uint8_t endpoint);
+
+// Hand over a simulated detection whose edge was seen at edge_us. Simulation input ISR only
+// (single producer); never blocks. Sets *woken when the actuator task should run next.
+void actuator_post_simulation_from_isr(int64_t edge_us, BaseType_t *woken);
+
+void actuator_get_stats(actuator_stats_t *out);
+// Zero the counters and latency maxima, e.g. between acceptance test runs
+void actuator_reset_stats(void);
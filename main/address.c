@@ -0,0 +1,131 @@
+// Address resolution: short address changes, takeovers, leaves and unknown senders
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "interview.h"
+#include "presence.h"
+#include "event_log.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "address.h"
+
+static const char *TAG = "ZB_SCAN";
+
+static address_resolved_cb_t s_resolved_cb;
+static address_stats_t s_stats;
+// Short addresses with an IEEE_addr_req outstanding
+static bool s_pending_used[ADDRESS_MAX_PENDING];
+static uint16_t s_pending[ADDRESS_MAX_PENDING];
+
+static void log_address(const uint8_t ieee[8], uint16_t short_addr, uint16_t old_short, uint8_t event)
+{
+	evlog_address_t a = { .short_addr = short_addr, .old_short = old_short, .event = event };
+	memcpy(a.ieee, ieee, sizeof(a.ieee));
+	event_log_write(EVLOG_ADDRESS, &a, sizeof(a));
+}
+
+void address_init(address_resolved_cb_t cb)
+{
+	s_resolved_cb = cb;
+}
+
+device_entry_t *address_bind(const uint8_t ieee[8], uint16_t short_addr)
+{
+	device_entry_t *owner = device_table_find_short(short_addr);
+	if (owner && memcmp(owner->ieee, ieee, sizeof(owner->ieee)) != 0) {
+		// The network gave the address to another device: the old owner moved or left unnoticed
+		ESP_LOGW(TAG, "0x%04X taken over by another device", short_addr);
+		log_address(owner->ieee, short_addr, DEVICE_TABLE_NO_ADDR, EVLOG_ADDRESS_CONFLICT);
+		interview_forget(owner);
+	}
+	device_entry_t *dev = device_table_find(ieee);
+	uint16_t old_short = dev ? dev->short_addr : DEVICE_TABLE_NO_ADDR;
+	dev = device_table_upsert(ieee, short_addr);
+	if (dev && old_short != DEVICE_TABLE_NO_ADDR && old_short != short_addr) {
+		ESP_LOGI(TAG, "0x%04X is now 0x%04X", old_short, short_addr);
+		log_address(ieee, short_addr, old_short, EVLOG_ADDRESS_CHANGED);
+	}
+	return dev;
+}
+
+void address_on_leave(const uint8_t ieee[8], uint16_t short_addr, bool rejoin)
+{
+	s_stats.leaves++;
+	if (rejoin) {
+		// Everything stays: the announce binds the device again, at whatever address it gets
+		s_stats.rejoins++;
+		ESP_LOGI(TAG, "0x%04X left to rejoin", short_addr);
+		return;
+	}
+	device_entry_t *dev = device_table_find(ieee);
+	ESP_LOGI(TAG, "0x%04X left the network", short_addr);
+	if (!dev) return;
+	log_address(ieee, short_addr, DEVICE_TABLE_NO_ADDR, EVLOG_ADDRESS_LEFT);
+	// The verdict stays with the IEEE address for when it joins again
+	interview_forget(dev);
+	presence_on_leave(dev);
+	device_table_unbind(dev);
+}
+
+static void resolved(const uint8_t ieee[8], uint16_t short_addr)
+{
+	device_entry_t *known = device_table_find_short(short_addr);
+	if (known && memcmp(known->ieee, ieee, sizeof(known->ieee)) == 0) return;  // announced meanwhile
+	device_entry_t *dev = address_bind(ieee, short_addr);
+	if (!dev) return;
+	log_address(ieee, short_addr, DEVICE_TABLE_NO_ADDR, EVLOG_ADDRESS_RESOLVED);
+	ESP_LOGI(TAG, "0x%04X resolved to %02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X", short_addr,
+			 ieee[7], ieee[6], ieee[5], ieee[4], ieee[3], ieee[2], ieee[1], ieee[0]);
+	if (s_resolved_cb) s_resolved_cb(dev);
+}
+
+static void ieee_addr_cb(esp_zb_zdp_status_t zdo_status, esp_zb_zdo_ieee_addr_rsp_t *resp, void *user_ctx)
+{
+	HEAP_GUARD_APP_SCOPE();
+	uintptr_t i = (uintptr_t)user_ctx;
+	metrics_count_zdp(METRICS_REQ_IEEE_ADDR, resp ? (int)zdo_status : -1);
+	if (i >= ADDRESS_MAX_PENDING || !s_pending_used[i]) return;
+	s_pending_used[i] = false;
+	uint16_t short_addr = s_pending[i];
+	if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS || !resp) {
+		s_stats.resolve_failed++;
+		ESP_LOGW(TAG, "IEEE_addr_req to 0x%04X failed (status=%d)", short_addr, zdo_status);
+		return;
+	}
+	s_stats.resolved_air++;
+	resolved(resp->ieee_addr, short_addr);
+}
+
+void address_resolve(uint16_t short_addr)
+{
+	if (short_addr == DEVICE_TABLE_NO_ADDR || device_table_find_short(short_addr)) return;
+	uint8_t ieee[8];
+	if (esp_zb_ieee_address_by_short(short_addr, ieee) == ESP_OK) {
+		s_stats.resolved_local++;
+		resolved(ieee, short_addr);
+		return;
+	}
+	int free_slot = -1;
+	for (int i = 0; i < ADDRESS_MAX_PENDING; i++) {
+		if (s_pending_used[i] && s_pending[i] == short_addr) return;
+		if (!s_pending_used[i] && free_slot < 0) free_slot = i;
+	}
+	if (free_slot < 0) {
+		s_stats.resolve_busy++;
+		return;
+	}
+	s_pending_used[free_slot] = true;
+	s_pending[free_slot] = short_addr;
+	esp_zb_zdo_ieee_addr_req_param_t req = { .dst_nwk_addr = short_addr, .addr_of_interest = short_addr,
+											 .request_type = 0, .start_index = 0 };
+	metrics_count(METRICS_REQ_IEEE_ADDR, METRICS_ISSUED);
+	ESP_LOGD(TAG, "IEEE_addr_req to unknown sender 0x%04X", short_addr);
+	esp_zb_zdo_ieee_addr_req(&req, ieee_addr_cb, (void *)(uintptr_t)free_slot);
+}
+
+void address_get_stats(address_stats_t *out)
+{
+	*out = s_stats;
+}
@@ -0,0 +1,50 @@
+// Address resolution: IEEE <-> short address bookkeeping on top of the device table
+// - Announces and Update-Device indications go through address_bind. A known IEEE address at a
+//   new short address keeps its entry (verdict, fingerprint, reporting state), so a rejoining
+//   device gets its verdict without a single request. A device showing up at an address the
+//   table gives to another IEEE address takes it over; the interview of the old owner is
+//   abandoned so answers still on their way cannot be credited to the wrong device
+// - Leave indications (the coordinator's children) and Update-Device "left" (devices behind
+//   routers) release the short address but keep the entry; a leave with rejoin changes nothing,
+//   the announce follows
+// - A frame from a short address the table does not know (a device bound to the coordinator
+//   before it restarted, or one that moved without announcing) is resolved to its IEEE address:
+//   from the stack's address map when it has one, otherwise with a ZDO IEEE_addr_req. The
+//   device then gets its verdict as on an announce (address_init callback)
+// - Runs in the Zigbee task
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device_table.h"
+
+// IEEE_addr_req outstanding at once; unknown senders beyond that are resolved on a later frame
+#ifndef ADDRESS_MAX_PENDING
+#define ADDRESS_MAX_PENDING         (4)
+#endif
+
+typedef struct {
+	uint32_t leaves;
+	uint32_t rejoins;               // leaves announced with rejoin
+	uint32_t resolved_local;        // from the stack's address map
+	uint32_t resolved_air;          // answered IEEE_addr_req
+	uint32_t resolve_failed;
+	uint32_t resolve_busy;          // not asked: ADDRESS_MAX_PENDING requests outstanding
+} address_stats_t;
+
+// A device resolved from a frame, now bound in the device table at its short address
+typedef void (*address_resolved_cb_t)(device_entry_t *dev);
+
+void address_init(address_resolved_cb_t cb);
+
+// The device is at short_addr (announce, Update-Device or resolution): device_table_upsert with
+// address change and takeover handling. NULL when the table is full.
+device_entry_t *address_bind(const uint8_t ieee[8], uint16_t short_addr);
+
+// ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION, or Update-Device status "left" (rejoin false)
+void address_on_leave(const uint8_t ieee[8], uint16_t short_addr, bool rejoin);
+
+// A frame came from short_addr: find its IEEE address unless the device table knows it
+void address_resolve(uint16_t short_addr);
+
+void address_get_stats(address_stats_t *out);
@@ -0,0 +1,84 @@
+// Channel selection for network formation: scoring over a channel survey table
+
+#include "channel_select.h"
+
+static int excess(int dbm)
+{
+	return dbm > CHANNEL_SELECT_FLOOR_DBM ? dbm - CHANNEL_SELECT_FLOOR_DBM : 0;
+}
+
+static const channel_survey_entry_t *surveyed(const channel_survey_entry_t *table, int ch)
+{
+	if (ch < CHANNEL_SURVEY_FIRST || ch > CHANNEL_SURVEY_LAST) return NULL;
+	const channel_survey_entry_t *e = &table[ch - CHANNEL_SURVEY_FIRST];
+	return (e->have & CHANNEL_SURVEY_HAVE_ED) ? e : NULL;
+}
+
+bool channel_select_wifi_overlap(uint8_t channel)
+{
+	// Zigbee channel c is centred on 2405 + 5 (c - 11) MHz and Wi-Fi channel w on 2412 + 5 (w - 1);
+	// 1, 6 and 11 each cover four Zigbee channels, leaving 15, 20, 25 and 26 in the gaps
+	return (channel >= 11 && channel <= 14) || (channel >= 16 && channel <= 19) ||
+		   (channel >= 21 && channel <= 24);
+}
+
+// Wi-Fi is bursty and 20 MHz wide: a short detection can miss it on this channel while it
+// shows on the others it covers
+static int wifi_term(const channel_survey_entry_t *table, uint8_t ch)
+{
+	if (!channel_select_wifi_overlap(ch)) {
+		// Outside the common plan: only leakage from busy adjacent channels
+		int spill = 0;
+		const channel_survey_entry_t *n;
+		if ((n = surveyed(table, ch - 1))) spill += excess(n->noise_max_dbm) / 4;
+		if ((n = surveyed(table, ch + 1))) spill += excess(n->noise_max_dbm) / 4;
+		return spill;
+	}
+	int first = ch <= 14 ? 11 : ch <= 19 ? 16 : 21;
+	int sum = 0, n = 0;
+	for (int c = first; c < first + 4; c++) {
+		const channel_survey_entry_t *e = surveyed(table, c);
+		if (c == ch || !e) continue;
+		sum += excess(e->noise_max_dbm);
+		n++;
+	}
+	return CHANNEL_SELECT_WIFI_PENALTY + (n ? sum / n / 2 : 0);
+}
+
+size_t channel_select_rank(const channel_survey_entry_t *table, uint32_t mask, channel_select_rank_t *out)
+{
+	size_t n = 0;
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+		const channel_survey_entry_t *e = surveyed(table, ch);
+		if (!(mask & (1UL << ch)) || !e) continue;
+		channel_select_rank_t r = { .channel = ch };
+		int avg = excess(e->noise_avg_dbm), peak = excess(e->noise_max_dbm);
+		r.noise = (int16_t)(avg + (peak > avg ? (peak - avg) / 2 : 0));
+		r.wifi = (int16_t)wifi_term(table, ch);
+		if (e->have & CHANNEL_SURVEY_HAVE_SCAN) {
+			r.pans = (int16_t)(e->networks * CHANNEL_SELECT_PAN_PENALTY + e->open_networks * CHANNEL_SELECT_OPEN_PAN_PENALTY);
+		}
+		r.score = (int16_t)(r.noise + r.wifi + r.pans);
+		// Insertion sort: 16 channels at most, and channels arrive in ascending order so ties
+		// keep the lower channel first
+		size_t i = n++;
+		while (i > 0 && out[i - 1].score > r.score) {
+			out[i] = out[i - 1];
+			i--;
+		}
+		out[i] = r;
+	}
+	return n;
+}
+
+uint32_t channel_select_mask(const channel_survey_entry_t *table, uint32_t mask, uint8_t candidates)
+{
+	channel_select_rank_t ranks[CHANNEL_SURVEY_COUNT];
+	size_t n = channel_select_rank(table, mask, ranks);
+	uint32_t out = 0;
+	for (size_t i = 0; i < n && i < candidates; i++) {
+		if (ranks[i].score > ranks[0].score + CHANNEL_SELECT_MARGIN) break;
+		out |= 1UL << ranks[i].channel;
+	}
+	return out;
+}
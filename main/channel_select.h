@@ -0,0 +1,58 @@
+// Channel selection for network formation
+// - Scores surveyed channels from noise floor, Wi-Fi overlap and neighbouring PANs; lower is better
+// - Pure functions over a channel survey table: no radio or stack calls, so recorded surveys
+//   can be replayed on the host (host/bench/bench_channel_select.c)
+// - Channels without an energy detection are never chosen
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "channel_survey.h"
+
+// Channels handed to formation (Kconfig: Zigbee scanner -> Formation channel candidates);
+// 0 skips the survey and lets the stack choose from the whole channel mask
+#ifndef CHANNEL_SELECT_CANDIDATES
+#ifdef CONFIG_ZB_SCAN_FORMATION_CANDIDATES
+#define CHANNEL_SELECT_CANDIDATES       (CONFIG_ZB_SCAN_FORMATION_CANDIDATES)
+#else
+#define CHANNEL_SELECT_CANDIDATES       (3)
+#endif
+#endif
+// Candidates scoring worse than the best by more than this are left out
+#ifndef CHANNEL_SELECT_MARGIN
+#define CHANNEL_SELECT_MARGIN           (10)
+#endif
+
+// Score weights, in dB of noise
+#ifndef CHANNEL_SELECT_FLOOR_DBM
+#define CHANNEL_SELECT_FLOOR_DBM        (-95)   // noise at or below this costs nothing
+#endif
+#ifndef CHANNEL_SELECT_WIFI_PENALTY
+#define CHANNEL_SELECT_WIFI_PENALTY     (6)     // inside the footprint of Wi-Fi channel 1, 6 or 11
+#endif
+#ifndef CHANNEL_SELECT_PAN_PENALTY
+#define CHANNEL_SELECT_PAN_PENALTY      (8)     // per neighbouring PAN
+#endif
+#ifndef CHANNEL_SELECT_OPEN_PAN_PENALTY
+#define CHANNEL_SELECT_OPEN_PAN_PENALTY (4)     // extra per PAN permitting join (join traffic)
+#endif
+
+typedef struct {
+	uint8_t channel;
+	int16_t score;                  // noise + wifi + pans
+	int16_t noise;                  // average excess over the floor, plus half the peak excess
+	int16_t wifi;                   // overlap with a common Wi-Fi channel and with busy neighbours
+	int16_t pans;
+} channel_select_rank_t;
+
+// True for Zigbee channels inside the 22 MHz of Wi-Fi channel 1, 6 or 11 (11-14, 16-19, 21-24)
+bool channel_select_wifi_overlap(uint8_t channel);
+
+// Score and sort the channels of mask that have an energy detection, best first (lowest channel
+// on ties). table holds CHANNEL_SURVEY_COUNT entries from channel 11; out has room for as many.
+// Returns the number of channels ranked.
+size_t channel_select_rank(const channel_survey_entry_t *table, uint32_t mask, channel_select_rank_t *out);
+
+// Mask of up to `candidates` best channels within CHANNEL_SELECT_MARGIN of the best one;
+// 0 when no channel of mask has been surveyed
+uint32_t channel_select_mask(const channel_survey_entry_t *table, uint32_t mask, uint8_t candidates);
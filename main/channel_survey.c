@@ -0,0 +1,333 @@
+// Channel survey: energy detection and active scans in budgeted single-channel slices
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "interview.h"
+#include "event_log.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "channel_survey.h"
+
+static const char *TAG = "ZB_SCAN";
+
+#define CHANNEL_BIT(ch)     (1UL << (ch))
+
+typedef enum {
+	SLICE_NONE = 0,
+	SLICE_ED,
+	SLICE_SCAN,
+} slice_kind_t;
+
+static channel_survey_entry_t s_table[CHANNEL_SURVEY_COUNT];
+static channel_survey_stats_t s_stats;
+static uint32_t s_mask;
+static bool s_running;
+static bool s_pass_pending;         // a slice ran since the table was last complete
+static slice_kind_t s_in_flight;    // at most one request outstanding
+static uint32_t s_in_flight_mask;
+static int64_t s_slice_start_us;
+static int64_t s_started_us;
+// Sweep: back-to-back requests over the whole mask, before the network is formed
+static channel_survey_done_cb_t s_sweep_done;
+static uint8_t s_sweep_ed_left;
+static bool s_sweep_scan_left;
+static bool s_sweep_ok;                 // at least one energy detection came back
+static channel_survey_open_pan_cb_t s_open_pan_cb;
+
+static void survey_step(uint8_t param);
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static channel_survey_entry_t *entry(uint8_t ch)
+{
+	return &s_table[ch - CHANNEL_SURVEY_FIRST];
+}
+
+// Time left until an entry is due (0 when due now), wrap-safe on the ms clock
+static uint32_t due_in_ms(bool have, uint32_t last_ms, uint32_t stale_ms, uint32_t now)
+{
+	if (!have) return 0;
+	uint32_t age = now - last_ms;
+	return age >= stale_ms ? 0 : stale_ms - age;
+}
+
+static void schedule_step(uint32_t delay_ms)
+{
+	esp_zb_scheduler_alarm_cancel(survey_step, 0);
+	esp_zb_scheduler_alarm(survey_step, 0, delay_ms ? delay_ms : 1);
+}
+
+// After a slice of slice_us off-channel, stay on the network channel long enough to keep
+// the survey under its budget
+static void slice_done(int64_t slice_us)
+{
+	s_in_flight = SLICE_NONE;
+	s_stats.radio_us += (uint64_t)slice_us;
+	if (!s_running) return;
+	uint64_t gap_us = (uint64_t)slice_us * (100 - CHANNEL_SURVEY_BUDGET_PCT) / CHANNEL_SURVEY_BUDGET_PCT;
+	schedule_step((uint32_t)((gap_us + 999) / 1000));
+}
+
+static void sweep_next(void);
+
+// Route a completed request to the sweep or to the sliced survey
+static void request_done(void)
+{
+	int64_t elapsed_us = esp_timer_get_time() - s_slice_start_us;
+	if (s_sweep_done) {
+		s_in_flight = SLICE_NONE;
+		s_stats.radio_us += (uint64_t)elapsed_us;
+		sweep_next();
+	} else {
+		slice_done(elapsed_us);
+	}
+}
+
+static void ed_cb(esp_zb_zdp_status_t status, uint16_t count, esp_zb_energy_detect_channel_info_t *info)
+{
+	HEAP_GUARD_APP_SCOPE();
+	metrics_count_zdp(METRICS_REQ_ENERGY_DETECT, status);
+	if (status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+		s_stats.errors++;
+		ESP_LOGW(TAG, "Energy detection (mask 0x%08lX) failed (status=%d)", (unsigned long)s_in_flight_mask, status);
+	}
+	uint32_t now = now_ms();
+	for (uint16_t i = 0; status == ESP_ZB_ZDP_STATUS_SUCCESS && info && i < count; i++) {
+		uint8_t ch = info[i].channel_nbr;
+		if (ch < CHANNEL_SURVEY_FIRST || ch > CHANNEL_SURVEY_LAST || !(s_in_flight_mask & CHANNEL_BIT(ch))) continue;
+		channel_survey_entry_t *e = entry(ch);
+		int8_t dbm = info[i].energy_detected;
+		if (!(e->have & CHANNEL_SURVEY_HAVE_ED)) {
+			e->noise_avg_dbm = dbm;
+			e->noise_max_dbm = dbm;
+		} else {
+			e->noise_avg_dbm = (int8_t)((3 * e->noise_avg_dbm + dbm - 2) / 4);
+			if (dbm > e->noise_max_dbm) e->noise_max_dbm = dbm;
+		}
+		e->noise_dbm = dbm;
+		e->ed_ms = now;
+		e->ed_count++;
+		e->have |= CHANNEL_SURVEY_HAVE_ED;
+	}
+	if (status == ESP_ZB_ZDP_STATUS_SUCCESS && count) s_sweep_ok = true;
+	request_done();
+}
+
+static void record_scan(uint8_t ch, uint8_t count, const esp_zb_network_descriptor_t *nwk_list)
+{
+	channel_survey_entry_t *e = entry(ch);
+	uint16_t old[CHANNEL_SURVEY_MAX_PANS];
+	uint8_t old_n = e->networks < CHANNEL_SURVEY_MAX_PANS ? e->networks : CHANNEL_SURVEY_MAX_PANS;
+	memcpy(old, e->pans, sizeof(old));
+	e->networks = 0;
+	e->open_networks = 0;
+	for (uint8_t i = 0; nwk_list && i < count; i++) {
+		const esp_zb_network_descriptor_t *d = &nwk_list[i];
+		if (d->logic_channel != ch) continue;
+		if (e->networks < CHANNEL_SURVEY_MAX_PANS) e->pans[e->networks] = d->short_pan_id;
+		e->networks++;
+		e->open_networks += d->permit_joining;
+		evlog_scan_t rec = { .pan_id = d->short_pan_id, .channel = ch, .permit_joining = d->permit_joining };
+		memcpy(rec.ext_pan_id, d->extended_pan_id, sizeof(rec.ext_pan_id));
+		event_log_write(EVLOG_SCAN, &rec, sizeof(rec));
+		// Only PANs that were not there last time are worth a log line
+		bool known = false;
+		for (uint8_t k = 0; k < old_n && !known; k++) known = old[k] == d->short_pan_id;
+		if (!known) {
+			ESP_LOGI(TAG, "Channel %u: PAN 0x%04X%s", ch, d->short_pan_id, d->permit_joining ? " (open)" : "");
+		}
+		if (d->permit_joining && s_open_pan_cb && !s_sweep_done) s_open_pan_cb(ch, d->short_pan_id);
+	}
+	e->scan_ms = now_ms();
+	e->scan_count++;
+	e->have |= CHANNEL_SURVEY_HAVE_SCAN;
+}
+
+static void scan_cb(esp_zb_zdp_status_t status, uint8_t count, esp_zb_network_descriptor_t *nwk_list)
+{
+	HEAP_GUARD_APP_SCOPE();
+	metrics_count_zdp(METRICS_REQ_ACTIVE_SCAN, status);
+	if (status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+		s_stats.errors++;
+		ESP_LOGW(TAG, "Active scan (mask 0x%08lX) failed (status=%d)", (unsigned long)s_in_flight_mask, status);
+	} else {
+		for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+			if (s_in_flight_mask & CHANNEL_BIT(ch)) record_scan(ch, count, nwk_list);
+		}
+	}
+	request_done();
+}
+
+static void issue(slice_kind_t kind, uint32_t mask)
+{
+	s_in_flight = kind;
+	s_in_flight_mask = mask;
+	s_slice_start_us = esp_timer_get_time();
+	metrics_count(kind == SLICE_ED ? METRICS_REQ_ENERGY_DETECT : METRICS_REQ_ACTIVE_SCAN, METRICS_ISSUED);
+	if (kind == SLICE_ED) {
+		esp_zb_zdo_energy_detect_request(mask, CHANNEL_SURVEY_ED_DURATION, ed_cb);
+	} else {
+		esp_zb_zdo_active_scan_request(mask, CHANNEL_SURVEY_SCAN_DURATION, scan_cb);
+	}
+}
+
+static bool interviews_busy(void)
+{
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.in_flight || is.queue_depth;
+}
+
+static void survey_step(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	if (!s_running || s_in_flight != SLICE_NONE || s_sweep_done) return;
+	// Pick the most overdue refresh; never-surveyed entries first
+	uint32_t now = now_ms();
+	uint32_t best_wait = UINT32_MAX;
+	uint8_t best_ch = 0;
+	slice_kind_t best_kind = SLICE_NONE;
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+		if (!(s_mask & CHANNEL_BIT(ch))) continue;
+		const channel_survey_entry_t *e = entry(ch);
+		uint32_t ed = due_in_ms(e->have & CHANNEL_SURVEY_HAVE_ED, e->ed_ms, CHANNEL_SURVEY_ED_STALE_MS, now);
+		uint32_t scan = due_in_ms(e->have & CHANNEL_SURVEY_HAVE_SCAN, e->scan_ms, CHANNEL_SURVEY_SCAN_STALE_MS, now);
+		if (ed < best_wait) {
+			best_wait = ed;
+			best_ch = ch;
+			best_kind = SLICE_ED;
+		}
+		if (scan < best_wait) {
+			best_wait = scan;
+			best_ch = ch;
+			best_kind = SLICE_SCAN;
+		}
+	}
+	if (best_kind == SLICE_NONE) return;
+	if (best_wait > 0) {
+		if (s_pass_pending) {
+			s_pass_pending = false;
+			s_stats.passes++;
+			channel_survey_stats_t st;
+			channel_survey_get_stats(&st);
+			ESP_LOGI(TAG, "Channel survey pass %lu complete: radio duty %u.%02u%% (budget %u%%)",
+					 (unsigned long)st.passes, st.duty_permyriad / 100, st.duty_permyriad % 100,
+					 CHANNEL_SURVEY_BUDGET_PCT);
+		}
+		schedule_step(best_wait);
+		return;
+	}
+	// Leave the channel to the interviews; the survey can wait
+	if (interviews_busy()) {
+		s_stats.busy_waits++;
+		schedule_step(CHANNEL_SURVEY_BUSY_RETRY_MS);
+		return;
+	}
+	s_pass_pending = true;
+	if (best_kind == SLICE_ED) {
+		s_stats.ed_slices++;
+	} else {
+		s_stats.scan_slices++;
+	}
+	issue(best_kind, CHANNEL_BIT(best_ch));
+}
+
+static void sweep_next(void)
+{
+	if (s_sweep_ed_left) {
+		s_sweep_ed_left--;
+		issue(SLICE_ED, s_mask);
+		return;
+	}
+	if (s_sweep_scan_left) {
+		s_sweep_scan_left = false;
+		issue(SLICE_SCAN, s_mask);
+		return;
+	}
+	channel_survey_done_cb_t done = s_sweep_done;
+	s_sweep_done = NULL;
+	ESP_LOGI(TAG, "Channel sweep done in %lu ms", (unsigned long)((esp_timer_get_time() - s_started_us) / 1000));
+	done(s_sweep_ok);
+}
+
+void channel_survey_sweep(uint32_t channel_mask, uint8_t ed_rounds, channel_survey_done_cb_t done)
+{
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) entry(ch)->channel = ch;
+	s_mask = channel_mask & 0x07FFF800UL;
+	memset(&s_stats, 0, sizeof(s_stats));
+	s_started_us = esp_timer_get_time();
+	s_sweep_done = done;
+	s_sweep_ed_left = ed_rounds;
+	s_sweep_scan_left = true;
+	s_sweep_ok = false;
+	ESP_LOGI(TAG, "Channel sweep: mask=0x%08lX, %u energy detection round(s) and an active scan",
+			 (unsigned long)s_mask, ed_rounds);
+	sweep_next();
+}
+
+void channel_survey_start(uint32_t channel_mask)
+{
+	if (!s_running) {
+		memset(&s_stats, 0, sizeof(s_stats));
+		s_started_us = esp_timer_get_time();
+	}
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) entry(ch)->channel = ch;
+	s_mask = channel_mask & 0x07FFF800UL;
+	s_running = true;
+	ESP_LOGI(TAG, "Channel survey started: mask=0x%08lX budget=%u%%", (unsigned long)s_mask,
+			 CHANNEL_SURVEY_BUDGET_PCT);
+	// A slice in flight schedules the next step when it completes
+	if (s_in_flight == SLICE_NONE) schedule_step(0);
+}
+
+void channel_survey_stop(void)
+{
+	s_running = false;
+	esp_zb_scheduler_alarm_cancel(survey_step, 0);
+}
+
+const channel_survey_entry_t *channel_survey_table(void)
+{
+	return s_table;
+}
+
+const channel_survey_entry_t *channel_survey_get(uint8_t channel)
+{
+	if (channel < CHANNEL_SURVEY_FIRST || channel > CHANNEL_SURVEY_LAST) return NULL;
+	return entry(channel);
+}
+
+void channel_survey_get_stats(channel_survey_stats_t *out)
+{
+	*out = s_stats;
+	out->elapsed_us = s_started_us ? (uint64_t)(esp_timer_get_time() - s_started_us) : 0;
+	out->duty_permyriad = out->elapsed_us ? (uint16_t)(out->radio_us * 10000 / out->elapsed_us) : 0;
+}
+
+void channel_survey_set_open_pan_cb(channel_survey_open_pan_cb_t cb)
+{
+	s_open_pan_cb = cb;
+}
+
+void channel_survey_log(void)
+{
+	uint32_t now = now_ms();
+	for (uint8_t ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+		if (!(s_mask & CHANNEL_BIT(ch))) continue;
+		const channel_survey_entry_t *e = entry(ch);
+		if (!e->have) {
+			ESP_LOGI(TAG, "ch%u: not surveyed yet", ch);
+			continue;
+		}
+		ESP_LOGI(TAG, "ch%u: noise %d dBm (avg %d, max %d, %lus ago) PANs %u (%u open, %lus ago)", ch,
+				 e->noise_dbm, e->noise_avg_dbm, e->noise_max_dbm, (unsigned long)((now - e->ed_ms) / 1000),
+				 e->networks, e->open_networks, (unsigned long)((now - e->scan_ms) / 1000));
+	}
+}
@@ -0,0 +1,115 @@
+// Channel survey: rolling per-channel table of noise and neighbouring PANs
+// - Work is cut into slices of one energy detection or one active scan on a single channel,
+//   so the radio leaves the network channel for tens of milliseconds at a time
+// - Only stale entries are refreshed, the most overdue first; nothing runs while all are fresh
+// - Slices are spaced so the time spent off the network channel stays under
+//   CHANNEL_SURVEY_BUDGET_PCT of elapsed time, and wait while interviews are in progress
+// - Before formation, channel_survey_sweep() fills the whole table at once for channel selection
+// - PANs heard permitting join are reported to an optional hook (the join window uses it)
+// - Runs in the Zigbee task (ZDO callbacks and esp_zb_scheduler_alarm)
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+#define CHANNEL_SURVEY_FIRST        (11)
+#define CHANNEL_SURVEY_LAST         (26)
+#define CHANNEL_SURVEY_COUNT        (CHANNEL_SURVEY_LAST - CHANNEL_SURVEY_FIRST + 1)
+
+// Radio time budget in percent (Kconfig: Zigbee scanner -> Channel survey budget)
+#ifndef CHANNEL_SURVEY_BUDGET_PCT
+#ifdef CONFIG_ZB_SCAN_SURVEY_BUDGET_PCT
+#define CHANNEL_SURVEY_BUDGET_PCT   (CONFIG_ZB_SCAN_SURVEY_BUDGET_PCT)
+#else
+#define CHANNEL_SURVEY_BUDGET_PCT   (2)
+#endif
+#endif
+// Scan durations (beacon interval exponent): ((1<<d)+1) * 15.36 ms per channel
+#ifndef CHANNEL_SURVEY_ED_DURATION
+#define CHANNEL_SURVEY_ED_DURATION      (1)     // ~46 ms
+#endif
+#ifndef CHANNEL_SURVEY_SCAN_DURATION
+#define CHANNEL_SURVEY_SCAN_DURATION    (2)     // ~77 ms
+#endif
+// Age after which an entry is refreshed
+#ifndef CHANNEL_SURVEY_ED_STALE_MS
+#define CHANNEL_SURVEY_ED_STALE_MS      (5 * 60 * 1000)
+#endif
+// Active scans come round faster while the join window listens for neighbours permitting join,
+// to catch a 180 s pairing window on any channel
+#ifndef CHANNEL_SURVEY_SCAN_STALE_MS
+#ifdef CONFIG_ZB_SCAN_JOIN_ON_OPEN_PAN
+#define CHANNEL_SURVEY_SCAN_STALE_MS    (120 * 1000)
+#else
+#define CHANNEL_SURVEY_SCAN_STALE_MS    (30 * 60 * 1000)
+#endif
+#endif
+// Retry delay while interviews have requests queued or in flight
+#ifndef CHANNEL_SURVEY_BUSY_RETRY_MS
+#define CHANNEL_SURVEY_BUSY_RETRY_MS    (500)
+#endif
+// Energy detections per channel in a sweep: Wi-Fi is bursty, several detections catch it
+#ifndef CHANNEL_SURVEY_SWEEP_ED_ROUNDS
+#define CHANNEL_SURVEY_SWEEP_ED_ROUNDS  (4)
+#endif
+// PAN IDs remembered per channel
+#ifndef CHANNEL_SURVEY_MAX_PANS
+#define CHANNEL_SURVEY_MAX_PANS         (4)
+#endif
+
+// Bits of channel_survey_entry_t.have
+#define CHANNEL_SURVEY_HAVE_ED      (1u << 0)
+#define CHANNEL_SURVEY_HAVE_SCAN    (1u << 1)
+
+typedef struct {
+	uint8_t channel;
+	uint8_t have;                   // CHANNEL_SURVEY_HAVE_*
+	int8_t noise_dbm;               // last energy detection
+	int8_t noise_avg_dbm;           // smoothed over detections (1/4 weight for the newest)
+	int8_t noise_max_dbm;
+	uint8_t networks;               // PANs heard by the last active scan
+	uint8_t open_networks;          // of those, permitting join
+	uint16_t pans[CHANNEL_SURVEY_MAX_PANS];     // first PAN IDs heard by the last active scan
+	uint32_t ed_ms;                 // time of the last energy detection (ms since boot)
+	uint32_t scan_ms;               // time of the last active scan
+	uint16_t ed_count;
+	uint16_t scan_count;
+} channel_survey_entry_t;
+
+typedef struct {
+	uint32_t ed_slices;
+	uint32_t scan_slices;
+	uint32_t busy_waits;            // slices postponed because interviews were running
+	uint32_t errors;                // scans reported as failed by the stack
+	uint32_t passes;                // times every channel was fresh at once
+	uint64_t radio_us;              // time spent off the network channel
+	uint64_t elapsed_us;            // since channel_survey_start
+	uint16_t duty_permyriad;        // radio_us / elapsed_us, in 0.01 %
+} channel_survey_stats_t;
+
+typedef void (*channel_survey_done_cb_t)(bool ok);
+typedef void (*channel_survey_open_pan_cb_t)(uint8_t channel, uint16_t pan_id);
+
+// Survey every channel of channel_mask back to back: ed_rounds energy detections over the whole
+// mask, then one active scan. For use before the network is formed, when there is no traffic to
+// protect. done(ok) runs in the Zigbee task; ok is false when no energy detection succeeded.
+void channel_survey_sweep(uint32_t channel_mask, uint8_t ed_rounds, channel_survey_done_cb_t done);
+
+// Start (or restart with a new mask) surveying the channels in channel_mask (bits 11..26)
+void channel_survey_start(uint32_t channel_mask);
+void channel_survey_stop(void);
+
+// Table entry of a channel, NULL outside 11..26
+const channel_survey_entry_t *channel_survey_get(uint8_t channel);
+// The whole table, CHANNEL_SURVEY_COUNT entries from channel 11
+const channel_survey_entry_t *channel_survey_table(void);
+
+void channel_survey_get_stats(channel_survey_stats_t *out);
+
+// Called in the Zigbee task for every PAN permitting join heard by a survey slice (not by the
+// pre-formation sweep); NULL to stop
+void channel_survey_set_open_pan_cb(channel_survey_open_pan_cb_t cb);
+
+// Log the table, one line per surveyed channel
+void channel_survey_log(void);
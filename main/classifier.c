@@ -0,0 +1,182 @@
+// Detection pipeline: runs the classifiers of each stage over the device's evidence
+
+#include <string.h>
+#include "esp_log.h"
+#include "matcher.h"
+#include "classify_rules.h"
+#include "classifier.h"
+
+static const char *TAG = "ZB_SCAN";
+
+typedef struct {
+	const char *name;
+	classify_stage_t stage;
+	classifier_fn_t fn;
+} classifier_t;
+
+typedef struct {
+	uint32_t oui;
+	interview_verdict_t verdict;
+	uint8_t confidence;
+	const char *vendor;
+} oui_rule_t;
+
+typedef struct {
+	uint16_t profile_id;
+	uint16_t device_id;
+	uint16_t cluster;
+	interview_verdict_t verdict;
+	uint8_t confidence;
+	const char *vendor;
+} descriptor_rule_t;
+
+#define OUI_RULE_(id, oui, verdict, confidence, vendor) { oui, verdict, confidence, vendor },
+static const oui_rule_t s_oui_rules[] = { CLASSIFY_OUI_RULES(OUI_RULE_) };
+#define DESCRIPTOR_RULE_(id, profile, device, cluster, verdict, confidence, vendor) \
+	{ profile, device, cluster, verdict, confidence, vendor },
+static const descriptor_rule_t s_descriptor_rules[] = { CLASSIFY_DESCRIPTOR_RULES(DESCRIPTOR_RULE_) };
+
+static classifier_stats_t s_stats;
+
+// ---- Classifiers -----------------------------------------------------------------
+
+static bool classify_oui(const classify_input_t *in, classify_vote_t *vote)
+{
+	const uint8_t *ieee = in->dev->ieee;
+	uint32_t oui = (uint32_t)ieee[7] << 16 | (uint32_t)ieee[6] << 8 | ieee[5];
+	for (size_t i = 0; i < sizeof(s_oui_rules) / sizeof(s_oui_rules[0]); i++) {
+		if (s_oui_rules[i].oui == oui) {
+			*vote = (classify_vote_t){ s_oui_rules[i].verdict, s_oui_rules[i].confidence, s_oui_rules[i].vendor };
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool has_cluster(const classify_input_t *in, uint16_t cluster)
+{
+	for (uint8_t i = 0; i < in->cluster_count; i++) {
+		if (in->clusters[i] == cluster) return true;
+	}
+	return false;
+}
+
+static bool classify_descriptor(const classify_input_t *in, classify_vote_t *vote)
+{
+	for (size_t i = 0; i < sizeof(s_descriptor_rules) / sizeof(s_descriptor_rules[0]); i++) {
+		const descriptor_rule_t *r = &s_descriptor_rules[i];
+		if ((r->profile_id == CLASSIFY_ANY || r->profile_id == in->profile_id) &&
+			(r->device_id == CLASSIFY_ANY || r->device_id == in->device_id) &&
+			(r->cluster == CLASSIFY_ANY || has_cluster(in, r->cluster))) {
+			*vote = (classify_vote_t){ r->verdict, r->confidence, r->vendor };
+			return true;
+		}
+	}
+	return false;
+}
+
+// Manufacturer/model through the matcher: an alert rule is a match; both strings without one
+// is another device; anything less leaves the device unidentified
+static bool classify_basic(const classify_input_t *in, classify_vote_t *vote)
+{
+	const zcl_basic_info_t *info = in->basic;
+	match_set_t hits = matcher_scan(info->manufacturer.str, info->manufacturer.len, MATCH_FIELD_MANUFACTURER) |
+					   matcher_scan(info->model.str, info->model.len, MATCH_FIELD_MODEL);
+	const char *vendor = hits ? matcher_rule_vendor(matcher_first(hits)) : NULL;
+	if (hits) ESP_LOGI(TAG, "Vendor %s (rule '%s')", vendor, matcher_rule_pattern(matcher_first(hits)));
+	if (hits & MATCH_ALERT_RULES) {
+		*vote = (classify_vote_t){ INTERVIEW_VERDICT_MATCH, 100, vendor };
+		return true;
+	}
+	if ((info->present & ZCL_BASIC_HAVE_MANUFACTURER) && (info->present & ZCL_BASIC_HAVE_MODEL)) {
+		*vote = (classify_vote_t){ INTERVIEW_VERDICT_OTHER, 100, vendor };
+		return true;
+	}
+	return false;
+}
+
+// Cheapest evidence first: the order is the order of the stages
+static const classifier_t s_classifiers[] = {
+	{ "oui", CLASSIFY_ANNCE, classify_oui },
+	{ "descriptor", CLASSIFY_DESCRIPTOR, classify_descriptor },
+	{ "basic", CLASSIFY_BASIC, classify_basic },
+};
+#define CLASSIFIER_COUNT    (sizeof(s_classifiers) / sizeof(s_classifiers[0]))
+
+static bool s_disabled[CLASSIFIER_COUNT];
+
+// ---- Pipeline --------------------------------------------------------------------
+
+static interview_verdict_t decided(const uint8_t confidence[2])
+{
+	if (confidence[0] >= CLASSIFIER_CONFIDENCE) return INTERVIEW_VERDICT_MATCH;
+	if (confidence[1] >= CLASSIFIER_CONFIDENCE) return INTERVIEW_VERDICT_OTHER;
+	return INTERVIEW_VERDICT_NONE;
+}
+
+// Votes land in confidence[]: [0] for MATCH, [1] for OTHER
+static interview_verdict_t run_stage(const classify_input_t *in, uint8_t confidence[2], classify_stage_t stage)
+{
+	s_stats.runs[stage]++;
+	for (size_t i = 0; i < CLASSIFIER_COUNT; i++) {
+		if (s_classifiers[i].stage != stage || s_disabled[i]) continue;
+		interview_verdict_t verdict = decided(confidence);
+		if (verdict != INTERVIEW_VERDICT_NONE) {
+			s_stats.early_exits++;
+			continue;
+		}
+		classify_vote_t vote;
+		if (!s_classifiers[i].fn(in, &vote) || vote.verdict == INTERVIEW_VERDICT_NONE) continue;
+		s_stats.votes++;
+		uint8_t *c = &confidence[vote.verdict == INTERVIEW_VERDICT_MATCH ? 0 : 1];
+		*c = *c + vote.confidence > 100 ? 100 : (uint8_t)(*c + vote.confidence);
+		ESP_LOGD(TAG, "0x%04X: %s votes %s %u%% (%s)", in->dev ? in->dev->short_addr : DEVICE_TABLE_NO_ADDR,
+				 s_classifiers[i].name, vote.verdict == INTERVIEW_VERDICT_MATCH ? "match" : "other", vote.confidence,
+				 vote.vendor ? vote.vendor : "?");
+	}
+	interview_verdict_t verdict = decided(confidence);
+	if (verdict != INTERVIEW_VERDICT_NONE) s_stats.decided[stage]++;
+	return verdict;
+}
+
+interview_verdict_t classifier_on_annce(device_entry_t *dev, uint8_t capability)
+{
+	memset(dev->confidence, 0, sizeof(dev->confidence));
+	classify_input_t in = { .dev = dev, .capability = capability };
+	interview_verdict_t verdict = run_stage(&in, dev->confidence, CLASSIFY_ANNCE);
+	if (verdict != INTERVIEW_VERDICT_NONE) {
+		ESP_LOGI(TAG, "0x%04X classified from its IEEE address: no interview", dev->short_addr);
+	}
+	return verdict;
+}
+
+interview_verdict_t classifier_on_descriptor(device_entry_t *dev, uint16_t profile_id, uint16_t device_id,
+											 const uint16_t *clusters, uint8_t cluster_count)
+{
+	classify_input_t in = { .dev = dev, .profile_id = profile_id, .device_id = device_id, .clusters = clusters,
+							.cluster_count = cluster_count };
+	return run_stage(&in, dev->confidence, CLASSIFY_DESCRIPTOR);
+}
+
+interview_verdict_t classifier_on_basic(device_entry_t *dev, const zcl_basic_info_t *info)
+{
+	classify_input_t in = { .dev = dev, .basic = info };
+	uint8_t none[2] = { 0 };
+	return run_stage(&in, dev ? dev->confidence : none, CLASSIFY_BASIC);
+}
+
+bool classifier_set_enabled(const char *name, bool enabled)
+{
+	for (size_t i = 0; i < CLASSIFIER_COUNT; i++) {
+		if (strcmp(s_classifiers[i].name, name) == 0) {
+			s_disabled[i] = !enabled;
+			return true;
+		}
+	}
+	return false;
+}
+
+void classifier_get_stats(classifier_stats_t *out)
+{
+	*out = s_stats;
+}
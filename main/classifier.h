@@ -0,0 +1,80 @@
+// Detection pipeline: plug-in classifiers over a shared per-device evidence record
+// - Each classifier reads one kind of evidence as it arrives: the IEEE address at the announce
+//   (OUI), each SimpleDesc answer (profile, device ID, input clusters), the Basic read
+//   response (manufacturer/model through the matcher)
+// - A classifier votes MATCH or OTHER with a confidence in percent. Votes add up in the device
+//   entry, and the first verdict to reach CLASSIFIER_CONFIDENCE decides: the remaining
+//   classifiers are not run and the interview skips its remaining requests. A device the OUI
+//   classifier recognises is classified at its announce without a single request
+// - Rules of the OUI and descriptor classifiers are in classify_rules.h; a new classifier is a
+//   function and a line in the table of classifier.c
+// - Runs in the Zigbee task
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "device_table.h"
+#include "interview.h"
+#include "zcl_attr.h"
+
+// Confidence (percent, at most 100) at which the votes for a verdict decide it (Kconfig: Zigbee
+// scanner -> Detection)
+#ifndef CLASSIFIER_CONFIDENCE
+#ifdef CONFIG_ZB_SCAN_CLASSIFIER_CONFIDENCE
+#define CLASSIFIER_CONFIDENCE       (CONFIG_ZB_SCAN_CLASSIFIER_CONFIDENCE)
+#else
+#define CLASSIFIER_CONFIDENCE       (100)
+#endif
+#endif
+
+typedef enum {
+	CLASSIFY_ANNCE,                 // IEEE address and capability
+	CLASSIFY_DESCRIPTOR,            // one endpoint's simple descriptor
+	CLASSIFY_BASIC,                 // Basic manufacturer/model
+	CLASSIFY_STAGE_COUNT,
+} classify_stage_t;
+
+// Evidence handed to the classifiers of a stage
+typedef struct {
+	const device_entry_t *dev;
+	uint8_t capability;             // CLASSIFY_ANNCE
+	uint16_t profile_id;            // CLASSIFY_DESCRIPTOR
+	uint16_t device_id;
+	const uint16_t *clusters;       // input clusters
+	uint8_t cluster_count;
+	const zcl_basic_info_t *basic;  // CLASSIFY_BASIC
+} classify_input_t;
+
+typedef struct {
+	interview_verdict_t verdict;
+	uint8_t confidence;             // percent
+	const char *vendor;             // for the log, may be NULL
+} classify_vote_t;
+
+// Returns true and fills vote when the classifier recognises the device
+typedef bool (*classifier_fn_t)(const classify_input_t *in, classify_vote_t *vote);
+
+typedef struct {
+	uint32_t runs[CLASSIFY_STAGE_COUNT];        // devices evaluated at each stage
+	uint32_t decided[CLASSIFY_STAGE_COUNT];     // verdicts reached at each stage
+	uint32_t votes;
+	uint32_t early_exits;                       // classifiers not run: a verdict was already reached
+} classifier_stats_t;
+
+// A device announced and was not known yet: clears its evidence and runs the announce
+// classifiers. Returns the verdict once confident, INTERVIEW_VERDICT_NONE otherwise.
+interview_verdict_t classifier_on_annce(device_entry_t *dev, uint8_t capability);
+
+// SimpleDesc answered during the interview
+interview_verdict_t classifier_on_descriptor(device_entry_t *dev, uint16_t profile_id, uint16_t device_id,
+											 const uint16_t *clusters, uint8_t cluster_count);
+
+// Basic read response; dev may be NULL (an answer from an address the table lost)
+interview_verdict_t classifier_on_basic(device_entry_t *dev, const zcl_basic_info_t *info);
+
+// Turn a classifier on or off by name ("oui", "descriptor", "basic"); false if unknown
+bool classifier_set_enabled(const char *name, bool enabled);
+
+void classifier_get_stats(classifier_stats_t *out);
@@ -0,0 +1,27 @@
+// Rules of the OUI and descriptor classifiers (classifier.c)
+// - A rule votes for a verdict with a confidence in percent; votes add up per device and
+//   CLASSIFIER_CONFIDENCE decides (classifier.h). 100 is decisive on its own
+// - OUI rules only for blocks a vendor uses for its own devices: the OUIs of chip vendors
+//   (Silicon Labs, Texas Instruments, Telink...) are shared by many brands, IKEA included
+// - Manufacturer/model strings are matched by main/match_rules.h
+#pragma once
+
+#define CLASSIFY_ANY                (0xFFFF)
+
+// X(id, oui, verdict, confidence, vendor): top 24 bits of the IEEE address
+#define CLASSIFY_OUI_RULES(X) \
+	X(PHILIPS_LIGHTING,     0x001788,   INTERVIEW_VERDICT_OTHER,    100,    "Philips") \
+	X(UBISYS,               0x001FEE,   INTERVIEW_VERDICT_OTHER,    100,    "ubisys") \
+	X(DRESDEN_ELEKTRONIK,   0x00212E,   INTERVIEW_VERDICT_OTHER,    100,    "dresden elektronik") \
+	X(DEVELCO,              0x0015BC,   INTERVIEW_VERDICT_OTHER,    100,    "Develco") \
+	X(LEGRAND,              0x000474,   INTERVIEW_VERDICT_OTHER,    100,    "Legrand") \
+	X(SAMJIN,               0x286D97,   INTERVIEW_VERDICT_OTHER,    100,    "SmartThings")
+
+// X(id, profile, device_id, cluster, verdict, confidence, vendor): an endpoint with this profile,
+// device ID and input cluster (CLASSIFY_ANY for any)
+#define CLASSIFY_DESCRIPTOR_RULES(X) \
+	X(TUYA_EF00,  CLASSIFY_ANY,   CLASSIFY_ANY,   0xEF00,         INTERVIEW_VERDICT_OTHER,    100,    "Tuya") \
+	X(LUMI_FCC0,  CLASSIFY_ANY,   CLASSIFY_ANY,   0xFCC0,         INTERVIEW_VERDICT_OTHER,    100,    "Xiaomi") \
+	X(LUMI_5F01,  0x0104,         0x5F01,         CLASSIFY_ANY,   INTERVIEW_VERDICT_OTHER,    100,    "Xiaomi") \
+	X(LUMI_5F02,  0x0104,         0x5F02,         CLASSIFY_ANY,   INTERVIEW_VERDICT_OTHER,    100,    "Xiaomi") \
+	X(IKEA_FC7C,  CLASSIFY_ANY,   CLASSIFY_ANY,   0xFC7C,         INTERVIEW_VERDICT_MATCH,    60,     "IKEA")
@@ -0,0 +1,150 @@
+// Serial console commands
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "sdkconfig.h"
+#include "join_window.h"
+#include "latency.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "console_cmds.h"
+
+static const char *TAG = "ZB_SCAN";
+
+static void print_join_status(void)
+{
+	// The join window belongs to the Zigbee task
+	join_window_stats_t st;
+	if (!esp_zb_lock_acquire(portMAX_DELAY)) return;
+	join_window_get_stats(&st);
+	esp_zb_lock_release();
+	if (st.open) {
+		printf("join window: open, %lu s left\n", (unsigned long)st.remaining_s);
+	} else {
+		printf("join window: closed, idle window every %lu s\n", (unsigned long)st.idle_interval_s);
+	}
+	printf("windows %lu, open %llu s, joins %lu (+%lu while closed)\n", (unsigned long)st.windows,
+		   (unsigned long long)(st.open_us / 1000000), (unsigned long)st.joins, (unsigned long)st.joins_closed);
+	printf("broadcasts %lu:", (unsigned long)st.broadcasts);
+	for (int i = 0; i < JOIN_WINDOW_SRC_COUNT; i++) {
+		printf(" %s %lu", join_window_src_name((join_window_src_t)i), (unsigned long)st.by_source[i]);
+	}
+	printf("\n");
+}
+
+static int cmd_join(int argc, char **argv)
+{
+	HEAP_GUARD_APP_SCOPE();
+	if (argc > 1 && strcmp(argv[1], "status") == 0) {
+		print_join_status();
+		return 0;
+	}
+	long seconds = JOIN_WINDOW_DEMAND_S;
+	if (argc > 1) {
+		char *end;
+		seconds = strtol(argv[1], &end, 10);
+		if (*end || seconds < 1 || seconds > 254) {
+			printf("usage: join [1-254 | status]\n");
+			return 1;
+		}
+	}
+	if (!join_window_request(JOIN_WINDOW_SRC_CONSOLE, (uint32_t)seconds)) {
+		printf("join window not opened (already open longer, or no network yet)\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int cmd_latency(int argc, char **argv)
+{
+	HEAP_GUARD_APP_SCOPE();
+	if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+		latency_reset();
+		return 0;
+	}
+	if (argc > 1) {
+		printf("usage: latency [reset]\n");
+		return 1;
+	}
+	latency_dump();
+	return 0;
+}
+
+static int cmd_metrics(int argc, char **argv)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)argv;
+	if (argc > 1) {
+		printf("usage: metrics\n");
+		return 1;
+	}
+	metrics_print();
+	return 0;
+}
+
+// The only way zb_storage is given up: a restore that keeps failing is retried, never erased
+static int cmd_factory_reset(int argc, char **argv)
+{
+	HEAP_GUARD_APP_SCOPE();
+	if (argc != 2 || strcmp(argv[1], "network") != 0) {
+		printf("usage: factory_reset network\n");
+		return 1;
+	}
+	ESP_LOGW(TAG, "Erasing zb_storage and restarting: a new network is formed, devices must be paired again");
+	if (!esp_zb_lock_acquire(portMAX_DELAY)) return 1;
+	esp_zb_factory_reset();
+	esp_zb_lock_release();
+	return 0;
+}
+
+esp_err_t console_cmds_init(void)
+{
+	esp_console_repl_t *repl = NULL;
+	esp_console_repl_config_t repl_cfg = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+	repl_cfg.prompt = "zb>";
+#if defined(CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG)
+	esp_console_dev_usb_serial_jtag_config_t dev_cfg = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+	esp_err_t err = esp_console_new_repl_usb_serial_jtag(&dev_cfg, &repl_cfg, &repl);
+#else
+	esp_console_dev_uart_config_t dev_cfg = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+	esp_err_t err = esp_console_new_repl_uart(&dev_cfg, &repl_cfg, &repl);
+#endif
+	const esp_console_cmd_t join_cmd = {
+		.command = "join",
+		.help = "Open the network for joining: join [seconds], or join status",
+		.hint = "[1-254 | status]",
+		.func = cmd_join,
+	};
+	const esp_console_cmd_t latency_cmd = {
+		.command = "latency",
+		.help = "Detection latency histograms per stage and device class, or latency reset",
+		.hint = "[reset]",
+		.func = cmd_latency,
+	};
+	const esp_console_cmd_t metrics_cmd = {
+		.command = "metrics",
+		.help = "Heap, task stack high-water marks, queue peaks and Zigbee request counters",
+		.func = cmd_metrics,
+	};
+	const esp_console_cmd_t factory_reset_cmd = {
+		.command = "factory_reset",
+		.help = "Erase the Zigbee network kept in zb_storage and restart; a new network is formed and every "
+				"device must be paired again",
+		.hint = "network",
+		.func = cmd_factory_reset,
+	};
+	if (err == ESP_OK) err = esp_console_register_help_command();
+	if (err == ESP_OK) err = esp_console_cmd_register(&join_cmd);
+	if (err == ESP_OK) err = esp_console_cmd_register(&latency_cmd);
+	if (err == ESP_OK) err = esp_console_cmd_register(&metrics_cmd);
+	if (err == ESP_OK) err = esp_console_cmd_register(&factory_reset_cmd);
+	if (err == ESP_OK) err = esp_console_start_repl(repl);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Failed to start the console: %s", esp_err_to_name(err));
+	}
+	return err;
+}
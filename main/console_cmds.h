@@ -0,0 +1,14 @@
+// Serial console: esp_console REPL on the default console (UART, or USB Serial/JTAG)
+// - join [seconds]   open the network for joining (default JOIN_WINDOW_DEMAND_S)
+// - join status      join window state and counters
+// - latency [reset]  detection latency histograms (latency.h), or clear them
+// - metrics          heap, stacks, queues and request counters (metrics.h)
+// - factory_reset network   erase zb_storage and restart: a new network is formed, the devices
+//                           must be paired again
+// - Commands run in the REPL task and take the Zigbee stack lock for stack calls
+#pragma once
+
+#include "esp_err.h"
+
+// Register the commands and start the REPL task
+esp_err_t console_cmds_init(void);
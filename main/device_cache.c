@@ -0,0 +1,270 @@
+// Persistent device classification cache backed by NVS
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "heap_guard.h"
+#include "metrics.h"
+#include "device_cache.h"
+
+static const char *TAG = "ZB_SCAN";
+
+#define NVS_NAMESPACE       "devcache"
+#define NVS_KEY_HEADER      "hdr"
+#define CACHE_MAGIC         (0x44434348u) // "DCCH"
+#define CACHE_VERSION       (1)
+#define CHUNK_COUNT         ((DEVICE_CACHE_MAX_ENTRIES + DEVICE_CACHE_CHUNK_ENTRIES - 1) / DEVICE_CACHE_CHUNK_ENTRIES)
+
+// Stored layout: keep it packed and stable; bump CACHE_VERSION when it changes
+typedef struct __attribute__((packed)) {
+	uint8_t ieee[8];
+	uint8_t verdict;            // interview_verdict_t, NONE marks a free slot
+	char manufacturer[DEVICE_CACHE_MANUF_LEN];  // not NUL-terminated when full
+	char model[DEVICE_CACHE_MODEL_LEN];
+} device_cache_entry_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t entry_size;
+	uint16_t max_entries;
+	uint16_t chunk_entries;
+} device_cache_header_t;
+
+_Static_assert(CHUNK_COUNT <= 32, "dirty mask is 32 bits");
+
+static device_cache_entry_t s_entries[DEVICE_CACHE_MAX_ENTRIES];
+// IEEE addresses as integers, scanned on lookup (keeps the hot loop to 8 bytes per entry)
+static uint64_t s_keys[DEVICE_CACHE_MAX_ENTRIES];
+static uint32_t s_last_seen[DEVICE_CACHE_MAX_ENTRIES]; // RAM only: LRU for eviction
+static uint32_t s_seen_counter;
+static uint32_t s_dirty;        // one bit per chunk
+static bool s_loaded;
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+// Flush task: NVS writes and commits (page GC, sector erase) on a stack of their own, off the
+// timer service task that drives the LED, buzzer, join button and metrics sampler
+static TaskHandle_t s_flush_task;
+static StackType_t s_flush_task_stack[DEVICE_CACHE_TASK_STACK];
+static StaticTask_t s_flush_task_tcb;
+static device_cache_stats_t s_stats;
+// Open from init on: nvs_open allocates, and the flush runs after start-up in the flush task
+static nvs_handle_t s_nvs;
+// Chunk being written; only the flush path uses it
+static device_cache_entry_t s_flush_buf[DEVICE_CACHE_CHUNK_ENTRIES];
+
+static uint64_t ieee_key(const uint8_t ieee[8])
+{
+	uint64_t k;
+	memcpy(&k, ieee, sizeof(k));
+	return k;
+}
+
+static void chunk_key(uint32_t chunk, char *out, size_t len)
+{
+	snprintf(out, len, "dev%02lu", (unsigned long)chunk);
+}
+
+static void flush_task(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		// Woken by the first change; those that follow within the delay are flushed with it
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		vTaskDelay(pdMS_TO_TICKS(DEVICE_CACHE_FLUSH_DELAY_MS));
+		(void)ulTaskNotifyTake(pdTRUE, 0);
+		// A failed flush leaves its chunks dirty: try again after another delay
+		if (device_cache_flush() != ESP_OK) xTaskNotifyGive(s_flush_task);
+	}
+}
+
+esp_err_t device_cache_init(void)
+{
+	memset(s_entries, 0, sizeof(s_entries));
+	memset(s_keys, 0, sizeof(s_keys));
+	s_dirty = 0;
+	if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+	if (!s_flush_task) {
+		s_flush_task = xTaskCreateStatic(flush_task, "dev_cache", DEVICE_CACHE_TASK_STACK, NULL, DEVICE_CACHE_TASK_PRIO,
+										 s_flush_task_stack, &s_flush_task_tcb);
+		metrics_register_task(s_flush_task, "dev_cache", DEVICE_CACHE_TASK_STACK);
+	}
+	if (!s_lock || !s_flush_task) {
+		ESP_LOGW(TAG, "Device cache: failed to create lock/flush task");
+		return ESP_ERR_NO_MEM;
+	}
+
+	if (s_nvs) nvs_close(s_nvs);
+	s_nvs = 0;
+	nvs_handle_t h;
+	esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Device cache: nvs_open failed: %s", esp_err_to_name(err));
+		return err;
+	}
+	s_nvs = h;
+	const device_cache_header_t want = {
+		.magic = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.entry_size = sizeof(device_cache_entry_t),
+		.max_entries = DEVICE_CACHE_MAX_ENTRIES,
+		.chunk_entries = DEVICE_CACHE_CHUNK_ENTRIES,
+	};
+	device_cache_header_t hdr;
+	size_t len = sizeof(hdr);
+	err = nvs_get_blob(h, NVS_KEY_HEADER, &hdr, &len);
+	if (err != ESP_OK || len != sizeof(hdr) || memcmp(&hdr, &want, sizeof(hdr)) != 0) {
+		// Missing or different layout: start empty
+		if (err == ESP_OK) ESP_LOGW(TAG, "Device cache: layout changed, discarding stored entries");
+		(void)nvs_erase_all(h);
+		err = nvs_set_blob(h, NVS_KEY_HEADER, &want, sizeof(want));
+		if (err == ESP_OK) err = nvs_commit(h);
+		s_loaded = true;
+		return err;
+	}
+	uint16_t count = 0;
+	for (uint32_t c = 0; c < CHUNK_COUNT; c++) {
+		char key[8];
+		chunk_key(c, key, sizeof(key));
+		len = sizeof(device_cache_entry_t) * DEVICE_CACHE_CHUNK_ENTRIES;
+		if (nvs_get_blob(h, key, &s_entries[c * DEVICE_CACHE_CHUNK_ENTRIES], &len) != ESP_OK) continue;
+	}
+	for (uint32_t i = 0; i < DEVICE_CACHE_MAX_ENTRIES; i++) {
+		if (s_entries[i].verdict != INTERVIEW_VERDICT_NONE) {
+			s_keys[i] = ieee_key(s_entries[i].ieee);
+			count++;
+		}
+	}
+	s_stats.entries = count;
+	s_loaded = true;
+	ESP_LOGI(TAG, "Device cache: %u known devices loaded", count);
+	return ESP_OK;
+}
+
+static int find_locked(uint64_t key)
+{
+	for (uint32_t i = 0; i < DEVICE_CACHE_MAX_ENTRIES; i++) {
+		if (s_keys[i] == key && s_entries[i].verdict != INTERVIEW_VERDICT_NONE) return (int)i;
+	}
+	return -1;
+}
+
+interview_verdict_t device_cache_lookup(const uint8_t ieee[8])
+{
+	if (!s_loaded) return INTERVIEW_VERDICT_NONE;
+	interview_verdict_t v = INTERVIEW_VERDICT_NONE;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	int i = find_locked(ieee_key(ieee));
+	if (i >= 0) {
+		v = (interview_verdict_t)s_entries[i].verdict;
+		s_last_seen[i] = ++s_seen_counter;
+		s_stats.hits++;
+	} else {
+		s_stats.misses++;
+	}
+	xSemaphoreGive(s_lock);
+	return v;
+}
+
+void device_cache_put(const uint8_t ieee[8], const char *manufacturer, size_t manufacturer_len,
+					  const char *model, size_t model_len, interview_verdict_t verdict)
+{
+	if (!s_loaded || verdict == INTERVIEW_VERDICT_NONE) return;
+	device_cache_entry_t e;
+	memset(&e, 0, sizeof(e));
+	memcpy(e.ieee, ieee, sizeof(e.ieee));
+	e.verdict = (uint8_t)verdict;
+	// Longer strings are truncated to the field
+	if (manufacturer_len > sizeof(e.manufacturer)) manufacturer_len = sizeof(e.manufacturer);
+	if (model_len > sizeof(e.model)) model_len = sizeof(e.model);
+	if (manufacturer) memcpy(e.manufacturer, manufacturer, manufacturer_len);
+	if (model) memcpy(e.model, model, model_len);
+
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	uint64_t key = ieee_key(ieee);
+	int i = find_locked(key);
+	if (i < 0) {
+		// Free slot, else evict the least recently seen entry
+		uint32_t victim = 0;
+		for (uint32_t j = 0; j < DEVICE_CACHE_MAX_ENTRIES; j++) {
+			if (s_entries[j].verdict == INTERVIEW_VERDICT_NONE) {
+				victim = j;
+				break;
+			}
+			if ((int32_t)(s_last_seen[j] - s_last_seen[victim]) < 0) victim = j;
+		}
+		if (s_entries[victim].verdict != INTERVIEW_VERDICT_NONE) {
+			s_stats.evictions++;
+		} else {
+			s_stats.entries++;
+		}
+		i = (int)victim;
+	}
+	s_last_seen[i] = ++s_seen_counter;
+	bool changed = memcmp(&s_entries[i], &e, sizeof(e)) != 0;
+	if (changed) {
+		// Unchanged entries never reach flash
+		s_entries[i] = e;
+		s_keys[i] = key;
+		s_dirty |= 1u << ((uint32_t)i / DEVICE_CACHE_CHUNK_ENTRIES);
+		s_stats.updates++;
+	}
+	xSemaphoreGive(s_lock);
+	if (changed && s_flush_task) xTaskNotifyGive(s_flush_task);
+}
+
+esp_err_t device_cache_flush(void)
+{
+	if (!s_loaded) return ESP_ERR_INVALID_STATE;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	uint32_t dirty = s_dirty;
+	xSemaphoreGive(s_lock);
+	if (!dirty) return ESP_OK;
+
+	esp_err_t err = ESP_OK;
+	for (uint32_t c = 0; c < CHUNK_COUNT && err == ESP_OK; c++) {
+		if (!(dirty & (1u << c))) continue;
+		// Snapshot the chunk under the lock; the flash write happens outside it
+		xSemaphoreTake(s_lock, portMAX_DELAY);
+		memcpy(s_flush_buf, &s_entries[c * DEVICE_CACHE_CHUNK_ENTRIES], sizeof(s_flush_buf));
+		s_dirty &= ~(1u << c);
+		xSemaphoreGive(s_lock);
+		char key[8];
+		chunk_key(c, key, sizeof(key));
+		// A blob write allocates inside NVS (its page list): expected, not the app's
+		heap_guard_idf_begin();
+		err = nvs_set_blob(s_nvs, key, s_flush_buf, sizeof(s_flush_buf));
+		heap_guard_idf_end();
+		if (err == ESP_OK) {
+			s_stats.chunk_writes++;
+		} else {
+			// Leave it dirty for the next flush
+			xSemaphoreTake(s_lock, portMAX_DELAY);
+			s_dirty |= 1u << c;
+			xSemaphoreGive(s_lock);
+		}
+	}
+	if (err == ESP_OK) err = nvs_commit(s_nvs);
+	if (err == ESP_OK) {
+		s_stats.flushes++;
+		ESP_LOGI(TAG, "Device cache flushed (%u entries)", s_stats.entries);
+	} else {
+		s_stats.write_errors++;
+		ESP_LOGW(TAG, "Device cache flush failed: %s", esp_err_to_name(err));
+	}
+	return err;
+}
+
+void device_cache_get_stats(device_cache_stats_t *out)
+{
+	*out = s_stats;
+}
+
+size_t device_cache_ram_bytes(void)
+{
+	return sizeof(s_entries) + sizeof(s_keys) + sizeof(s_last_seen) + sizeof(s_flush_buf);
+}
@@ -0,0 +1,65 @@
+// Persistent device classification cache
+// - IEEE address -> manufacturer / model / verdict, kept in RAM and mirrored to the `nvs` partition
+// - Writes are batched: changed entries mark their chunk dirty and wake a low-priority flush
+//   task, which waits DEVICE_CACHE_FLUSH_DELAY_MS and writes only the dirty chunks, so a join
+//   storm costs one write pass
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "interview.h"
+
+// Devices remembered across reboots (at most 32 chunks)
+#ifndef DEVICE_CACHE_MAX_ENTRIES
+#define DEVICE_CACHE_MAX_ENTRIES    (256)
+#endif
+// Entries per NVS blob; only dirty chunks are rewritten
+#ifndef DEVICE_CACHE_CHUNK_ENTRIES
+#define DEVICE_CACHE_CHUNK_ENTRIES  (8)
+#endif
+// Delay between the first change and the flush (coalesces bursts of classifications)
+#ifndef DEVICE_CACHE_FLUSH_DELAY_MS
+#define DEVICE_CACHE_FLUSH_DELAY_MS (10 * 1000)
+#endif
+// Flush task: below the Zigbee and actuator tasks; its stack covers NVS writes and log lines
+#ifndef DEVICE_CACHE_TASK_PRIO
+#define DEVICE_CACHE_TASK_PRIO      (1)
+#endif
+#ifndef DEVICE_CACHE_TASK_STACK
+#define DEVICE_CACHE_TASK_STACK     (3072)
+#endif
+// Stored string lengths (longer names are truncated)
+#define DEVICE_CACHE_MANUF_LEN      (16)
+#define DEVICE_CACHE_MODEL_LEN      (32)
+
+typedef struct {
+	uint16_t entries;
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t updates;           // entries added or changed
+	uint32_t evictions;
+	uint32_t flushes;
+	uint32_t chunk_writes;
+	uint32_t write_errors;
+} device_cache_stats_t;
+
+// Load the cache from NVS (call after nvs_flash_init)
+esp_err_t device_cache_init(void);
+
+// Verdict stored for this IEEE address, or INTERVIEW_VERDICT_NONE if unknown
+interview_verdict_t device_cache_lookup(const uint8_t ieee[8]);
+
+// Record a classification; persisted by the next flush. The strings are length-delimited
+// (views into the read attribute response) and truncated to the cache fields.
+void device_cache_put(const uint8_t ieee[8], const char *manufacturer, size_t manufacturer_len,
+					  const char *model, size_t model_len, interview_verdict_t verdict);
+
+// Write dirty chunks now (normally done by the flush task)
+esp_err_t device_cache_flush(void);
+
+void device_cache_get_stats(device_cache_stats_t *out);
+
+// Static RAM of the cache (entries, lookup keys, LRU stamps, flush buffer)
+size_t device_cache_ram_bytes(void);
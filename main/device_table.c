@@ -0,0 +1,263 @@
+// Device table: open addressing on the IEEE address with a short address secondary index
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "device_table.h"
+
+static const char *TAG = "ZB_SCAN";
+
+_Static_assert(DEVICE_TABLE_MAX_DEVICES >= 1 && DEVICE_TABLE_MAX_DEVICES <= 4096, "entry index must fit the bucket type");
+
+// Buckets: next power of two >= 2 * entries, so the load factor stays <= 0.5
+#define POW2_AT_LEAST(n)    ((n) <= 32 ? 32 : (n) <= 64 ? 64 : (n) <= 128 ? 128 : (n) <= 256 ? 256 : \
+							 (n) <= 512 ? 512 : (n) <= 1024 ? 1024 : (n) <= 2048 ? 2048 : \
+							 (n) <= 4096 ? 4096 : 8192)
+#define BUCKETS             POW2_AT_LEAST(2 * DEVICE_TABLE_MAX_DEVICES)
+#define BUCKET_MASK         ((uint32_t)BUCKETS - 1)
+
+// Buckets hold entry index + 1, so the zeroed arrays start out empty
+static device_entry_t s_entries[DEVICE_TABLE_MAX_DEVICES];
+static uint16_t s_by_ieee[BUCKETS];
+static uint16_t s_by_short[BUCKETS];
+static uint32_t s_used[(DEVICE_TABLE_MAX_DEVICES + 31) / 32];
+static uint16_t s_free[DEVICE_TABLE_MAX_DEVICES];   // removed entries, reused first
+static uint16_t s_free_count;
+static uint16_t s_high;                             // entries handed out so far
+static device_table_stats_t s_stats;
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static bool is_used(uint16_t idx)
+{
+	return (s_used[idx / 32] >> (idx % 32)) & 1u;
+}
+
+static void set_used(uint16_t idx, bool used)
+{
+	if (used) {
+		s_used[idx / 32] |= 1u << (idx % 32);
+	} else {
+		s_used[idx / 32] &= ~(1u << (idx % 32));
+	}
+}
+
+// Fibonacci hashing: the multiply spreads sequential addresses (same OUI) over the buckets
+static uint32_t hash_ieee(const uint8_t ieee[8])
+{
+	uint64_t v;
+	memcpy(&v, ieee, sizeof(v));
+	return (uint32_t)((v * 0x9E3779B97F4A7C15ull) >> 32) & BUCKET_MASK;
+}
+
+static uint32_t hash_short(uint16_t short_addr)
+{
+	return (((uint32_t)short_addr * 0x9E3779B1u) >> 16) & BUCKET_MASK;
+}
+
+static uint32_t home_bucket(const uint16_t *index, uint16_t idx)
+{
+	return index == s_by_ieee ? hash_ieee(s_entries[idx].ieee) : hash_short(s_entries[idx].short_addr);
+}
+
+// ---- Index maintenance -----------------------------------------------------------
+
+static void index_insert(uint16_t *index, uint32_t home, uint16_t idx)
+{
+	uint32_t b = home;
+	while (index[b]) b = (b + 1) & BUCKET_MASK;
+	index[b] = (uint16_t)(idx + 1);
+}
+
+// Remove entry idx from the index and shift later members of the probe run back,
+// so lookups never need tombstones
+static void index_delete(uint16_t *index, uint32_t home, uint16_t idx)
+{
+	uint32_t hole = home;
+	while (index[hole] != idx + 1) {
+		if (!index[hole]) return;
+		hole = (hole + 1) & BUCKET_MASK;
+	}
+	uint32_t b = hole;
+	for (;;) {
+		b = (b + 1) & BUCKET_MASK;
+		if (!index[b]) break;
+		uint32_t h = home_bucket(index, (uint16_t)(index[b] - 1));
+		// Move it if the hole lies on its probe path (between its home bucket and b)
+		if (((b - h) & BUCKET_MASK) >= ((b - hole) & BUCKET_MASK)) {
+			index[hole] = index[b];
+			hole = b;
+		}
+	}
+	index[hole] = 0;
+}
+
+static void unbind_short(device_entry_t *e)
+{
+	if (e->short_addr == DEVICE_TABLE_NO_ADDR) return;
+	index_delete(s_by_short, hash_short(e->short_addr), device_table_index(e));
+	e->short_addr = DEVICE_TABLE_NO_ADDR;
+}
+
+static void bind_short(device_entry_t *e, uint16_t short_addr)
+{
+	if (e->short_addr == short_addr) return;
+	if (short_addr != DEVICE_TABLE_NO_ADDR) {
+		// The network reassigned this address: it no longer belongs to the old owner
+		device_entry_t *other = device_table_find_short(short_addr);
+		if (other) {
+			s_stats.addr_conflicts++;
+			unbind_short(other);
+		}
+	}
+	if (e->short_addr != DEVICE_TABLE_NO_ADDR) s_stats.addr_changes++;
+	unbind_short(e);
+	e->short_addr = short_addr;
+	if (short_addr != DEVICE_TABLE_NO_ADDR) {
+		index_insert(s_by_short, hash_short(short_addr), device_table_index(e));
+	}
+}
+
+// ---- Allocation ----------------------------------------------------------------
+
+static bool is_idle(const device_entry_t *e)
+{
+	return e->state == DEVICE_STATE_NEW || e->state == DEVICE_STATE_DONE || e->state == DEVICE_STATE_FAILED;
+}
+
+// Least recently seen device that is not being interviewed. Only runs when the table is full.
+static device_entry_t *find_victim(void)
+{
+	device_entry_t *victim = NULL;
+	for (uint16_t i = 0; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+		device_entry_t *e = &s_entries[i];
+		if (is_used(i) && is_idle(e) &&
+			(!victim || (int32_t)(e->last_seen_ms - victim->last_seen_ms) < 0)) {
+			victim = e;
+		}
+	}
+	return victim;
+}
+
+static device_entry_t *entry_alloc(void)
+{
+	uint16_t idx;
+	if (s_free_count) {
+		idx = s_free[--s_free_count];
+	} else if (s_high < DEVICE_TABLE_MAX_DEVICES) {
+		idx = s_high++;
+	} else {
+		device_entry_t *victim = find_victim();
+		if (!victim) return NULL;
+		ESP_LOGI(TAG, "Device table full: evicting 0x%04X", victim->short_addr);
+		s_stats.evictions++;
+		device_table_remove(victim);
+		idx = s_free[--s_free_count];
+	}
+	set_used(idx, true);
+	s_stats.entries++;
+	if (s_stats.entries > s_stats.peak) s_stats.peak = s_stats.entries;
+	return &s_entries[idx];
+}
+
+// ---- API -----------------------------------------------------------------------
+
+void device_table_clear(void)
+{
+	memset(s_entries, 0, sizeof(s_entries));
+	memset(s_by_ieee, 0, sizeof(s_by_ieee));
+	memset(s_by_short, 0, sizeof(s_by_short));
+	memset(s_used, 0, sizeof(s_used));
+	s_free_count = 0;
+	s_high = 0;
+	memset(&s_stats, 0, sizeof(s_stats));
+}
+
+device_entry_t *device_table_find(const uint8_t ieee[8])
+{
+	uint32_t b = hash_ieee(ieee);
+	while (s_by_ieee[b]) {
+		device_entry_t *e = &s_entries[s_by_ieee[b] - 1];
+		if (memcmp(e->ieee, ieee, sizeof(e->ieee)) == 0) return e;
+		b = (b + 1) & BUCKET_MASK;
+	}
+	return NULL;
+}
+
+device_entry_t *device_table_find_short(uint16_t short_addr)
+{
+	if (short_addr == DEVICE_TABLE_NO_ADDR) return NULL;
+	uint32_t b = hash_short(short_addr);
+	while (s_by_short[b]) {
+		device_entry_t *e = &s_entries[s_by_short[b] - 1];
+		if (e->short_addr == short_addr) return e;
+		b = (b + 1) & BUCKET_MASK;
+	}
+	return NULL;
+}
+
+device_entry_t *device_table_upsert(const uint8_t ieee[8], uint16_t short_addr)
+{
+	device_entry_t *e = device_table_find(ieee);
+	if (!e) {
+		e = entry_alloc();
+		if (!e) {
+			s_stats.full++;
+			ESP_LOGW(TAG, "Device table full: cannot track 0x%04X", short_addr);
+			return NULL;
+		}
+		memset(e, 0, sizeof(*e));
+		memcpy(e->ieee, ieee, sizeof(e->ieee));
+		e->short_addr = DEVICE_TABLE_NO_ADDR;
+		e->parent_short = DEVICE_TABLE_NO_ADDR;
+		index_insert(s_by_ieee, hash_ieee(ieee), device_table_index(e));
+		s_stats.inserts++;
+	}
+	bind_short(e, short_addr);
+	device_table_touch(e);
+	return e;
+}
+
+void device_table_touch(device_entry_t *e)
+{
+	e->last_seen_ms = now_ms();
+}
+
+void device_table_remove(device_entry_t *e)
+{
+	uint16_t idx = device_table_index(e);
+	unbind_short(e);
+	index_delete(s_by_ieee, hash_ieee(e->ieee), idx);
+	set_used(idx, false);
+	s_free[s_free_count++] = idx;
+	s_stats.entries--;
+}
+
+void device_table_unbind(device_entry_t *e)
+{
+	unbind_short(e);
+}
+
+uint16_t device_table_index(const device_entry_t *e)
+{
+	return (uint16_t)(e - s_entries);
+}
+
+device_entry_t *device_table_at(uint16_t index)
+{
+	if (index >= DEVICE_TABLE_MAX_DEVICES || !is_used(index)) return NULL;
+	return &s_entries[index];
+}
+
+void device_table_get_stats(device_table_stats_t *out)
+{
+	*out = s_stats;
+}
+
+size_t device_table_ram_bytes(void)
+{
+	return sizeof(s_entries) + sizeof(s_by_ieee) + sizeof(s_by_short) + sizeof(s_used) + sizeof(s_free);
+}
@@ -0,0 +1,101 @@
+// Device table: every device seen on the network, keyed by IEEE address
+// - Fixed footprint, statically allocated: no heap on lookup/insert
+// - Open addressing (linear probing) on the IEEE address, secondary index on the short address
+// - Entries keep a stable index; when full, the least recently seen idle device is evicted
+// - Holds the per-device interview state, verdict, alert flag, firmware fingerprint and last-seen time,
+//   where the device sits in the mesh (parent, link quality, depth; filled in by topology.c) and
+//   its reporting state (presence.c)
+// - Not thread safe: used from the Zigbee task only
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+// Devices tracked at once (Kconfig: Zigbee scanner -> Maximum tracked devices)
+#ifndef DEVICE_TABLE_MAX_DEVICES
+#ifdef CONFIG_ZB_SCAN_MAX_DEVICES
+#define DEVICE_TABLE_MAX_DEVICES    (CONFIG_ZB_SCAN_MAX_DEVICES)
+#else
+#define DEVICE_TABLE_MAX_DEVICES    (256)
+#endif
+#endif
+// Endpoints remembered per device from the ActiveEP response
+#ifndef DEVICE_TABLE_MAX_EPS
+#define DEVICE_TABLE_MAX_EPS        (8)
+#endif
+
+#define DEVICE_TABLE_NO_ADDR        (0xFFFF)    // short address unknown or taken over by another device
+
+typedef enum {
+	DEVICE_STATE_NEW = 0,           // seen, not interviewed
+	DEVICE_STATE_ACTIVE_EP,         // waiting for the endpoint list
+	DEVICE_STATE_DESCRIBE,          // looking for an HA endpoint
+	DEVICE_STATE_READ_BASIC,        // reading manufacturer/model
+	DEVICE_STATE_DONE,              // classified
+	DEVICE_STATE_FAILED,            // gave up; a new announce restarts the interview
+	DEVICE_STATE_REFRESH,           // classified, re-reading the Basic firmware attributes
+} device_state_t;
+
+#define DEVICE_FLAG_ALERTED         (1u << 0)
+#define DEVICE_FLAG_ROUTER          (1u << 1)   // announced as a full-function device (can have children)
+#define DEVICE_FLAG_PARENT          (1u << 2)   // devices joined through it
+#define DEVICE_FLAG_ON_OFF          (1u << 3)   // On/Off server cluster on report_ep
+#define DEVICE_FLAG_REPORTING       (1u << 4)   // reports to the coordinator (presence.c)
+#define DEVICE_FLAG_NO_REPORTING    (1u << 5)   // refused or failed the reporting setup
+#define DEVICE_FLAG_OFFLINE         (1u << 6)   // missed its reports
+
+typedef struct {
+	uint8_t ieee[8];
+	uint16_t short_addr;
+	uint8_t state;                  // device_state_t, owned by the interview
+	uint8_t verdict;                // interview_verdict_t
+	uint8_t flags;
+	uint8_t ep_count;
+	uint8_t next_ep;                // next endpoint to describe
+	uint8_t eps[DEVICE_TABLE_MAX_EPS];
+	uint8_t report_ep;              // HA endpoint with Basic and On/Off, 0 = unknown
+	uint32_t last_seen_ms;
+	uint32_t fw_fingerprint;        // Basic firmware attributes (zcl_basic_fw_fingerprint), 0 = unknown
+	uint16_t parent_short;          // router it joined through, 0x0000 = coordinator, DEVICE_TABLE_NO_ADDR = unknown
+	uint8_t lqi;                    // link quality to the parent, 0 = unknown
+	uint8_t depth;                  // hops from the coordinator, 0 = unknown
+	uint8_t confidence[2];          // classifier.c: votes for MATCH and for OTHER on this join, percent
+} device_entry_t;
+
+typedef struct {
+	uint16_t entries;
+	uint16_t peak;
+	uint32_t inserts;
+	uint32_t evictions;
+	uint32_t full;                  // inserts refused: every device was being interviewed
+	uint32_t addr_changes;          // short address changed for a known IEEE address
+	uint32_t addr_conflicts;        // short address taken over from another IEEE address
+} device_table_stats_t;
+
+void device_table_clear(void);
+
+device_entry_t *device_table_find(const uint8_t ieee[8]);
+device_entry_t *device_table_find_short(uint16_t short_addr);
+
+// Find the device or insert it, binding short_addr to it and refreshing last-seen.
+// Returns NULL only when the table is full of devices that are being interviewed.
+device_entry_t *device_table_upsert(const uint8_t ieee[8], uint16_t short_addr);
+
+// Refresh last-seen (any traffic from the device)
+void device_table_touch(device_entry_t *e);
+
+void device_table_remove(device_entry_t *e);
+
+// Forget the short address but keep the entry (device left, or its address went to another device)
+void device_table_unbind(device_entry_t *e);
+
+// Stable index of an entry, valid until the entry is removed or evicted
+uint16_t device_table_index(const device_entry_t *e);
+device_entry_t *device_table_at(uint16_t index);
+
+void device_table_get_stats(device_table_stats_t *out);
+
+// Static RAM of the table and its indexes
+size_t device_table_ram_bytes(void);
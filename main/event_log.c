@@ -0,0 +1,343 @@
+// Event log: RAM staging buffer and the task that appends it to the `evlog` flash ring
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_partition.h"
+#include "event_log.h"
+#include "metrics.h"
+
+static const char *TAG = "ZB_SCAN";
+
+_Static_assert((EVENT_LOG_BUF_LEN & (EVENT_LOG_BUF_LEN - 1)) == 0, "EVENT_LOG_BUF_LEN must be a power of two");
+_Static_assert(EVENT_LOG_BUF_LEN + sizeof(evlog_sector_hdr_t) <= EVLOG_SECTOR_SIZE, "a batch must fit a sector");
+_Static_assert(EVENT_LOG_BATCH_BYTES < EVENT_LOG_BUF_LEN, "batch threshold below the buffer size");
+
+#define REC_MAX             (sizeof(evlog_rec_hdr_t) + EVLOG_PAYLOAD_MAX)
+#define NO_SECTOR           (0xFFFF)
+
+// Records in the staging ring are complete, with the CRC left to the log task. s_head is
+// advanced by the writers under s_lock, s_tail by the log task only.
+static uint8_t s_buf[EVENT_LOG_BUF_LEN];
+static uint32_t s_head;
+static uint32_t s_tail;
+static uint32_t s_first_ms;             // time the buffer went from empty to non-empty
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Owned by the log task after event_log_init()
+static const esp_partition_t *s_part;
+static uint8_t s_batch[EVENT_LOG_BUF_LEN];
+static uint16_t s_erased = NO_SECTOR;   // sector known to be erased, ahead of the current one
+static uint32_t s_dropped_logged;
+static TaskHandle_t s_task;
+static StackType_t s_task_stack[EVENT_LOG_TASK_STACK];
+static StaticTask_t s_task_tcb;
+static event_log_stats_t s_stats;
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void ring_copy_out(uint32_t pos, void *dst, size_t len)
+{
+	uint32_t off = pos & (EVENT_LOG_BUF_LEN - 1);
+	size_t first = len < EVENT_LOG_BUF_LEN - off ? len : EVENT_LOG_BUF_LEN - off;
+	memcpy(dst, &s_buf[off], first);
+	memcpy((uint8_t *)dst + first, s_buf, len - first);
+}
+
+static void ring_copy_in(uint32_t pos, const void *src, size_t len)
+{
+	uint32_t off = pos & (EVENT_LOG_BUF_LEN - 1);
+	size_t first = len < EVENT_LOG_BUF_LEN - off ? len : EVENT_LOG_BUF_LEN - off;
+	memcpy(&s_buf[off], src, first);
+	memcpy(s_buf, (const uint8_t *)src + first, len - first);
+}
+
+// ---- Writers -------------------------------------------------------------------
+
+void event_log_write(evlog_type_t type, const void *payload, size_t len)
+{
+	if (len > EVLOG_PAYLOAD_MAX) len = EVLOG_PAYLOAD_MAX;
+	evlog_rec_hdr_t hdr = { .type = (uint8_t)type, .len = (uint8_t)len, .crc = 0, .time_ms = now_ms() };
+	uint32_t size = (uint32_t)(sizeof(hdr) + len);
+	bool wake = false;
+	portENTER_CRITICAL(&s_lock);
+	uint32_t used = s_head - s_tail;
+	if (!s_part || used + size > EVENT_LOG_BUF_LEN) {
+		s_stats.dropped++;
+	} else {
+		ring_copy_in(s_head, &hdr, sizeof(hdr));
+		ring_copy_in(s_head + sizeof(hdr), payload, len);
+		s_head += size;
+		if (!used) s_first_ms = hdr.time_ms;
+		s_stats.records++;
+		if (type < EVLOG_TYPE_COUNT) s_stats.by_type[type]++;
+		if (used + size > s_stats.buf_peak) s_stats.buf_peak = (uint16_t)(used + size);
+		// Start the flush timer, then wake the task once a batch is ready
+		wake = !used || (used < EVENT_LOG_BATCH_BYTES && used + size >= EVENT_LOG_BATCH_BYTES);
+	}
+	portEXIT_CRITICAL(&s_lock);
+	if (wake && s_task) xTaskNotify(s_task, 0, eNoAction);
+}
+
+void event_log_attr(uint16_t short_addr, uint8_t endpoint, uint16_t cluster, uint16_t attr_id, uint8_t type,
+					const void *value, size_t len)
+{
+	uint8_t rec[EVLOG_PAYLOAD_MAX];
+	evlog_attr_t *a = (evlog_attr_t *)rec;
+	a->short_addr = short_addr;
+	a->endpoint = endpoint;
+	a->cluster = cluster;
+	a->attr_id = attr_id;
+	a->type = type;
+	size_t room = sizeof(rec) - sizeof(*a);
+	if (len > room) len = room;
+	if (len) memcpy(a->value, value, len);
+	event_log_write(EVLOG_ATTR, rec, sizeof(*a) + len);
+}
+
+void event_log_flush(void)
+{
+	if (s_task) xTaskNotify(s_task, 1, eSetBits);
+}
+
+void event_log_get_stats(event_log_stats_t *out)
+{
+	portENTER_CRITICAL(&s_lock);
+	*out = s_stats;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+// ---- Flash ---------------------------------------------------------------------
+
+static esp_err_t erase_sector(uint16_t sector)
+{
+	esp_err_t err = esp_partition_erase_range(s_part, (size_t)sector * EVLOG_SECTOR_SIZE, EVLOG_SECTOR_SIZE);
+	if (err == ESP_OK) {
+		portENTER_CRITICAL(&s_lock);
+		s_stats.erases++;
+		portEXIT_CRITICAL(&s_lock);
+	}
+	return err;
+}
+
+// Start the next sector of the ring and erase the one after it
+static esp_err_t next_sector(void)
+{
+	uint16_t next = (uint16_t)((s_stats.sector + 1) % s_stats.sectors);
+	esp_err_t err = s_erased == next ? ESP_OK : erase_sector(next);
+	if (err != ESP_OK) return err;
+	evlog_sector_hdr_t hdr = { .magic = EVLOG_MAGIC, .seq = s_stats.seq + 1, .version = EVLOG_VERSION,
+							   .boot = s_stats.boot, .reserved = 0xFFFFFFFFu };
+	err = esp_partition_write(s_part, (size_t)next * EVLOG_SECTOR_SIZE, &hdr, sizeof(hdr));
+	if (err != ESP_OK) return err;
+	portENTER_CRITICAL(&s_lock);
+	s_stats.sector = next;
+	s_stats.offset = sizeof(hdr);
+	s_stats.seq = hdr.seq;
+	portEXIT_CRITICAL(&s_lock);
+	uint16_t ahead = (uint16_t)((next + 1) % s_stats.sectors);
+	s_erased = erase_sector(ahead) == ESP_OK ? ahead : NO_SECTOR;
+	return ESP_OK;
+}
+
+// Append one record to the batch, computing its CRC
+static size_t batch_add(size_t at, const evlog_rec_hdr_t *hdr, const void *payload)
+{
+	evlog_rec_hdr_t h = *hdr;
+	h.crc = evlog_crc16(evlog_crc16(0xFFFF, &h.time_ms, sizeof(h.time_ms)), payload, h.len);
+	memcpy(&s_batch[at], &h, sizeof(h));
+	memcpy(&s_batch[at + sizeof(h)], payload, h.len);
+	return at + sizeof(h) + h.len;
+}
+
+// Write out everything buffered, one flash write per sector touched. Returns false when the
+// flash refused a write or a new sector; what is left stays in the buffer. The log task is the
+// only writer of the flash position in s_stats: it reads it as is and updates it under s_lock.
+static bool drain(void)
+{
+	portENTER_CRITICAL(&s_lock);
+	uint32_t head = s_head;
+	uint32_t dropped = s_stats.dropped;
+	portEXIT_CRITICAL(&s_lock);
+	uint32_t tail = s_tail;
+	bool note_drops = dropped != s_dropped_logged;
+	while (tail != head || note_drops) {
+		size_t room = EVLOG_SECTOR_SIZE - s_stats.offset;
+		if (room > sizeof(s_batch)) room = sizeof(s_batch);
+		size_t len = 0;
+		uint32_t logged_before = s_dropped_logged;
+		uint32_t count = 0;
+		if (note_drops && REC_MAX <= room) {
+			evlog_dropped_t d = { .count = dropped - s_dropped_logged };
+			evlog_rec_hdr_t h = { .type = EVLOG_DROPPED, .len = sizeof(d), .time_ms = now_ms() };
+			len = batch_add(len, &h, &d);
+			s_dropped_logged = dropped;
+			note_drops = false;
+		}
+		uint32_t batch_tail = tail;
+		while (batch_tail != head) {
+			evlog_rec_hdr_t h;
+			uint8_t payload[EVLOG_PAYLOAD_MAX];
+			ring_copy_out(batch_tail, &h, sizeof(h));
+			if (len + sizeof(h) + h.len > room) break;
+			ring_copy_out(batch_tail + sizeof(h), payload, h.len);
+			len = batch_add(len, &h, payload);
+			batch_tail += sizeof(h) + h.len;
+			count++;
+		}
+		if (!len) {
+			// The next record does not fit this sector
+			if (next_sector() != ESP_OK) return false;
+			continue;
+		}
+		esp_err_t err = esp_partition_write(s_part, (size_t)s_stats.sector * EVLOG_SECTOR_SIZE + s_stats.offset,
+											s_batch, len);
+		if (err != ESP_OK) ESP_LOGW(TAG, "Event log write failed: %s", esp_err_to_name(err));
+		tail = batch_tail;
+		portENTER_CRITICAL(&s_lock);
+		if (err != ESP_OK) {
+			// Do not write over what may be half-programmed: continue in a fresh sector. The
+			// batch is lost: count it as dropped, and report again the drops it carried
+			s_stats.offset = EVLOG_SECTOR_SIZE;
+			s_stats.dropped += count;
+			s_dropped_logged = logged_before;
+		} else {
+			s_stats.offset += (uint16_t)len;
+			s_stats.bytes += (uint32_t)len;
+			s_stats.writes++;
+		}
+		s_tail = tail;
+		dropped = s_stats.dropped;
+		portEXIT_CRITICAL(&s_lock);
+		if (err != ESP_OK) return false;
+		note_drops = dropped != s_dropped_logged;
+	}
+	return true;
+}
+
+static void event_log_task(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		portENTER_CRITICAL(&s_lock);
+		uint32_t used = s_head - s_tail;
+		uint32_t age = now_ms() - s_first_ms;
+		bool drops = s_dropped_logged != s_stats.dropped;
+		portEXIT_CRITICAL(&s_lock);
+		TickType_t wait = portMAX_DELAY;
+		if (used && used < EVENT_LOG_BATCH_BYTES && age < EVENT_LOG_FLUSH_MS) {
+			wait = pdMS_TO_TICKS(EVENT_LOG_FLUSH_MS - age);
+		} else if (used || drops) {
+			if (drain()) continue;
+			// Flash failing: retry after a while rather than spin
+			wait = pdMS_TO_TICKS(EVENT_LOG_FLUSH_MS);
+		}
+		uint32_t bits = 0;
+		if (xTaskNotifyWait(0, UINT32_MAX, &bits, wait) == pdTRUE && bits) (void)drain();
+	}
+}
+
+// ---- Recovery ------------------------------------------------------------------
+
+static bool all_erased(const uint8_t *p, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (p[i] != 0xFF) return false;
+	}
+	return true;
+}
+
+// Find the newest sector and the end of its records; returns the last boot number seen
+static uint16_t recover(uint8_t *sector_buf)
+{
+	uint16_t newest = NO_SECTOR;
+	evlog_sector_hdr_t best = { 0 };
+	for (uint16_t i = 0; i < s_stats.sectors; i++) {
+		evlog_sector_hdr_t h;
+		if (esp_partition_read(s_part, (size_t)i * EVLOG_SECTOR_SIZE, &h, sizeof(h)) != ESP_OK) continue;
+		if (h.magic != EVLOG_MAGIC || h.version != EVLOG_VERSION) continue;
+		if (newest == NO_SECTOR || (int32_t)(h.seq - best.seq) > 0) {
+			newest = i;
+			best = h;
+		}
+	}
+	if (newest == NO_SECTOR) {
+		// Empty log: the first append starts sector 0
+		s_stats.sector = (uint16_t)(s_stats.sectors - 1);
+		s_stats.offset = EVLOG_SECTOR_SIZE;
+		s_stats.seq = 0;
+		return 0;
+	}
+	s_stats.sector = newest;
+	s_stats.seq = best.seq;
+	uint16_t boot = best.boot;
+	size_t off = sizeof(evlog_sector_hdr_t);
+	if (esp_partition_read(s_part, (size_t)newest * EVLOG_SECTOR_SIZE, sector_buf, EVLOG_SECTOR_SIZE) != ESP_OK) {
+		s_stats.offset = EVLOG_SECTOR_SIZE;
+		return boot;
+	}
+	while (off + sizeof(evlog_rec_hdr_t) <= EVLOG_SECTOR_SIZE) {
+		evlog_rec_hdr_t h;
+		memcpy(&h, &sector_buf[off], sizeof(h));
+		if (h.type == EVLOG_ERASED) break;
+		const uint8_t *payload = &sector_buf[off + sizeof(h)];
+		if (h.len > EVLOG_PAYLOAD_MAX || off + sizeof(h) + h.len > EVLOG_SECTOR_SIZE ||
+			evlog_crc16(evlog_crc16(0xFFFF, &h.time_ms, sizeof(h.time_ms)), payload, h.len) != h.crc) {
+			s_stats.torn++;
+			break;
+		}
+		if (h.type == EVLOG_BOOT && h.len >= sizeof(evlog_boot_t)) {
+			evlog_boot_t b;
+			memcpy(&b, payload, sizeof(b));
+			boot = b.boot;
+		}
+		off += sizeof(h) + h.len;
+	}
+	// Append only onto erased flash; anything else (a torn record) moves on to a fresh sector
+	s_stats.offset = all_erased(&sector_buf[off], EVLOG_SECTOR_SIZE - off) ? (uint16_t)off : EVLOG_SECTOR_SIZE;
+	// The sector ahead should have been erased when this one was started
+	uint16_t ahead = (uint16_t)((newest + 1) % s_stats.sectors);
+	if (esp_partition_read(s_part, (size_t)ahead * EVLOG_SECTOR_SIZE, sector_buf, EVLOG_SECTOR_SIZE) == ESP_OK &&
+		all_erased(sector_buf, EVLOG_SECTOR_SIZE)) {
+		s_erased = ahead;
+	}
+	return boot;
+}
+
+esp_err_t event_log_init(void)
+{
+	const esp_partition_t *part = esp_partition_find_first((esp_partition_type_t)EVLOG_PARTITION_TYPE,
+														   (esp_partition_subtype_t)EVLOG_PARTITION_SUBTYPE,
+														   EVLOG_PARTITION_LABEL);
+	if (!part || part->size / EVLOG_SECTOR_SIZE < 3) {
+		ESP_LOGW(TAG, "No '%s' partition of 3 sectors or more: event log disabled", EVLOG_PARTITION_LABEL);
+		return ESP_ERR_NOT_FOUND;
+	}
+	uint8_t *sector_buf = malloc(EVLOG_SECTOR_SIZE);
+	if (!sector_buf) return ESP_ERR_NO_MEM;
+	s_part = part;
+	s_stats.sectors = (uint16_t)(part->size / EVLOG_SECTOR_SIZE);
+	uint16_t last_boot = recover(sector_buf);
+	free(sector_buf);
+	s_stats.boot = (uint16_t)(last_boot + 1);
+	ESP_LOGI(TAG, "Event log: boot %u, sector %u/%u at %u (seq %lu)%s", s_stats.boot, s_stats.sector,
+			 s_stats.sectors, s_stats.offset, (unsigned long)s_stats.seq, s_stats.torn ? ", torn record skipped" : "");
+
+	evlog_boot_t b = { .boot = s_stats.boot, .reset_reason = (uint8_t)esp_reset_reason() };
+	event_log_write(EVLOG_BOOT, &b, sizeof(b));
+	s_task = xTaskCreateStatic(event_log_task, "event_log", EVENT_LOG_TASK_STACK, NULL, EVENT_LOG_TASK_PRIO,
+							   s_task_stack, &s_task_tcb);
+	if (!s_task) {
+		ESP_LOGE(TAG, "Failed to create event log task");
+		return ESP_ERR_NO_MEM;
+	}
+	metrics_register_task(s_task, "event_log", EVENT_LOG_TASK_STACK);
+	return ESP_OK;
+}
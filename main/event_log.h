@@ -0,0 +1,72 @@
+// Event log: binary records of joins, interview steps, attributes, alerts and scan results,
+// kept in the `evlog` flash partition across reboots (format in event_log_format.h,
+// decoded on a PC with host/tools/evlog_decode.c)
+// - Callers copy a small fixed-layout record into a RAM buffer: no formatting, no flash access.
+//   Any task may write; a full buffer drops the record and counts it
+// - A low-priority task appends the buffer to flash in batches, when EVENT_LOG_BATCH_BYTES are
+//   waiting or EVENT_LOG_FLUSH_MS after the oldest buffered record
+// - The sector after the one being written is erased ahead of time, so an append never waits
+//   for an erase; erasing it drops the oldest sector of history
+// - At boot the newest sector is found from the sector headers and writing resumes after its
+//   last intact record; a record torn by a reset makes the writer move on to a fresh sector
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "event_log_format.h"
+
+// Staging buffer between the writers and the log task (power of two)
+#ifndef EVENT_LOG_BUF_LEN
+#define EVENT_LOG_BUF_LEN           (2048)
+#endif
+// Buffered bytes that wake the log task
+#ifndef EVENT_LOG_BATCH_BYTES
+#define EVENT_LOG_BATCH_BYTES       (512)
+#endif
+// Longest a record waits in RAM
+#ifndef EVENT_LOG_FLUSH_MS
+#define EVENT_LOG_FLUSH_MS          (5 * 1000)
+#endif
+// Below the actuator task: flash writes are the least urgent work on the chip
+#ifndef EVENT_LOG_TASK_PRIO
+#define EVENT_LOG_TASK_PRIO         (1)
+#endif
+#ifndef EVENT_LOG_TASK_STACK
+#define EVENT_LOG_TASK_STACK        (3072)
+#endif
+
+typedef struct {
+	uint32_t records;               // accepted into the buffer
+	uint32_t by_type[EVLOG_TYPE_COUNT];
+	uint32_t dropped;               // buffer full, or no partition
+	uint32_t bytes;                 // record bytes written to flash
+	uint32_t writes;                // flash write operations
+	uint32_t erases;                // sectors erased
+	uint32_t torn;                  // torn records found at boot
+	uint16_t buf_peak;
+	uint16_t sectors;               // partition size in sectors, 0 when there is no partition
+	uint16_t sector;                // sector being written
+	uint16_t offset;                // next write offset in it
+	uint32_t seq;                   // its sequence number
+	uint16_t boot;
+} event_log_stats_t;
+
+// Find the partition, resume after the last record, log EVLOG_BOOT and start the log task.
+// Without an `evlog` partition the log stays disabled and records are counted as dropped.
+esp_err_t event_log_init(void);
+
+// Queue one record; payload is len bytes in the layout of the type's evlog_*_t (longer
+// payloads are cut to EVLOG_PAYLOAD_MAX). Never blocks.
+void event_log_write(evlog_type_t type, const void *payload, size_t len);
+
+// One attribute of a read response: value is the attribute's bytes (for strings, without the
+// length prefix), cut to fit the record
+void event_log_attr(uint16_t short_addr, uint8_t endpoint, uint16_t cluster, uint16_t attr_id, uint8_t type,
+					const void *value, size_t len);
+
+// Wake the log task to write out the buffer now
+void event_log_flush(void);
+
+void event_log_get_stats(event_log_stats_t *out);
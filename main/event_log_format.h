@@ -0,0 +1,167 @@
+// Event log: on-flash format, shared by the firmware (main/event_log.c) and the host decoder
+// (host/tools/evlog_decode.c)
+// - The `evlog` partition is a ring of 4 KB sectors. Each written sector starts with a header
+//   holding a sequence number: the highest one is being appended to, the next sector in the
+//   ring is kept erased, and the one after it holds the oldest records
+// - Records follow the sector header back to back: an evlog_rec_hdr_t, then len bytes of
+//   payload. Erased flash (type 0xFF) ends a sector; a record never spans two sectors
+// - A record whose CRC does not match was torn by a reset during the write: the rest of that
+//   sector is ignored and the writer continues in the next one
+// - Little-endian and packed. Times are milliseconds since boot; an EVLOG_BOOT record starts
+//   every boot
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define EVLOG_PARTITION_LABEL       "evlog"
+#define EVLOG_PARTITION_TYPE        (0x40)      // app-defined partition type, see partitions.csv
+#define EVLOG_PARTITION_SUBTYPE     (0x00)
+#define EVLOG_SECTOR_SIZE           (4096)
+#define EVLOG_MAGIC                 (0x4C56455Au)   // "ZEVL"
+#define EVLOG_VERSION               (1)
+#define EVLOG_PAYLOAD_MAX           (48)
+
+typedef enum {
+	EVLOG_BOOT = 1,             // evlog_boot_t
+	EVLOG_FORMED,               // evlog_formed_t: network formed, or resumed from zb_storage
+	EVLOG_JOIN,                 // evlog_join_t: device announce
+	EVLOG_ACTIVE_EP,            // evlog_active_ep_t
+	EVLOG_SIMPLE_DESC,          // evlog_simple_desc_t
+	EVLOG_STEP_FAILED,          // evlog_step_failed_t: interview step failed, timed out or given up
+	EVLOG_ATTR,                 // evlog_attr_t: one attribute of a read response
+	EVLOG_ALERT,                // evlog_alert_t
+	EVLOG_SCAN,                 // evlog_scan_t: one PAN heard by an active scan
+	EVLOG_DROPPED,              // evlog_dropped_t: records lost to a full buffer before this one
+	EVLOG_PRESENCE,             // evlog_presence_t: reporting set up or refused, device silent or back
+	EVLOG_ADDRESS,              // evlog_address_t: short address changed, taken over, released or resolved
+	EVLOG_TYPE_COUNT,
+	EVLOG_ERASED = 0xFF,
+} evlog_type_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t magic;
+	uint32_t seq;               // +1 per sector started
+	uint16_t version;
+	uint16_t boot;              // boot that started the sector
+	uint32_t reserved;          // 0xFFFFFFFF
+} evlog_sector_hdr_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t type;               // evlog_type_t
+	uint8_t len;                // payload bytes
+	uint16_t crc;               // evlog_crc16() of time_ms and the payload
+	uint32_t time_ms;           // since boot
+} evlog_rec_hdr_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t boot;              // 1 for the first boot on an empty log
+	uint8_t reset_reason;       // esp_reset_reason_t
+} evlog_boot_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t pan_id;
+	uint8_t channel;
+	uint8_t resumed;            // 1: restored from zb_storage after a reset; absent in older records
+} evlog_formed_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint16_t parent_short;      // 0xFFFF when unknown
+	uint8_t ieee[8];
+	uint8_t capability;
+} evlog_join_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint8_t count;
+	uint8_t eps[];              // first count endpoints that fit the payload
+} evlog_active_ep_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint8_t endpoint;
+	uint16_t profile_id;
+	uint16_t device_id;
+	uint16_t clusters[];        // input clusters that fit the payload
+} evlog_simple_desc_t;
+
+#define EVLOG_STATUS_TIMEOUT        (0xFF)
+#define EVLOG_STATUS_GAVE_UP        (0xFE)
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint8_t step;               // 0 ActiveEP, 1 SimpleDesc, 2 Basic read
+	uint8_t endpoint;
+	uint8_t status;             // ZDP status, EVLOG_STATUS_TIMEOUT or EVLOG_STATUS_GAVE_UP
+	uint8_t attempt;
+} evlog_step_failed_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint8_t endpoint;
+	uint16_t cluster;
+	uint16_t attr_id;
+	uint8_t type;               // ZCL attribute type
+	uint8_t value[];            // strings without their length prefix, truncated to the payload
+} evlog_attr_t;
+
+#define EVLOG_ALERT_INTERVIEW       (0)     // classified on this join: announce, descriptor or Basic read
+#define EVLOG_ALERT_CACHE           (1)     // known from the device cache or an earlier join in this run
+#define EVLOG_ALERT_SIMULATION      (2)     // simulation input pin
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint8_t endpoint;
+	uint8_t source;             // EVLOG_ALERT_*
+} evlog_alert_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t pan_id;
+	uint8_t channel;
+	uint8_t permit_joining;
+	uint8_t ext_pan_id[8];
+} evlog_scan_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t count;
+} evlog_dropped_t;
+
+#define EVLOG_PRESENCE_SUBSCRIBED   (0)
+#define EVLOG_PRESENCE_REFUSED      (1)
+#define EVLOG_PRESENCE_OFFLINE      (2)
+#define EVLOG_PRESENCE_BACK         (3)
+
+typedef struct __attribute__((packed)) {
+	uint16_t short_addr;
+	uint8_t endpoint;
+	uint8_t state;              // EVLOG_PRESENCE_*
+	uint32_t silent_s;          // OFFLINE and BACK: time since the device was last heard, 0 = back by announce
+} evlog_presence_t;
+
+#define EVLOG_ADDRESS_CHANGED       (0)     // the device announced at a new short address
+#define EVLOG_ADDRESS_CONFLICT      (1)     // another device announced at this device's address: it lost it
+#define EVLOG_ADDRESS_LEFT          (2)
+#define EVLOG_ADDRESS_RESOLVED      (3)     // IEEE address of an unknown sender found
+
+typedef struct __attribute__((packed)) {
+	uint8_t ieee[8];
+	uint16_t short_addr;
+	uint16_t old_short;         // CHANGED: previous address, otherwise 0xFFFF
+	uint8_t event;              // EVLOG_ADDRESS_*
+} evlog_address_t;
+
+_Static_assert(sizeof(evlog_sector_hdr_t) == 16, "sector header layout");
+_Static_assert(sizeof(evlog_rec_hdr_t) == 8, "record header layout");
+_Static_assert(sizeof(evlog_attr_t) + 16 <= EVLOG_PAYLOAD_MAX, "attribute records keep room for a value");
+
+// CRC-16/CCITT-FALSE; start with 0xFFFF
+static inline uint16_t evlog_crc16(uint16_t crc, const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	while (len--) {
+		crc ^= (uint16_t)(*p++ << 8);
+		for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+	}
+	return crc;
+}
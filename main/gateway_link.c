@@ -0,0 +1,298 @@
+// Gateway link: RAM staging buffer and the task that frames it onto the UART
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "event_log.h"
+#include "metrics.h"
+#include "gateway_link.h"
+
+static const char *TAG = "ZB_SCAN";
+
+_Static_assert((GATEWAY_LINK_BUF_LEN & (GATEWAY_LINK_BUF_LEN - 1)) == 0, "GATEWAY_LINK_BUF_LEN must be a power of two");
+_Static_assert(GATEWAY_LINK_BUF_LEN >= 4 * GWLINK_RECORDS_MAX, "the buffer holds a few frames");
+
+// Records are staged with their own time; the frame header and record ages are filled in by
+// the link task
+typedef struct __attribute__((packed)) {
+	uint8_t type;
+	uint8_t len;
+	uint32_t time_ms;
+} staged_hdr_t;
+
+// Joins and verdicts stop here; alerts and network records may fill the rest
+#define LOW_PRIO_LIMIT      (GATEWAY_LINK_BUF_LEN * 3 / 4)
+
+// s_head is advanced by the callers under s_lock, s_tail by the link task only, once a frame
+// has been handed to the UART
+static uint8_t s_buf[GATEWAY_LINK_BUF_LEN];
+static uint32_t s_head;
+static uint32_t s_tail;
+static uint32_t s_first_ms;             // time the buffer went from empty to non-empty
+static bool s_urgent;                   // an alert is waiting: send without waiting for the flush time
+static bool s_on;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static gateway_link_stats_t s_stats;
+
+// Owned by the link task after gateway_link_init()
+static uint8_t s_frame[GWLINK_FRAME_MAX];
+static uint8_t s_node[8];
+static uint16_t s_seq;
+static uint32_t s_dropped_sent;
+static TaskHandle_t s_task;
+static StackType_t s_task_stack[GATEWAY_LINK_TASK_STACK];
+static StaticTask_t s_task_tcb;
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void ring_copy_out(uint32_t pos, void *dst, size_t len)
+{
+	uint32_t off = pos & (GATEWAY_LINK_BUF_LEN - 1);
+	size_t first = len < GATEWAY_LINK_BUF_LEN - off ? len : GATEWAY_LINK_BUF_LEN - off;
+	memcpy(dst, &s_buf[off], first);
+	memcpy((uint8_t *)dst + first, s_buf, len - first);
+}
+
+static void ring_copy_in(uint32_t pos, const void *src, size_t len)
+{
+	uint32_t off = pos & (GATEWAY_LINK_BUF_LEN - 1);
+	size_t first = len < GATEWAY_LINK_BUF_LEN - off ? len : GATEWAY_LINK_BUF_LEN - off;
+	memcpy(&s_buf[off], src, first);
+	memcpy(s_buf, (const uint8_t *)src + first, len - first);
+}
+
+// ---- Callers -------------------------------------------------------------------
+
+static void link_write(gwlink_type_t type, const void *payload, size_t len)
+{
+	if (len > GWLINK_PAYLOAD_MAX) len = GWLINK_PAYLOAD_MAX;
+	staged_hdr_t hdr = { .type = (uint8_t)type, .len = (uint8_t)len, .time_ms = now_ms() };
+	uint32_t size = (uint32_t)(sizeof(hdr) + len);
+	bool urgent = type == GWLINK_ALERT;
+	uint32_t limit = urgent || type == GWLINK_NETWORK ? GATEWAY_LINK_BUF_LEN : LOW_PRIO_LIMIT;
+	bool wake = false;
+	portENTER_CRITICAL(&s_lock);
+	if (!s_on) {
+		// No gateway configured: nothing is lost
+		portEXIT_CRITICAL(&s_lock);
+		return;
+	}
+	uint32_t used = s_head - s_tail;
+	if (used + size > limit) {
+		s_stats.dropped++;
+		if (urgent) s_stats.alerts_dropped++;
+	} else {
+		ring_copy_in(s_head, &hdr, sizeof(hdr));
+		ring_copy_in(s_head + sizeof(hdr), payload, len);
+		s_head += size;
+		if (!used) s_first_ms = hdr.time_ms;
+		s_stats.records++;
+		s_stats.by_type[type]++;
+		if (used + size > s_stats.buf_peak) s_stats.buf_peak = (uint16_t)(used + size);
+		// Start the flush timer, send once a frame is full, or at once for an alert
+		wake = !used || (urgent && !s_urgent) || (used < GWLINK_RECORDS_MAX && used + size >= GWLINK_RECORDS_MAX);
+		s_urgent |= urgent;
+	}
+	portEXIT_CRITICAL(&s_lock);
+	if (wake && s_task) xTaskNotify(s_task, 0, eNoAction);
+}
+
+void gateway_link_network(uint16_t pan_id, uint8_t channel, bool resumed)
+{
+	gwlink_network_t n = { .pan_id = pan_id, .channel = channel, .resumed = resumed };
+	link_write(GWLINK_NETWORK, &n, sizeof(n));
+}
+
+void gateway_link_join(const uint8_t ieee[8], uint16_t short_addr, uint16_t parent_short, uint8_t capability)
+{
+	gwlink_join_t j = { .short_addr = short_addr, .parent_short = parent_short, .capability = capability };
+	memcpy(j.ieee, ieee, sizeof(j.ieee));
+	link_write(GWLINK_JOIN, &j, sizeof(j));
+}
+
+void gateway_link_verdict(const uint8_t ieee[8], uint16_t short_addr, interview_verdict_t verdict, uint8_t source,
+						  const char *model, size_t model_len)
+{
+	uint8_t rec[GWLINK_PAYLOAD_MAX];
+	gwlink_verdict_t *v = (gwlink_verdict_t *)rec;
+	memcpy(v->ieee, ieee, sizeof(v->ieee));
+	v->short_addr = short_addr;
+	v->verdict = (uint8_t)verdict;
+	v->source = source;
+	size_t room = sizeof(rec) - sizeof(*v);
+	if (!model) model_len = 0;
+	if (model_len > room) model_len = room;
+	if (model_len) memcpy(v->model, model, model_len);
+	link_write(GWLINK_VERDICT, rec, sizeof(*v) + model_len);
+}
+
+void gateway_link_alert(const uint8_t *ieee, uint16_t short_addr, uint8_t endpoint, uint8_t source)
+{
+	gwlink_alert_t a = { .short_addr = short_addr, .endpoint = endpoint, .source = source };
+	if (ieee) memcpy(a.ieee, ieee, sizeof(a.ieee));
+	link_write(GWLINK_ALERT, &a, sizeof(a));
+}
+
+void gateway_link_get_stats(gateway_link_stats_t *out)
+{
+	portENTER_CRITICAL(&s_lock);
+	*out = s_stats;
+	out->on = s_on;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+// ---- UART ----------------------------------------------------------------------
+
+static size_t frame_add(size_t at, uint8_t type, uint32_t age_ms, const void *payload, uint8_t len)
+{
+	gwlink_rec_hdr_t h = { .type = type, .len = len, .age_ms = age_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)age_ms };
+	memcpy(&s_frame[at], &h, sizeof(h));
+	memcpy(&s_frame[at + sizeof(h)], payload, len);
+	return at + sizeof(h) + len;
+}
+
+// Send everything buffered, one frame at a time. uart_write_bytes waits while the gateway holds
+// CTS; the buffer is only released once a frame is handed over, so callers see the back-pressure.
+static void drain(void)
+{
+	for (;;) {
+		portENTER_CRITICAL(&s_lock);
+		uint32_t head = s_head;
+		uint32_t dropped = s_stats.dropped;
+		if (head == s_tail) s_urgent = false;
+		portEXIT_CRITICAL(&s_lock);
+		uint32_t tail = s_tail;
+		bool note_drops = dropped != s_dropped_sent;
+		if (tail == head && !note_drops) return;
+
+		uint32_t t = now_ms();
+		uint32_t age_max = 0, alert_age_max = 0;
+		uint8_t *records = &s_frame[sizeof(gwlink_frame_hdr_t)];
+		size_t len = 0;
+		uint8_t count = 0;
+		if (note_drops) {
+			gwlink_dropped_t d = { .count = dropped - s_dropped_sent };
+			len = frame_add(sizeof(gwlink_frame_hdr_t), GWLINK_DROPPED, 0, &d, sizeof(d)) - sizeof(gwlink_frame_hdr_t);
+			count++;
+			s_dropped_sent = dropped;
+		}
+		while (tail != head) {
+			staged_hdr_t h;
+			uint8_t payload[GWLINK_PAYLOAD_MAX];
+			ring_copy_out(tail, &h, sizeof(h));
+			if (len + sizeof(gwlink_rec_hdr_t) + h.len > GWLINK_RECORDS_MAX) break;
+			ring_copy_out(tail + sizeof(h), payload, h.len);
+			uint32_t age = t - h.time_ms;
+			if (age > age_max) age_max = age;
+			if (h.type == GWLINK_ALERT && age > alert_age_max) alert_age_max = age;
+			len = frame_add(sizeof(gwlink_frame_hdr_t) + len, h.type, age, payload, h.len) -
+				  sizeof(gwlink_frame_hdr_t);
+			count++;
+			tail += sizeof(h) + h.len;
+		}
+
+		gwlink_frame_hdr_t fh = { .sync = { GWLINK_SYNC0, GWLINK_SYNC1 }, .version = GWLINK_VERSION, .count = count,
+								  .len = (uint16_t)len, .seq = s_seq++, .time_ms = t };
+		event_log_stats_t ls;
+		event_log_get_stats(&ls);
+		fh.boot = ls.boot;
+		memcpy(fh.node, s_node, sizeof(fh.node));
+		uint16_t crc = gwlink_frame_crc(&fh, records);
+		memcpy(s_frame, &fh, sizeof(fh));
+		memcpy(&records[len], &crc, sizeof(crc));
+		size_t size = sizeof(fh) + len + sizeof(crc);
+
+		size_t room = 0;
+		bool stalled = uart_get_tx_buffer_free_size(GATEWAY_LINK_UART, &room) == ESP_OK && room < size;
+		int64_t t0 = esp_timer_get_time();
+		int sent = uart_write_bytes(GATEWAY_LINK_UART, s_frame, size);
+		if (sent != (int)size) ESP_LOGW(TAG, "Gateway link: UART write failed");
+
+		portENTER_CRITICAL(&s_lock);
+		s_tail = tail;
+		s_stats.frames++;
+		s_stats.bytes += (uint32_t)size;
+		if (count > s_stats.frame_records_max) s_stats.frame_records_max = count;
+		if (age_max > s_stats.age_max_ms) s_stats.age_max_ms = age_max;
+		if (alert_age_max > s_stats.alert_age_max_ms) s_stats.alert_age_max_ms = alert_age_max;
+		if (stalled) {
+			s_stats.stalls++;
+			s_stats.stall_ms += (uint32_t)((esp_timer_get_time() - t0) / 1000);
+		}
+		portEXIT_CRITICAL(&s_lock);
+	}
+}
+
+static void gateway_link_task(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		portENTER_CRITICAL(&s_lock);
+		uint32_t used = s_head - s_tail;
+		uint32_t age = now_ms() - s_first_ms;
+		bool urgent = s_urgent;
+		bool drops = s_dropped_sent != s_stats.dropped;
+		portEXIT_CRITICAL(&s_lock);
+		TickType_t wait = portMAX_DELAY;
+		if (used && !urgent && used < GWLINK_RECORDS_MAX && age < GATEWAY_LINK_FLUSH_MS) {
+			wait = pdMS_TO_TICKS(GATEWAY_LINK_FLUSH_MS - age);
+		} else if (used || drops) {
+			drain();
+			continue;
+		}
+		(void)xTaskNotifyWait(0, UINT32_MAX, NULL, wait);
+	}
+}
+
+esp_err_t gateway_link_init(void)
+{
+	if (GATEWAY_LINK_TX_GPIO < 0) {
+		ESP_LOGI(TAG, "Gateway link off (no TX pin)");
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+	uart_config_t cfg = {
+		.baud_rate = GATEWAY_LINK_BAUD,
+		.data_bits = UART_DATA_8_BITS,
+		.parity = UART_PARITY_DISABLE,
+		.stop_bits = UART_STOP_BITS_1,
+		.flow_ctrl = GATEWAY_LINK_CTS_GPIO >= 0 ? UART_HW_FLOWCTRL_CTS : UART_HW_FLOWCTRL_DISABLE,
+		.source_clk = UART_SCLK_DEFAULT,
+	};
+	// Transmit only: the smallest receive buffer the driver accepts
+	esp_err_t err = uart_driver_install(GATEWAY_LINK_UART, UART_HW_FIFO_LEN(GATEWAY_LINK_UART) + 1,
+										GATEWAY_LINK_TX_BUF, 0, NULL, 0);
+	if (err == ESP_OK) err = uart_param_config(GATEWAY_LINK_UART, &cfg);
+	if (err == ESP_OK) {
+		err = uart_set_pin(GATEWAY_LINK_UART, GATEWAY_LINK_TX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+						   GATEWAY_LINK_CTS_GPIO >= 0 ? GATEWAY_LINK_CTS_GPIO : UART_PIN_NO_CHANGE);
+	}
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Gateway link: UART%d setup failed: %s", GATEWAY_LINK_UART, esp_err_to_name(err));
+		return err;
+	}
+	// The node ID is the coordinator's IEEE address, in Zigbee byte order
+	uint8_t mac[8];
+	if (esp_read_mac(mac, ESP_MAC_IEEE802154) == ESP_OK) {
+		for (int i = 0; i < 8; i++) s_node[i] = mac[7 - i];
+	}
+	s_task = xTaskCreateStatic(gateway_link_task, "gw_link", GATEWAY_LINK_TASK_STACK, NULL, GATEWAY_LINK_TASK_PRIO,
+							   s_task_stack, &s_task_tcb);
+	if (!s_task) {
+		ESP_LOGE(TAG, "Failed to create gateway link task");
+		return ESP_ERR_NO_MEM;
+	}
+	portENTER_CRITICAL(&s_lock);
+	s_on = true;
+	portEXIT_CRITICAL(&s_lock);
+	metrics_register_task(s_task, "gw_link", GATEWAY_LINK_TASK_STACK);
+	ESP_LOGI(TAG, "Gateway link on UART%d (TX %d, CTS %d) at %d baud, flush %d ms", GATEWAY_LINK_UART,
+			 GATEWAY_LINK_TX_GPIO, GATEWAY_LINK_CTS_GPIO, GATEWAY_LINK_BAUD, GATEWAY_LINK_FLUSH_MS);
+	return ESP_OK;
+}
@@ -0,0 +1,99 @@
+// Gateway link: joins, verdicts and alerts streamed to a host gateway over a UART, in framed
+// binary batches (format in gateway_link_format.h, reference receiver host/tools/gateway_recv.c)
+// - Callers copy a small record into a RAM buffer and return: no formatting, no UART access
+// - A task sends the buffer in frames of up to GWLINK_FRAME_MAX bytes: when a frame is full,
+//   GATEWAY_LINK_FLUSH_MS after the oldest buffered record, or at once for an alert
+// - Back-pressure: with CTS wired, the gateway holds the UART while it is busy and the task waits
+//   in uart_write_bytes. Records keep coalescing meanwhile; joins and verdicts are dropped once
+//   the buffer is 3/4 full, alerts only when it is full. A DROPPED record tells the gateway how
+//   many it missed
+// - Off until a TX pin is set; records are then ignored, not counted as dropped
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "interview.h"
+#include "gateway_link_format.h"
+
+// UART to the gateway (UART0 is the console)
+#ifndef GATEWAY_LINK_UART
+#define GATEWAY_LINK_UART           (1)
+#endif
+// Pins (Kconfig: Zigbee scanner -> Gateway link), none claimed by default: TX -1 turns the link
+// off, CTS -1 sends without flow control
+#ifndef GATEWAY_LINK_TX_GPIO
+#ifdef CONFIG_ZB_SCAN_GATEWAY_TX_GPIO
+#define GATEWAY_LINK_TX_GPIO        (CONFIG_ZB_SCAN_GATEWAY_TX_GPIO)
+#else
+#define GATEWAY_LINK_TX_GPIO        (-1)
+#endif
+#endif
+#ifndef GATEWAY_LINK_CTS_GPIO
+#ifdef CONFIG_ZB_SCAN_GATEWAY_CTS_GPIO
+#define GATEWAY_LINK_CTS_GPIO       (CONFIG_ZB_SCAN_GATEWAY_CTS_GPIO)
+#else
+#define GATEWAY_LINK_CTS_GPIO       (-1)
+#endif
+#endif
+#ifndef GATEWAY_LINK_BAUD
+#ifdef CONFIG_ZB_SCAN_GATEWAY_BAUD
+#define GATEWAY_LINK_BAUD           (CONFIG_ZB_SCAN_GATEWAY_BAUD)
+#else
+#define GATEWAY_LINK_BAUD           (460800)
+#endif
+#endif
+// Longest a record waits for more to share its frame
+#ifndef GATEWAY_LINK_FLUSH_MS
+#ifdef CONFIG_ZB_SCAN_GATEWAY_FLUSH_MS
+#define GATEWAY_LINK_FLUSH_MS       (CONFIG_ZB_SCAN_GATEWAY_FLUSH_MS)
+#else
+#define GATEWAY_LINK_FLUSH_MS       (50)
+#endif
+#endif
+// Staging buffer between the callers and the link task (power of two)
+#ifndef GATEWAY_LINK_BUF_LEN
+#define GATEWAY_LINK_BUF_LEN        (2048)
+#endif
+// UART driver's transmit buffer: a few frames
+#ifndef GATEWAY_LINK_TX_BUF
+#define GATEWAY_LINK_TX_BUF         (1024)
+#endif
+// Above the event log: the gateway's view should not lag behind the flash history
+#ifndef GATEWAY_LINK_TASK_PRIO
+#define GATEWAY_LINK_TASK_PRIO      (2)
+#endif
+#ifndef GATEWAY_LINK_TASK_STACK
+#define GATEWAY_LINK_TASK_STACK     (2560)
+#endif
+
+typedef struct {
+	bool on;                        // false: no TX pin, nothing below is counted
+	uint32_t records;               // accepted into the buffer
+	uint32_t by_type[GWLINK_TYPE_COUNT];
+	uint32_t dropped;               // buffer full
+	uint32_t alerts_dropped;        // of which alerts
+	uint32_t frames;
+	uint32_t bytes;                 // frame bytes handed to the UART
+	uint32_t stalls;                // frames that found the UART's buffer full: the gateway was slow
+	uint32_t stall_ms;              // time spent waiting for it
+	uint32_t age_max_ms;            // longest a record waited in the buffer
+	uint32_t alert_age_max_ms;      // longest an alert waited
+	uint16_t buf_peak;
+	uint16_t frame_records_max;
+} gateway_link_stats_t;
+
+// Install the UART driver and start the link task. Without a TX pin the link stays off.
+esp_err_t gateway_link_init(void);
+
+void gateway_link_network(uint16_t pan_id, uint8_t channel, bool resumed);
+void gateway_link_join(const uint8_t ieee[8], uint16_t short_addr, uint16_t parent_short, uint8_t capability);
+// model may be NULL when the verdict did not come from the Basic read
+void gateway_link_verdict(const uint8_t ieee[8], uint16_t short_addr, interview_verdict_t verdict, uint8_t source,
+						  const char *model, size_t model_len);
+// ieee NULL for the simulation input; source is EVLOG_ALERT_*. Sends the buffer at once.
+void gateway_link_alert(const uint8_t *ieee, uint16_t short_addr, uint8_t endpoint, uint8_t source);
+
+void gateway_link_get_stats(gateway_link_stats_t *out);
@@ -0,0 +1,99 @@
+// Gateway link: wire format, shared by the firmware (main/gateway_link.c) and the reference
+// receiver (host/tools/gateway_recv.c)
+// - A stream of frames on a UART. Each frame is a gwlink_frame_hdr_t, len bytes of records and
+//   a CRC-16 (evlog_crc16(), little-endian) over the header after the sync bytes and the records
+// - The sync bytes may also occur inside a frame: a receiver that lost its place looks for them,
+//   and takes a frame only when its version, length and CRC check out
+// - A frame carries the coordinator's IEEE address, its boot number and a sequence number that
+//   goes up by one per frame in a boot, so one gateway can take the streams of many
+//   coordinators and see frames it lost
+// - Records follow the header back to back: a gwlink_rec_hdr_t, then len bytes of payload in
+//   the layout of the type's gwlink_*_t. Unknown types are skipped by their length
+// - Little-endian and packed. IEEE addresses are in Zigbee order (least significant byte first)
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "event_log_format.h"
+
+#define GWLINK_SYNC0                (0xA5)
+#define GWLINK_SYNC1                (0x5A)
+#define GWLINK_VERSION              (1)
+// Longest frame on the wire, header and CRC included
+#define GWLINK_FRAME_MAX            (256)
+#define GWLINK_PAYLOAD_MAX          (40)
+
+typedef enum {
+	GWLINK_NETWORK = 1,         // gwlink_network_t: network formed or resumed
+	GWLINK_JOIN,                // gwlink_join_t: device announce
+	GWLINK_VERDICT,             // gwlink_verdict_t: device classified
+	GWLINK_ALERT,               // gwlink_alert_t
+	GWLINK_DROPPED,             // gwlink_dropped_t: records lost to back-pressure before this one
+	GWLINK_TYPE_COUNT,
+} gwlink_type_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t sync[2];            // GWLINK_SYNC0, GWLINK_SYNC1
+	uint8_t version;            // GWLINK_VERSION
+	uint8_t count;              // records
+	uint16_t len;               // record bytes
+	uint16_t seq;               // +1 per frame, 0 for the first of a boot
+	uint16_t boot;              // event log boot number, 0 without an event log
+	uint8_t node[8];            // IEEE address of the coordinator
+	uint32_t time_ms;           // since boot, when the frame was sent
+} gwlink_frame_hdr_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t type;               // gwlink_type_t
+	uint8_t len;                // payload bytes
+	uint16_t age_ms;            // frame time_ms minus the record's time, saturated
+} gwlink_rec_hdr_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t pan_id;
+	uint8_t channel;
+	uint8_t resumed;            // 1: restored from zb_storage
+} gwlink_network_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t ieee[8];
+	uint16_t short_addr;
+	uint16_t parent_short;      // 0xFFFF when unknown
+	uint8_t capability;
+} gwlink_join_t;
+
+#define GWLINK_VERDICT_INTERVIEW    (0)     // classified on this join
+#define GWLINK_VERDICT_CACHE        (1)     // known from the device cache
+
+typedef struct __attribute__((packed)) {
+	uint8_t ieee[8];
+	uint16_t short_addr;
+	uint8_t verdict;            // interview_verdict_t: 1 other, 2 match
+	uint8_t source;             // GWLINK_VERDICT_*
+	char model[];               // Basic model identifier when the verdict came from it, cut to the payload
+} gwlink_verdict_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t ieee[8];            // all zero for the simulation input
+	uint16_t short_addr;
+	uint8_t endpoint;
+	uint8_t source;             // EVLOG_ALERT_*
+} gwlink_alert_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t count;
+} gwlink_dropped_t;
+
+_Static_assert(sizeof(gwlink_frame_hdr_t) == 22, "frame header layout");
+_Static_assert(sizeof(gwlink_rec_hdr_t) == 4, "record header layout");
+_Static_assert(sizeof(gwlink_verdict_t) + 16 <= GWLINK_PAYLOAD_MAX, "verdict records keep room for a model");
+
+// Records of a full frame
+#define GWLINK_RECORDS_MAX          (GWLINK_FRAME_MAX - sizeof(gwlink_frame_hdr_t) - sizeof(uint16_t))
+
+// CRC of a frame: header from the version byte on, then the records
+static inline uint16_t gwlink_frame_crc(const gwlink_frame_hdr_t *hdr, const void *records)
+{
+	uint16_t crc = evlog_crc16(0xFFFF, &hdr->version, sizeof(*hdr) - sizeof(hdr->sync));
+	return evlog_crc16(crc, records, hdr->len);
+}
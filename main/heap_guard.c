@@ -0,0 +1,178 @@
+// Heap guard: counts from the ESP-IDF heap hooks, reported outside the allocator
+
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/timers.h"
+#include "heap_guard.h"
+
+static const char *TAG = "ZB_SCAN";
+
+// ESP-IDF tasks that run no app code. linenoise and esp_console_run allocate for every command
+// line typed in the REPL; ipc0/ipc1 only exist on dual-core targets
+static const char *const s_idf_tasks[] = { "console_repl", "esp_timer", "ipc0", "ipc1" };
+
+static heap_guard_stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Called with s_lock held
+static heap_guard_task_t *task_slot(TaskHandle_t task)
+{
+	for (uint8_t i = 0; i < s_stats.task_count; i++) {
+		if (s_stats.tasks[i].task == task) return &s_stats.tasks[i];
+	}
+	if (s_stats.task_count == HEAP_GUARD_MAX_TASKS) return NULL;
+	heap_guard_task_t *t = &s_stats.tasks[s_stats.task_count++];
+	*t = (heap_guard_task_t){ .task = task };
+	// The name is kept rather than looked up later, when the task may be gone. pcTaskGetName
+	// only reads the TCB, and FreeRTOS sits in IRAM (CONFIG_FREERTOS_PLACE_FUNCTIONS_INTO_FLASH
+	// unset), so this is safe inside the allocator
+	const char *name = task ? pcTaskGetName(task) : "none";
+	for (size_t i = 0; i < sizeof(t->name) - 1 && name[i]; i++) t->name[i] = name[i];
+	return t;
+}
+
+// Runs inside the allocator, possibly from an ISR: count only, no logging, no allocation
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+	(void)ptr;
+	(void)caps;
+	portENTER_CRITICAL_SAFE(&s_lock);
+	if (!s_stats.armed) {
+		s_stats.init_allocs++;
+	} else {
+		s_stats.allocs++;
+		s_stats.bytes += size;
+		heap_guard_task_t *t = task_slot(xTaskGetCurrentTaskHandle());
+		if (!t) {
+			s_stats.untracked++;
+		} else {
+			t->allocs++;
+			t->bytes += size;
+			if ((!t->expected || t->app_depth) && !t->idf_depth && !t->app_allocs++) t->first_size = size;
+		}
+	}
+	portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+{
+	(void)ptr;
+	portENTER_CRITICAL_SAFE(&s_lock);
+	if (s_stats.armed) {
+		s_stats.frees++;
+		heap_guard_task_t *t = task_slot(xTaskGetCurrentTaskHandle());
+		if (t) t->frees++;
+	}
+	portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void heap_guard_arm(void)
+{
+	portENTER_CRITICAL(&s_lock);
+	bool was_armed = s_stats.armed;
+	s_stats.armed = true;
+	portEXIT_CRITICAL(&s_lock);
+	if (was_armed) return;
+	ESP_LOGI(TAG, "Heap guard armed: %lu allocations during start-up", (unsigned long)s_stats.init_allocs);
+}
+
+void heap_guard_expect_task(TaskHandle_t task)
+{
+	if (!task) return;
+	portENTER_CRITICAL(&s_lock);
+	heap_guard_task_t *t = task_slot(task);
+	if (t) t->expected = true;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+void heap_guard_expect_idf_tasks(void)
+{
+	// Timer callbacks are the app's and open with HEAP_GUARD_APP_SCOPE
+	heap_guard_expect_task(xTimerGetTimerDaemonTaskHandle());
+	for (size_t i = 0; i < sizeof(s_idf_tasks) / sizeof(s_idf_tasks[0]); i++) {
+		heap_guard_expect_task(xTaskGetHandle(s_idf_tasks[i]));
+	}
+}
+
+void heap_guard_idf_begin(void)
+{
+	portENTER_CRITICAL(&s_lock);
+	heap_guard_task_t *t = task_slot(xTaskGetCurrentTaskHandle());
+	if (t) t->idf_depth++;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+void heap_guard_idf_end(void)
+{
+	portENTER_CRITICAL(&s_lock);
+	heap_guard_task_t *t = task_slot(xTaskGetCurrentTaskHandle());
+	if (t && t->idf_depth) t->idf_depth--;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+uint8_t heap_guard_app_begin(void)
+{
+	uint8_t outer = 0;
+	portENTER_CRITICAL(&s_lock);
+	heap_guard_task_t *t = task_slot(xTaskGetCurrentTaskHandle());
+	if (t) {
+		outer = t->idf_depth;
+		t->idf_depth = 0;
+		t->app_depth++;
+	}
+	portEXIT_CRITICAL(&s_lock);
+	return outer;
+}
+
+void heap_guard_app_end(const uint8_t *outer)
+{
+	portENTER_CRITICAL(&s_lock);
+	heap_guard_task_t *t = task_slot(xTaskGetCurrentTaskHandle());
+	if (t) {
+		t->idf_depth = *outer;
+		if (t->app_depth) t->app_depth--;
+	}
+	portEXIT_CRITICAL(&s_lock);
+}
+
+// Slot by slot under the lock: the whole stats would not fit on the timer service's stack
+void heap_guard_check(void)
+{
+	for (uint8_t i = 0; i < HEAP_GUARD_MAX_TASKS; i++) {
+		portENTER_CRITICAL(&s_lock);
+		heap_guard_task_t t = s_stats.tasks[i];
+		bool log = i < s_stats.task_count && !t.logged && t.app_allocs;
+		if (log) s_stats.tasks[i].logged = true;
+		portEXIT_CRITICAL(&s_lock);
+		if (log) {
+			ESP_LOGW(TAG, "Heap allocation after start-up in task %s: %lu so far, first %lu bytes", t.name,
+					 (unsigned long)t.app_allocs, (unsigned long)t.first_size);
+		}
+	}
+	portENTER_CRITICAL(&s_lock);
+	uint32_t untracked = s_stats.untracked_logged ? 0 : s_stats.untracked;
+	if (untracked) s_stats.untracked_logged = true;
+	portEXIT_CRITICAL(&s_lock);
+	if (untracked) {
+		ESP_LOGW(TAG, "Heap allocations after start-up in more than %d tasks: %lu not attributed, counted as the "
+				 "app's", HEAP_GUARD_MAX_TASKS, (unsigned long)untracked);
+	}
+}
+
+void heap_guard_get_stats(heap_guard_stats_t *out)
+{
+	portENTER_CRITICAL(&s_lock);
+	*out = s_stats;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t heap_guard_app_allocs(void)
+{
+	portENTER_CRITICAL(&s_lock);
+	uint32_t n = s_stats.untracked;
+	for (uint8_t i = 0; i < s_stats.task_count; i++) n += s_stats.tasks[i].app_allocs;
+	portEXIT_CRITICAL(&s_lock);
+	return n;
+}
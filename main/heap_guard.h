@@ -0,0 +1,100 @@
+// Heap guard: heap allocations after start-up, counted per task
+// - The app's tasks, timers, mutexes and tables are statically allocated, and its own code
+//   allocates nothing once start-up is over. The heap is still used after that by the Zigbee
+//   stack, by ESP-IDF's own tasks (console REPL, timer service, ipc, esp_timer) and inside
+//   ESP-IDF calls such as NVS writes. Those are expected: the tasks and calls are marked, and
+//   their allocations are only counted
+// - The Zigbee task is not marked as a whole: it runs most of the app. Its main loop is an
+//   ESP-IDF call (heap_guard_idf_begin), and every app callback it makes (signal and action
+//   handlers, scheduler alarms, ZDO callbacks) opens with HEAP_GUARD_APP_SCOPE. The
+//   stack's request calls made from there take their frames from its preallocated buffer pool
+//   (esp_zb_io_buffer_size_set) and are not marked. The app's timer callbacks and console
+//   commands open with it too, inside the (expected) timer service and REPL tasks
+// - Counted from the ESP-IDF heap hooks (CONFIG_HEAP_USE_HOOKS, sdkconfig.defaults), which run
+//   inside the allocator: they only count. The metrics sampler logs the first unexpected
+//   allocation of each task once
+// - `metrics` prints the counts
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// A slot per task that allocates after start-up or is marked: the app's (zigbee_main, actuator,
+// event_log, dev_cache, gw_link, and main until app_main returns) and ESP-IDF's (timer service,
+// console_repl, esp_timer, ipc0/ipc1 and an IDLE task per core), with room for a few more
+#ifndef HEAP_GUARD_APP_TASKS
+#define HEAP_GUARD_APP_TASKS        (6)
+#endif
+#ifndef HEAP_GUARD_IDF_TASKS
+#define HEAP_GUARD_IDF_TASKS        (7)
+#endif
+#ifndef HEAP_GUARD_MAX_TASKS
+#define HEAP_GUARD_MAX_TASKS        (HEAP_GUARD_APP_TASKS + HEAP_GUARD_IDF_TASKS + 3)
+#endif
+#define HEAP_GUARD_NAME_LEN         (16)
+
+typedef struct {
+	// NULL: outside any task (host: the simulator's event loop). Only compared, never
+	// dereferenced: the task may have been deleted since
+	TaskHandle_t task;
+	char name[HEAP_GUARD_NAME_LEN]; // copied when the slot was taken
+	uint32_t allocs;
+	uint32_t app_allocs;            // not expected: app code, outside heap_guard_idf_begin/end
+	uint32_t frees;
+	uint32_t bytes;                 // allocated, frees not subtracted
+	uint32_t first_size;            // size of the first app allocation
+	uint8_t idf_depth;              // nesting of heap_guard_idf_begin
+	uint8_t app_depth;              // nesting of heap_guard_app_begin
+	bool expected;                  // an ESP-IDF task: every allocation is expected
+	bool logged;
+} heap_guard_task_t;
+
+typedef struct {
+	bool armed;
+	uint32_t init_allocs;           // during start-up
+	uint32_t allocs;                // after start-up, all tasks
+	uint32_t frees;
+	uint32_t bytes;
+	uint32_t untracked;             // from tasks beyond HEAP_GUARD_MAX_TASKS: not attributed,
+									// counted as the app's
+	bool untracked_logged;
+	uint8_t task_count;
+	heap_guard_task_t tasks[HEAP_GUARD_MAX_TASKS];
+} heap_guard_stats_t;
+
+// Start-up is over: count from now on. main.c calls it once the network is up and app_main has
+// set up the rest, whichever comes last
+void heap_guard_arm(void);
+
+// The task's allocations are expected (ESP-IDF's own tasks): counted, never logged, except in the
+// app code it runs (HEAP_GUARD_APP_SCOPE)
+void heap_guard_expect_task(TaskHandle_t task);
+
+// Mark ESP-IDF's own tasks (console REPL, timer service, ipc, esp_timer): app_main, once they
+// all exist
+void heap_guard_expect_idf_tasks(void);
+
+// Allocations of the calling task between these are made inside an ESP-IDF call (an NVS write)
+// and expected. They nest
+void heap_guard_idf_begin(void);
+void heap_guard_idf_end(void);
+
+// App code called back from inside an ESP-IDF call or task (the Zigbee main loop, the timer
+// service): its allocations are not expected until the end of the enclosing block, early returns
+// included, even in an expected task. First statement of the callback
+#define HEAP_GUARD_APP_SCOPE() \
+	uint8_t heap_guard_outer_ __attribute__((cleanup(heap_guard_app_end))) = heap_guard_app_begin()
+uint8_t heap_guard_app_begin(void);
+void heap_guard_app_end(const uint8_t *outer);
+
+// Log the first unexpected allocation after start-up of each task once, and the first untracked
+// one (metrics sampler)
+void heap_guard_check(void);
+
+void heap_guard_get_stats(heap_guard_stats_t *out);
+
+// Unexpected allocations after start-up by the app's own code. Untracked ones are included: they
+// cannot be told apart from the app's, and a task missing from the slots must not hide one
+uint32_t heap_guard_app_allocs(void);
@@ -0,0 +1,556 @@
+// Interview scheduler: throttles the ZDO/ZCL requests sent to joining devices
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+#include "device_table.h"
+#include "interview.h"
+#include "event_log.h"
+#include "latency.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "classifier.h"
+
+static const char *TAG = "ZB_SCAN";
+
+#define HA_PROFILE_ID       (0x0104)
+#define ON_OFF_CLUSTER      (0x0006)
+#define GREEN_POWER_EP      (242)
+
+typedef enum {
+	STEP_ACTIVE_EP,
+	STEP_SIMPLE_DESC,
+	STEP_READ_BASIC,
+} interview_step_kind_t;
+
+typedef struct {
+	uint16_t dev;               // device table index
+	uint8_t kind;
+	uint8_t endpoint;
+	uint8_t attempts;
+	uint32_t not_before_ms;     // backoff: do not issue before this time
+	uint32_t since_us;          // end of the previous stage (latency histograms)
+	uint32_t annce_us;          // device announce
+} interview_step_t;
+
+typedef struct {
+	bool used;
+	uint8_t tsn;                // ZCL reads are matched by source + TSN
+	uint16_t seq;               // ZDO callbacks carry slot + seq to detect stale responses
+	uint32_t deadline_ms;
+	interview_step_t step;
+} interview_slot_t;
+
+// Ring buffer of pending steps. Each device has at most one step queued or in flight;
+// follow-up steps go to the front so started devices finish before new ones begin.
+static interview_step_t s_queue[INTERVIEW_QUEUE_LEN];
+static uint16_t s_head;
+static uint16_t s_count;
+static interview_slot_t s_slots[INTERVIEW_MAX_IN_FLIGHT];
+static uint16_t s_seq;
+static bool s_tick_armed;
+static interview_stats_t s_stats;
+static interview_classified_cb_t s_classified_cb;
+
+static void active_ep_cb(esp_zb_zdp_status_t zdo_status, uint8_t ep_count, uint8_t *ep_id_list, void *user_ctx);
+static void simple_desc_cb(esp_zb_zdp_status_t zdo_status, esp_zb_af_simple_desc_1_1_t *simple_desc, void *user_ctx);
+static void interview_pump(void);
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint32_t now_us(void)
+{
+	return (uint32_t)esp_timer_get_time();
+}
+
+static bool time_reached(uint32_t now, uint32_t t)
+{
+	return (int32_t)(now - t) >= 0;
+}
+
+// Device records live in the device table; steps refer to them by their stable index.
+// A device with a step queued or in flight is never evicted (its state is not idle).
+static device_entry_t *step_dev(const interview_step_t *step)
+{
+	return device_table_at(step->dev);
+}
+
+// ---- Step queue ------------------------------------------------------------------
+
+// A refresh that fails leaves the device classified
+static uint8_t failed_state(const device_entry_t *d)
+{
+	return d->state == DEVICE_STATE_REFRESH ? DEVICE_STATE_DONE : DEVICE_STATE_FAILED;
+}
+
+static bool queue_push(const interview_step_t *step, bool front)
+{
+	if (s_count >= INTERVIEW_QUEUE_LEN) {
+		s_stats.dropped_queue_full++;
+		step_dev(step)->state = failed_state(step_dev(step));
+		ESP_LOGW(TAG, "Queue full: dropping step %u for 0x%04X", step->kind, step_dev(step)->short_addr);
+		return false;
+	}
+	if (front) {
+		s_head = (uint16_t)((s_head + INTERVIEW_QUEUE_LEN - 1) % INTERVIEW_QUEUE_LEN);
+		s_queue[s_head] = *step;
+	} else {
+		s_queue[(s_head + s_count) % INTERVIEW_QUEUE_LEN] = *step;
+	}
+	s_count++;
+	if (s_count > s_stats.queue_peak) s_stats.queue_peak = s_count;
+	return true;
+}
+
+static void queue_remove(uint16_t pos)
+{
+	// Close the gap by shifting the entries before pos one slot towards the tail
+	for (uint16_t i = pos; i > 0; i--) {
+		s_queue[(s_head + i) % INTERVIEW_QUEUE_LEN] = s_queue[(s_head + i - 1) % INTERVIEW_QUEUE_LEN];
+	}
+	s_head = (uint16_t)((s_head + 1) % INTERVIEW_QUEUE_LEN);
+	s_count--;
+}
+
+static void queue_drop_device(uint16_t dev)
+{
+	for (uint16_t pos = 0; pos < s_count; pos++) {
+		if (s_queue[(s_head + pos) % INTERVIEW_QUEUE_LEN].dev == dev) {
+			queue_remove(pos);
+			return;
+		}
+	}
+}
+
+// prev is the step that just completed, NULL for the first one
+static void queue_step(device_entry_t *d, uint8_t kind, uint8_t endpoint, const interview_step_t *prev)
+{
+	uint32_t now = now_us();
+	interview_step_t step = {.dev = device_table_index(d), .kind = kind, .endpoint = endpoint,
+							 .since_us = now, .annce_us = prev ? prev->annce_us : now};
+	(void)queue_push(&step, kind != STEP_ACTIVE_EP);
+}
+
+// Time since the end of the previous stage, retries and queueing included
+static void record_stage(latency_stage_t stage, const interview_step_t *step)
+{
+	latency_record(stage, latency_class_of(step_dev(step)), now_us() - step->since_us);
+}
+
+// ---- In-flight slots -----------------------------------------------------------
+
+static void *slot_token(uint8_t idx)
+{
+	return (void *)(uintptr_t)(((uint32_t)s_slots[idx].seq << 8) | idx);
+}
+
+static interview_slot_t *slot_from_token(void *user_ctx)
+{
+	uint32_t token = (uint32_t)(uintptr_t)user_ctx;
+	uint8_t idx = (uint8_t)(token & 0xff);
+	if (idx >= INTERVIEW_MAX_IN_FLIGHT) return NULL;
+	interview_slot_t *slot = &s_slots[idx];
+	if (!slot->used || slot->seq != (uint16_t)(token >> 8)) return NULL;
+	return slot;
+}
+
+static interview_slot_t *slot_for_device(uint16_t dev)
+{
+	for (uint8_t i = 0; i < INTERVIEW_MAX_IN_FLIGHT; i++) {
+		if (s_slots[i].used && s_slots[i].step.dev == dev) return &s_slots[i];
+	}
+	return NULL;
+}
+
+static void slot_release(interview_slot_t *slot)
+{
+	slot->used = false;
+	s_stats.in_flight--;
+}
+
+static void slot_complete(interview_slot_t *slot)
+{
+	slot_release(slot);
+	s_stats.completed++;
+}
+
+static void log_step_failed(const interview_step_t *step, uint8_t status)
+{
+	evlog_step_failed_t f = { .short_addr = step_dev(step)->short_addr, .step = (uint8_t)step->kind,
+							  .endpoint = step->endpoint, .status = status, .attempt = step->attempts };
+	event_log_write(EVLOG_STEP_FAILED, &f, sizeof(f));
+}
+
+// Give the step another chance after a growing delay, or give up on the device
+static void slot_retry(interview_slot_t *slot)
+{
+	interview_step_t step = slot->step;
+	device_entry_t *d = step_dev(&step);
+	slot_release(slot);
+	if (step.attempts > INTERVIEW_MAX_RETRIES) {
+		s_stats.dropped_retries++;
+		d->state = failed_state(d);
+		log_step_failed(&step, EVLOG_STATUS_GAVE_UP);
+		ESP_LOGW(TAG, "Giving up step %u for 0x%04X after %u attempts", step.kind, d->short_addr, step.attempts);
+		return;
+	}
+	s_stats.retries++;
+	step.not_before_ms = now_ms() + ((uint32_t)INTERVIEW_BACKOFF_MS << (step.attempts - 1));
+	(void)queue_push(&step, true);
+}
+
+// ---- State machine -------------------------------------------------------------
+
+// Describe the next candidate endpoint, or give up when none is left
+static void describe_next(device_entry_t *d, const interview_step_t *prev)
+{
+	if (d->next_ep >= d->ep_count) {
+		ESP_LOGW(TAG, "0x%04X: no endpoint answered Basic manufacturer/model", d->short_addr);
+		d->state = DEVICE_STATE_FAILED;
+		return;
+	}
+	d->state = DEVICE_STATE_DESCRIBE;
+	queue_step(d, STEP_SIMPLE_DESC, d->eps[d->next_ep++], prev);
+}
+
+static const metrics_req_t s_step_req[] = {
+	[STEP_ACTIVE_EP] = METRICS_REQ_ACTIVE_EP,
+	[STEP_SIMPLE_DESC] = METRICS_REQ_SIMPLE_DESC,
+	[STEP_READ_BASIC] = METRICS_REQ_READ_ATTR,
+};
+
+static void issue(uint8_t idx)
+{
+	interview_slot_t *slot = &s_slots[idx];
+	interview_step_t *step = &slot->step;
+	uint16_t addr = step_dev(step)->short_addr;
+	step->attempts++;
+	slot->seq = ++s_seq;
+	slot->deadline_ms = now_ms() + INTERVIEW_TIMEOUT_MS;
+	s_stats.issued++;
+	metrics_count(s_step_req[step->kind], METRICS_ISSUED);
+	switch (step->kind) {
+	case STEP_ACTIVE_EP: {
+		esp_zb_zdo_active_ep_req_param_t aep = {.addr_of_interest = addr};
+		ESP_LOGD(TAG, "Requesting ActiveEP to 0x%04X", addr);
+		esp_zb_zdo_active_ep_req(&aep, active_ep_cb, slot_token(idx));
+		break;
+	}
+	case STEP_SIMPLE_DESC: {
+		esp_zb_zdo_simple_desc_req_param_t sreq = {
+			.addr_of_interest = addr,
+			.endpoint = step->endpoint,
+		};
+		esp_zb_zdo_simple_desc_req(&sreq, simple_desc_cb, slot_token(idx));
+		break;
+	}
+	case STEP_READ_BASIC: {
+		// Basic 0x0000: Manufacturer Name 0x0004 and Model Id 0x0005 identify the device; Application
+		// version 0x0001, HW version 0x0003 and SW build 0x4000 fingerprint its firmware in the same
+		// request. A device whose response would not fit in one frame returns the leading attributes.
+		static uint16_t attrs[] = {0x0004, 0x0005, 0x0001, 0x0003, 0x4000};
+		esp_zb_zcl_read_attr_cmd_t cmd = {
+			.zcl_basic_cmd = {
+				.dst_addr_u = {.addr_short = addr},
+				.dst_endpoint = step->endpoint,
+				.src_endpoint = 1,
+			},
+			.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+			.clusterID = 0x0000,
+			.manuf_specific = 0,
+			.direction = 0,
+			.dis_default_resp = 1,
+			.manuf_code = 0,
+			.attr_number = (uint8_t)(sizeof(attrs)/sizeof(attrs[0])),
+			.attr_field = attrs,
+		};
+		slot->tsn = esp_zb_zcl_read_attr_cmd_req(&cmd);
+		ESP_LOGD(TAG, "Reading Basic attrs (tsn=%u) to 0x%04X/ep%u", slot->tsn, addr, step->endpoint);
+		break;
+	}
+	}
+}
+
+static void interview_tick(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	s_tick_armed = false;
+	uint32_t now = now_ms();
+	for (uint8_t i = 0; i < INTERVIEW_MAX_IN_FLIGHT; i++) {
+		if (s_slots[i].used && time_reached(now, s_slots[i].deadline_ms)) {
+			s_stats.timeouts++;
+			metrics_count(s_step_req[s_slots[i].step.kind], METRICS_TIMEOUT);
+			log_step_failed(&s_slots[i].step, EVLOG_STATUS_TIMEOUT);
+			ESP_LOGW(TAG, "Step %u for 0x%04X timed out (attempt %u)",
+					 s_slots[i].step.kind, step_dev(&s_slots[i].step)->short_addr, s_slots[i].step.attempts);
+			slot_retry(&s_slots[i]);
+		}
+	}
+	interview_pump();
+}
+
+// Issue queued steps while the window has room, then keep the tick alive while work remains
+static void interview_pump(void)
+{
+	uint32_t now = now_ms();
+	uint16_t pos = 0;
+	while (s_stats.in_flight < INTERVIEW_MAX_IN_FLIGHT && pos < s_count) {
+		interview_step_t *step = &s_queue[(s_head + pos) % INTERVIEW_QUEUE_LEN];
+		if (!time_reached(now, step->not_before_ms)) {
+			pos++;
+			continue;
+		}
+		uint8_t idx = 0;
+		while (s_slots[idx].used) idx++;
+		s_slots[idx].used = true;
+		s_slots[idx].step = *step;
+		queue_remove(pos);
+		s_stats.in_flight++;
+		if (s_stats.in_flight > s_stats.in_flight_peak) s_stats.in_flight_peak = s_stats.in_flight;
+		issue(idx);
+	}
+	s_stats.queue_depth = s_count;
+	if (s_count == 0 && s_stats.in_flight == 0) {
+		if (s_stats.issued) {
+			ESP_LOGI(TAG, "Interview queue drained: issued=%lu done=%lu retries=%lu timeouts=%lu dropped=%lu peak=%u",
+					 (unsigned long)s_stats.issued, (unsigned long)s_stats.completed,
+					 (unsigned long)s_stats.retries, (unsigned long)s_stats.timeouts,
+					 (unsigned long)(s_stats.dropped_queue_full + s_stats.dropped_retries), s_stats.queue_peak);
+		}
+		return;
+	}
+	if (!s_tick_armed) {
+		s_tick_armed = true;
+		esp_zb_scheduler_alarm(interview_tick, 0, INTERVIEW_TICK_MS);
+	}
+}
+
+void interview_init(interview_classified_cb_t cb)
+{
+	s_classified_cb = cb;
+}
+
+interview_verdict_t interview_start(device_entry_t *d)
+{
+	if (d->state == DEVICE_STATE_DONE) {
+		s_stats.known++;
+		ESP_LOGI(TAG, "0x%04X already classified: skipping interview", d->short_addr);
+		return (interview_verdict_t)d->verdict;
+	}
+	if (d->state != DEVICE_STATE_NEW && d->state != DEVICE_STATE_FAILED) {
+		s_stats.duplicates++;
+		return INTERVIEW_VERDICT_NONE;
+	}
+	d->state = DEVICE_STATE_ACTIVE_EP;
+	d->verdict = INTERVIEW_VERDICT_NONE;
+	queue_step(d, STEP_ACTIVE_EP, 0, NULL);
+	interview_pump();
+	return INTERVIEW_VERDICT_NONE;
+}
+
+static void active_ep_cb(esp_zb_zdp_status_t zdo_status, uint8_t ep_count, uint8_t *ep_id_list, void *user_ctx)
+{
+	HEAP_GUARD_APP_SCOPE();
+	uint32_t c0 = latency_cycles();
+	interview_slot_t *slot = slot_from_token(user_ctx);
+	if (!slot) return; // already timed out and retried
+	device_entry_t *d = step_dev(&slot->step);
+	latency_class_t cls = latency_class_of(d);
+	device_table_touch(d);
+	if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+		ESP_LOGW(TAG, "ActiveEP to 0x%04X failed: status=%d", d->short_addr, zdo_status);
+		log_step_failed(&slot->step, (uint8_t)zdo_status);
+		s_stats.failures++;
+		metrics_count_zdp(METRICS_REQ_ACTIVE_EP, zdo_status);
+		slot_retry(slot);
+		interview_pump();
+		latency_record(LATENCY_CPU_ACTIVE_EP, cls, latency_cycles() - c0);
+		return;
+	}
+	interview_step_t step = slot->step;
+	record_stage(LATENCY_ACTIVE_EP, &step);
+	metrics_count(METRICS_REQ_ACTIVE_EP, METRICS_OK);
+	slot_complete(slot);
+	if (ep_count == 0 || !ep_id_list) {
+		ESP_LOGW(TAG, "ActiveEP of 0x%04X is empty", d->short_addr);
+		d->state = DEVICE_STATE_FAILED;
+		interview_pump();
+		latency_record(LATENCY_CPU_ACTIVE_EP, cls, latency_cycles() - c0);
+		return;
+	}
+	uint8_t rec[EVLOG_PAYLOAD_MAX];
+	evlog_active_ep_t *a = (evlog_active_ep_t *)rec;
+	uint8_t logged = ep_count < sizeof(rec) - sizeof(*a) ? ep_count : (uint8_t)(sizeof(rec) - sizeof(*a));
+	a->short_addr = d->short_addr;
+	a->count = ep_count;
+	memcpy(a->eps, ep_id_list, logged);
+	event_log_write(EVLOG_ACTIVE_EP, rec, sizeof(*a) + logged);
+	ESP_LOGD(TAG, "Active endpoints of 0x%04X (%u):", d->short_addr, ep_count);
+	d->ep_count = 0;
+	d->next_ep = 0;
+	for (uint8_t i = 0; i < ep_count; i++) {
+		ESP_LOGD(TAG, "  - ep %u", ep_id_list[i]);
+		// Green Power endpoint never carries HA Basic: do not spend a SimpleDesc on it
+		if (ep_id_list[i] != GREEN_POWER_EP && d->ep_count < DEVICE_TABLE_MAX_EPS) {
+			d->eps[d->ep_count++] = ep_id_list[i];
+		}
+	}
+	describe_next(d, &step);
+	interview_pump();
+	latency_record(LATENCY_CPU_ACTIVE_EP, cls, latency_cycles() - c0);
+}
+
+static void simple_desc_cb(esp_zb_zdp_status_t zdo_status, esp_zb_af_simple_desc_1_1_t *sd, void *user_ctx)
+{
+	HEAP_GUARD_APP_SCOPE();
+	uint32_t c0 = latency_cycles();
+	interview_slot_t *slot = slot_from_token(user_ctx);
+	if (!slot) return;
+	device_entry_t *d = step_dev(&slot->step);
+	latency_class_t cls = latency_class_of(d);
+	device_table_touch(d);
+	if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS || !sd) {
+		ESP_LOGW(TAG, "SimpleDesc of 0x%04X/ep%u failed: status=%d", d->short_addr, slot->step.endpoint, zdo_status);
+		log_step_failed(&slot->step, (uint8_t)zdo_status);
+		s_stats.failures++;
+		metrics_count_zdp(METRICS_REQ_SIMPLE_DESC, zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS ? (int)zdo_status : -1);
+		slot_retry(slot);
+		interview_pump();
+		latency_record(LATENCY_CPU_SIMPLE_DESC, cls, latency_cycles() - c0);
+		return;
+	}
+	interview_step_t step = slot->step;
+	record_stage(LATENCY_SIMPLE_DESC, &step);
+	metrics_count(METRICS_REQ_SIMPLE_DESC, METRICS_OK);
+	slot_complete(slot);
+	uint8_t rec[EVLOG_PAYLOAD_MAX];
+	evlog_simple_desc_t *r = (evlog_simple_desc_t *)rec;
+	uint8_t logged = sd->app_input_cluster_count;
+	if (logged > (sizeof(rec) - sizeof(*r)) / sizeof(uint16_t)) logged = (sizeof(rec) - sizeof(*r)) / sizeof(uint16_t);
+	r->short_addr = d->short_addr;
+	r->endpoint = sd->endpoint;
+	r->profile_id = sd->app_profile_id;
+	r->device_id = sd->app_device_id;
+	memcpy(r->clusters, sd->app_cluster_list, logged * sizeof(uint16_t));
+	event_log_write(EVLOG_SIMPLE_DESC, rec, sizeof(*r) + logged * sizeof(uint16_t));
+	ESP_LOGD(TAG, "SimpleDesc: ep=%u profile=0x%04X device=0x%04X", sd->endpoint, sd->app_profile_id, sd->app_device_id);
+	if (sd->app_profile_id == HA_PROFILE_ID) {
+		// The endpoint that answers Basic is the one presence.c subscribes to
+		d->report_ep = sd->endpoint;
+		d->flags &= (uint8_t)~DEVICE_FLAG_ON_OFF;
+		for (uint8_t i = 0; i < sd->app_input_cluster_count; i++) {
+			if (sd->app_cluster_list[i] == ON_OFF_CLUSTER) d->flags |= DEVICE_FLAG_ON_OFF;
+		}
+	}
+	interview_verdict_t verdict = classifier_on_descriptor(d, sd->app_profile_id, sd->app_device_id,
+														   sd->app_cluster_list, sd->app_input_cluster_count);
+	if (verdict != INTERVIEW_VERDICT_NONE) {
+		// Decided by the descriptor: no Basic read
+		latency_record(LATENCY_DETECT, cls, now_us() - step.annce_us);
+		d->state = DEVICE_STATE_DONE;
+		d->verdict = (uint8_t)verdict;
+		s_stats.classified++;
+		if (s_classified_cb) s_classified_cb(d, verdict, sd->endpoint);
+	} else if (sd->app_profile_id == HA_PROFILE_ID) {
+		// Only try to read Basic on HA profile endpoints (0x0104)
+		d->state = DEVICE_STATE_READ_BASIC;
+		queue_step(d, STEP_READ_BASIC, sd->endpoint, &step);
+	} else {
+		ESP_LOGD(TAG, "Non-HA profile (0x%04X) on ep %u: skipping Basic read", sd->app_profile_id, sd->endpoint);
+		describe_next(d, &step);
+	}
+	interview_pump();
+	latency_record(LATENCY_CPU_SIMPLE_DESC, cls, latency_cycles() - c0);
+}
+
+// A device that has not been asked for Basic yet, typically one that just took over the short
+// address of another, cannot be identified by a response from that address
+static bool basic_asked(const device_entry_t *d)
+{
+	return d->state == DEVICE_STATE_DESCRIBE || d->state == DEVICE_STATE_READ_BASIC || d->state == DEVICE_STATE_FAILED;
+}
+
+bool interview_on_read_attr_resp(uint16_t short_addr, uint8_t tsn, interview_verdict_t verdict)
+{
+	device_entry_t *d = device_table_find_short(short_addr);
+	if (!d) return false;
+	device_table_touch(d);
+	uint16_t dev = device_table_index(d);
+	interview_slot_t *slot = slot_for_device(dev);
+	bool ours = slot && slot->step.kind == STEP_READ_BASIC && slot->tsn == tsn;
+	bool first = false;
+	interview_step_t step = {0};
+	if (slot) step = slot->step;
+	if (d->state == DEVICE_STATE_REFRESH) {
+		// Firmware re-read of a classified device: the caller compares the fingerprint
+		if (ours) {
+			metrics_count(METRICS_REQ_READ_ATTR, METRICS_OK);
+			slot_complete(slot);
+			d->state = DEVICE_STATE_DONE;
+			s_stats.refreshes++;
+		}
+		interview_pump();
+		return false;
+	}
+	if (ours) {
+		record_stage(LATENCY_BASIC_READ, &step);
+		metrics_count(METRICS_REQ_READ_ATTR, METRICS_OK);
+	}
+	if (verdict != INTERVIEW_VERDICT_NONE && basic_asked(d)) {
+		// Identified (a late answer to a timed-out read counts too): stop the interview
+		if (slot) {
+			latency_record(LATENCY_DETECT, latency_class_of(d), now_us() - step.annce_us);
+			slot_complete(slot);
+		} else {
+			queue_drop_device(dev);
+		}
+		d->state = DEVICE_STATE_DONE;
+		d->verdict = (uint8_t)verdict;
+		s_stats.classified++;
+		first = true;
+	} else if (ours) {
+		slot_complete(slot);
+		if (d->state != DEVICE_STATE_DONE) describe_next(d, &step);
+	}
+	interview_pump();
+	return first;
+}
+
+bool interview_refresh(device_entry_t *d)
+{
+	if (d->state != DEVICE_STATE_DONE || !d->report_ep) return false;
+	d->state = DEVICE_STATE_REFRESH;
+	// Behind the interviews of new devices
+	interview_step_t step = {.dev = device_table_index(d), .kind = STEP_READ_BASIC, .endpoint = d->report_ep};
+	if (!queue_push(&step, false)) return false;
+	interview_pump();
+	return true;
+}
+
+void interview_forget(device_entry_t *d)
+{
+	uint16_t dev = device_table_index(d);
+	queue_drop_device(dev);
+	interview_slot_t *slot = slot_for_device(dev);
+	// Its callback no longer matches a slot and is ignored
+	if (slot) slot_release(slot);
+	if (d->state == DEVICE_STATE_REFRESH) {
+		d->state = DEVICE_STATE_DONE;
+	} else if (d->state != DEVICE_STATE_DONE && d->state != DEVICE_STATE_FAILED) {
+		d->state = DEVICE_STATE_NEW;
+	}
+	interview_pump();
+}
+
+void interview_get_stats(interview_stats_t *out)
+{
+	s_stats.queue_depth = s_count;
+	*out = s_stats;
+}
@@ -0,0 +1,87 @@
+// Interview scheduler for joined devices
+// - Per-device state machine: ActiveEP -> SimpleDesc (one endpoint at a time) -> Basic read
+// - Stops as soon as the detection pipeline (classifier.h) reaches a verdict, after a SimpleDesc
+//   or the Basic read; classified IEEE addresses skip the interview
+// - Bounded in-flight window, timeouts and retry with backoff
+// - Runs entirely in the Zigbee task (ZDO callbacks and esp_zb_scheduler_alarm)
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device_table.h"
+
+// Maximum ZDO/ZCL interview requests outstanding at once
+#ifndef INTERVIEW_MAX_IN_FLIGHT
+#define INTERVIEW_MAX_IN_FLIGHT     (4)
+#endif
+// Pending interview steps that can be queued (at most one per device)
+#ifndef INTERVIEW_QUEUE_LEN
+#define INTERVIEW_QUEUE_LEN         (128)
+#endif
+// Time to wait for a response before retrying
+#ifndef INTERVIEW_TIMEOUT_MS
+#define INTERVIEW_TIMEOUT_MS        (2500)
+#endif
+// Retries per step; the delay doubles on each retry
+#ifndef INTERVIEW_MAX_RETRIES
+#define INTERVIEW_MAX_RETRIES       (3)
+#endif
+#ifndef INTERVIEW_BACKOFF_MS
+#define INTERVIEW_BACKOFF_MS        (250)
+#endif
+// Period of the housekeeping alarm while work is pending
+#ifndef INTERVIEW_TICK_MS
+#define INTERVIEW_TICK_MS           (50)
+#endif
+
+typedef enum {
+	INTERVIEW_VERDICT_NONE = 0,     // not identified (yet)
+	INTERVIEW_VERDICT_OTHER,        // manufacturer/model known, not a match
+	INTERVIEW_VERDICT_MATCH,        // IKEA TRÅDFRI
+} interview_verdict_t;
+
+typedef struct {
+	uint16_t queue_depth;       // steps waiting to be issued
+	uint16_t queue_peak;
+	uint8_t in_flight;
+	uint8_t in_flight_peak;
+	uint32_t issued;            // requests handed to the stack, retries included
+	uint32_t completed;
+	uint32_t retries;
+	uint32_t timeouts;          // no response within INTERVIEW_TIMEOUT_MS
+	uint32_t failures;          // error status reported by the stack
+	uint32_t dropped_queue_full;
+	uint32_t dropped_retries;   // gave up after INTERVIEW_MAX_RETRIES
+	uint32_t known;             // announces answered from an earlier classification
+	uint32_t duplicates;        // announces ignored because an interview was running
+	uint32_t classified;
+	uint32_t refreshes;         // firmware re-reads of classified devices answered
+} interview_stats_t;
+
+// A device classified by its descriptors, without the Basic read (the caller of a Basic read
+// response gets the verdict from interview_on_read_attr_resp instead)
+typedef void (*interview_classified_cb_t)(device_entry_t *dev, interview_verdict_t verdict, uint8_t endpoint);
+
+void interview_init(interview_classified_cb_t cb);
+
+// Handle a device announce (dev comes from device_table_upsert). Returns the verdict
+// straight away for a device that was already classified (no radio traffic); otherwise
+// queues the interview and returns INTERVIEW_VERDICT_NONE.
+interview_verdict_t interview_start(device_entry_t *dev);
+
+// Feed Basic cluster read responses back to the scheduler (from the ZCL action handler).
+// verdict is INTERVIEW_VERDICT_NONE when the response did not identify the device.
+// Returns true when this response classified the device for the first time.
+bool interview_on_read_attr_resp(uint16_t short_addr, uint8_t tsn, interview_verdict_t verdict);
+
+// Re-read the Basic firmware attributes of a classified device on its report endpoint, behind
+// any interview in progress. The response goes through interview_on_read_attr_resp as usual
+// (never a first classification); the device stays classified if it does not answer.
+bool interview_refresh(device_entry_t *dev);
+
+// Abandon whatever is queued or in flight for dev (it left, or lost its short address to another
+// device): answers still on their way are ignored. A classified device stays classified; one
+// in the middle of its interview starts over at its next announce.
+void interview_forget(device_entry_t *dev);
+
+void interview_get_stats(interview_stats_t *out);
@@ -0,0 +1,232 @@
+// Join window: permit join on demand, extended by joins, idle windows with exponential backoff
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "esp_zigbee_core.h"
+#include "nwk/esp_zigbee_nwk.h"
+#include "channel_survey.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "join_window.h"
+
+static const char *TAG = "ZB_SCAN";
+
+// The button's request waits this long for the Zigbee stack lock per try
+#define BUTTON_LOCK_WAIT_TICKS  (1)
+#define BUTTON_LOCK_TRIES       (50)
+
+static join_window_stats_t s_stats;
+static bool s_started;                  // network formed
+static bool s_open;
+static join_window_src_t s_window_src;  // what opened the current window
+static int64_t s_opened_us;
+static int64_t s_until_us;
+static uint32_t s_window_joins;
+static uint32_t s_idle_s = JOIN_WINDOW_IDLE_MIN_S;
+// Button debounce, ISR only
+static int64_t s_button_us;
+static bool s_button_seen;
+
+static const char *const s_src_names[JOIN_WINDOW_SRC_COUNT] = {
+	"formation", "button", "console", "survey", "idle", "join",
+};
+
+static void close_cb(uint8_t param);
+static void idle_cb(uint8_t param);
+
+const char *join_window_src_name(join_window_src_t src)
+{
+	return src < JOIN_WINDOW_SRC_COUNT ? s_src_names[src] : "?";
+}
+
+static void window_closed(void)
+{
+	esp_zb_scheduler_alarm_cancel(close_cb, 0);
+	s_open = false;
+	uint32_t open_s = (uint32_t)((esp_timer_get_time() - s_opened_us) / 1000000);
+	s_stats.open_us += (uint64_t)(esp_timer_get_time() - s_opened_us);
+	s_stats.windows++;
+	// Joins mean devices are being added: look again soon. An idle window nobody used means
+	// there is nobody waiting: look less often
+	if (s_window_joins) {
+		s_idle_s = JOIN_WINDOW_IDLE_MIN_S;
+	} else if (s_window_src == JOIN_WINDOW_SRC_IDLE) {
+		s_idle_s = s_idle_s * 2 < JOIN_WINDOW_IDLE_MAX_S ? s_idle_s * 2 : JOIN_WINDOW_IDLE_MAX_S;
+	}
+	if (JOIN_WINDOW_IDLE_S > 0) {
+		esp_zb_scheduler_alarm(idle_cb, 0, s_idle_s * 1000);
+		ESP_LOGI(TAG, "Join window closed after %lu s: %lu join(s); next idle window in %lu s",
+				 (unsigned long)open_s, (unsigned long)s_window_joins, (unsigned long)s_idle_s);
+	} else {
+		ESP_LOGI(TAG, "Join window closed after %lu s: %lu join(s)", (unsigned long)open_s,
+				 (unsigned long)s_window_joins);
+	}
+}
+
+static void close_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	if (s_open) window_closed();
+}
+
+static void idle_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	join_window_open(JOIN_WINDOW_SRC_IDLE, JOIN_WINDOW_IDLE_S);
+}
+
+bool join_window_open(join_window_src_t src, uint32_t seconds)
+{
+	if (!s_started) {
+		ESP_LOGW(TAG, "Join window (%s): no network yet", join_window_src_name(src));
+		return false;
+	}
+	// 255 would be "open until closed", which is what this module is here to avoid
+	if (seconds < 1) seconds = 1;
+	if (seconds > 254) seconds = 254;
+	int64_t now = esp_timer_get_time();
+	int64_t until = now + (int64_t)seconds * 1000000;
+	if (s_open && until <= s_until_us) return false;
+	esp_err_t err = esp_zb_bdb_open_network((uint8_t)seconds);
+	metrics_count(METRICS_REQ_PERMIT_JOIN, METRICS_ISSUED);
+	metrics_count(METRICS_REQ_PERMIT_JOIN, err == ESP_OK ? METRICS_OK : METRICS_FAILED);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Permit join broadcast (%s) failed: %s", join_window_src_name(src), esp_err_to_name(err));
+		return false;
+	}
+	s_stats.broadcasts++;
+	s_stats.by_source[src < JOIN_WINDOW_SRC_COUNT ? src : JOIN_WINDOW_SRC_CONSOLE]++;
+	bool extended = s_open;
+	if (!s_open) {
+		s_open = true;
+		s_window_src = src;
+		s_opened_us = now;
+		s_window_joins = 0;
+	}
+	s_until_us = until;
+	esp_zb_scheduler_alarm_cancel(idle_cb, 0);
+	esp_zb_scheduler_alarm_cancel(close_cb, 0);
+	esp_zb_scheduler_alarm(close_cb, 0, seconds * 1000);
+	ESP_LOGI(TAG, "Join window %s for %lu s (%s)", extended ? "extended" : "open", (unsigned long)seconds,
+			 join_window_src_name(src));
+	return true;
+}
+
+bool join_window_request(join_window_src_t src, uint32_t seconds)
+{
+	if (!esp_zb_lock_acquire(portMAX_DELAY)) return false;
+	bool ok = join_window_open(src, seconds);
+	esp_zb_lock_release();
+	return ok;
+}
+
+void join_window_note_join(void)
+{
+	if (!s_open) {
+		s_stats.joins_closed++;
+		return;
+	}
+	s_stats.joins++;
+	s_window_joins++;
+	// More devices of the same batch are likely on their way
+	if (s_until_us - esp_timer_get_time() < (int64_t)JOIN_WINDOW_EXTEND_S * 1000000 / 2) {
+		join_window_open(JOIN_WINDOW_SRC_JOIN, JOIN_WINDOW_EXTEND_S);
+	}
+}
+
+void join_window_on_permit_status(uint8_t seconds)
+{
+	// Our own alarm normally closes the window first; this catches the stack closing it early
+	if (seconds == 0 && s_open) window_closed();
+}
+
+static void open_pan_heard(uint8_t channel, uint16_t pan_id)
+{
+	if (pan_id == esp_zb_get_pan_id()) return;
+	if (join_window_open(JOIN_WINDOW_SRC_SURVEY, JOIN_WINDOW_SURVEY_S)) {
+		ESP_LOGI(TAG, "PAN 0x%04X on channel %u permits join: devices are being paired nearby", pan_id, channel);
+	}
+}
+
+void join_window_start(bool formed)
+{
+	s_started = true;
+	if (JOIN_WINDOW_ON_OPEN_PAN) channel_survey_set_open_pan_cb(open_pan_heard);
+	if (formed) {
+		join_window_open(JOIN_WINDOW_SRC_FORMATION, JOIN_WINDOW_FORMATION_S);
+	} else if (JOIN_WINDOW_IDLE_S > 0) {
+		// Resumed: the devices are still joined, nothing to open for until the idle schedule
+		esp_zb_scheduler_alarm(idle_cb, 0, s_idle_s * 1000);
+	}
+}
+
+void join_window_get_stats(join_window_stats_t *out)
+{
+	*out = s_stats;
+	out->open = s_open;
+	out->idle_interval_s = s_idle_s;
+	out->remaining_s = 0;
+	if (s_open) {
+		int64_t now = esp_timer_get_time();
+		out->open_us += (uint64_t)(now - s_opened_us);
+		out->remaining_s = s_until_us > now ? (uint32_t)((s_until_us - now + 999999) / 1000000) : 0;
+	}
+}
+
+// Timer task: the Zigbee stack lock may be held, which an ISR cannot wait for. The timer task
+// also runs the metrics sampler and the LED timers, so it waits a tick at most
+// and queues the press again while the stack is busy
+static void button_pressed(void *arg, uint32_t tries)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)arg;
+	if (esp_zb_lock_acquire(BUTTON_LOCK_WAIT_TICKS)) {
+		join_window_open(JOIN_WINDOW_SRC_BUTTON, JOIN_WINDOW_DEMAND_S);
+		esp_zb_lock_release();
+	} else if (tries + 1 >= BUTTON_LOCK_TRIES || xTimerPendFunctionCall(button_pressed, NULL, tries + 1, 0) != pdPASS) {
+		ESP_LOGW(TAG, "Join button: Zigbee stack busy, press again");
+	}
+}
+
+static void IRAM_ATTR button_isr(void *arg)
+{
+	(void)arg;
+	int64_t now = esp_timer_get_time();
+	if (s_button_seen && now - s_button_us < JOIN_WINDOW_BUTTON_DEBOUNCE_US) return;
+	s_button_seen = true;
+	s_button_us = now;
+	BaseType_t woken = pdFALSE;
+	xTimerPendFunctionCallFromISR(button_pressed, NULL, 0, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+esp_err_t join_window_init(void)
+{
+	if (JOIN_WINDOW_BUTTON_GPIO < 0) return ESP_OK;
+	gpio_config_t io = {
+		.pin_bit_mask = 1ULL << JOIN_WINDOW_BUTTON_GPIO,
+		.mode = GPIO_MODE_INPUT,
+		.pull_up_en = GPIO_PULLUP_ENABLE,
+		.pull_down_en = GPIO_PULLDOWN_DISABLE,
+		.intr_type = GPIO_INTR_NEGEDGE,
+	};
+	esp_err_t err = gpio_config(&io);
+	if (err == ESP_OK) {
+		err = gpio_install_isr_service(0);
+		if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;
+	}
+	if (err == ESP_OK) err = gpio_isr_handler_add(JOIN_WINDOW_BUTTON_GPIO, button_isr, NULL);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Failed to configure join button on GPIO %d: %s", JOIN_WINDOW_BUTTON_GPIO, esp_err_to_name(err));
+		return err;
+	}
+	ESP_LOGI(TAG, "Join button on GPIO %d: opens the network for %u s", JOIN_WINDOW_BUTTON_GPIO, JOIN_WINDOW_DEMAND_S);
+	return ESP_OK;
+}
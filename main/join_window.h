@@ -0,0 +1,143 @@
+// Join window: permit join opened on demand instead of kept open by periodic steering
+// - Opened after formation (not when the network is resumed after a reset), by the join
+//   button, by the `join` console command, and when the channel survey hears another PAN
+//   permitting join (devices are being paired nearby)
+// - A join extends the open window, so a batch of devices pairs in one window
+// - While idle, a short window still opens now and then for devices powered on without a
+//   button press; the gap doubles after each window without joins, up to JOIN_WINDOW_IDLE_MAX_S
+//   (4 min), and falls back to the minimum after a window with joins. Such a device can wait
+//   that long to join: the button (or `join`) is the way to pair one within seconds.
+//   JOIN_WINDOW_MOSTLY_OPEN (opt-in) trades that for long idle windows with short gaps, which
+//   keep the network open most of the time
+// - One permit-join broadcast per window or extension, counted with the joins per window
+// - join_window_open() runs in the Zigbee task; join_window_request() is for other tasks
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+// Kconfig: Zigbee scanner -> Join window
+// Window opened by the button or the console
+#ifndef JOIN_WINDOW_DEMAND_S
+#ifdef CONFIG_ZB_SCAN_JOIN_WINDOW_S
+#define JOIN_WINDOW_DEMAND_S            (CONFIG_ZB_SCAN_JOIN_WINDOW_S)
+#else
+#define JOIN_WINDOW_DEMAND_S            (120)
+#endif
+#endif
+// Idle profile: the default back-off, or (opt-in) the network open most of the time. Only the
+// defaults of the three options below depend on it
+#ifndef JOIN_WINDOW_MOSTLY_OPEN
+#ifdef CONFIG_ZB_SCAN_JOIN_MOSTLY_OPEN
+#define JOIN_WINDOW_MOSTLY_OPEN         (true)
+#else
+#define JOIN_WINDOW_MOSTLY_OPEN         (false)
+#endif
+#endif
+// Window opened while idle; 0 disables idle windows
+#ifndef JOIN_WINDOW_IDLE_S
+#ifdef CONFIG_ZB_SCAN_JOIN_IDLE_WINDOW_S
+#define JOIN_WINDOW_IDLE_S              (CONFIG_ZB_SCAN_JOIN_IDLE_WINDOW_S)
+#else
+#define JOIN_WINDOW_IDLE_S              (JOIN_WINDOW_MOSTLY_OPEN ? 240 : 30)
+#endif
+#endif
+// Gap between idle windows: starts at the minimum, doubles while nobody joins. A bulb powered
+// on in a gap without any trigger waits for the next window, up to the maximum
+#ifndef JOIN_WINDOW_IDLE_MIN_S
+#ifdef CONFIG_ZB_SCAN_JOIN_IDLE_MIN_S
+#define JOIN_WINDOW_IDLE_MIN_S          (CONFIG_ZB_SCAN_JOIN_IDLE_MIN_S)
+#else
+#define JOIN_WINDOW_IDLE_MIN_S          (JOIN_WINDOW_MOSTLY_OPEN ? 10 : 60)
+#endif
+#endif
+#ifndef JOIN_WINDOW_IDLE_MAX_S
+#ifdef CONFIG_ZB_SCAN_JOIN_IDLE_MAX_S
+#define JOIN_WINDOW_IDLE_MAX_S          (CONFIG_ZB_SCAN_JOIN_IDLE_MAX_S)
+#else
+#define JOIN_WINDOW_IDLE_MAX_S          (JOIN_WINDOW_MOSTLY_OPEN ? 20 : 240)
+#endif
+#endif
+// Button (active low, internal pull-up) opening a window; -1 for none. GPIO 9 is the BOOT
+// button of the ESP32-C6 DevKit
+#ifndef JOIN_WINDOW_BUTTON_GPIO
+#ifdef CONFIG_ZB_SCAN_JOIN_BUTTON_GPIO
+#define JOIN_WINDOW_BUTTON_GPIO         (CONFIG_ZB_SCAN_JOIN_BUTTON_GPIO)
+#else
+#define JOIN_WINDOW_BUTTON_GPIO         (9)
+#endif
+#endif
+#ifndef JOIN_WINDOW_BUTTON_DEBOUNCE_US
+#define JOIN_WINDOW_BUTTON_DEBOUNCE_US  (200 * 1000)
+#endif
+// Open when the survey hears another PAN permitting join
+#ifndef JOIN_WINDOW_ON_OPEN_PAN
+#ifdef CONFIG_ZB_SCAN_JOIN_ON_OPEN_PAN
+#define JOIN_WINDOW_ON_OPEN_PAN         (true)
+#else
+#define JOIN_WINDOW_ON_OPEN_PAN         (false)
+#endif
+#endif
+#ifndef JOIN_WINDOW_FORMATION_S
+#define JOIN_WINDOW_FORMATION_S         (180)   // what BDB steering used to open
+#endif
+#ifndef JOIN_WINDOW_SURVEY_S
+#define JOIN_WINDOW_SURVEY_S            (60)
+#endif
+// After a join the window stays open at least this long; it is rebroadcast only once less
+// than half of it is left, so a join storm costs a handful of broadcasts
+#ifndef JOIN_WINDOW_EXTEND_S
+#define JOIN_WINDOW_EXTEND_S            (60)
+#endif
+
+// What opened or extended a window
+typedef enum {
+	JOIN_WINDOW_SRC_FORMATION = 0,
+	JOIN_WINDOW_SRC_BUTTON,
+	JOIN_WINDOW_SRC_CONSOLE,
+	JOIN_WINDOW_SRC_SURVEY,
+	JOIN_WINDOW_SRC_IDLE,
+	JOIN_WINDOW_SRC_JOIN,
+	JOIN_WINDOW_SRC_COUNT,
+} join_window_src_t;
+
+typedef struct {
+	uint32_t broadcasts;                        // permit-join broadcasts sent
+	uint32_t by_source[JOIN_WINDOW_SRC_COUNT];  // broadcasts by what asked for them
+	uint32_t windows;                           // windows closed
+	uint32_t joins;                             // device announcements while open
+	uint32_t joins_closed;                      // announcements while closed (rejoins)
+	uint32_t idle_interval_s;                   // wait before the next idle window
+	uint32_t remaining_s;                       // left in the open window, 0 when closed
+	uint64_t open_us;                           // total time open, current window included
+	bool open;
+} join_window_stats_t;
+
+// Configure the join button (installs the GPIO ISR service). Call once at boot.
+esp_err_t join_window_init(void);
+
+// The network is up: open the first window if it was just formed, and start the idle schedule
+// (Zigbee task)
+void join_window_start(bool formed);
+
+// Open the window for `seconds` (1..254) from now, or extend an open one to that. Returns
+// false when nothing was broadcast: an open window already lasts longer, or there is no
+// network yet. Zigbee task only.
+bool join_window_open(join_window_src_t src, uint32_t seconds);
+
+// join_window_open() from any other task, under the Zigbee stack lock. Waits for the lock: not
+// for the timer task, whose other timers would stall meanwhile
+bool join_window_request(join_window_src_t src, uint32_t seconds);
+
+// A device announced itself (ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE)
+void join_window_note_join(void);
+
+// ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS: the stack reports the permit-join duration
+void join_window_on_permit_status(uint8_t seconds);
+
+// Zigbee task, or with the stack lock held
+void join_window_get_stats(join_window_stats_t *out);
+
+const char *join_window_src_name(join_window_src_t src);
@@ -0,0 +1,123 @@
+// Hot-path latency histograms
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "latency.h"
+
+static latency_hist_t s_hist[LATENCY_STAGE_COUNT][LATENCY_CLASS_COUNT];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const s_stage_names[LATENCY_STAGE_COUNT] = {
+	"annce->active_ep", "simple_desc", "basic_read", "annce->verdict", "alert_output",
+	"cpu:annce", "cpu:active_ep_cb", "cpu:simple_desc_cb", "cpu:read_resp",
+};
+
+static const char *const s_class_names[LATENCY_CLASS_COUNT] = { "router", "end_device", "other" };
+
+static unsigned bucket_of(uint32_t v)
+{
+	unsigned b = v ? 31u - (unsigned)__builtin_clz(v) : 0;
+	return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+}
+
+latency_class_t latency_class_of(const device_entry_t *dev)
+{
+	if (!dev) return LATENCY_CLASS_OTHER;
+	return (dev->flags & DEVICE_FLAG_ROUTER) ? LATENCY_CLASS_ROUTER : LATENCY_CLASS_END_DEVICE;
+}
+
+void latency_record(latency_stage_t stage, latency_class_t cls, uint32_t value)
+{
+	if (stage >= LATENCY_STAGE_COUNT || cls >= LATENCY_CLASS_COUNT) return;
+	latency_hist_t *h = &s_hist[stage][cls];
+	unsigned b = bucket_of(value);
+	portENTER_CRITICAL(&s_lock);
+	h->count++;
+	h->sum += value;
+	if (value > h->max) h->max = value;
+	h->buckets[b]++;
+	portEXIT_CRITICAL(&s_lock);
+}
+
+void latency_get(latency_stage_t stage, latency_class_t cls, latency_hist_t *out)
+{
+	if (stage >= LATENCY_STAGE_COUNT || cls >= LATENCY_CLASS_COUNT) {
+		memset(out, 0, sizeof(*out));
+		return;
+	}
+	portENTER_CRITICAL(&s_lock);
+	*out = s_hist[stage][cls];
+	portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t latency_percentile(const latency_hist_t *h, uint32_t pct)
+{
+	if (!h->count) return 0;
+	uint64_t rank = ((uint64_t)h->count * pct + 99) / 100;
+	if (rank == 0) rank = 1;
+	uint64_t seen = 0;
+	for (unsigned b = 0; b < LATENCY_BUCKETS; b++) {
+		seen += h->buckets[b];
+		if (seen >= rank) {
+			uint32_t upper = (uint32_t)((2ull << b) - 1);
+			return upper < h->max ? upper : h->max;
+		}
+	}
+	return h->max;
+}
+
+bool latency_stage_is_cycles(latency_stage_t stage)
+{
+	return stage >= LATENCY_CPU_ANNCE;
+}
+
+const char *latency_stage_name(latency_stage_t stage)
+{
+	return stage < LATENCY_STAGE_COUNT ? s_stage_names[stage] : "?";
+}
+
+const char *latency_class_name(latency_class_t cls)
+{
+	return cls < LATENCY_CLASS_COUNT ? s_class_names[cls] : "?";
+}
+
+// Microseconds with one decimal, from either unit
+static void print_us(const char *label, uint64_t v, bool cycles)
+{
+	uint64_t tenths = cycles ? v * 10 / LATENCY_CPU_MHZ : v * 10;
+	printf(" %s=%llu.%u", label, (unsigned long long)(tenths / 10), (unsigned)(tenths % 10));
+}
+
+void latency_dump(void)
+{
+	latency_hist_t h;
+	bool any = false;
+	for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+		bool cycles = latency_stage_is_cycles((latency_stage_t)s);
+		for (int c = 0; c < LATENCY_CLASS_COUNT; c++) {
+			latency_get((latency_stage_t)s, (latency_class_t)c, &h);
+			if (!h.count) continue;
+			any = true;
+			printf("%-18s %-10s n=%lu", s_stage_names[s], s_class_names[c], (unsigned long)h.count);
+			print_us("mean", h.sum / h.count, cycles);
+			print_us("p50", latency_percentile(&h, 50), cycles);
+			print_us("p90", latency_percentile(&h, 90), cycles);
+			print_us("p99", latency_percentile(&h, 99), cycles);
+			print_us("max", h.max, cycles);
+			printf(" us\n  %s log2:", cycles ? "cycles" : "us");
+			for (unsigned b = 0; b < LATENCY_BUCKETS; b++) {
+				if (h.buckets[b]) printf(" %u:%lu", b, (unsigned long)h.buckets[b]);
+			}
+			printf("\n");
+		}
+	}
+	if (!any) printf("no latency samples yet\n");
+}
+
+void latency_reset(void)
+{
+	portENTER_CRITICAL(&s_lock);
+	memset(s_hist, 0, sizeof(s_hist));
+	portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,76 @@
+// Hot-path latency: log2 histograms per detection stage and device class
+// - Stage latencies are microseconds between two points of the announce -> ActiveEP ->
+//   SimpleDesc -> Basic read -> alert chain, queueing, retries and air time included
+// - Handler costs are CPU cycles spent inside the Zigbee callbacks of that chain
+// - Bucket b holds samples in [2^b, 2^(b+1)), bucket 0 also holds 0 and the last bucket
+//   everything above; percentiles are reported as bucket upper bounds
+// - Recording is a handful of instructions under a spinlock, from any task
+// - Built for the host too: there esp_timer is the simulator's clock and the cycle counter is
+//   host CPU time plus the modelled driver costs, both at LATENCY_CPU_MHZ
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_cpu.h"
+#include "device_table.h"
+
+#ifndef LATENCY_BUCKETS
+#define LATENCY_BUCKETS             (24)    // up to 8.4 s, or 8.4 M cycles
+#endif
+// Converts handler cycles to microseconds in the dump
+#ifndef LATENCY_CPU_MHZ
+#ifdef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define LATENCY_CPU_MHZ             (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#else
+#define LATENCY_CPU_MHZ             (160)
+#endif
+#endif
+
+typedef enum {
+	LATENCY_ACTIVE_EP,              // announce -> ActiveEP response (us)
+	LATENCY_SIMPLE_DESC,            // previous response -> SimpleDesc response (us)
+	LATENCY_BASIC_READ,             // SimpleDesc response -> Basic read response (us)
+	LATENCY_DETECT,                 // announce -> verdict (us)
+	LATENCY_ALERT_OUTPUT,           // alert posted -> LED and buzzer on, in the actuator task (us)
+	LATENCY_CPU_ANNCE,              // device announce signal handler (cycles)
+	LATENCY_CPU_ACTIVE_EP,          // ActiveEP callback (cycles)
+	LATENCY_CPU_SIMPLE_DESC,        // SimpleDesc callback (cycles)
+	LATENCY_CPU_READ_RESP,          // ZCL action handler on a Basic read response (cycles)
+	LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+typedef enum {
+	LATENCY_CLASS_ROUTER,           // announced as a router (mains powered, always listening)
+	LATENCY_CLASS_END_DEVICE,       // end device, possibly sleepy: answers when it polls its parent
+	LATENCY_CLASS_OTHER,            // not tied to a device (alert output) or not in the device table
+	LATENCY_CLASS_COUNT,
+} latency_class_t;
+
+typedef struct {
+	uint32_t count;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+// Timestamp for LATENCY_CPU_* samples
+static inline uint32_t latency_cycles(void)
+{
+	return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+latency_class_t latency_class_of(const device_entry_t *dev);
+
+void latency_record(latency_stage_t stage, latency_class_t cls, uint32_t value);
+
+void latency_get(latency_stage_t stage, latency_class_t cls, latency_hist_t *out);
+// Upper bound of the bucket holding the pct-th percentile, capped at the maximum seen
+uint32_t latency_percentile(const latency_hist_t *h, uint32_t pct);
+bool latency_stage_is_cycles(latency_stage_t stage);
+const char *latency_stage_name(latency_stage_t stage);
+const char *latency_class_name(latency_class_t cls);
+
+// Print every non-empty histogram to the console (`latency` command), times in microseconds
+void latency_dump(void);
+void latency_reset(void);
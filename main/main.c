@@ -1,17 +1,26 @@
 // Zigbee Coordinator example for ESP32-C6
-// - Start the Zigbee stack in no-autostart mode
-// - Form a network (BDB network formation) and open it for joining
-// - Detect devices that join and raise an alert if they are IKEA TRÅDFRI
+// - Start the Zigbee stack in no-autostart mode, first thing at boot, and bring up the
+//   peripherals while it starts
+// - Resume the network kept in zb_storage after a reset: same PAN, channel and keys, the
+//   devices stay joined
+// - Otherwise survey the channels, then form a network (BDB network formation) on the
+//   quietest ones and open it for joining
+// - Detect devices that join and raise an alert if they are IKEA TRÅDFRI, from their IEEE address,
+//   descriptors or Basic strings, whichever decides first (classifier.c)
+// - Keep track of classified devices from their attribute reports instead of querying them again
+// - Follow devices by IEEE address across leaves, rejoins and short address changes
+// - Tasks, timers and tables statically allocated: the app's own code allocates nothing after
+//   start-up, what the stack and ESP-IDF allocate is counted apart (heap_guard.c)
+// - Stream joins, verdicts and alerts to a host gateway in CRC-checked binary frames over a UART
+//   (gateway_link.c)
 
 #include <stdio.h>
 #include <string.h>
-#include <ctype.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
-#include "driver/gpio.h"
-#include "driver/ledc.h"
 
 #include "esp_zigbee_core.h"
 #include "platform/esp_zigbee_platform.h"
@@ -21,291 +30,240 @@
 #include "nwk/esp_zigbee_nwk.h"
 // HA utilities to create a minimal local endpoint
 #include "ha/esp_zigbee_ha_standard.h"
-// On-board RGB LED (WS2812) driven via RMT
-#include "led_strip.h"
-#include "freertos/timers.h"
+
+#include "device_table.h"
+#include "heap_guard.h"
+#include "interview.h"
+#include "classifier.h"
+#include "zcl_attr.h"
+#include "device_cache.h"
+#include "actuator.h"
+#include "trigger_input.h"
+#include "channel_survey.h"
+#include "channel_select.h"
+#include "join_window.h"
+#include "console_cmds.h"
+#include "topology.h"
+#include "event_log.h"
+#include "gateway_link.h"
+#include "latency.h"
+#include "metrics.h"
+#include "presence.h"
+#include "address.h"
 
 static const char *TAG = "ZB_SCAN";
 
 // Channel mask: channels 11..26
 #define ZB_SCAN_CHANNEL_MASK  (0x07FFF800)
-// Scan duration (beacon intervals): time per channel = ((1<<d)+1) * 15.36 ms
-// For occasional ZDO scans (optional)
-#define ZB_SCAN_DURATION      (4)  // ~ (16+1)*15.36ms ≈ 261 ms per channel
-
-// Assumption: the board has a WS2812 RGB LED on GPIO 8 (ESP32-C6 DevKitC)
-#ifndef BOARD_RGB_LED_GPIO
-#define BOARD_RGB_LED_GPIO     (8)
-#endif
-// Active buzzer on GPIO 10 (logic high = ON)
-#ifndef BUZZER_GPIO
-#define BUZZER_GPIO            (10)
-#endif
-
-// Pin for simulating bulb detection (HIGH = trigger alarm)
-#ifndef SIMULATION_PIN
-#define SIMULATION_PIN          (11)
-#endif
-
-// Alert duration (LED red + active buzzer) in milliseconds
-#ifndef ALERT_DURATION_MS
-#define ALERT_DURATION_MS       (10 * 1000) // 10 seconds
-#endif
-
-// Active buzzer volume percentage (0..100). Implemented with LEDC PWM
-#ifndef BUZZER_VOLUME_PCT
-#define BUZZER_VOLUME_PCT       (100)
-#endif
-
-// PWM configuration for the buzzer
-#ifndef BUZZER_PWM_FREQ_HZ
-#define BUZZER_PWM_FREQ_HZ      (2000) // 2 kHz (more audible for some buzzers)
+// Zigbee task stack, bytes
+#define ZB_TASK_STACK         (7168)
+
+// Stack tables (Kconfig: Zigbee scanner -> Network size)
+#ifdef CONFIG_ZB_SCAN_MAX_CHILDREN
+#define ZB_SCAN_MAX_CHILDREN  (CONFIG_ZB_SCAN_MAX_CHILDREN)
+#else
+#define ZB_SCAN_MAX_CHILDREN  (32)
 #endif
-#ifndef BUZZER_LEDC_MODE
-#define BUZZER_LEDC_MODE        LEDC_LOW_SPEED_MODE
+#ifdef CONFIG_ZB_SCAN_NETWORK_SIZE
+#define ZB_SCAN_NETWORK_SIZE  (CONFIG_ZB_SCAN_NETWORK_SIZE)
+#else
+#define ZB_SCAN_NETWORK_SIZE  (300)
 #endif
-#ifndef BUZZER_LEDC_TIMER
-#define BUZZER_LEDC_TIMER       LEDC_TIMER_0
+#ifdef CONFIG_ZB_SCAN_IO_BUFFERS
+#define ZB_SCAN_IO_BUFFERS    (CONFIG_ZB_SCAN_IO_BUFFERS)
+#else
+#define ZB_SCAN_IO_BUFFERS    (80)
 #endif
-#ifndef BUZZER_LEDC_CHANNEL
-#define BUZZER_LEDC_CHANNEL     LEDC_CHANNEL_0
+// Drop the network kept in zb_storage and form a new one at every boot (Kconfig: Zigbee scanner)
+#ifdef CONFIG_ZB_SCAN_FORM_AT_BOOT
+#define ZB_SCAN_FORM_AT_BOOT    (true)
+#else
+#define ZB_SCAN_FORM_AT_BOOT    (false)
 #endif
-#ifndef BUZZER_LEDC_DUTY_RES
-#define BUZZER_LEDC_DUTY_RES    LEDC_TIMER_10_BIT // 10 bits -> 1023 max
-#endif
-
-static led_strip_handle_t s_led_strip = NULL;
-static TimerHandle_t s_led_timer = NULL; // timer to return to green after the configured duration
-static TimerHandle_t s_buzzer_timer = NULL; // buzzer blink timer during alert
-static volatile bool s_buzzer_state = false;
-static uint32_t s_buzzer_on_duty = 0;       // duty for the configured volume
-
-// Track devices already alerted to avoid duplicates
-static uint16_t s_alerted[16];
-static uint8_t s_alerted_count = 0;
-static uint8_t s_alerted_wr_idx = 0;
+// Retries of a failed network restore or formation: the delay doubles up to the maximum, and the
+// restore failures after which an error is logged. zb_storage is only erased at the console
+// (factory_reset)
+#define ZB_SCAN_RESUME_RETRY_MS     (1000)
+#define ZB_SCAN_RESUME_RETRY_MAX_MS (5 * 60 * 1000)
+#define ZB_SCAN_RESUME_TRIES        (5)
+#define ZB_SCAN_FORM_RETRY_MS       (3000)
+#define ZB_SCAN_FORM_RETRY_MAX_MS   (60 * 1000)
+
+// Zigbee task, statically allocated like the app's other tasks: no heap is spent on it
+static StackType_t s_zb_task_stack[ZB_TASK_STACK];
+static StaticTask_t s_zb_task_tcb;
+// Start-up steps that run in parallel: the network comes up in the Zigbee task while app_main
+// sets up the peripherals, console and metrics, and either may finish last
+static portMUX_TYPE s_startup_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_startup_network;
+static bool s_startup_app_main;
+static uint16_t s_resume_failures;
+static uint16_t s_form_failures;
 
-// Simulation flag to avoid multiple alerts
-static bool s_simulation_alerted = false;
-
-static void zb_start_active_scan(uint8_t param);
-static void try_read_basic_attrs(uint16_t nwk_addr, uint8_t endpoint);
-static void active_ep_cb(esp_zb_zdp_status_t zdo_status, uint8_t ep_count, uint8_t *ep_id_list, void *user_ctx);
-static void simple_desc_cb(esp_zb_zdp_status_t zdo_status, esp_zb_af_simple_desc_1_1_t *simple_desc, void *user_ctx);
 static esp_err_t zcl_action_handler(esp_zb_core_action_callback_id_t cb_id, const void *message);
-static void reopen_steering_cb(uint8_t param);
-static void simulation_check_cb(TimerHandle_t xTimer);
+static void formation_survey_done(bool ok);
 
-static bool contains_word_ci(const char *haystack, const char *needle)
+static void log_alert(const uint8_t ieee[8], uint16_t short_addr, uint8_t endpoint, uint8_t source)
 {
-    if (!haystack || !needle) return false;
-    size_t nlen = strlen(needle);
-    if (nlen == 0) return true;
-    for (const char *p = haystack; *p; ++p) {
-        size_t i = 0;
-        while (i < nlen && p[i] && (char)tolower((unsigned char)p[i]) == (char)tolower((unsigned char)needle[i])) {
-            i++;
-        }
-        if (i == nlen) return true;
-    }
-    return false;
+	evlog_alert_t a = { .short_addr = short_addr, .endpoint = endpoint, .source = source };
+	event_log_write(EVLOG_ALERT, &a, sizeof(a));
+	gateway_link_alert(ieee, short_addr, endpoint, source);
 }
 
-static void led_set_rgb(uint8_t r, uint8_t g, uint8_t b)
+// Avoid alerting twice for the same device (tracked per IEEE address in the device table)
+static bool mark_alerted(device_entry_t *dev)
 {
-	if (!s_led_strip) return;
-	// Set color of the first pixel and refresh
-	// Some WS2812 boards use GRB order; swap R<->G to correct colors
-	(void)led_strip_set_pixel(s_led_strip, 0, g, r, b);
-	(void)led_strip_refresh(s_led_strip);
+	if (!dev || (dev->flags & DEVICE_FLAG_ALERTED)) return false;
+	dev->flags |= DEVICE_FLAG_ALERTED;
+	return true;
 }
 
-static void led_timer_cb(TimerHandle_t xTimer)
+// A device classified on this join, by the announce classifiers, its descriptors or its Basic
+// read: remember it, follow its reports and alert on a match. Strings are NULL when the verdict
+// came before the Basic read.
+static void device_classified(device_entry_t *dev, interview_verdict_t verdict, uint8_t endpoint,
+							  const zcl_attr_view_t *manuf, const zcl_attr_view_t *model)
 {
-	(void)xTimer;
-	// Return to green (idle)
-	led_set_rgb(0, 255, 0);
-	// Active buzzer: turn off PWM (duty 0)
-	(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, 0);
-	(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
-	// Stop buzzer blink
-	if (s_buzzer_timer) {
-		xTimerStop(s_buzzer_timer, 0);
+	device_cache_put(dev->ieee, manuf ? manuf->str : "", manuf ? manuf->len : 0, model ? model->str : "",
+					 model ? model->len : 0, verdict);
+	gateway_link_verdict(dev->ieee, dev->short_addr, verdict, GWLINK_VERDICT_INTERVIEW, model ? model->str : NULL,
+						 model ? model->len : 0);
+	presence_on_classified(dev);
+	if (verdict != INTERVIEW_VERDICT_MATCH) return;
+	actuator_post_alert(dev->short_addr, endpoint);
+	log_alert(dev->ieee, dev->short_addr, endpoint, EVLOG_ALERT_INTERVIEW);
+	if (mark_alerted(dev)) {
+		ESP_LOGW(TAG, "ALERT: IKEA TRÅDFRI bulb detected (0x%04X ep%u)", dev->short_addr, endpoint);
 	}
-	// Reset simulation flag to allow re-triggering
-	s_simulation_alerted = false;
 }
 
-static void led_init(void)
+static void interview_classified(device_entry_t *dev, interview_verdict_t verdict, uint8_t endpoint)
 {
-	// Configure LED strip device with RMT
-	led_strip_config_t strip_config = {
-		.strip_gpio_num = BOARD_RGB_LED_GPIO,
-		.max_leds = 1,
-		.led_model = LED_MODEL_WS2812,
-		.flags.invert_out = false,
-	};
-	led_strip_rmt_config_t rmt_config = {
-		.resolution_hz = 10 * 1000 * 1000, // 10MHz
-		.flags.with_dma = false,
-	};
-	esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &s_led_strip);
-	if (err != ESP_OK) {
-		ESP_LOGW(TAG, "Failed to initialize RGB LED (gpio=%d): %s", BOARD_RGB_LED_GPIO, esp_err_to_name(err));
-		s_led_strip = NULL;
-		return;
-	}
-	(void)led_strip_clear(s_led_strip);
-	// Create one-shot timer with the configured alert duration
-	s_led_timer = xTimerCreate("led_to_green", pdMS_TO_TICKS(ALERT_DURATION_MS), pdFALSE, NULL, led_timer_cb);
-	if (s_led_timer == NULL) {
-		ESP_LOGW(TAG, "Failed to create LED timer");
-	}
-	// Idle state: green
-	led_set_rgb(0, 255, 0);
+	device_classified(dev, verdict, endpoint, NULL, NULL);
 }
 
-static void buzzer_init(void)
+// Verdict a device already had at its current short address: from the persistent cache when it
+// was classified in an earlier run, from the device table when in this one (no radio traffic
+// either way). Otherwise the announce classifiers may classify it on the spot (handled here, and
+// NONE is returned), or ActiveEP -> SimpleDesc -> Basic read starts, throttled by the interview
+// scheduler.
+static interview_verdict_t identify(device_entry_t *dev, const uint8_t ieee[8], uint16_t short_addr,
+									uint8_t capability)
 {
-	// Configure LEDC for PWM on the buzzer GPIO
-	ledc_timer_config_t tcfg = {
-		.speed_mode = BUZZER_LEDC_MODE,
-		.duty_resolution = BUZZER_LEDC_DUTY_RES,
-		.timer_num = BUZZER_LEDC_TIMER,
-		.freq_hz = BUZZER_PWM_FREQ_HZ,
-		.clk_cfg = LEDC_AUTO_CLK,
-	};
-	esp_err_t err = ledc_timer_config(&tcfg);
-	if (err != ESP_OK) {
-		ESP_LOGW(TAG, "LEDC timer config failed: %s", esp_err_to_name(err));
-	}
-	ledc_channel_config_t ccfg = {
-		.gpio_num = BUZZER_GPIO,
-		.speed_mode = BUZZER_LEDC_MODE,
-		.channel = BUZZER_LEDC_CHANNEL,
-		.intr_type = LEDC_INTR_DISABLE,
-		.timer_sel = BUZZER_LEDC_TIMER,
-		.duty = 0,
-		.hpoint = 0,
-		.flags = { .output_invert = 0 },
-	};
-	err = ledc_channel_config(&ccfg);
-	if (err != ESP_OK) {
-		ESP_LOGW(TAG, "LEDC channel config failed: %s", esp_err_to_name(err));
+	interview_verdict_t verdict = device_cache_lookup(ieee);
+	if (verdict == INTERVIEW_VERDICT_NONE) {
+		if (!dev) return verdict;
+		if (dev->state == DEVICE_STATE_NEW || dev->state == DEVICE_STATE_FAILED) {
+			interview_verdict_t now = classifier_on_annce(dev, capability);
+			if (now != INTERVIEW_VERDICT_NONE) {
+				dev->state = DEVICE_STATE_DONE;
+				dev->verdict = (uint8_t)now;
+				device_classified(dev, now, 0, NULL, NULL);
+				return INTERVIEW_VERDICT_NONE;
+			}
+		}
+		verdict = interview_start(dev);
+	} else {
+		ESP_LOGI(TAG, "0x%04X found in device cache: skipping interview", short_addr);
+		gateway_link_verdict(ieee, short_addr, verdict, GWLINK_VERDICT_CACHE, NULL, 0);
+		// Classified in an earlier run: presence.c may re-read its firmware once it reports
+		if (dev && dev->state == DEVICE_STATE_NEW) {
+			dev->state = DEVICE_STATE_DONE;
+			dev->verdict = (uint8_t)verdict;
+		}
 	}
-	// Compute duty for the configured volume
-	uint32_t max_duty = (1U << (int)BUZZER_LEDC_DUTY_RES) - 1U;
-	uint32_t pct = (BUZZER_VOLUME_PCT > 100) ? 100 : BUZZER_VOLUME_PCT;
-	s_buzzer_on_duty = (max_duty * pct) / 100U;
-	// Ensure initial OFF
-	(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, 0);
-	(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
+	return verdict;
 }
 
-static void buzzer_toggle_cb(TimerHandle_t xTimer)
+// A device heard from without an announce (address.c resolved its IEEE address). It did not
+// just join: alert once per run only
+static void device_resolved(device_entry_t *dev)
 {
-	(void)xTimer;
-	s_buzzer_state = !s_buzzer_state;
-	if (s_buzzer_state) {
-		(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, s_buzzer_on_duty);
-		(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
-	} else {
-		(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, 0);
-		(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
+	if (identify(dev, dev->ieee, dev->short_addr, 0) == INTERVIEW_VERDICT_MATCH && mark_alerted(dev)) {
+		actuator_post_alert(dev->short_addr, 0);
+		log_alert(dev->ieee, dev->short_addr, 0, EVLOG_ALERT_CACHE);
+		ESP_LOGW(TAG, "ALERT: IKEA TRÅDFRI bulb detected (0x%04X, known device)", dev->short_addr);
 	}
 }
 
-static void buzzer_timer_create(void)
+static void startup_step_done(bool *step)
 {
-	// Periodic timer for 2 Hz blink (toggle every 250 ms)
-	if (!s_buzzer_timer) {
-		s_buzzer_timer = xTimerCreate("buzz_tgl", pdMS_TO_TICKS(250), pdTRUE, NULL, buzzer_toggle_cb);
-	}
+	portENTER_CRITICAL(&s_startup_lock);
+	*step = true;
+	bool done = s_startup_network && s_startup_app_main;
+	portEXIT_CRITICAL(&s_startup_lock);
+	// Start-up is over: from here on the app's own code allocates nothing, count what is
+	// allocated anyway
+	if (done) heap_guard_arm();
 }
 
-// Avoid alerting twice for the same device
-static bool has_alerted_for(uint16_t short_addr)
+static void bdb_start(uint8_t mode)
 {
-	for (uint8_t i = 0; i < s_alerted_count; i++) {
-		if (s_alerted[i] == short_addr) return true;
-	}
-	return false;
+	HEAP_GUARD_APP_SCOPE();
+	esp_err_t err = esp_zb_bdb_start_top_level_commissioning(mode);
+	if (err != ESP_OK) ESP_LOGE(TAG, "BDB commissioning (mode 0x%02X) failed to start: %s", mode, esp_err_to_name(err));
 }
 
-static void mark_alerted_for(uint16_t short_addr)
+// Delay before the next try after `failures` failed ones: first_ms, doubled each time up to max_ms
+static uint32_t retry_delay_ms(uint16_t failures, uint32_t first_ms, uint32_t max_ms)
 {
-	for (uint8_t i = 0; i < s_alerted_count; i++) {
-		if (s_alerted[i] == short_addr) return;
-	}
-	if (s_alerted_count < (uint8_t)(sizeof(s_alerted)/sizeof(s_alerted[0]))) {
-		s_alerted[s_alerted_count++] = short_addr;
-	} else {
-		// Simple policy: circular overwrite
-		s_alerted[s_alerted_wr_idx++ % (uint8_t)(sizeof(s_alerted)/sizeof(s_alerted[0]))] = short_addr;
-	}
+	uint32_t ms = first_ms;
+	for (uint16_t i = 1; i < failures && ms < max_ms; i++) ms *= 2;
+	return ms < max_ms ? ms : max_ms;
 }
 
-// Trigger simulation alarm (same as bulb detection)
-static void trigger_simulation_alarm(void)
+// Formed, or resumed from zb_storage with the devices still joined: start serving them
+static void network_up(bool resumed)
 {
-	if (s_simulation_alerted) return; // Avoid multiple alerts
-	s_simulation_alerted = true;
-
-	// Set LED red for the configured duration
-	led_set_rgb(255, 0, 0);
-	if (s_led_timer) {
-		xTimerStop(s_led_timer, 0);
-		xTimerStart(s_led_timer, 0);
-	}
-	// Active buzzer: start 2 Hz blinking
-	buzzer_timer_create();
-	// Ensure starting in ON state (duty according to volume) and state coherence
-	(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, s_buzzer_on_duty);
-	(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
-	s_buzzer_state = true; // next toggle -> OFF
-	if (s_buzzer_timer) {
-		xTimerStop(s_buzzer_timer, 0);
-		xTimerStart(s_buzzer_timer, 0);
-	}
-	ESP_LOGW(TAG, "SIMULATION ALERT: Triggered by HIGH on GPIO %d", SIMULATION_PIN);
+	uint8_t ch = esp_zb_get_current_channel();
+	uint16_t pan_id = esp_zb_get_pan_id();
+	metrics_boot_network(resumed);
+	ESP_LOGI(TAG, "Network %s: PAN 0x%04X on channel %u, %lu ms after boot%s", resumed ? "resumed" : "formed", pan_id,
+			 ch, (unsigned long)(esp_timer_get_time() / 1000), resumed ? "" : ". Opening for joining...");
+	evlog_formed_t f = { .pan_id = pan_id, .channel = ch, .resumed = resumed };
+	event_log_write(EVLOG_FORMED, &f, sizeof(f));
+	gateway_link_network(pan_id, ch, resumed);
+	// Permit join on demand, extended by joins, with backed-off idle windows; a resumed network
+	// has its devices already and only opens on request
+	join_window_start(!resumed);
+	// Parents, link quality and depth of the devices behind routers
+	topology_start();
+	// Attribute reporting from classified devices: liveness without polling
+	presence_start();
+	// Keep a per-channel picture of noise and neighbouring PANs, within a small airtime budget
+	channel_survey_start(ZB_SCAN_CHANNEL_MASK);
+	startup_step_done(&s_startup_network);
 }
 
-// Periodic callback to check simulation pin
-static void simulation_check_cb(TimerHandle_t xTimer)
+// Forming now would strand every joined device on the old network: keep trying, backed off,
+// until the restore succeeds or the operator erases zb_storage
+static void resume_failed(esp_err_t st)
 {
-	(void)xTimer;
-	int level = gpio_get_level(SIMULATION_PIN);
-	if (level == 1) {
-		trigger_simulation_alarm();
+	metrics_count_network_failure(true);
+	uint32_t ms = retry_delay_ms(++s_resume_failures, ZB_SCAN_RESUME_RETRY_MS, ZB_SCAN_RESUME_RETRY_MAX_MS);
+	if (s_resume_failures == ZB_SCAN_RESUME_TRIES) {
+		ESP_LOGE(TAG, "Network restore failed %u times: no network until it succeeds. `factory_reset` at the "
+				 "console erases it and forms a new one (devices must be paired again)", s_resume_failures);
 	}
+	ESP_LOGW(TAG, "Network restore failed (status=%s, attempt %u). Retrying in %lu ms", esp_err_to_name(st),
+			 s_resume_failures, (unsigned long)ms);
+	esp_zb_scheduler_alarm(bdb_start, ESP_ZB_BDB_MODE_INITIALIZATION, ms);
 }
 
-// Scan complete callback: logs discovered networks
-static void zb_scan_complete_cb(esp_zb_zdp_status_t zdo_status, uint8_t count,
-								esp_zb_network_descriptor_t *nwk_list)
+// Try again on the same channel set
+static void formation_failed(esp_err_t st)
 {
-	ESP_LOGI(TAG, "Scan complete: status=%d, networks found=%d", zdo_status, count);
-	for (uint8_t i = 0; i < count; i++) {
-		esp_zb_network_descriptor_t *d = &nwk_list[i];
-		ESP_LOGI(TAG,
-				 "[%u] CH=%u PAN_ID=0x%04X EPN=%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X PJ=%d RC=%d EC=%d",
-				 i,
-				 d->logic_channel,
-				 d->short_pan_id,
-				 d->extended_pan_id[7], d->extended_pan_id[6], d->extended_pan_id[5], d->extended_pan_id[4],
-				 d->extended_pan_id[3], d->extended_pan_id[2], d->extended_pan_id[1], d->extended_pan_id[0],
-				 d->permit_joining, d->router_capacity, d->end_device_capacity);
-	}
-	if (count == 0) {
-		ESP_LOGW(TAG, "No Zigbee networks found.");
-	}
-	// Optionally schedule another scan (e.g., every 1s)
-	esp_zb_scheduler_alarm(zb_start_active_scan, 0, 1000);
+	metrics_count_network_failure(false);
+	uint32_t ms = retry_delay_ms(++s_form_failures, ZB_SCAN_FORM_RETRY_MS, ZB_SCAN_FORM_RETRY_MAX_MS);
+	ESP_LOGE(TAG, "Failed to form network (status=%s, attempt %u). Retrying in %lu ms", esp_err_to_name(st),
+			 s_form_failures, (unsigned long)ms);
+	esp_zb_scheduler_alarm(bdb_start, ESP_ZB_BDB_MODE_NETWORK_FORMATION, ms);
 }
 
 // App signal handler required by Zigbee SDK
 void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_s)
 {
+	HEAP_GUARD_APP_SCOPE();
 	uint32_t *sg = signal_s->p_app_signal;
 	esp_zb_app_signal_type_t sig = *sg;
 	esp_err_t st = signal_s->esp_err_status;
@@ -315,44 +273,82 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_s)
 
 	switch (sig) {
 	case ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP:
-		// Stack is ready: form a network as Coordinator and open for joining
-		ESP_LOGI(TAG, "Forming network (BDB network formation)...");
-		esp_zb_set_bdb_commissioning_mode(ESP_ZB_BDB_MODE_NETWORK_FORMATION);
-		ESP_ERROR_CHECK(esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_FORMATION));
+		// Stack is ready: restore the network kept in zb_storage, if there is one
+		metrics_boot_mark(METRICS_BOOT_STACK);
+		bdb_start(ESP_ZB_BDB_MODE_INITIALIZATION);
 		break;
-	case ESP_ZB_BDB_SIGNAL_FORMATION:
+	case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT:
 		if (st == ESP_OK) {
-			uint8_t ch = esp_zb_get_current_channel();
-			ESP_LOGI(TAG, "Network formed on channel %u. Opening for joining (steering 180s)...", ch);
-			esp_zb_set_bdb_commissioning_mode(ESP_ZB_BDB_MODE_NETWORK_STEERING);
-			ESP_ERROR_CHECK(esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING));
+			network_up(true);
+		} else {
+			resume_failed(st);
+		}
+		break;
+	case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START:
+		// Factory new: no network to resume, nor devices to strand, whether or not the
+		// initialization succeeded
+		if (st != ESP_OK) ESP_LOGW(TAG, "Stack initialization failed (status=%s): forming anyway", esp_err_to_name(st));
+		if (CHANNEL_SELECT_CANDIDATES > 0) {
+			// No network yet: pick the channels, then form one as Coordinator and open for joining
+			channel_survey_sweep(ZB_SCAN_CHANNEL_MASK, CHANNEL_SURVEY_SWEEP_ED_ROUNDS, formation_survey_done);
 		} else {
-			ESP_LOGE(TAG, "Failed to form network (status=%s). Retrying in 3s", esp_err_to_name(st));
-			esp_zb_scheduler_alarm(NULL, 0, 3000); // placeholder to retry later if desired
+			formation_survey_done(false);
 		}
 		break;
-	case ESP_ZB_BDB_SIGNAL_STEERING:
+	case ESP_ZB_BDB_SIGNAL_FORMATION:
 		if (st == ESP_OK) {
-			ESP_LOGI(TAG, "Steering completed. We will keep reopening steering periodically.");
-			// Re-open steering every 60s to make joining easier if the window was missed
-			esp_zb_scheduler_alarm(reopen_steering_cb, 0, 60000);
+			network_up(false);
 		} else {
-			ESP_LOGW(TAG, "Steering failed or cancelled (%s). Retrying in 10s", esp_err_to_name(st));
-			esp_zb_scheduler_alarm(reopen_steering_cb, 0, 10000);
+			formation_failed(st);
+		}
+		break;
+	case ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE: {
+		// A router reports a device that joined or rejoined through it
+		esp_zb_zdo_signal_device_update_params_t *p = (esp_zb_zdo_signal_device_update_params_t *)esp_zb_app_signal_get_params(sg);
+		if (p) topology_on_device_update(p->long_addr, p->short_addr, p->parent_short, p->status);
+		}
+		break;
+	case ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS: {
+		uint8_t *seconds = (uint8_t *)esp_zb_app_signal_get_params(sg);
+		if (st == ESP_OK && seconds) join_window_on_permit_status(*seconds);
+		}
+		break;
+	case ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION: {
+		// A child of the coordinator left, for good or to rejoin
+		esp_zb_zdo_signal_leave_indication_params_t *p = (esp_zb_zdo_signal_leave_indication_params_t *)esp_zb_app_signal_get_params(sg);
+		if (p) address_on_leave(p->device_addr, p->short_addr, p->rejoin);
 		}
 		break;
 	case ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE: {
 		// A device announced its presence after joining/rejoining
 		esp_zb_zdo_signal_device_annce_params_t *p = (esp_zb_zdo_signal_device_annce_params_t *)esp_zb_app_signal_get_params(sg);
 		if (p) {
+			uint32_t c0 = latency_cycles();
 			ESP_LOGI(TAG, "DEVICE_ANNCE: short=0x%04X ieee=%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X cap=0x%02X",
 					p->device_short_addr,
 					p->ieee_addr[7], p->ieee_addr[6], p->ieee_addr[5], p->ieee_addr[4],
 					p->ieee_addr[3], p->ieee_addr[2], p->ieee_addr[1], p->ieee_addr[0],
 					p->capability);
-			esp_zb_zdo_active_ep_req_param_t aep = {.addr_of_interest = p->device_short_addr};
-			ESP_LOGI(TAG, "Requesting ActiveEP to 0x%04X", p->device_short_addr);
-            esp_zb_zdo_active_ep_req(&aep, active_ep_cb, (void *)(uintptr_t)p->device_short_addr);
+			join_window_note_join();
+			metrics_count_announce();
+			// Known IEEE address, at its old short address or a new one: verdict without any request
+			device_entry_t *dev = address_bind(p->ieee_addr, p->device_short_addr);
+			topology_on_annce(dev, p->capability);
+			evlog_join_t j = { .short_addr = p->device_short_addr, .capability = p->capability,
+							   .parent_short = dev ? dev->parent_short : DEVICE_TABLE_NO_ADDR };
+			memcpy(j.ieee, p->ieee_addr, sizeof(j.ieee));
+			event_log_write(EVLOG_JOIN, &j, sizeof(j));
+			gateway_link_join(p->ieee_addr, p->device_short_addr, j.parent_short, p->capability);
+			interview_verdict_t verdict = identify(dev, p->ieee_addr, p->device_short_addr, p->capability);
+			presence_on_annce(dev);
+			if (verdict == INTERVIEW_VERDICT_MATCH) {
+				actuator_post_alert(p->device_short_addr, 0);
+				log_alert(p->ieee_addr, p->device_short_addr, 0, EVLOG_ALERT_CACHE);
+				if (mark_alerted(dev)) {
+					ESP_LOGW(TAG, "ALERT: IKEA TRÅDFRI bulb detected (0x%04X, known device)", p->device_short_addr);
+				}
+			}
+			latency_record(LATENCY_CPU_ANNCE, latency_class_of(dev), latency_cycles() - c0);
 		} else {
 			ESP_LOGW(TAG, "DEVICE_ANNCE without params. Ignoring");
 		}
@@ -363,128 +359,69 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_s)
 	}
 }
 
-static void zb_start_active_scan(uint8_t param)
-{
-	(void)param;
-	ESP_LOGI(TAG, "Starting Zigbee active scan: mask=0x%08lX dur=%u",
-			 (unsigned long)ZB_SCAN_CHANNEL_MASK, (unsigned)ZB_SCAN_DURATION);
-	// Launch active scan; callback will run from the Zigbee task
-	esp_zb_zdo_active_scan_request(ZB_SCAN_CHANNEL_MASK, ZB_SCAN_DURATION, zb_scan_complete_cb);
-}
-
-static void active_ep_cb(esp_zb_zdp_status_t zdo_status, uint8_t ep_count, uint8_t *ep_id_list, void *user_ctx)
-{
-	uint16_t nwk_addr = (uint16_t)(uintptr_t)user_ctx;
-	if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS || ep_count == 0 || !ep_id_list) {
-		ESP_LOGW(TAG, "ActiveEP failed/empty: status=%d", zdo_status);
-		return;
-	}
-	ESP_LOGI(TAG, "Active endpoints of 0x%04X (%u):", nwk_addr, ep_count);
-	for (uint8_t i = 0; i < ep_count; i++) {
-		ESP_LOGI(TAG, "  - ep %u", ep_id_list[i]);
-	}
-	// Request Simple Descriptor for all endpoints to find Basic 0x0000
-	for (uint8_t i = 0; i < ep_count; i++) {
-		esp_zb_zdo_simple_desc_req_param_t sreq = {
-			.addr_of_interest = nwk_addr,
-			.endpoint = ep_id_list[i],
-		};
-		esp_zb_zdo_simple_desc_req(&sreq, simple_desc_cb, (void *)(uintptr_t)nwk_addr);
-	}
-}
-
-static void simple_desc_cb(esp_zb_zdp_status_t zdo_status, esp_zb_af_simple_desc_1_1_t *sd, void *user_ctx)
-{
-	uint16_t nwk_addr = (uint16_t)(uintptr_t)user_ctx;
-	if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS || !sd) {
-		ESP_LOGW(TAG, "SimpleDesc failed: status=%d", zdo_status);
-		return;
-	}
-	ESP_LOGI(TAG, "SimpleDesc: ep=%u profile=0x%04X device=0x%04X", sd->endpoint, sd->app_profile_id, sd->app_device_id);
-	// Only try to read Basic on HA profile endpoints (0x0104). Skip ep 242 (Green Power)
-	if (sd->app_profile_id == 0x0104) {
-		// Try reading Basic 0x0000 (Manufacturer Name 0x0004, Model Id 0x0005)
-		try_read_basic_attrs(nwk_addr, sd->endpoint);
-	} else {
-		ESP_LOGI(TAG, "Non-HA profile (0x%04X) on ep %u: skipping Basic read", sd->app_profile_id, sd->endpoint);
-	}
-}
-
-static void try_read_basic_attrs(uint16_t nwk_addr, uint8_t endpoint)
-{
-	static uint16_t attrs[] = {0x0004, 0x0005};
-	esp_zb_zcl_read_attr_cmd_t cmd = {
-		.zcl_basic_cmd = {
-			.dst_addr_u = {.addr_short = nwk_addr},
-			.dst_endpoint = endpoint,
-			.src_endpoint = 1,
-		},
-		.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-		.clusterID = 0x0000,
-		.manuf_specific = 0,
-		.direction = 0,
-		.dis_default_resp = 1,
-		.manuf_code = 0,
-		.attr_number = (uint8_t)(sizeof(attrs)/sizeof(attrs[0])),
-		.attr_field = attrs,
-	};
-	uint8_t tsn = esp_zb_zcl_read_attr_cmd_req(&cmd);
-	ESP_LOGI(TAG, "Reading Basic attrs (tsn=%u) to 0x%04X/ep%u", tsn, nwk_addr, endpoint);
-}
-
 static esp_err_t zcl_action_handler(esp_zb_core_action_callback_id_t cb_id, const void *message)
 {
+	HEAP_GUARD_APP_SCOPE();
 	if (cb_id == ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID) {
 		const esp_zb_zcl_cmd_read_attr_resp_message_t *m = (const esp_zb_zcl_cmd_read_attr_resp_message_t *)message;
 		const uint16_t cluster = m->info.cluster;
 		if (cluster == 0x0000) {
-			// Iterate response variables
-			bool any_match = false;
-			for (esp_zb_zcl_read_attr_resp_variable_t *v = m->variables; v; v = v->next) {
-				if (v->status != ESP_ZB_ZCL_STATUS_SUCCESS) continue;
-				uint16_t attr_id = v->attribute.id;
-				// String attributes carry the first byte as length
-				if (v->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING ||
-					v->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING) {
-					const uint8_t *raw = (const uint8_t *)v->attribute.data.value;
-					if (!raw) continue;
-					uint16_t len = raw[0];
-					static char buf[64];
-					if (len >= sizeof(buf)) len = sizeof(buf) - 1;
-					memcpy(buf, raw + 1, len);
-					buf[len] = '\0';
-					ESP_LOGI(TAG, "Basic attr 0x%04X='%s' (src 0x%04X ep%u)", attr_id, buf, m->info.src_address.u.short_addr, m->info.src_endpoint);
-					bool is_ikea = contains_word_ci(buf, "ikea");
-					bool is_tradfri = contains_word_ci(buf, "tradfri");
-					if ((attr_id == 0x0004 && is_ikea) || (attr_id == 0x0005 && is_tradfri)) {
-						any_match = true;
-					}
+			uint32_t c0 = latency_cycles();
+			// Strings stay in the payload as (pointer, length) views
+			uint16_t src = m->info.src_address.u.short_addr;
+			zcl_basic_info_t info;
+			zcl_basic_parse(m->variables, &info);
+			const zcl_attr_view_t *manuf = &info.manufacturer;
+			const zcl_attr_view_t *model = &info.model;
+			// Every attribute goes to the event log as is; the console only gets them at debug level
+			zcl_attr_iter_t it;
+			zcl_attr_view_t v;
+			zcl_attr_iter_init(&it, m->variables);
+			while (zcl_attr_next(&it, &v)) {
+				if (v.is_string) {
+					event_log_attr(src, m->info.src_endpoint, cluster, v.id, v.type, v.str, v.len);
+				} else {
+					event_log_attr(src, m->info.src_endpoint, cluster, v.id, v.type, &v.u32,
+								   v.len < sizeof(v.u32) ? v.len : sizeof(v.u32));
 				}
 			}
-			if (any_match) {
-				uint16_t src = m->info.src_address.u.short_addr;
-				// Set LED red for the configured duration whenever detected
-				led_set_rgb(255, 0, 0);
-				if (s_led_timer) {
-					xTimerStop(s_led_timer, 0);
-					xTimerStart(s_led_timer, 0);
-				}
-				// Active buzzer: start 2 Hz blinking
-				buzzer_timer_create();
-				// Ensure starting in ON state (duty according to volume) and state coherence
-				(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, s_buzzer_on_duty);
-				(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
-				s_buzzer_state = true; // next toggle -> OFF
-				if (s_buzzer_timer) {
-					xTimerStop(s_buzzer_timer, 0);
-					xTimerStart(s_buzzer_timer, 0);
-				}
-				if (!has_alerted_for(src)) {
-					ESP_LOGW(TAG, "ALERT: IKEA TRÅDFRI bulb detected (0x%04X ep%u)", src, m->info.src_endpoint);
-					mark_alerted_for(src);
-				}
+			if (info.present & ZCL_BASIC_HAVE_MANUFACTURER) {
+				ESP_LOGD(TAG, "Basic attr 0x0004='%.*s' (src 0x%04X ep%u)", manuf->len, manuf->str, src, m->info.src_endpoint);
+			}
+			if (info.present & ZCL_BASIC_HAVE_MODEL) {
+				ESP_LOGD(TAG, "Basic attr 0x0005='%.*s' (src 0x%04X ep%u)", model->len, model->str, src, m->info.src_endpoint);
 			}
+			device_entry_t *dev = device_table_find_short(src);
+			interview_verdict_t verdict = classifier_on_basic(dev, &info);
+			uint32_t fw = zcl_basic_fw_fingerprint(&info);
+			if (dev && fw && fw != dev->fw_fingerprint) {
+				ESP_LOGI(TAG, "0x%04X firmware: app=%u hw=%u build='%.*s' (fp %08lX%s)", src,
+						 info.app_version, info.hw_version, info.sw_build.len, info.sw_build.str,
+						 (unsigned long)fw, dev->fw_fingerprint ? ", changed" : "");
+				dev->fw_fingerprint = fw;
+			}
+			// Only the response that classifies the device raises the alert; duplicates are ignored
+			bool first = interview_on_read_attr_resp(src, m->info.header.tsn, verdict);
+			if (first && dev) device_classified(dev, verdict, m->info.src_endpoint, manuf, model);
+			latency_record(LATENCY_CPU_READ_RESP, latency_class_of(dev), latency_cycles() - c0);
+		}
+	} else if (cb_id == ESP_ZB_CORE_REPORT_ATTR_CB_ID) {
+		const esp_zb_zcl_report_attr_message_t *m = (const esp_zb_zcl_report_attr_message_t *)message;
+		if (m->status == ESP_ZB_ZCL_STATUS_SUCCESS) {
+			presence_on_report(m->src_address.u.short_addr, m->src_endpoint, m->cluster, m->attribute.id);
 		}
+	} else if (cb_id == ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID) {
+		const esp_zb_zcl_cmd_config_report_resp_message_t *m = (const esp_zb_zcl_cmd_config_report_resp_message_t *)message;
+		// One SUCCESS record, or a record per attribute that was not configured
+		uint8_t status = ESP_ZB_ZCL_STATUS_SUCCESS;
+		for (const esp_zb_zcl_config_report_resp_variable_t *v = m->variables; v; v = v->next) {
+			if (v->status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+				status = v->status;
+				break;
+			}
+		}
+		if (m->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) status = m->info.status;
+		presence_on_config_report_resp(m->info.src_address.u.short_addr, m->info.header.tsn, status);
 	}
 	return ESP_OK;
 }
@@ -497,10 +434,14 @@ static void zigbee_task(void *pv)
 		.install_code_policy = false,
 		.nwk_cfg = {
 			.zczr_cfg = {
-				.max_children = 16,
+				.max_children = ZB_SCAN_MAX_CHILDREN,
 			}
 		}
 	};
+	// Address map and neighbour table, and frame buffers for the routing and APS traffic of a
+	// large network; must be set before esp_zb_init
+	ESP_ERROR_CHECK(esp_zb_overall_network_size_set(ZB_SCAN_NETWORK_SIZE));
+	ESP_ERROR_CHECK(esp_zb_io_buffer_size_set(ZB_SCAN_IO_BUFFERS));
 	esp_zb_init(&cfg);
 
 	// Register a minimal local endpoint (HA Configuration Tool) on ep=1
@@ -514,28 +455,55 @@ static void zigbee_task(void *pv)
 	// Allowed channels
 	esp_zb_set_primary_network_channel_set(ZB_SCAN_CHANNEL_MASK);
 
-	// Start the stack without autostart; handle BDB in the signal handler
+	// Start the stack without autostart; handle BDB in the signal handler. The network of the
+	// previous boot is resumed unless configured otherwise
+	esp_zb_nvram_erase_at_start(ZB_SCAN_FORM_AT_BOOT);
 	ESP_ERROR_CHECK(esp_zb_start(false));
 
-	// Run Zigbee main loop (blocking)
+	// Run Zigbee main loop (blocking). What the stack allocates in it is expected; the app's
+	// callbacks are not (HEAP_GUARD_APP_SCOPE)
+	heap_guard_idf_begin();
 	esp_zb_stack_main_loop();
 }
 
-static void reopen_steering_cb(uint8_t param)
+// Narrow the formation channel set to the best surveyed channels; without survey data the
+// stack chooses from the whole mask
+static void formation_survey_done(bool ok)
 {
-	(void)param;
-	ESP_LOGI(TAG, "Re-opening network for joining (steering)...");
-	esp_zb_set_bdb_commissioning_mode(ESP_ZB_BDB_MODE_NETWORK_STEERING);
-	esp_err_t err = esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
-	if (err != ESP_OK) {
-		ESP_LOGW(TAG, "Failed to reopen steering: %s. Retrying in 15s", esp_err_to_name(err));
-		esp_zb_scheduler_alarm(reopen_steering_cb, 0, 15000);
+	uint32_t mask = ok ? channel_select_mask(channel_survey_table(), ZB_SCAN_CHANNEL_MASK, CHANNEL_SELECT_CANDIDATES) : 0;
+	if (mask) {
+		channel_select_rank_t ranks[CHANNEL_SURVEY_COUNT];
+		size_t n = channel_select_rank(channel_survey_table(), ZB_SCAN_CHANNEL_MASK, ranks);
+		// The chosen channels and the runners-up
+		for (size_t i = 0; i < n && i < CHANNEL_SELECT_CANDIDATES + 2u; i++) {
+			const channel_select_rank_t *r = &ranks[i];
+			ESP_LOGI(TAG, "ch%u: score %d (noise %d, wifi %d, PANs %d)%s", r->channel, r->score, r->noise, r->wifi,
+					 r->pans, (mask & (1UL << r->channel)) ? " *" : "");
+		}
+		esp_zb_set_primary_network_channel_set(mask);
+	} else if (CHANNEL_SELECT_CANDIDATES > 0) {
+		ESP_LOGW(TAG, "No channel survey data: forming on any channel of 0x%08lX", (unsigned long)ZB_SCAN_CHANNEL_MASK);
 	}
+	ESP_LOGI(TAG, "Forming network (BDB network formation, channels 0x%08lX)...",
+			 (unsigned long)(mask ? mask : ZB_SCAN_CHANNEL_MASK));
+	esp_zb_set_bdb_commissioning_mode(ESP_ZB_BDB_MODE_NETWORK_FORMATION);
+	ESP_ERROR_CHECK(esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_FORMATION));
 }
 
 void app_main(void)
 {
+	metrics_boot_mark(METRICS_BOOT_APP_MAIN);
 	ESP_ERROR_CHECK(nvs_flash_init());
+	// Binary event history in the evlog partition, appended by a low-priority task
+	(void)event_log_init();
+	// Joins, verdicts and alerts to a host gateway, framed and batched on UART1
+	(void)gateway_link_init();
+	// Known devices (IEEE -> verdict) from previous runs
+	(void)device_cache_init();
+	// Devices heard from without an announce get their verdict like announced ones
+	address_init(device_resolved);
+	interview_init(interview_classified);
+	metrics_boot_mark(METRICS_BOOT_STORAGE);
 
 	// Platform configuration (native radio + default host)
 	esp_zb_platform_config_t platform_cfg = {
@@ -550,42 +518,27 @@ void app_main(void)
 	};
 	ESP_ERROR_CHECK(esp_zb_platform_config(&platform_cfg));
 
-	// Initialize on-board RGB LED (if present)
-	led_init();
-	// Initialize active buzzer (PWM on GPIO)
-	buzzer_init();
-
-	// Startup beep: 200ms to verify buzzer works
-	(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, s_buzzer_on_duty);
-	(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
-	vTaskDelay(pdMS_TO_TICKS(200));  // 200ms beep
-	(void)ledc_set_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL, 0);
-	(void)ledc_update_duty(BUZZER_LEDC_MODE, BUZZER_LEDC_CHANNEL);
-
-	// Configure simulation pin as input
-	gpio_config_t sim_io = {
-		.pin_bit_mask = 1ULL << SIMULATION_PIN,
-		.mode = GPIO_MODE_INPUT,
-		.pull_up_en = GPIO_PULLUP_DISABLE,
-		.pull_down_en = GPIO_PULLDOWN_DISABLE,
-		.intr_type = GPIO_INTR_DISABLE,
-	};
-	esp_err_t err = gpio_config(&sim_io);
-	if (err != ESP_OK) {
-		ESP_LOGW(TAG, "Failed to configure GPIO %d for simulation: %s", SIMULATION_PIN, esp_err_to_name(err));
-	}
-
-	// Reset simulation flag
-	s_simulation_alerted = false;
-
-	// Create periodic timer to check simulation pin (every 1 second)
-	TimerHandle_t sim_timer = xTimerCreate("sim_check", pdMS_TO_TICKS(1000), pdTRUE, NULL, simulation_check_cb);
-	if (sim_timer) {
-		xTimerStart(sim_timer, 0);
-	} else {
-		ESP_LOGW(TAG, "Failed to create simulation timer");
-	}
-
-	// Create Zigbee task (larger stack)
-	xTaskCreate(zigbee_task, "zigbee_main", 7168, NULL, 5, NULL);
+	// Create Zigbee task (larger stack) before the peripherals: the network is restored while
+	// they are set up, and nothing below is needed before the first device is heard from
+	TaskHandle_t zb_task = xTaskCreateStatic(zigbee_task, "zigbee_main", ZB_TASK_STACK, NULL, 5, s_zb_task_stack,
+											 &s_zb_task_tcb);
+	metrics_register_task(zb_task, "zigbee_main", ZB_TASK_STACK);
+	metrics_boot_mark(METRICS_BOOT_ZIGBEE_TASK);
+
+	// RGB LED and active buzzer, driven by the actuator task
+	(void)actuator_init();
+
+	// Simulation input: rising edge on SIMULATION_PIN raises a simulated alert
+	(void)trigger_input_init();
+
+	// Join button and the serial console's join command
+	(void)join_window_init();
+	(void)console_cmds_init();
+	metrics_boot_mark(METRICS_BOOT_PERIPHERALS);
+	// ESP-IDF's own tasks, the console REPL among them, allocate as they please
+	heap_guard_expect_idf_tasks();
+
+	// Heap and stack sampling; last, so the main task's stack use is complete
+	(void)metrics_init();
+	startup_step_done(&s_startup_app_main);
 }
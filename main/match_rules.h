@@ -0,0 +1,52 @@
+// Manufacturer/model rules recognised by the matcher
+// - Patterns are lowercase ASCII substrings, matched case-insensitively; accented Latin-1
+//   letters in the attribute fold to their base letter, so "tradfri" matches "TRÅDFRI"
+// - Editing this list requires regenerating main/matcher_tables.h:
+//     cmake --build build-host --target matcher_tables
+// - At most 64 rules (one bit each in match_set_t)
+#pragma once
+
+#define MATCH_FIELD_MANUFACTURER    (1u << 0)   // Basic 0x0004
+#define MATCH_FIELD_MODEL           (1u << 1)   // Basic 0x0005
+#define MATCH_FIELD_ANY             (MATCH_FIELD_MANUFACTURER | MATCH_FIELD_MODEL)
+
+#define MATCH_FLAG_ALERT            (1u << 0)   // a hit classifies the device as a match
+
+// X(id, fields, flags, vendor, pattern)
+#define MATCH_RULES(X) \
+	X(IKEA,             MATCH_FIELD_MANUFACTURER,   MATCH_FLAG_ALERT,   "IKEA",             "ikea") \
+	X(IKEA_TRADFRI,     MATCH_FIELD_MODEL,          MATCH_FLAG_ALERT,   "IKEA",             "tradfri") \
+	X(PHILIPS,          MATCH_FIELD_MANUFACTURER,   0,                  "Philips",          "philips") \
+	X(SIGNIFY,          MATCH_FIELD_MANUFACTURER,   0,                  "Philips",          "signify") \
+	X(XIAOMI_LUMI,      MATCH_FIELD_ANY,            0,                  "Xiaomi",           "lumi") \
+	X(XIAOMI,           MATCH_FIELD_MANUFACTURER,   0,                  "Xiaomi",           "xiaomi") \
+	X(AQARA,            MATCH_FIELD_ANY,            0,                  "Aqara",            "aqara") \
+	X(SONOFF,           MATCH_FIELD_ANY,            0,                  "Sonoff",           "sonoff") \
+	X(EWELINK,          MATCH_FIELD_MANUFACTURER,   0,                  "Sonoff",           "ewelink") \
+	X(TUYA_TZ,          MATCH_FIELD_MANUFACTURER,   0,                  "Tuya",             "_tz") \
+	X(TUYA_TYZB,        MATCH_FIELD_MANUFACTURER,   0,                  "Tuya",             "_tyzb") \
+	X(TUYA,             MATCH_FIELD_MANUFACTURER,   0,                  "Tuya",             "tuya") \
+	X(OSRAM,            MATCH_FIELD_MANUFACTURER,   0,                  "Ledvance",         "osram") \
+	X(LEDVANCE,         MATCH_FIELD_MANUFACTURER,   0,                  "Ledvance",         "ledvance") \
+	X(INNR,             MATCH_FIELD_MANUFACTURER,   0,                  "innr",             "innr") \
+	X(GLEDOPTO,         MATCH_FIELD_ANY,            0,                  "Gledopto",         "gledopto") \
+	X(HEIMAN,           MATCH_FIELD_MANUFACTURER,   0,                  "Heiman",           "heiman") \
+	X(LEGRAND,          MATCH_FIELD_MANUFACTURER,   0,                  "Legrand",          "legrand") \
+	X(SCHNEIDER,        MATCH_FIELD_MANUFACTURER,   0,                  "Schneider",        "schneider") \
+	X(DANFOSS,          MATCH_FIELD_MANUFACTURER,   0,                  "Danfoss",          "danfoss") \
+	X(BOSCH,            MATCH_FIELD_MANUFACTURER,   0,                  "Bosch",            "bosch") \
+	X(DEVELCO,          MATCH_FIELD_MANUFACTURER,   0,                  "Develco",          "develco") \
+	X(FRIENT,           MATCH_FIELD_MANUFACTURER,   0,                  "Develco",          "frient") \
+	X(SAMJIN,           MATCH_FIELD_MANUFACTURER,   0,                  "SmartThings",      "samjin") \
+	X(SMARTTHINGS,      MATCH_FIELD_MANUFACTURER,   0,                  "SmartThings",      "smartthings") \
+	X(CENTRALITE,       MATCH_FIELD_MANUFACTURER,   0,                  "Centralite",       "centralite") \
+	X(SENGLED,          MATCH_FIELD_MANUFACTURER,   0,                  "Sengled",          "sengled") \
+	X(THIRD_REALITY,    MATCH_FIELD_MANUFACTURER,   0,                  "Third Reality",    "third reality") \
+	X(PAULMANN,         MATCH_FIELD_MANUFACTURER,   0,                  "Paulmann",         "paulmann") \
+	X(MULLER_LICHT,     MATCH_FIELD_MANUFACTURER,   0,                  "Müller Licht",     "muller licht") \
+	X(NIKO,             MATCH_FIELD_MANUFACTURER,   0,                  "Niko",             "niko") \
+	X(UBISYS,           MATCH_FIELD_MANUFACTURER,   0,                  "ubisys",           "ubisys") \
+	X(NAMRON,           MATCH_FIELD_MANUFACTURER,   0,                  "Namron",           "namron") \
+	X(HORNBACH,         MATCH_FIELD_MANUFACTURER,   0,                  "Hornbach",         "hornbach") \
+	X(LIDL,             MATCH_FIELD_MANUFACTURER,   0,                  "Lidl",             "lidl") \
+	X(ESPRESSIF,        MATCH_FIELD_MANUFACTURER,   0,                  "Espressif",        "espressif")
@@ -0,0 +1,58 @@
+// Multi-pattern matcher: runs the generated Aho-Corasick DFA over case-folded UTF-8
+
+#include "matcher.h"
+#include "matcher_tables.h"
+
+_Static_assert(MATCH_TABLES_RULE_COUNT == MATCH_RULE_COUNT, "matcher_tables.h is stale: rebuild the matcher_tables host target");
+
+#define X(id, fields, flags, vendor, pattern) vendor,
+static const char *const s_vendor[MATCH_RULE_COUNT] = { MATCH_RULES(X) };
+#undef X
+#define X(id, fields, flags, vendor, pattern) pattern,
+static const char *const s_pattern[MATCH_RULE_COUNT] = { MATCH_RULES(X) };
+#undef X
+
+#define FIELD_BIT_(id, fields, flags, vendor, pattern, field) | (((fields) & (field)) ? MATCH_RULE_BIT(MATCH_RULE_##id) : 0)
+#define MANUF_BIT_(id, fields, flags, vendor, pattern) FIELD_BIT_(id, fields, flags, vendor, pattern, MATCH_FIELD_MANUFACTURER)
+#define MODEL_BIT_(id, fields, flags, vendor, pattern) FIELD_BIT_(id, fields, flags, vendor, pattern, MATCH_FIELD_MODEL)
+static const match_set_t s_manuf_rules = (match_set_t)0 MATCH_RULES(MANUF_BIT_);
+static const match_set_t s_model_rules = (match_set_t)0 MATCH_RULES(MODEL_BIT_);
+
+// Base letter of U+00C0..U+00FF (UTF-8 C3 80..C3 BF); 0 for symbols and ligatures
+static const char s_latin1_fold[64] =
+	"aaaaaa\0ceeeeiiii" "dnooooo\0ouuuuy\0\0"
+	"aaaaaa\0ceeeeiiii" "dnooooo\0ouuuuy\0y";
+
+match_set_t matcher_scan(const char *str, size_t len, unsigned fields)
+{
+	const uint8_t *p = (const uint8_t *)str;
+	match_set_t hits = 0;
+	uint32_t state = 0;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t c = p[i];
+		uint8_t cls = 0;
+		if (c < 0x80) {
+			// The class table already maps upper and lower case to the same symbol
+			cls = s_match_class[c];
+		} else if (c == 0xC3 && i + 1 < len && (p[i + 1] & 0xC0) == 0x80) {
+			cls = s_match_class[(uint8_t)s_latin1_fold[p[++i] & 0x3F]];
+		}
+		// Any other non-ASCII byte is a symbol that no pattern contains
+		state = s_match_delta[state][cls];
+		hits |= s_match_out[state];
+	}
+	match_set_t scope = 0;
+	if (fields & MATCH_FIELD_MANUFACTURER) scope |= s_manuf_rules;
+	if (fields & MATCH_FIELD_MODEL) scope |= s_model_rules;
+	return hits & scope;
+}
+
+const char *matcher_rule_vendor(match_rule_id_t id)
+{
+	return id < MATCH_RULE_COUNT ? s_vendor[id] : "?";
+}
+
+const char *matcher_rule_pattern(match_rule_id_t id)
+{
+	return id < MATCH_RULE_COUNT ? s_pattern[id] : "?";
+}
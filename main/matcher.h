@@ -0,0 +1,41 @@
+// Multi-pattern matcher for Basic manufacturer/model strings
+// - Rules live in match_rules.h; the Aho-Corasick automaton is generated at build time
+//   (main/matcher_tables.h, by host/tools/gen_matcher.c) and stored in flash
+// - One pass over the attribute bytes, case-insensitive, Latin-1 accents folded
+// - Returns every matching rule at once as a bit set
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "match_rules.h"
+
+#define X(id, fields, flags, vendor, pattern) MATCH_RULE_##id,
+typedef enum {
+	MATCH_RULES(X)
+	MATCH_RULE_COUNT
+} match_rule_id_t;
+#undef X
+
+_Static_assert(MATCH_RULE_COUNT <= 64, "match_set_t has one bit per rule");
+
+typedef uint64_t match_set_t;
+
+#define MATCH_RULE_BIT(id)          ((match_set_t)1 << (id))
+
+// Rules that classify a device as a match (MATCH_FLAG_ALERT)
+#define MATCH_ALERT_BIT_(id, fields, flags, vendor, pattern) | (((flags) & MATCH_FLAG_ALERT) ? MATCH_RULE_BIT(MATCH_RULE_##id) : 0)
+#define MATCH_ALERT_RULES           ((match_set_t)0 MATCH_RULES(MATCH_ALERT_BIT_))
+
+// Rules matching str[0..len) that apply to any of the given MATCH_FIELD_* bits.
+// str does not need to be NUL-terminated and may hold arbitrary bytes.
+match_set_t matcher_scan(const char *str, size_t len, unsigned fields);
+
+// Vendor name and pattern of a rule
+const char *matcher_rule_vendor(match_rule_id_t id);
+const char *matcher_rule_pattern(match_rule_id_t id);
+
+// Lowest rule in a non-empty set
+static inline match_rule_id_t matcher_first(match_set_t set)
+{
+	return (match_rule_id_t)__builtin_ctzll(set);
+}
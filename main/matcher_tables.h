@@ -0,0 +1,289 @@
+// Generated by host/tools/gen_matcher.c from match_rules.h: do not edit.
+// Aho-Corasick DFA over 36 patterns: 223 states x 29 symbol classes
+#pragma once
+
+#include <stdint.h>
+
+#define MATCH_TABLES_RULE_COUNT     (36)
+#define MATCH_STATES                (223)
+#define MATCH_CLASSES               (29)
+
+// ASCII byte -> symbol class (upper and lower case share a class)
+static const uint8_t s_match_class[128] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+	18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 0, 0, 0, 0, 2,
+	0, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+	18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 0, 0, 0, 0, 0,
+};
+
+static const uint8_t s_match_delta[MATCH_STATES][MATCH_CLASSES] = {
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,3,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,4,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,0,0},
+	{0,0,53,7,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,8,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,105,111,143,104,116,9,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,10,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,11,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,125,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,171,111,143,104,46,122,77,13,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,14,0,0,26,178,190,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,15,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,16,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,213,46,122,77,85,1,0,2,26,178,74,62,17,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,171,111,143,104,46,122,77,13,1,0,0,26,178,190,62,12,0,0,18,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,21,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,78,178,22,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,23,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,24,77,85,1,0,192,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,123,19,5,194,0,0,30,25,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,212,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,195,143,104,46,122,77,85,1,0,0,26,28,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,29,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,31,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,32,111,143,104,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,33,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,34,190,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,35,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,38,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,39,19,5,194,0,0,30,0,0},
+	{0,0,53,40,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,42,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,43,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,44,77,85,1,0,0,26,178,190,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,45,77,85,1,0,0,26,178,190,62,12,0,123,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,123,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,104,48,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,49,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,50,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,213,46,122,77,85,1,0,2,26,178,51,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,52,26,178,75,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,54,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,56,55},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,57},
+	{0,0,53,36,58,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,112,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,195,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,60,0},
+	{0,0,53,61,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,64,19,5,194,0,0,30,0,0},
+	{0,0,53,65,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,66,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,68,46,122,91,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,105,111,143,104,116,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,69,0,30,0,0},
+	{0,0,53,70,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,71,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,72,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,73,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,145,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,75,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,76,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,78,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,79,122,77,85,212,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,80,46,122,91,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,105,111,143,104,116,122,77,85,1,0,0,26,178,190,81,12,0,0,19,5,194,69,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,82,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,171,111,143,104,46,122,77,13,1,0,0,26,178,190,62,12,0,0,19,83,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,84,12,0,6,19,5,59,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,1,0,0,26,178,190,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,87,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,88,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,89,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,90,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,78,178,190,62,12,0,92,19,5,194,0,0,30,0,0},
+	{0,0,53,93,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,94,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,95,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,105,111,143,104,116,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,144,122,77,97,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,1,0,0,26,178,98,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,99,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,100,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,101,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,105,111,143,104,102,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,103,215,5,194,117,47,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,105,111,143,104,116,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,106,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,107,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,108,12,0,123,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,109,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,64,110,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,112,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,113,5,194,0,0,30,0,0},
+	{0,0,53,128,111,114,104,153,122,77,85,20,0,0,26,133,190,41,12,0,64,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,144,122,77,115,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,1,0,0,26,178,98,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,215,5,194,117,47,30,0,0},
+	{0,0,53,36,111,143,104,118,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,119,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,120,104,67,122,77,85,212,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,104,144,122,77,85,1,0,0,26,178,190,121,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,123,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,124,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,125,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,126,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,127,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,129,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,130,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,131,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,132,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,75,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,134,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,135,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,136,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,6,19,137,59,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,138,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,139,0,0,26,178,190,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,140,62,12,0,161,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,141,85,191,0,0,26,178,75,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,78,178,190,62,12,0,0,142,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,144,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,145,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,146,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,147,19,5,59,0,0,30,0,0},
+	{0,0,53,148,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,8,46,122,77,85,1,0,0,149,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,150,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,213,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,151,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,152,122,77,159,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,154,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,200,111,143,104,46,122,155,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,156,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,157,122,77,85,212,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,158,46,122,91,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,105,111,143,104,116,122,77,85,1,0,0,26,178,190,81,12,0,0,19,5,194,69,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,160,0,0,26,178,190,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,74,62,12,0,161,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,162,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,163,53,105,111,143,104,116,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,164,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,165,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,166,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,215,5,194,0,47,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,167,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,168,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,213,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,169,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,170,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,172,0,0,30,0,0},
+	{0,0,53,36,195,143,104,46,122,77,85,1,0,0,173,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,212,0,0,26,174,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,175,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,176,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,177,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,179,0,0,30,0,0},
+	{0,0,53,36,195,143,104,46,122,77,85,1,0,0,180,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,212,0,0,181,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,104,182,122,77,85,212,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,143,68,46,122,91,85,1,0,0,26,178,190,62,12,0,183,215,5,194,0,47,30,0,0},
+	{0,184,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,185,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,186,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,36,111,187,213,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,144,122,77,188,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,1,0,0,26,178,190,205,12,0,0,19,189,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,159,1,0,0,26,178,190,62,12,0,6,19,5,59,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,192,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,3,122,77,85,1,0,0,26,178,190,193,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,36,195,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,196,0,0,26,178,190,112,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,2,26,178,74,62,12,0,0,197,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,198,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,199,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,201,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,202,19,5,179,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,203,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,204,62,12,0,0,63,5,194,0,0,30,0,0},
+	{0,0,53,200,111,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,206,63,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,207,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,200,208,143,104,46,122,77,85,191,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,209,111,143,104,46,122,77,85,1,0,0,26,178,190,112,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,210,104,46,122,77,85,1,0,0,26,178,190,62,12,37,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,144,122,77,211,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,86,122,77,85,1,0,0,26,178,190,205,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,213,46,122,77,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,105,111,143,104,116,122,77,85,1,0,0,214,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,67,122,77,85,212,0,0,26,178,190,62,12,0,0,19,5,27,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,216,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,171,111,143,104,46,122,77,13,1,0,0,26,178,190,62,12,0,217,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,218,122,77,85,1,0,0,26,178,190,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,0,219,5,194,0,47,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,20,0,0,26,133,190,41,216,0,0,220,5,194,0,0,30,0,0},
+	{0,0,53,128,111,96,104,153,122,77,85,221,0,0,26,133,190,41,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,222,21,85,1,0,2,26,178,74,62,12,0,0,19,5,194,0,0,30,0,0},
+	{0,0,53,36,111,143,104,46,122,77,85,1,0,0,26,178,190,62,12,0,123,19,5,194,0,0,30,0,0},
+};
+
+// Rules matched when the automaton enters each state
+static const uint64_t s_match_out[MATCH_STATES] = {
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x1ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x2ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x4ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x8ull, 0x0ull, 0x0ull, 0x0ull, 0x10ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x20ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x40ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x80ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x100ull, 0x0ull,
+	0x0ull, 0x200ull, 0x0ull, 0x0ull, 0x400ull, 0x0ull,
+	0x0ull, 0x800ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x1000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x2000ull, 0x0ull, 0x0ull, 0x4000ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x8000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x10000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x20000ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x40000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x80000ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x100000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x200000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x400000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x800000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x1000000ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x2000000ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x4000000ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x8000000ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x10000000ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x20000000ull, 0x0ull, 0x0ull,
+	0x0ull, 0x40000000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x80000000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x100000000ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x0ull, 0x200000000ull, 0x0ull, 0x0ull, 0x400000000ull, 0x0ull,
+	0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull, 0x0ull,
+	0x800000000ull,
+};
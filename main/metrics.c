@@ -0,0 +1,308 @@
+// Runtime metrics: periodic heap and stack sampling, request counters, console snapshot
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "esp_zigbee_core.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "interview.h"
+#include "classifier.h"
+#include "actuator.h"
+#include "event_log.h"
+#include "presence.h"
+#include "heap_guard.h"
+#include "gateway_link.h"
+#include "metrics.h"
+
+static const char *TAG = "ZB_SCAN";
+
+#ifdef CONFIG_MAIN_TASK_STACK_SIZE
+#define MAIN_TASK_STACK             (CONFIG_MAIN_TASK_STACK_SIZE)
+#else
+#define MAIN_TASK_STACK             (7168)      // sdkconfig.defaults
+#endif
+#ifdef CONFIG_FREERTOS_TIMER_TASK_STACK_DEPTH
+#define TIMER_TASK_STACK            (CONFIG_FREERTOS_TIMER_TASK_STACK_DEPTH)
+#else
+#define TIMER_TASK_STACK            (2048)
+#endif
+// esp_console REPL task (ESP_CONSOLE_REPL_CONFIG_DEFAULT)
+#define REPL_TASK_NAME              "console_repl"
+#define REPL_TASK_STACK             (4096)
+
+typedef struct {
+	TaskHandle_t handle;            // NULL once sampled for good (main task)
+	bool warned;
+} task_slot_t;
+
+static task_slot_t s_slots[METRICS_MAX_TASKS];
+static metrics_snapshot_t s_m;
+static TimerHandle_t s_timer;
+static StaticTimer_t s_timer_buf;
+// sample() and the snapshot: the timer task samples while the console task takes a snapshot
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+static bool s_heap_warned;
+
+static const char *const s_req_names[METRICS_REQ_COUNT] = {
+	"active_ep", "simple_desc", "read_attr", "mgmt_lqi", "energy_detect", "active_scan", "permit_join", "bind",
+	"config_report", "ieee_addr",
+};
+
+static const char *const s_boot_names[METRICS_BOOT_COUNT] = {
+	"app_main", "storage", "zigbee_task", "peripherals", "stack", "network",
+};
+
+static void sample_task(uint8_t i, TaskHandle_t handle)
+{
+	metrics_task_t *t = &s_m.tasks[i];
+	uint32_t free_bytes = (uint32_t)uxTaskGetStackHighWaterMark(handle);
+	if (free_bytes > t->stack_bytes) free_bytes = t->stack_bytes;
+	if (free_bytes < t->free_min) t->free_min = free_bytes;
+	if (t->free_min < METRICS_STACK_WARN_BYTES && !s_slots[i].warned) {
+		s_slots[i].warned = true;
+		ESP_LOGW(TAG, "Task %s: %lu of %lu stack bytes never used", t->name, (unsigned long)t->free_min,
+				 (unsigned long)t->stack_bytes);
+	}
+}
+
+// Called with s_lock held
+static void sample(void)
+{
+	s_m.samples++;
+	s_m.heap_free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+	s_m.heap_free_min = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+	s_m.heap_largest = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+	if (s_m.heap_largest < s_m.heap_largest_min) s_m.heap_largest_min = s_m.heap_largest;
+	if (s_m.heap_largest_min < METRICS_HEAP_WARN_BYTES && !s_heap_warned) {
+		s_heap_warned = true;
+		ESP_LOGW(TAG, "Largest free heap block down to %lu bytes (%lu free)", (unsigned long)s_m.heap_largest_min,
+				 (unsigned long)s_m.heap_free);
+	}
+	for (uint8_t i = 0; METRICS_STACKS && i < s_m.task_count; i++) {
+		if (s_slots[i].handle) sample_task(i, s_slots[i].handle);
+	}
+	heap_guard_check();
+}
+
+static void sample_locked(void)
+{
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	sample();
+	xSemaphoreGive(s_lock);
+}
+
+static void sample_timer_cb(TimerHandle_t t)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)t;
+	sample_locked();
+}
+
+static int8_t add_task(const char *name, uint32_t stack_bytes)
+{
+	if (s_m.task_count >= METRICS_MAX_TASKS) return -1;
+	uint8_t i = s_m.task_count++;
+	s_m.tasks[i] = (metrics_task_t){ .name = name, .stack_bytes = stack_bytes, .free_min = stack_bytes };
+	s_slots[i] = (task_slot_t){ 0 };
+	return (int8_t)i;
+}
+
+void metrics_register_task(TaskHandle_t task, const char *name, uint32_t stack_bytes)
+{
+	if (!task) return;
+	int8_t i = add_task(name, stack_bytes);
+	if (i >= 0) s_slots[i].handle = task;
+}
+
+esp_err_t metrics_init(void)
+{
+	if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+	if (!s_lock) {
+		ESP_LOGW(TAG, "Metrics: failed to create lock");
+		return ESP_ERR_NO_MEM;
+	}
+	s_m.heap_largest_min = UINT32_MAX;
+	// app_main returns after this and its task is deleted: what it used so far is all it uses
+	int8_t main_slot = add_task("main", MAIN_TASK_STACK);
+	if (METRICS_STACKS && main_slot >= 0) sample_task((uint8_t)main_slot, NULL);
+	metrics_register_task(xTimerGetTimerDaemonTaskHandle(), "timer_svc", TIMER_TASK_STACK);
+	metrics_register_task(xTaskGetHandle(REPL_TASK_NAME), REPL_TASK_NAME, REPL_TASK_STACK);
+	sample_locked();
+	s_timer = xTimerCreateStatic("metrics", pdMS_TO_TICKS(METRICS_SAMPLE_MS), pdTRUE, NULL, sample_timer_cb,
+								 &s_timer_buf);
+	if (!s_timer || xTimerStart(s_timer, 0) != pdPASS) {
+		ESP_LOGW(TAG, "Metrics: failed to start the sampling timer");
+		return ESP_ERR_NO_MEM;
+	}
+	return ESP_OK;
+}
+
+void metrics_count(metrics_req_t req, metrics_result_t result)
+{
+	if (req < METRICS_REQ_COUNT && result < METRICS_RESULT_COUNT) s_m.requests[req][result]++;
+}
+
+void metrics_count_zdp(metrics_req_t req, int zdp_status)
+{
+	// A ZDP timeout is the stack giving up on the answer, the same thing as our own timeouts
+	metrics_count(req, zdp_status == ESP_ZB_ZDP_STATUS_SUCCESS ? METRICS_OK
+				  : zdp_status == ESP_ZB_ZDP_STATUS_TIMEOUT ? METRICS_TIMEOUT : METRICS_FAILED);
+}
+
+void metrics_count_announce(void)
+{
+	s_m.announces++;
+}
+
+void metrics_boot_mark(metrics_boot_t phase)
+{
+	if (phase >= METRICS_BOOT_COUNT || (s_m.boot_phases & (1u << phase))) return;
+	s_m.boot_us[phase] = (uint32_t)esp_timer_get_time();
+	s_m.boot_phases |= (uint8_t)(1u << phase);
+}
+
+void metrics_boot_network(bool resumed)
+{
+	if (!(s_m.boot_phases & (1u << METRICS_BOOT_NETWORK))) s_m.network_resumed = resumed;
+	metrics_boot_mark(METRICS_BOOT_NETWORK);
+}
+
+void metrics_count_network_failure(bool resume)
+{
+	if (resume) {
+		s_m.restore_failures++;
+	} else {
+		s_m.formation_failures++;
+	}
+}
+
+void metrics_snapshot(metrics_snapshot_t *out)
+{
+	// The interview, classifier and presence state belongs to the Zigbee task: read it under the
+	// stack lock, before taking s_lock
+	interview_stats_t is;
+	classifier_stats_t cs;
+	presence_stats_t ps;
+	bool zb_locked = esp_zb_lock_acquire(portMAX_DELAY);
+	interview_get_stats(&is);
+	classifier_get_stats(&cs);
+	presence_get_stats(&ps);
+	if (zb_locked) esp_zb_lock_release();
+
+	if (s_lock) xSemaphoreTake(s_lock, portMAX_DELAY);
+	// Heap and stacks as of now, not as of the last periodic sample
+	sample();
+	s_m.uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+	s_m.interview_queue = is.queue_depth;
+	s_m.interview_queue_peak = is.queue_peak;
+	s_m.interview_queue_len = INTERVIEW_QUEUE_LEN;
+	s_m.interview_in_flight_peak = is.in_flight_peak;
+	s_m.interview_window = INTERVIEW_MAX_IN_FLIGHT;
+	s_m.classified = is.classified + cs.decided[CLASSIFY_ANNCE];
+	actuator_stats_t as;
+	actuator_get_stats(&as);
+	s_m.actuator_ring_peak = as.ring_peak;
+	s_m.actuator_ring_len = ACTUATOR_RING_LEN;
+	s_m.alerts = as.posted;
+	s_m.alerts_dropped = as.dropped;
+	event_log_stats_t es;
+	event_log_get_stats(&es);
+	s_m.event_log_peak = es.buf_peak;
+	s_m.event_log_len = EVENT_LOG_BUF_LEN;
+	s_m.event_log_dropped = es.dropped;
+	s_m.reports = ps.reports;
+	s_m.reporting = ps.reporting;
+	s_m.offline = ps.offline;
+	*out = s_m;
+	if (s_lock) xSemaphoreGive(s_lock);
+}
+
+const char *metrics_req_name(metrics_req_t req)
+{
+	return req < METRICS_REQ_COUNT ? s_req_names[req] : "?";
+}
+
+const char *metrics_boot_name(metrics_boot_t phase)
+{
+	return phase < METRICS_BOOT_COUNT ? s_boot_names[phase] : "?";
+}
+
+void metrics_print(void)
+{
+	metrics_snapshot_t m;
+	metrics_snapshot(&m);
+	printf("up %lu s, %lu samples\n", (unsigned long)m.uptime_s, (unsigned long)m.samples);
+	printf("boot (ms):");
+	for (int b = 0; b < METRICS_BOOT_COUNT; b++) {
+		if (m.boot_phases & (1u << b)) {
+			printf(" %s %lu.%lu", s_boot_names[b], (unsigned long)(m.boot_us[b] / 1000),
+				   (unsigned long)(m.boot_us[b] % 1000 / 100));
+		} else {
+			printf(" %s -", s_boot_names[b]);
+		}
+	}
+	printf("%s\n", !(m.boot_phases & (1u << METRICS_BOOT_NETWORK)) ? "" : m.network_resumed ? " (resumed)" : " (formed)");
+	if (m.restore_failures || m.formation_failures) {
+		printf("network: %u failed restores, %u failed formations%s\n", m.restore_failures, m.formation_failures,
+			   (m.boot_phases & (1u << METRICS_BOOT_NETWORK)) ? "" : ", retrying");
+	}
+	printf("heap: free %lu (min %lu), largest block %lu (min %lu)\n", (unsigned long)m.heap_free,
+		   (unsigned long)m.heap_free_min, (unsigned long)m.heap_largest, (unsigned long)m.heap_largest_min);
+	heap_guard_stats_t hg;
+	heap_guard_get_stats(&hg);
+	if (hg.armed) {
+		printf("heap after start-up: %lu allocations (%lu bytes), %lu frees; %lu during start-up\n  by task:",
+			   (unsigned long)hg.allocs, (unsigned long)hg.bytes, (unsigned long)hg.frees, (unsigned long)hg.init_allocs);
+		for (uint8_t i = 0; i < hg.task_count; i++) {
+			const heap_guard_task_t *t = &hg.tasks[i];
+			if (!t->allocs) continue;
+			printf(" %s %lu", t->name, (unsigned long)t->allocs);
+			if (t->app_allocs) printf(" (%lu app)", (unsigned long)t->app_allocs);
+		}
+		printf(hg.untracked ? " untracked %lu (more tasks than slots, counted as app)\n" : "\n", (unsigned long)hg.untracked);
+	} else {
+		printf("heap after start-up: not armed (%lu allocations so far)\n", (unsigned long)hg.init_allocs);
+	}
+	if (METRICS_STACKS) {
+		printf("stack unused/size:");
+		for (uint8_t i = 0; i < m.task_count; i++) {
+			printf(" %s %lu/%lu", m.tasks[i].name, (unsigned long)m.tasks[i].free_min,
+				   (unsigned long)m.tasks[i].stack_bytes);
+		}
+		printf("\n");
+	}
+	printf("queues: interview %u/%u (peak %u, in flight peak %u/%u), actuator peak %u/%u (dropped %lu), "
+		   "event log peak %u/%u (dropped %lu)\n", m.interview_queue, m.interview_queue_len,
+		   m.interview_queue_peak, m.interview_in_flight_peak, m.interview_window, m.actuator_ring_peak,
+		   m.actuator_ring_len, (unsigned long)m.alerts_dropped, m.event_log_peak, m.event_log_len,
+		   (unsigned long)m.event_log_dropped);
+	gateway_link_stats_t gw;
+	gateway_link_get_stats(&gw);
+	if (!gw.on) {
+		printf("gateway link: off (no TX pin)\n");
+	} else {
+		printf("gateway link: %lu records in %lu frames (%lu bytes, up to %u records a frame), dropped %lu "
+			   "(%lu alerts), waited up to %lu ms (alerts %lu ms), buffer peak %u/%u, stalled %lu times for %lu ms\n",
+			   (unsigned long)gw.records, (unsigned long)gw.frames, (unsigned long)gw.bytes, gw.frame_records_max,
+			   (unsigned long)gw.dropped, (unsigned long)gw.alerts_dropped, (unsigned long)gw.age_max_ms,
+			   (unsigned long)gw.alert_age_max_ms, gw.buf_peak, GATEWAY_LINK_BUF_LEN, (unsigned long)gw.stalls,
+			   (unsigned long)gw.stall_ms);
+	}
+	printf("requests issued/ok/failed/timeout:");
+	for (int r = 0; r < METRICS_REQ_COUNT; r++) {
+		printf(" %s %lu/%lu/%lu/%lu", s_req_names[r], (unsigned long)m.requests[r][METRICS_ISSUED],
+			   (unsigned long)m.requests[r][METRICS_OK], (unsigned long)m.requests[r][METRICS_FAILED],
+			   (unsigned long)m.requests[r][METRICS_TIMEOUT]);
+	}
+	printf("\nannounces %lu, classified %lu, alerts %lu, reports %lu (%u devices reporting, %u offline)\n",
+		   (unsigned long)m.announces, (unsigned long)m.classified, (unsigned long)m.alerts, (unsigned long)m.reports,
+		   m.reporting, m.offline);
+}
@@ -0,0 +1,133 @@
+// Runtime metrics: heap, task stacks, queue usage and Zigbee request counters
+// - Every METRICS_SAMPLE_MS a timer samples free heap, the largest free block and the stack
+//   high-water mark of each registered task, keeping the minimum seen of each. It warns once
+//   when a stack or the largest block runs low
+// - Request counters for every ZDO/ZCL request the app issues: issued, answered, failed
+//   (error status from the stack) and timed out
+// - Queue peaks come from the modules' own statistics (interview queue and window, actuator
+//   ring, event log buffer)
+// - Boot phases: the time since boot at which each step of the start-up completed, up to the
+//   network being served
+// - `metrics` at the serial console prints the snapshot
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef METRICS_SAMPLE_MS
+#define METRICS_SAMPLE_MS           (10 * 1000)
+#endif
+#ifndef METRICS_MAX_TASKS
+#define METRICS_MAX_TASKS           (8)
+#endif
+// Stack high-water marks sampled and printed; off where they say nothing about the target's
+// stacks (host build)
+#ifndef METRICS_STACKS
+#define METRICS_STACKS              (1)
+#endif
+// Warn when a task has less stack left than this, or the largest free heap block falls below
+#ifndef METRICS_STACK_WARN_BYTES
+#define METRICS_STACK_WARN_BYTES    (512)
+#endif
+#ifndef METRICS_HEAP_WARN_BYTES
+#define METRICS_HEAP_WARN_BYTES     (16 * 1024)
+#endif
+
+typedef enum {
+	METRICS_REQ_ACTIVE_EP,
+	METRICS_REQ_SIMPLE_DESC,
+	METRICS_REQ_READ_ATTR,          // ZCL Read Attributes (Basic)
+	METRICS_REQ_MGMT_LQI,
+	METRICS_REQ_ENERGY_DETECT,
+	METRICS_REQ_ACTIVE_SCAN,
+	METRICS_REQ_PERMIT_JOIN,        // BDB open network broadcast
+	METRICS_REQ_BIND,               // ZDO Bind to the coordinator (presence.c)
+	METRICS_REQ_CONFIG_REPORT,      // ZCL Configure Reporting
+	METRICS_REQ_IEEE_ADDR,          // ZDO IEEE_addr_req for an unknown short address (address.c)
+	METRICS_REQ_COUNT,
+} metrics_req_t;
+
+typedef enum {
+	METRICS_ISSUED,
+	METRICS_OK,
+	METRICS_FAILED,
+	METRICS_TIMEOUT,
+	METRICS_RESULT_COUNT,
+} metrics_result_t;
+
+// Boot phases, in the order they normally complete
+typedef enum {
+	METRICS_BOOT_APP_MAIN,          // app_main entered
+	METRICS_BOOT_STORAGE,           // NVS, event log and device cache loaded
+	METRICS_BOOT_ZIGBEE_TASK,       // Zigbee task created
+	METRICS_BOOT_PERIPHERALS,       // LED, buzzer, inputs and console set up
+	METRICS_BOOT_STACK,             // stack started (SKIP_STARTUP)
+	METRICS_BOOT_NETWORK,           // network resumed or formed: devices are served
+	METRICS_BOOT_COUNT,
+} metrics_boot_t;
+
+typedef struct {
+	const char *name;
+	uint32_t stack_bytes;
+	uint32_t free_min;              // lowest stack high-water mark sampled, bytes
+} metrics_task_t;
+
+typedef struct {
+	uint32_t uptime_s;
+	uint32_t samples;
+	// Heap (MALLOC_CAP_DEFAULT)
+	uint32_t heap_free;
+	uint32_t heap_free_min;         // since boot, as tracked by the allocator
+	uint32_t heap_largest;
+	uint32_t heap_largest_min;      // smallest largest-block sampled: fragmentation
+	// Tasks
+	uint8_t task_count;
+	metrics_task_t tasks[METRICS_MAX_TASKS];
+	// Queues: current / peak / capacity
+	uint16_t interview_queue, interview_queue_peak, interview_queue_len;
+	uint8_t interview_in_flight_peak, interview_window;
+	uint16_t actuator_ring_peak, actuator_ring_len;
+	uint16_t event_log_peak, event_log_len;
+	uint32_t event_log_dropped;
+	uint32_t alerts_dropped;
+	// Counters
+	uint32_t requests[METRICS_REQ_COUNT][METRICS_RESULT_COUNT];
+	uint32_t announces;
+	uint32_t classified;
+	uint32_t alerts;
+	uint32_t reports;               // attribute reports received
+	uint16_t reporting, offline;    // devices reporting now, and of those the silent ones
+	// Boot
+	uint32_t boot_us[METRICS_BOOT_COUNT];   // time since boot each phase completed
+	uint8_t boot_phases;                    // bit per phase reached
+	bool network_resumed;                   // restored from zb_storage, not formed
+	uint16_t restore_failures;              // failed restores of zb_storage, retried
+	uint16_t formation_failures;            // failed formations, retried
+} metrics_snapshot_t;
+
+// Start sampling; call at the end of app_main, which also records the main task's stack
+esp_err_t metrics_init(void);
+
+// Follow the stack of a task created by the app (stack_bytes as passed to xTaskCreate)
+void metrics_register_task(TaskHandle_t task, const char *name, uint32_t stack_bytes);
+
+// Count a request outcome (Zigbee task, or with the Zigbee lock held)
+void metrics_count(metrics_req_t req, metrics_result_t result);
+// Count the outcome of a ZDO request from its ZDP status (esp_zb_zdp_status_t)
+void metrics_count_zdp(metrics_req_t req, int zdp_status);
+void metrics_count_announce(void);
+// A boot phase completed; only the first time counts (any task)
+void metrics_boot_mark(metrics_boot_t phase);
+// METRICS_BOOT_NETWORK, restored from zb_storage or formed
+void metrics_boot_network(bool resumed);
+// A restore from zb_storage (resume) or a formation failed and is retried
+void metrics_count_network_failure(bool resume);
+
+// Takes the Zigbee stack lock to read the Zigbee task's counters (console or another app task)
+void metrics_snapshot(metrics_snapshot_t *out);
+void metrics_print(void);
+const char *metrics_req_name(metrics_req_t req);
+const char *metrics_boot_name(metrics_boot_t phase);
@@ -0,0 +1,373 @@
+// Presence: reporting setup, liveness from attribute reports, firmware re-reads
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "nwk/esp_zigbee_nwk.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+#include "zcl/esp_zigbee_zcl_common.h"
+#include "interview.h"
+#include "event_log.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "presence.h"
+#include "address.h"
+
+static const char *TAG = "ZB_SCAN";
+
+#define BASIC_CLUSTER       (0x0000)
+#define ON_OFF_CLUSTER      (0x0006)
+#define ATTR_ON_OFF         (0x0000)
+#define ATTR_SW_BUILD       (0x4000)
+#define LOCAL_EP            (1)
+// Maximum interval 0: report on change only, no periodic report
+#define REPORT_ON_CHANGE    (0)
+
+_Static_assert(PRESENCE_HEARTBEAT_S > 0 && PRESENCE_HEARTBEAT_S < 0xFFFF, "On/Off max reporting interval");
+
+typedef enum {
+	SETUP_BIND_ON_OFF,
+	SETUP_REPORT_ON_OFF,
+	SETUP_BIND_BASIC,               // Basic steps are best effort
+	SETUP_REPORT_BASIC,
+	SETUP_DONE,
+} setup_step_t;
+
+static presence_stats_t s_stats;
+static bool s_started;
+// Setup of one device at a time
+static bool s_active;
+static bool s_waiting;              // request out, answer pending
+static uint16_t s_dev;              // device table index
+static uint16_t s_short;
+static setup_step_t s_step;
+static bool s_basic_ok;
+static uint8_t s_seq;               // Bind user_ctx: answers to abandoned requests are ignored
+static uint8_t s_tsn;               // Configure Reporting
+
+static void setup_cb(uint8_t param);
+static void issue_cb(uint8_t param);
+static void timeout_cb(uint8_t param);
+
+static uint32_t now_ms(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void log_presence(const device_entry_t *dev, uint8_t state, uint32_t silent_ms)
+{
+	evlog_presence_t p = { .short_addr = dev->short_addr, .endpoint = dev->report_ep, .state = state,
+						   .silent_s = silent_ms / 1000 };
+	event_log_write(EVLOG_PRESENCE, &p, sizeof(p));
+}
+
+static void schedule_setup(uint32_t delay_ms)
+{
+	if (!s_started || s_active) return;
+	esp_zb_scheduler_alarm_cancel(setup_cb, 0);
+	esp_zb_scheduler_alarm(setup_cb, 0, delay_ms);
+}
+
+static bool is_candidate(const device_entry_t *e)
+{
+	return (e->state == DEVICE_STATE_DONE || e->state == DEVICE_STATE_REFRESH) && (e->flags & DEVICE_FLAG_ON_OFF) &&
+		   e->report_ep && !(e->flags & (DEVICE_FLAG_REPORTING | DEVICE_FLAG_NO_REPORTING)) &&
+		   e->short_addr != DEVICE_TABLE_NO_ADDR;
+}
+
+static bool interviews_busy(void)
+{
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.in_flight || is.queue_depth;
+}
+
+// The device being set up, unless it left the table or changed address meanwhile
+static device_entry_t *setup_dev(void)
+{
+	device_entry_t *d = device_table_at(s_dev);
+	return d && d->short_addr == s_short ? d : NULL;
+}
+
+static void refresh_fw(device_entry_t *dev)
+{
+	if (interview_refresh(dev)) s_stats.fw_rereads++;
+}
+
+static void setup_finish(device_entry_t *d, bool ok)
+{
+	s_active = false;
+	s_waiting = false;
+	esp_zb_scheduler_alarm_cancel(timeout_cb, 0);
+	if (d && ok) {
+		d->flags = (uint8_t)((d->flags | DEVICE_FLAG_REPORTING) & ~(DEVICE_FLAG_NO_REPORTING | DEVICE_FLAG_OFFLINE));
+		device_table_touch(d);
+		s_stats.subscribed++;
+		log_presence(d, EVLOG_PRESENCE_SUBSCRIBED, 0);
+		ESP_LOGI(TAG, "0x%04X ep%u reports On/Off every %u s%s", d->short_addr, d->report_ep,
+				 (unsigned)PRESENCE_HEARTBEAT_S, s_basic_ok ? " and firmware changes" : "");
+	} else if (d) {
+		d->flags |= DEVICE_FLAG_NO_REPORTING;
+		s_stats.refused++;
+		log_presence(d, EVLOG_PRESENCE_REFUSED, 0);
+		ESP_LOGW(TAG, "0x%04X refused attribute reporting: liveness unknown until it announces", d->short_addr);
+	}
+	schedule_setup(PRESENCE_REQ_GAP_MS);
+}
+
+// Outcome of the request of the current step
+static void step_done(bool ok)
+{
+	s_waiting = false;
+	esp_zb_scheduler_alarm_cancel(timeout_cb, 0);
+	device_entry_t *d = setup_dev();
+	if (!d) {
+		setup_finish(NULL, false);
+		return;
+	}
+	if (!ok) {
+		if (s_step < SETUP_BIND_BASIC) {
+			setup_finish(d, false);
+			return;
+		}
+		// On/Off alone still tells whether the device is there
+		s_basic_ok = false;
+		s_stats.basic_refused++;
+		setup_finish(d, true);
+		return;
+	}
+	if (++s_step == SETUP_DONE) {
+		setup_finish(d, true);
+		return;
+	}
+	esp_zb_scheduler_alarm(issue_cb, 0, PRESENCE_REQ_GAP_MS);
+}
+
+static void bind_cb(esp_zb_zdp_status_t zdo_status, void *user_ctx)
+{
+	HEAP_GUARD_APP_SCOPE();
+	if (!s_waiting || (uint8_t)(uintptr_t)user_ctx != s_seq) return;
+	metrics_count_zdp(METRICS_REQ_BIND, zdo_status);
+	if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+		ESP_LOGD(TAG, "Bind on 0x%04X failed: status=%d", s_short, zdo_status);
+	}
+	step_done(zdo_status == ESP_ZB_ZDP_STATUS_SUCCESS);
+}
+
+void presence_on_config_report_resp(uint16_t short_addr, uint8_t tsn, uint8_t status)
+{
+	if (!s_waiting || short_addr != s_short || tsn != s_tsn) return;
+	bool ok = status == ESP_ZB_ZCL_STATUS_SUCCESS;
+	metrics_count(METRICS_REQ_CONFIG_REPORT, ok ? METRICS_OK : METRICS_FAILED);
+	if (!ok) ESP_LOGD(TAG, "Configure Reporting on 0x%04X refused: status=0x%02X", short_addr, status);
+	step_done(ok);
+}
+
+static void timeout_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	if (!s_waiting) return;
+	bool bind = s_step == SETUP_BIND_ON_OFF || s_step == SETUP_BIND_BASIC;
+	metrics_count(bind ? METRICS_REQ_BIND : METRICS_REQ_CONFIG_REPORT, METRICS_TIMEOUT);
+	step_done(false);
+}
+
+static void send_bind(const device_entry_t *d, uint16_t cluster)
+{
+	esp_zb_zdo_bind_req_param_t req = {
+		.src_endp = d->report_ep,
+		.cluster_id = cluster,
+		.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED,
+		.dst_endp = LOCAL_EP,
+		.req_dst_addr = d->short_addr,
+	};
+	memcpy(req.src_address, d->ieee, sizeof(req.src_address));
+	esp_zb_get_long_address(req.dst_address_u.addr_long);
+	metrics_count(METRICS_REQ_BIND, METRICS_ISSUED);
+	esp_zb_zdo_device_bind_req(&req, bind_cb, (void *)(uintptr_t)s_seq);
+}
+
+static void send_config_report(const device_entry_t *d, uint16_t cluster, uint16_t attr, uint8_t type,
+							   uint16_t max_interval_s)
+{
+	// Booleans and strings have no reportable change: any change is reported
+	esp_zb_zcl_config_report_record_t rec = {
+		.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND,
+		.attributeID = attr,
+		.attrType = type,
+		.min_interval = 0,
+		.max_interval = max_interval_s,
+		.reportable_change = NULL,
+	};
+	esp_zb_zcl_config_report_cmd_t cmd = {
+		.zcl_basic_cmd = {
+			.dst_addr_u = {.addr_short = d->short_addr},
+			.dst_endpoint = d->report_ep,
+			.src_endpoint = LOCAL_EP,
+		},
+		.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+		.clusterID = cluster,
+		.record_number = 1,
+		.record_field = &rec,
+	};
+	metrics_count(METRICS_REQ_CONFIG_REPORT, METRICS_ISSUED);
+	s_tsn = esp_zb_zcl_config_report_cmd_req(&cmd);
+}
+
+// Send the request of the current step
+static void issue_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	device_entry_t *d = setup_dev();
+	if (!s_active || s_waiting) return;
+	if (!d) {
+		setup_finish(NULL, false);
+		return;
+	}
+	s_waiting = true;
+	s_seq++;
+	s_stats.reqs++;
+	switch (s_step) {
+	case SETUP_BIND_ON_OFF:
+		send_bind(d, ON_OFF_CLUSTER);
+		break;
+	case SETUP_REPORT_ON_OFF:
+		send_config_report(d, ON_OFF_CLUSTER, ATTR_ON_OFF, ESP_ZB_ZCL_ATTR_TYPE_BOOL, PRESENCE_HEARTBEAT_S);
+		break;
+	case SETUP_BIND_BASIC:
+		send_bind(d, BASIC_CLUSTER);
+		break;
+	default:
+		send_config_report(d, BASIC_CLUSTER, ATTR_SW_BUILD, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, REPORT_ON_CHANGE);
+		break;
+	}
+	// The stack times out ZDO requests itself, but a ZCL command nobody answers has no callback
+	if (s_waiting) esp_zb_scheduler_alarm(timeout_cb, 0, PRESENCE_TIMEOUT_MS);
+}
+
+// Start the setup of the next device that needs one
+static void setup_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	if (s_active) return;
+	uint16_t i = 0;
+	for (; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+		device_entry_t *e = device_table_at(i);
+		if (e && is_candidate(e)) break;
+	}
+	if (i == DEVICE_TABLE_MAX_DEVICES) return;
+	// Leave the air to the interviews
+	if (interviews_busy()) {
+		esp_zb_scheduler_alarm(setup_cb, 0, PRESENCE_BUSY_RETRY_MS);
+		return;
+	}
+	s_active = true;
+	s_dev = i;
+	s_short = device_table_at(i)->short_addr;
+	s_step = SETUP_BIND_ON_OFF;
+	s_basic_ok = true;
+	issue_cb(0);
+}
+
+// Reporting devices that went quiet
+static void check_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	uint32_t now = now_ms();
+	const uint32_t limit_ms = (uint32_t)PRESENCE_HEARTBEAT_S * PRESENCE_MISSED_REPORTS * 1000u;
+	for (uint16_t i = 0; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+		device_entry_t *e = device_table_at(i);
+		if (!e || (e->flags & (DEVICE_FLAG_REPORTING | DEVICE_FLAG_OFFLINE)) != DEVICE_FLAG_REPORTING) continue;
+		uint32_t silent = now - e->last_seen_ms;
+		if (silent <= limit_ms) continue;
+		e->flags |= DEVICE_FLAG_OFFLINE;
+		s_stats.went_offline++;
+		log_presence(e, EVLOG_PRESENCE_OFFLINE, silent);
+		ESP_LOGW(TAG, "0x%04X offline: no report for %lu s", e->short_addr, (unsigned long)(silent / 1000));
+	}
+	esp_zb_scheduler_alarm(check_cb, 0, PRESENCE_CHECK_MS);
+	schedule_setup(0);
+}
+
+static void came_back(device_entry_t *dev, uint32_t silent_ms)
+{
+	dev->flags &= (uint8_t)~DEVICE_FLAG_OFFLINE;
+	s_stats.came_back++;
+	log_presence(dev, EVLOG_PRESENCE_BACK, silent_ms);
+	ESP_LOGI(TAG, "0x%04X back after %lu s", dev->short_addr, (unsigned long)(silent_ms / 1000));
+	// It may have been away for a firmware update
+	refresh_fw(dev);
+}
+
+void presence_start(void)
+{
+	if (s_started) return;
+	s_started = true;
+	esp_zb_scheduler_alarm(check_cb, 0, PRESENCE_CHECK_MS);
+	schedule_setup(PRESENCE_REQ_GAP_MS);
+}
+
+void presence_on_classified(device_entry_t *dev)
+{
+	if (dev && is_candidate(dev)) schedule_setup(PRESENCE_REQ_GAP_MS);
+}
+
+void presence_on_annce(device_entry_t *dev)
+{
+	if (!dev) return;
+	// A rejoin may follow a factory reset, which clears the device's bindings: set up again
+	dev->flags &= (uint8_t)~(DEVICE_FLAG_REPORTING | DEVICE_FLAG_NO_REPORTING);
+	if (dev->flags & DEVICE_FLAG_OFFLINE) came_back(dev, 0);
+	schedule_setup(PRESENCE_REQ_GAP_MS);
+}
+
+void presence_on_leave(device_entry_t *dev)
+{
+	dev->flags &= (uint8_t)~(DEVICE_FLAG_REPORTING | DEVICE_FLAG_NO_REPORTING | DEVICE_FLAG_OFFLINE);
+}
+
+void presence_on_report(uint16_t short_addr, uint8_t endpoint, uint16_t cluster, uint16_t attr_id)
+{
+	s_stats.reports++;
+	device_entry_t *dev = device_table_find_short(short_addr);
+	if (!dev) {
+		s_stats.reports_unknown++;
+		address_resolve(short_addr);
+		return;
+	}
+	uint32_t silent = now_ms() - dev->last_seen_ms;
+	device_table_touch(dev);
+	if (cluster == ON_OFF_CLUSTER && !(dev->flags & DEVICE_FLAG_REPORTING)) {
+		// Bound before the coordinator restarted
+		dev->flags = (uint8_t)((dev->flags | DEVICE_FLAG_REPORTING | DEVICE_FLAG_ON_OFF) & ~DEVICE_FLAG_NO_REPORTING);
+		if (!dev->report_ep) dev->report_ep = endpoint;
+		s_stats.learned++;
+		ESP_LOGI(TAG, "0x%04X ep%u already reports On/Off", short_addr, endpoint);
+	}
+	if (dev->flags & DEVICE_FLAG_OFFLINE) {
+		came_back(dev, silent);
+	} else if (cluster == BASIC_CLUSTER && attr_id == ATTR_SW_BUILD) {
+		ESP_LOGI(TAG, "0x%04X reports a new SW build", short_addr);
+		refresh_fw(dev);
+	}
+}
+
+void presence_get_stats(presence_stats_t *out)
+{
+	presence_stats_t st = s_stats;
+	st.reporting = st.offline = 0;
+	for (uint16_t i = 0; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+		const device_entry_t *e = device_table_at(i);
+		if (!e || !(e->flags & DEVICE_FLAG_REPORTING)) continue;
+		st.reporting++;
+		st.offline += (e->flags & DEVICE_FLAG_OFFLINE) != 0;
+	}
+	*out = st;
+}
@@ -0,0 +1,88 @@
+// Presence: attribute reporting instead of repeated interrogation of classified devices
+// - Once a device with an On/Off server cluster is classified, its On/Off cluster is bound to
+//   the coordinator (ZDO Bind) and On/Off reporting is configured with PRESENCE_HEARTBEAT_S as
+//   the maximum interval, so the device reports at least that often. Basic is bound too and its
+//   SW build ID reported on change where the device allows it; many refuse, which is not an error
+// - Every report refreshes the device's last-seen time. A reporting device silent for
+//   PRESENCE_MISSED_REPORTS heartbeats is marked offline. When it is heard from again (a report,
+//   or an announce) or reports a Basic change, its Basic firmware attributes are re-read
+//   (interview_refresh), so a firmware update shows up as a new fingerprint
+// - Bindings live in the devices: after a coordinator reboot, a report from a device in the
+//   device table marks it reporting again without any request; one from an unknown short address
+//   has it resolved (address.c)
+// - Setup requests go out one at a time, PRESENCE_REQ_GAP_MS apart, and wait while interviews are
+//   in progress. A device that refuses or does not answer is asked again only after it re-announces
+// - Runs in the Zigbee task
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "device_table.h"
+
+// Maximum reporting interval of On/Off: the heartbeat (Kconfig: Zigbee scanner -> Presence)
+#ifndef PRESENCE_HEARTBEAT_S
+#ifdef CONFIG_ZB_SCAN_PRESENCE_HEARTBEAT_S
+#define PRESENCE_HEARTBEAT_S        (CONFIG_ZB_SCAN_PRESENCE_HEARTBEAT_S)
+#else
+#define PRESENCE_HEARTBEAT_S        (300)
+#endif
+#endif
+// Heartbeats a device may miss before it is marked offline
+#ifndef PRESENCE_MISSED_REPORTS
+#ifdef CONFIG_ZB_SCAN_PRESENCE_MISSED_REPORTS
+#define PRESENCE_MISSED_REPORTS     (CONFIG_ZB_SCAN_PRESENCE_MISSED_REPORTS)
+#else
+#define PRESENCE_MISSED_REPORTS     (3)
+#endif
+#endif
+// Period of the silence check
+#ifndef PRESENCE_CHECK_MS
+#define PRESENCE_CHECK_MS           (30 * 1000)
+#endif
+// Spacing between setup requests, the retry delay while interviews are busy, and the wait for
+// a Configure Reporting response
+#ifndef PRESENCE_REQ_GAP_MS
+#define PRESENCE_REQ_GAP_MS         (100)
+#endif
+#ifndef PRESENCE_BUSY_RETRY_MS
+#define PRESENCE_BUSY_RETRY_MS      (500)
+#endif
+#ifndef PRESENCE_TIMEOUT_MS
+#define PRESENCE_TIMEOUT_MS         (5000)
+#endif
+
+typedef struct {
+	uint16_t reporting;             // devices reporting now
+	uint16_t offline;               // of those, the ones marked offline
+	uint32_t subscribed;            // setups completed
+	uint32_t refused;               // setups refused or unanswered
+	uint32_t basic_refused;         // Basic reporting refused: On/Off alone still gives liveness
+	uint32_t reqs;                  // Bind and Configure Reporting requests sent
+	uint32_t reports;
+	uint32_t reports_unknown;       // from short addresses not in the device table
+	uint32_t learned;               // devices found reporting without a setup (earlier boot)
+	uint32_t went_offline;
+	uint32_t came_back;
+	uint32_t fw_rereads;            // Basic firmware re-reads queued
+} presence_stats_t;
+
+// The network is up: start the silence check and set up the devices already classified
+void presence_start(void);
+
+// The interview classified dev for the first time
+void presence_on_classified(device_entry_t *dev);
+
+// Device announce, after the device table and the interview have seen it
+void presence_on_annce(device_entry_t *dev);
+
+// The device left the network for good: it keeps no binding
+void presence_on_leave(device_entry_t *dev);
+
+// ESP_ZB_CORE_REPORT_ATTR_CB_ID
+void presence_on_report(uint16_t short_addr, uint8_t endpoint, uint16_t cluster, uint16_t attr_id);
+
+// ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID: status is the first failed record's, or success
+void presence_on_config_report_resp(uint16_t short_addr, uint8_t tsn, uint8_t status);
+
+void presence_get_stats(presence_stats_t *out);
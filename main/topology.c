@@ -0,0 +1,241 @@
+// Network topology: parents from Update-Device, link quality from neighbour tables
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "nwk/esp_zigbee_nwk.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+#include "interview.h"
+#include "address.h"
+#include "metrics.h"
+#include "heap_guard.h"
+#include "topology.h"
+
+static const char *TAG = "ZB_SCAN";
+
+// Neighbour relationship (Mgmt_Lqi_rsp and the NWK neighbour table)
+#define REL_PARENT          (0)
+#define REL_CHILD           (1)
+// Update-Device status
+#define UPDATE_LEFT         (2)
+// Announce capability: full-function device
+#define CAP_ROUTER          (0x02)
+
+static topology_stats_t s_stats;
+static bool s_started;
+static bool s_pass_active;
+static bool s_pass_again;           // joins during the pass: run another one after it
+static uint16_t s_cursor;           // device table index of the router being crawled
+static uint8_t s_start_index;       // next Mgmt_Lqi page of that router
+static uint16_t s_crawl_short;
+static bool s_in_flight;
+
+static void crawl_step(uint8_t param);
+static void refresh_cb(uint8_t param);
+
+static void schedule_refresh(uint32_t delay_ms)
+{
+	if (!s_started) return;
+	if (s_pass_active) {
+		s_pass_again = true;
+		return;
+	}
+	esp_zb_scheduler_alarm_cancel(refresh_cb, 0);
+	esp_zb_scheduler_alarm(refresh_cb, 0, delay_ms);
+}
+
+static void set_parent(device_entry_t *dev, uint16_t parent_short)
+{
+	if (dev->parent_short != parent_short) {
+		dev->parent_short = parent_short;
+		dev->lqi = 0;               // the link quality was for the old parent
+	}
+	if (parent_short == 0x0000) {
+		dev->depth = 1;
+		return;
+	}
+	device_entry_t *parent = device_table_find_short(parent_short);
+	if (parent) parent->flags |= DEVICE_FLAG_ROUTER | DEVICE_FLAG_PARENT;
+	dev->depth = parent && parent->depth ? (uint8_t)(parent->depth + 1) : 0;
+}
+
+void topology_on_device_update(const uint8_t ieee[8], uint16_t short_addr, uint16_t parent_short, uint8_t status)
+{
+	s_stats.updates++;
+	if (status == UPDATE_LEFT) {
+		address_on_leave(ieee, short_addr, false);
+		return;
+	}
+	device_entry_t *dev = address_bind(ieee, short_addr);
+	if (dev) set_parent(dev, parent_short);
+}
+
+void topology_on_annce(device_entry_t *dev, uint8_t capability)
+{
+	if (dev && (capability & CAP_ROUTER)) dev->flags |= DEVICE_FLAG_ROUTER;
+	schedule_refresh(TOPOLOGY_SETTLE_MS);
+}
+
+static bool interviews_busy(void)
+{
+	interview_stats_t is;
+	interview_get_stats(&is);
+	return is.in_flight || is.queue_depth;
+}
+
+// The coordinator's children, from its own neighbour table
+static void read_local_neighbors(void)
+{
+	esp_zb_nwk_info_iterator_t it = ESP_ZB_NWK_INFO_ITERATOR_INIT;
+	esp_zb_nwk_neighbor_info_t nbr;
+	while (esp_zb_nwk_get_next_neighbor(&it, &nbr) == ESP_OK) {
+		if (nbr.relationship != REL_CHILD) continue;
+		device_entry_t *dev = device_table_find(nbr.ieee_addr);
+		if (!dev) continue;
+		set_parent(dev, 0x0000);
+		dev->lqi = nbr.lqi;
+	}
+}
+
+static void pass_done(void)
+{
+	s_pass_active = false;
+	s_stats.passes++;
+	topology_log();
+	esp_zb_scheduler_alarm(refresh_cb, 0, s_pass_again ? TOPOLOGY_SETTLE_MS : TOPOLOGY_REFRESH_MS);
+	s_pass_again = false;
+}
+
+static void lqi_cb(const esp_zb_zdo_mgmt_lqi_rsp_t *rsp, void *user_ctx)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)user_ctx;
+	s_in_flight = false;
+	device_entry_t *router = device_table_at(s_cursor);
+	bool next_router = true;
+	metrics_count_zdp(METRICS_REQ_MGMT_LQI, rsp ? rsp->status : -1);
+	if (!rsp || rsp->status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+		s_stats.lqi_failures++;
+		ESP_LOGW(TAG, "Mgmt_Lqi to 0x%04X failed (status=%d)", s_crawl_short, rsp ? rsp->status : -1);
+	} else if (router && router->short_addr == s_crawl_short) {
+		for (uint8_t i = 0; i < rsp->neighbor_table_list_count; i++) {
+			const esp_zb_zdo_neighbor_table_list_t *n = &rsp->neighbor_table_list[i];
+			if (n->relationship == REL_PARENT) {
+				if (!router->depth && n->depth < UINT8_MAX) router->depth = (uint8_t)(n->depth + 1);
+				continue;
+			}
+			if (n->relationship != REL_CHILD) continue;
+			device_entry_t *child = device_table_find(n->ieee_addr);
+			if (!child) continue;
+			set_parent(child, router->short_addr);
+			child->depth = n->depth;
+			child->lqi = n->lqi;
+		}
+		uint16_t next = (uint16_t)(rsp->start_index + rsp->neighbor_table_list_count);
+		if (rsp->neighbor_table_list_count && next < rsp->neighbor_table_entries && next <= UINT8_MAX) {
+			s_start_index = (uint8_t)next;
+			next_router = false;
+		}
+	}
+	if (next_router) {
+		s_cursor++;
+		s_start_index = 0;
+	}
+	esp_zb_scheduler_alarm(crawl_step, 0, TOPOLOGY_REQ_GAP_MS);
+}
+
+// One Mgmt_Lqi page to the next router that has children
+static void crawl_step(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	if (s_in_flight) return;
+	device_entry_t *router = NULL;
+	for (; s_cursor < DEVICE_TABLE_MAX_DEVICES; s_cursor++, s_start_index = 0) {
+		device_entry_t *e = device_table_at(s_cursor);
+		if (e && (e->flags & DEVICE_FLAG_PARENT) && e->short_addr != DEVICE_TABLE_NO_ADDR) {
+			router = e;
+			break;
+		}
+	}
+	if (!router) {
+		pass_done();
+		return;
+	}
+	// Leave the air to the interviews
+	if (interviews_busy()) {
+		esp_zb_scheduler_alarm(crawl_step, 0, TOPOLOGY_BUSY_RETRY_MS);
+		return;
+	}
+	esp_zb_zdo_mgmt_lqi_req_param_t req = { .dst_addr = router->short_addr, .start_index = s_start_index };
+	s_crawl_short = router->short_addr;
+	s_in_flight = true;
+	s_stats.lqi_reqs++;
+	metrics_count(METRICS_REQ_MGMT_LQI, METRICS_ISSUED);
+	esp_zb_zdo_mgmt_lqi_req(&req, lqi_cb, NULL);
+}
+
+static void refresh_cb(uint8_t param)
+{
+	HEAP_GUARD_APP_SCOPE();
+	(void)param;
+	if (s_pass_active) return;
+	s_pass_active = true;
+	s_cursor = 0;
+	s_start_index = 0;
+	read_local_neighbors();
+	crawl_step(0);
+}
+
+void topology_start(void)
+{
+	s_started = true;
+	schedule_refresh(TOPOLOGY_REFRESH_MS);
+}
+
+void topology_get_stats(topology_stats_t *out)
+{
+	topology_stats_t st = s_stats;
+	st.devices = st.routers = st.parents = st.coordinator_children = 0;
+	st.unknown_parent = st.unknown_lqi = 0;
+	st.max_depth = 0;
+	memset(st.by_depth, 0, sizeof(st.by_depth));
+	for (uint16_t i = 0; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+		const device_entry_t *e = device_table_at(i);
+		if (!e) continue;
+		st.devices++;
+		st.routers += (e->flags & DEVICE_FLAG_ROUTER) != 0;
+		st.parents += (e->flags & DEVICE_FLAG_PARENT) != 0;
+		st.coordinator_children += e->parent_short == 0x0000;
+		st.unknown_parent += e->parent_short == DEVICE_TABLE_NO_ADDR;
+		st.unknown_lqi += e->lqi == 0;
+		if (e->depth > st.max_depth) st.max_depth = e->depth;
+		st.by_depth[e->depth < TOPOLOGY_DEPTH_BUCKETS ? e->depth : TOPOLOGY_DEPTH_BUCKETS - 1]++;
+	}
+	*out = st;
+}
+
+void topology_log(void)
+{
+	topology_stats_t st;
+	topology_get_stats(&st);
+	ESP_LOGI(TAG, "Topology: %u devices, %u routers (%u with children), %u on the coordinator, depth max %u, "
+			 "parent unknown %u, LQI unknown %u", st.devices, st.routers, st.parents, st.coordinator_children,
+			 st.max_depth, st.unknown_parent, st.unknown_lqi);
+	for (uint16_t i = 0; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+		const device_entry_t *r = device_table_at(i);
+		if (!r || !(r->flags & DEVICE_FLAG_PARENT)) continue;
+		unsigned children = 0, lqi_sum = 0, lqi_n = 0;
+		for (uint16_t k = 0; k < DEVICE_TABLE_MAX_DEVICES; k++) {
+			const device_entry_t *c = device_table_at(k);
+			if (!c || c->parent_short != r->short_addr) continue;
+			children++;
+			if (c->lqi) {
+				lqi_sum += c->lqi;
+				lqi_n++;
+			}
+		}
+		ESP_LOGI(TAG, "  router 0x%04X: depth %u, LQI %u, %u children (LQI avg %u)", r->short_addr, r->depth, r->lqi,
+				 children, lqi_n ? lqi_sum / lqi_n : 0);
+	}
+}
@@ -0,0 +1,61 @@
+// Network topology: where each device of the device table sits in the mesh
+// - Parent from the Update-Device a router sends the trust center for every join or rejoin
+//   through it (DEVICE_UPDATE signal); the coordinator's own children come from its neighbour table
+// - Link quality and depth from the coordinator's neighbour table (no radio traffic) and from
+//   Mgmt_Lqi requests to the routers that have children, one page in flight at a time
+// - A refresh pass runs TOPOLOGY_SETTLE_MS after joins stop and every TOPOLOGY_REFRESH_MS;
+//   Mgmt_Lqi requests wait while interviews are in progress
+// - Runs in the Zigbee task
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device_table.h"
+
+// Quiet time after the last join before a refresh pass
+#ifndef TOPOLOGY_SETTLE_MS
+#define TOPOLOGY_SETTLE_MS          (10 * 1000)
+#endif
+// Periodic refresh of link quality
+#ifndef TOPOLOGY_REFRESH_MS
+#define TOPOLOGY_REFRESH_MS         (15 * 60 * 1000)
+#endif
+// Spacing between Mgmt_Lqi pages, and the retry delay while interviews are busy
+#ifndef TOPOLOGY_REQ_GAP_MS
+#define TOPOLOGY_REQ_GAP_MS         (100)
+#endif
+#ifndef TOPOLOGY_BUSY_RETRY_MS
+#define TOPOLOGY_BUSY_RETRY_MS      (500)
+#endif
+// Depths counted separately in topology_stats_t.by_depth; deeper devices go in the last bucket
+#define TOPOLOGY_DEPTH_BUCKETS      (5)
+
+typedef struct {
+	uint16_t devices;
+	uint16_t routers;                       // devices announced as routers
+	uint16_t parents;                       // routers with devices joined through them
+	uint16_t coordinator_children;
+	uint16_t unknown_parent;
+	uint16_t unknown_lqi;
+	uint8_t max_depth;
+	uint16_t by_depth[TOPOLOGY_DEPTH_BUCKETS];  // [0] depth unknown, [1] coordinator children, ...
+	uint32_t updates;                       // Update-Device indications
+	uint32_t passes;                        // completed refresh passes
+	uint32_t lqi_reqs;
+	uint32_t lqi_failures;
+} topology_stats_t;
+
+// The network is up: start the periodic refresh
+void topology_start(void);
+
+// ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE: short_addr joined or rejoined through parent_short
+// (status 0 secured rejoin, 1 unsecured join, 2 left, 3 trust center rejoin)
+void topology_on_device_update(const uint8_t ieee[8], uint16_t short_addr, uint16_t parent_short, uint8_t status);
+
+// Device announce: records the router capability and schedules a refresh
+void topology_on_annce(device_entry_t *dev, uint8_t capability);
+
+void topology_get_stats(topology_stats_t *out);
+
+// One summary line, then one line per router with children
+void topology_log(void);
@@ -0,0 +1,77 @@
+// Simulation input: edge-triggered GPIO interrupt with debounce
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "actuator.h"
+#include "trigger_input.h"
+
+static const char *TAG = "ZB_SCAN";
+
+// Written by the ISR only
+static volatile trigger_input_stats_t s_stats;
+static int64_t s_last_accepted_us;
+static bool s_have_accepted;
+// Minimum time between accepted edges
+static volatile uint32_t s_filter_us = TRIGGER_INPUT_PULSE_TRAIN ? TRIGGER_INPUT_PULSE_MIN_US : TRIGGER_INPUT_DEBOUNCE_US;
+
+static void IRAM_ATTR trigger_isr(void *arg)
+{
+	(void)arg;
+	int64_t now = esp_timer_get_time();
+	s_stats.edges++;
+	// Leading-edge debounce: the first edge fires at once, the ones that follow it within
+	// the filter time are contact bounce
+	if (s_have_accepted && now - s_last_accepted_us < (int64_t)s_filter_us) {
+		s_stats.bounces++;
+		return;
+	}
+	s_have_accepted = true;
+	s_last_accepted_us = now;
+	s_stats.accepted++;
+	BaseType_t woken = pdFALSE;
+	actuator_post_simulation_from_isr(now, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+void trigger_input_set_pulse_train(bool on)
+{
+	s_filter_us = on ? TRIGGER_INPUT_PULSE_MIN_US : TRIGGER_INPUT_DEBOUNCE_US;
+	ESP_LOGI(TAG, "Simulation input on GPIO %d: %s mode (%lu us between triggers)", SIMULATION_PIN,
+			 on ? "pulse-train" : "switch", (unsigned long)s_filter_us);
+}
+
+void trigger_input_get_stats(trigger_input_stats_t *out)
+{
+	out->edges = s_stats.edges;
+	out->accepted = s_stats.accepted;
+	out->bounces = s_stats.bounces;
+}
+
+esp_err_t trigger_input_init(void)
+{
+	// The pull-down keeps a disconnected pin from raising an interrupt storm
+	gpio_config_t io = {
+		.pin_bit_mask = 1ULL << SIMULATION_PIN,
+		.mode = GPIO_MODE_INPUT,
+		.pull_up_en = GPIO_PULLUP_DISABLE,
+		.pull_down_en = GPIO_PULLDOWN_ENABLE,
+		.intr_type = GPIO_INTR_POSEDGE,
+	};
+	esp_err_t err = gpio_config(&io);
+	if (err == ESP_OK) {
+		err = gpio_install_isr_service(0);
+		// Already installed by another driver: share it
+		if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;
+	}
+	if (err == ESP_OK) err = gpio_isr_handler_add(SIMULATION_PIN, trigger_isr, NULL);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Failed to configure GPIO %d for simulation: %s", SIMULATION_PIN, esp_err_to_name(err));
+		return err;
+	}
+	trigger_input_set_pulse_train(TRIGGER_INPUT_PULSE_TRAIN);
+	return ESP_OK;
+}
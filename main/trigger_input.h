@@ -0,0 +1,55 @@
+// Simulation input: a rising edge on SIMULATION_PIN simulates a detection
+// - Edge-triggered GPIO interrupt, no polling timer
+// - Debounced in the ISR: an edge closer than the debounce time to the last accepted edge
+//   is a bounce and is only counted
+// - Pulse-train mode replaces the debounce with a much shorter minimum pulse period, so
+//   every pulse of a burst injected by a test rig is one simulated detection
+// - Accepted edges are timestamped in the ISR and handed to the actuator task, which
+//   counts every one of them and measures trigger-to-alert latency (actuator_stats_t)
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+// Pin for simulating bulb detection (rising edge = trigger alarm)
+#ifndef SIMULATION_PIN
+#define SIMULATION_PIN                  (11)
+#endif
+
+// Kconfig: Zigbee scanner -> Simulation input
+#ifndef TRIGGER_INPUT_DEBOUNCE_US
+#ifdef CONFIG_ZB_SCAN_SIM_DEBOUNCE_US
+#define TRIGGER_INPUT_DEBOUNCE_US       (CONFIG_ZB_SCAN_SIM_DEBOUNCE_US)
+#else
+#define TRIGGER_INPUT_DEBOUNCE_US       (20 * 1000)
+#endif
+#endif
+#ifndef TRIGGER_INPUT_PULSE_MIN_US
+#ifdef CONFIG_ZB_SCAN_SIM_PULSE_MIN_US
+#define TRIGGER_INPUT_PULSE_MIN_US      (CONFIG_ZB_SCAN_SIM_PULSE_MIN_US)
+#else
+#define TRIGGER_INPUT_PULSE_MIN_US      (50)
+#endif
+#endif
+#ifdef CONFIG_ZB_SCAN_SIM_PULSE_TRAIN
+#define TRIGGER_INPUT_PULSE_TRAIN       (true)
+#else
+#define TRIGGER_INPUT_PULSE_TRAIN       (false)
+#endif
+
+typedef struct {
+	uint32_t edges;             // rising edges seen by the ISR
+	uint32_t accepted;          // edges handed over as simulated detections
+	uint32_t bounces;           // edges rejected by the debounce / minimum pulse period
+} trigger_input_stats_t;
+
+// Configure SIMULATION_PIN as an interrupt input (installs the GPIO ISR service)
+esp_err_t trigger_input_init(void);
+
+// Switch between pulse-train mode (TRIGGER_INPUT_PULSE_MIN_US between accepted edges) and
+// switch mode (TRIGGER_INPUT_DEBOUNCE_US)
+void trigger_input_set_pulse_train(bool on);
+
+void trigger_input_get_stats(trigger_input_stats_t *out);
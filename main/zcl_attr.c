@@ -0,0 +1,146 @@
+// Zero-copy parsing of ZCL read attribute responses
+
+#include <string.h>
+#include "zcl/esp_zigbee_zcl_common.h"
+#include "zcl_attr.h"
+
+// Length-prefixed string types: prefix size in bytes, 0 for other types
+static uint8_t string_prefix(uint8_t type)
+{
+	switch (type) {
+	case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+	case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
+		return 1;
+	case ESP_ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING:
+	case ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING:
+		return 2;
+	default:
+		return 0;
+	}
+}
+
+static bool decode(const esp_zb_zcl_attribute_t *attr, zcl_attr_view_t *out)
+{
+	const uint8_t *raw = (const uint8_t *)attr->data.value;
+	uint16_t size = attr->data.size;
+	if (!raw) return false;
+	memset(out, 0, sizeof(*out));
+	out->id = attr->id;
+	out->type = (uint8_t)attr->data.type;
+	uint8_t prefix = string_prefix(out->type);
+	if (prefix) {
+		// The size bounds the view: without one (0) the length prefix cannot be trusted
+		if (size < prefix) return false;
+		uint16_t len = prefix == 1 ? raw[0] : (uint16_t)(raw[0] | (raw[1] << 8));
+		// All ones is the ZCL "non-value"; a length past the value means a malformed record
+		if (len == (prefix == 1 ? 0xFF : 0xFFFF)) return false;
+		if ((uint32_t)prefix + len > size) return false;
+		out->is_string = true;
+		out->str = (const char *)raw + prefix;
+		out->len = len;
+		return true;
+	}
+	if (size == 0) return false;
+	out->str = (const char *)raw;
+	out->len = size;
+	if (size <= 4) {
+		// Values are stored in the CPU's (little-endian) byte order
+		for (uint16_t i = 0; i < size; i++) out->u32 |= (uint32_t)raw[i] << (8 * i);
+	}
+	return true;
+}
+
+bool zcl_attr_next(zcl_attr_iter_t *it, zcl_attr_view_t *out)
+{
+	while (it->next) {
+		const esp_zb_zcl_read_attr_resp_variable_t *v = it->next;
+		it->next = v->next;
+		if (v->status == ESP_ZB_ZCL_STATUS_SUCCESS && decode(&v->attribute, out)) return true;
+	}
+	return false;
+}
+
+void zcl_basic_parse(const esp_zb_zcl_read_attr_resp_variable_t *list, zcl_basic_info_t *out)
+{
+	memset(out, 0, sizeof(*out));
+	zcl_attr_iter_t it;
+	zcl_attr_view_t a;
+	zcl_attr_iter_init(&it, list);
+	while (zcl_attr_next(&it, &a)) {
+		switch (a.id) {
+		case ZCL_BASIC_ZCL_VERSION:
+			if (a.is_string) break;
+			out->zcl_version = (uint8_t)a.u32;
+			out->present |= ZCL_BASIC_HAVE_ZCL_VERSION;
+			break;
+		case ZCL_BASIC_APP_VERSION:
+			if (a.is_string) break;
+			out->app_version = (uint8_t)a.u32;
+			out->present |= ZCL_BASIC_HAVE_APP_VERSION;
+			break;
+		case ZCL_BASIC_STACK_VERSION:
+			if (a.is_string) break;
+			out->stack_version = (uint8_t)a.u32;
+			out->present |= ZCL_BASIC_HAVE_STACK_VERSION;
+			break;
+		case ZCL_BASIC_HW_VERSION:
+			if (a.is_string) break;
+			out->hw_version = (uint8_t)a.u32;
+			out->present |= ZCL_BASIC_HAVE_HW_VERSION;
+			break;
+		case ZCL_BASIC_POWER_SOURCE:
+			if (a.is_string) break;
+			out->power_source = (uint8_t)a.u32;
+			out->present |= ZCL_BASIC_HAVE_POWER_SOURCE;
+			break;
+		case ZCL_BASIC_MANUFACTURER:
+			if (!a.is_string) break;
+			out->manufacturer = a;
+			out->present |= ZCL_BASIC_HAVE_MANUFACTURER;
+			break;
+		case ZCL_BASIC_MODEL:
+			if (!a.is_string) break;
+			out->model = a;
+			out->present |= ZCL_BASIC_HAVE_MODEL;
+			break;
+		case ZCL_BASIC_DATE_CODE:
+			if (!a.is_string) break;
+			out->date_code = a;
+			out->present |= ZCL_BASIC_HAVE_DATE_CODE;
+			break;
+		case ZCL_BASIC_SW_BUILD:
+			if (!a.is_string) break;
+			out->sw_build = a;
+			out->present |= ZCL_BASIC_HAVE_SW_BUILD;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	for (size_t i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+uint32_t zcl_basic_fw_fingerprint(const zcl_basic_info_t *info)
+{
+	uint16_t have = info->present & ZCL_BASIC_HAVE_FIRMWARE;
+	if (!have) return 0;
+	// Which attributes were present is part of the fingerprint, so a missing attribute
+	// and an empty one do not collide
+	uint32_t h = fnv1a(2166136261u, &have, sizeof(have));
+	h = fnv1a(h, &info->app_version, 1);
+	h = fnv1a(h, &info->stack_version, 1);
+	h = fnv1a(h, &info->hw_version, 1);
+	h = fnv1a(h, info->date_code.str, info->date_code.len);
+	h = fnv1a(h, "\0", 1);
+	h = fnv1a(h, info->sw_build.str, info->sw_build.len);
+	return h ? h : 1;
+}
@@ -0,0 +1,79 @@
+// Zero-copy parsing of ZCL read attribute responses
+// - Walks the esp_zb_zcl_read_attr_resp_variable_t list and yields views into the payload:
+//   strings as (pointer, length) without the length prefix, integers decoded
+// - Nothing is copied, nothing is NUL-terminated: print views with "%.*s"
+// - Reentrant: all state lives in the caller's iterator
+// - Basic cluster helper collects the attributes used to identify a device and its firmware
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "zcl/esp_zigbee_zcl_command.h"
+
+typedef struct {
+	uint16_t id;
+	uint8_t type;               // esp_zb_zcl_attr_type_t
+	bool is_string;
+	const char *str;            // string types: bytes after the length prefix
+	uint16_t len;               // string length, or size of a numeric value
+	uint32_t u32;               // numeric types (unsigned, enum, bitmap, bool), zero-extended
+} zcl_attr_view_t;
+
+typedef struct {
+	const esp_zb_zcl_read_attr_resp_variable_t *next;
+} zcl_attr_iter_t;
+
+static inline void zcl_attr_iter_init(zcl_attr_iter_t *it, const esp_zb_zcl_read_attr_resp_variable_t *list)
+{
+	it->next = list;
+}
+
+// Next successfully read attribute with a well-formed value. Records with an error
+// status, no value, a "non-value" string length or a length beyond the value are skipped;
+// so are strings of unknown value size (0), whose length cannot be checked.
+bool zcl_attr_next(zcl_attr_iter_t *it, zcl_attr_view_t *out);
+
+// Basic cluster (0x0000) attributes
+#define ZCL_BASIC_ZCL_VERSION       (0x0000)
+#define ZCL_BASIC_APP_VERSION       (0x0001)
+#define ZCL_BASIC_STACK_VERSION     (0x0002)
+#define ZCL_BASIC_HW_VERSION        (0x0003)
+#define ZCL_BASIC_MANUFACTURER      (0x0004)
+#define ZCL_BASIC_MODEL             (0x0005)
+#define ZCL_BASIC_DATE_CODE         (0x0006)
+#define ZCL_BASIC_POWER_SOURCE      (0x0007)
+#define ZCL_BASIC_SW_BUILD          (0x4000)
+
+// Bits of zcl_basic_info_t.present
+#define ZCL_BASIC_HAVE_ZCL_VERSION      (1u << 0)
+#define ZCL_BASIC_HAVE_APP_VERSION      (1u << 1)
+#define ZCL_BASIC_HAVE_STACK_VERSION    (1u << 2)
+#define ZCL_BASIC_HAVE_HW_VERSION       (1u << 3)
+#define ZCL_BASIC_HAVE_MANUFACTURER     (1u << 4)
+#define ZCL_BASIC_HAVE_MODEL            (1u << 5)
+#define ZCL_BASIC_HAVE_DATE_CODE        (1u << 6)
+#define ZCL_BASIC_HAVE_POWER_SOURCE     (1u << 7)
+#define ZCL_BASIC_HAVE_SW_BUILD         (1u << 8)
+#define ZCL_BASIC_HAVE_FIRMWARE         (ZCL_BASIC_HAVE_APP_VERSION | ZCL_BASIC_HAVE_STACK_VERSION | \
+										 ZCL_BASIC_HAVE_HW_VERSION | ZCL_BASIC_HAVE_DATE_CODE | ZCL_BASIC_HAVE_SW_BUILD)
+
+typedef struct {
+	uint16_t present;           // ZCL_BASIC_HAVE_* of the attributes found
+	uint8_t zcl_version;
+	uint8_t app_version;
+	uint8_t stack_version;
+	uint8_t hw_version;
+	uint8_t power_source;
+	zcl_attr_view_t manufacturer;
+	zcl_attr_view_t model;
+	zcl_attr_view_t date_code;
+	zcl_attr_view_t sw_build;
+} zcl_basic_info_t;
+
+// Collect Basic attributes from a read attribute response, in one pass over the list.
+// The string views point into the response and are only valid inside the callback.
+void zcl_basic_parse(const esp_zb_zcl_read_attr_resp_variable_t *list, zcl_basic_info_t *out);
+
+// 32-bit fingerprint (FNV-1a) of the firmware attributes present; 0 when there are none
+uint32_t zcl_basic_fw_fingerprint(const zcl_basic_info_t *info);
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# Static memory budget of the app, per subsystem
+# - Firmware: input sections of libmain.a in the link map (idf.py build runs it after linking)
+#     mem_budget.py --map build/zigbee_scan.map [--archive libmain.a]
+# - Host: `size` over the app objects (host/CMakeLists.txt, target mem_budget)
+#     mem_budget.py [--size-tool size] --objects build-host/.../*.o
+# Flash is code, read-only data and the initial values of .data; RAM is .data, .bss and IRAM code.
+# A source file missing from SUBSYSTEMS is reported under "other" so it cannot go unnoticed.
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+SUBSYSTEMS = (
+    ('zigbee/interview', ('main', 'interview', 'classifier', 'matcher', 'zcl_attr', 'presence', 'address',
+                          'topology', 'join_window', 'channel_survey', 'channel_select')),
+    ('device tables', ('device_table', 'device_cache')),
+    ('logging', ('event_log', 'latency', 'metrics', 'heap_guard')),
+    ('I/O', ('actuator', 'trigger_input', 'console_cmds', 'gateway_link')),
+)
+COLUMNS = ('text', 'rodata', 'data', 'bss', 'iram')
+
+# GNU ld map: ` .section  0xADDR  0xSIZE  path/libmain.a(file.c.obj)`, the section name on a line
+# of its own when it is long
+MAP_ENTRY = re.compile(r'^ (\S+)?\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(\S+)$')
+MEMBER = re.compile(r'\(([^()]+?)\.c\.(?:obj|o)\)$')
+
+
+def subsystem_of(stem):
+    for name, stems in SUBSYSTEMS:
+        if stem in stems:
+            return name
+    return 'other'
+
+
+def section_kind(section):
+    if section.startswith(('.iram', '.iram1')):
+        return 'iram'
+    if section.startswith(('.text', '.literal')):
+        return 'text'
+    if section.startswith(('.rodata', '.srodata')):
+        return 'rodata'
+    if section.startswith(('.data', '.sdata', '.dram')):
+        return 'data'
+    if section.startswith(('.bss', '.sbss', '.noinit')) or section == 'COMMON':
+        return 'bss'
+    return None  # debug info, attributes, comments: not loaded
+
+
+def read_map(path, archive):
+    per_file = {}
+    in_memory_map = False
+    pending = None
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not in_memory_map:
+                in_memory_map = line.startswith('Linker script and memory map')
+                continue
+            m = MAP_ENTRY.match(line)
+            if not m:
+                # A long section name: its address, size and file follow on the next line
+                pending = line.strip() if line.startswith(' .') and len(line.split()) == 1 else None
+                continue
+            section = m.group(1) or pending
+            pending = None
+            origin = m.group(3)
+            if not section or os.path.basename(origin).split('(')[0] != archive:
+                continue
+            member = MEMBER.search(origin)
+            kind = section_kind(section)
+            if not member or not kind:
+                continue
+            sizes = per_file.setdefault(member.group(1), dict.fromkeys(COLUMNS, 0))
+            sizes[kind] += int(m.group(2), 16)
+    if not in_memory_map:
+        sys.exit('mem_budget: %s is not a GNU ld map file' % path)
+    return per_file
+
+
+def read_objects(size_tool, objects):
+    # Berkeley format: text includes the read-only data
+    out = subprocess.run([size_tool] + objects, check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    per_file = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) < 6 or not fields[0].isdigit():
+            continue
+        stem = re.sub(r'\.c\.(obj|o)$', '', os.path.basename(fields[5]))
+        if stem == os.path.basename(fields[5]):
+            continue
+        per_file[stem] = dict(zip(COLUMNS, (int(fields[0]), 0, int(fields[1]), int(fields[2]), 0)))
+    return per_file
+
+
+def report(per_file, title):
+    totals = {}
+    for stem, sizes in per_file.items():
+        group = totals.setdefault(subsystem_of(stem), dict.fromkeys(COLUMNS, 0))
+        for c in COLUMNS:
+            group[c] += sizes[c]
+    order = [name for name, _ in SUBSYSTEMS] + ['other']
+    print(title)
+    print('%-18s %8s %8s  %8s %8s %8s %8s %8s' % (('subsystem', 'flash', 'RAM') + COLUMNS))
+    all_sizes = dict.fromkeys(COLUMNS, 0)
+    for name in order:
+        if name not in totals:
+            continue
+        s = totals[name]
+        for c in COLUMNS:
+            all_sizes[c] += s[c]
+        print_row(name, s)
+    print_row('total', all_sizes)
+
+
+def print_row(name, s):
+    flash = s['text'] + s['rodata'] + s['data'] + s['iram']
+    ram = s['data'] + s['bss'] + s['iram']
+    print('%-18s %8d %8d  %8d %8d %8d %8d %8d' % ((name, flash, ram) + tuple(s[c] for c in COLUMNS)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Static memory of the app per subsystem')
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument('--map', help='GNU ld map file of the firmware')
+    src.add_argument('--objects', nargs='+', help='object files of the app (host build)')
+    ap.add_argument('--archive', default='libmain.a', help='archive of the app in the map (default libmain.a)')
+    ap.add_argument('--size-tool', default='size', help='binutils size for --objects (default size)')
+    args = ap.parse_args()
+    if args.map:
+        report(read_map(args.map, args.archive), 'Static memory of %s by subsystem (bytes)' % args.archive)
+    else:
+        report(read_objects(args.size_tool, args.objects), 'Static memory of the app objects by subsystem (bytes, host)')
+
+
+if __name__ == '__main__':
+    main()